@@ -0,0 +1,80 @@
+#pragma once
+// Byte sources for the GPS parsers.
+// The parsers only need "give me whatever bytes are ready", so the GPS layer reads through this
+// interface and can be fed from the UART, a recorded log file or a memory buffer alike. Reads
+// never block: they return what is available now, 0 when nothing is.
+// Pure C++ (no Arduino dependency) so recorded logs can be replayed on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace io {
+
+class ByteSource {
+public:
+    virtual ~ByteSource() {}
+    // Copy up to len ready bytes into buf; returns how many were copied
+    virtual size_t read(uint8_t* buf, size_t len) = 0;
+    // Bytes that can be read without waiting (a lower bound is fine)
+    virtual int available() = 0;
+};
+
+// Any port with read(uint8_t*, size_t) and available(), e.g. HardwareSerial
+template <class Port>
+class PortSource : public ByteSource {
+public:
+    explicit PortSource(Port &port) : _port(port) {}
+    size_t read(uint8_t* buf, size_t len) override { return _port.read(buf, len); }
+    int available() override { return _port.available(); }
+
+private:
+    Port &_port;
+};
+
+// Replays a buffer; the data is not copied and must outlive the source
+class MemorySource : public ByteSource {
+public:
+    MemorySource(const void* data, size_t len) : _data((const uint8_t*)data), _len(len), _pos(0) {}
+
+    size_t read(uint8_t* buf, size_t len) override {
+        size_t n = _len - _pos;
+        if (n > len) n = len;
+        memcpy(buf, _data + _pos, n);
+        _pos += n;
+        return n;
+    }
+    int available() override { return (int)(_len - _pos); }
+
+    void rewind() { _pos = 0; }
+    bool done() const { return _pos >= _len; }
+
+private:
+    const uint8_t* _data;
+    size_t _len;
+    size_t _pos;
+};
+
+// Replays a file opened by the caller (stdio, so LittleFS/SD through the VFS or a host file)
+class FileSource : public ByteSource {
+public:
+    explicit FileSource(FILE* f) : _f(f), _eof(f == nullptr) {}
+
+    size_t read(uint8_t* buf, size_t len) override {
+        if (_eof) return 0;
+        size_t n = fread(buf, 1, len, _f);
+        if (n < len) _eof = true;
+        return n;
+    }
+    // A file has no "ready" count; report one chunk until the end is reached
+    int available() override { return _eof ? 0 : 128; }
+
+    bool done() const { return _eof; }
+
+private:
+    FILE* _f;
+    bool _eof;
+};
+
+} // namespace io
@@ -0,0 +1,299 @@
+#pragma once
+// Deterministic synthetic drive for DEMO_MODE and repeatable benchmark runs.
+// A script is a list of phases, each saying what speed to head for, how hard to accelerate or
+// brake getting there, how fast to turn, how many satellites are used and whether there is a fix
+// at all. DriveGenerator integrates the script in fixed steps (position, course, altitude, a
+// little seeded speed jitter so the noise gate has work to do) and formats the result as the
+// NMEA a receiver would send: GGA + RMC every epoch and a GSV cycle once a second. The same
+// seed and script always give the same bytes. NmeaSource wraps it as an io::ByteSource that
+// produces epochs as the supplied clock passes them, so it can stand in for the UART.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "byte_source.hpp"
+
+namespace demo {
+
+struct Phase {
+    uint32_t durationMs;
+    float targetKmh;     // speed to head for
+    float accelMs2;      // magnitude used to get there (accelerating or braking)
+    float turnDegS;      // course change rate, + = clockwise
+    uint8_t sats;        // satellites used; GSV reports a few more in view
+    bool fix;            // false = dropout (GGA quality 0, RMC void)
+};
+
+// A lap of everything the UI has to cope with; ~4.5 min, then it repeats
+static const Phase DEFAULT_DRIVE[] = {
+    {  8000,   0.0f, 1.0f,  0.0f,  9, true  },  // parked: jitter only
+    { 12000, 100.0f, 3.5f,  0.0f, 10, true  },  // hard launch to 100
+    { 20000, 100.0f, 1.0f,  2.0f, 11, true  },  // sweeping bend
+    {  6000,   0.0f, 8.0f,  0.0f, 11, true  },  // emergency stop
+    {  5000,   0.0f, 1.0f,  0.0f,  9, true  },
+    { 30000,  50.0f, 2.0f,  0.0f,  8, true  },  // town
+    {  6000,  50.0f, 1.0f,  0.0f,  3, false },  // tunnel: fix dropout
+    { 20000,  50.0f, 1.0f, -9.0f,  7, true  },  // roundabouts
+    { 25000,   4.0f, 1.5f,  0.0f,  6, true  },  // walking pace, near the gate
+    { 40000, 130.0f, 2.5f,  0.0f, 12, true  },  // motorway
+    { 15000, 180.0f, 1.2f,  0.0f, 12, true  },  // past the end of the dial
+    { 30000,  30.0f, 3.0f,  1.0f, 10, true  },
+    { 20000,   0.0f, 2.0f,  0.0f,  9, true  },
+    { 30000,  15.0f, 4.0f,  0.0f,  8, true  },  // stop-and-go
+};
+static constexpr size_t DEFAULT_DRIVE_LEN = sizeof(DEFAULT_DRIVE) / sizeof(DEFAULT_DRIVE[0]);
+
+// Linear battery curve: drains steadily, then jumps back to full as if recharged
+struct BatteryCurve {
+    float startPct = 90.0f;
+    float drainPctPerMin = 2.0f;
+    float floorPct = 3.0f;       // wraps back to startPct below this
+};
+
+struct DriveState {
+    uint32_t tMs;
+    float speedKmh;              // true speed, before jitter
+    float courseDeg;
+    double latDeg, lonDeg;
+    float altM;
+    uint8_t sats;
+    bool fix;
+};
+
+// Earth radius used for dead-reckoning the synthetic track (same as geo_utils)
+static constexpr double DRIVE_EARTH_R_M = 6371000.0;
+static constexpr uint32_t DRIVE_START_DAY = 19875;     // 2024-06-01, days since 1970
+static constexpr uint32_t DRIVE_START_SEC = 12 * 3600; // 12:00:00 UTC
+// Upper bound of one epoch's NMEA (GGA + RMC + a 4-message GSV cycle)
+static constexpr size_t DRIVE_EPOCH_MAX = 512;
+
+class DriveGenerator {
+public:
+    DriveGenerator(const Phase* script = DEFAULT_DRIVE, size_t count = DEFAULT_DRIVE_LEN, uint32_t seed = 1)
+        : _script(script), _count(count), _seed(seed ? seed : 1) { reset(); }
+
+    void reset() {
+        _rng = _seed;
+        _phase = 0; _phaseMs = 0;
+        _s.tMs = 0; _s.speedKmh = 0.0f; _s.courseDeg = 45.0f;
+        _s.latDeg = 48.137154; _s.lonDeg = 11.576124; _s.altM = 520.0f;
+        applyPhase();
+    }
+
+    // Advance the drive by dtMs
+    void step(uint32_t dtMs) {
+        if (!_count) return;
+        const Phase &p = _script[_phase];
+        float dt = dtMs * 0.001f;
+        float dv = p.accelMs2 * 3.6f * dt;
+        if (_s.speedKmh < p.targetKmh) _s.speedKmh = fminf(p.targetKmh, _s.speedKmh + dv);
+        else _s.speedKmh = fmaxf(p.targetKmh, _s.speedKmh - dv);
+        if (_s.speedKmh > 0.0f) _s.courseDeg = fmodf(_s.courseDeg + p.turnDegS * dt + 360.0f, 360.0f);
+
+        double d = _s.speedKmh / 3.6 * dt;
+        double h = _s.courseDeg * M_PI / 180.0;
+        _s.latDeg += d * cos(h) / DRIVE_EARTH_R_M * 180.0 / M_PI;
+        _s.lonDeg += d * sin(h) / (DRIVE_EARTH_R_M * cos(_s.latDeg * M_PI / 180.0)) * 180.0 / M_PI;
+        _s.altM = 520.0f + 15.0f * sinf(_s.tMs * 1e-5f);
+
+        _s.tMs += dtMs;
+        _phaseMs += dtMs;
+        if (_phaseMs >= p.durationMs) {
+            _phaseMs = 0;
+            _phase = (_phase + 1) % _count;
+            applyPhase();
+        }
+    }
+
+    const DriveState& state() const { return _s; }
+    size_t phase() const { return _phase; }
+
+    // Battery level for a given drive time; a pure function so the UI can read it from any task
+    static float batteryPct(uint32_t tMs, const BatteryCurve &c = BatteryCurve()) {
+        float span = c.startPct - c.floorPct;
+        if (span <= 0.0f || c.drainPctPerMin <= 0.0f) return c.startPct;
+        float used = fmodf(tMs / 60000.0f * c.drainPctPerMin, span);
+        return c.startPct - used;
+    }
+
+    // Format one epoch (GGA + RMC, plus the GSV cycle when 'withGsv') into 'out'. Returns the
+    // length, or 0 if 'cap' is too small (DRIVE_EPOCH_MAX always fits). Each sentence is under
+    // nmea::MAX_SENTENCE.
+    size_t nmea(char* out, size_t cap, bool withGsv) {
+        size_t n = 0;
+        bool ok = true;
+        char t[12], lat[32], lon[32], date[8];
+        uint32_t sec = _s.tMs / 1000, cs = (_s.tMs % 1000) / 10;
+        uint32_t day = DRIVE_START_DAY + (DRIVE_START_SEC + sec) / 86400, sod = (DRIVE_START_SEC + sec) % 86400;
+        snprintf(t, sizeof(t), "%02u%02u%02u.%02u", (unsigned)(sod / 3600), (unsigned)(sod / 60 % 60), (unsigned)(sod % 60), (unsigned)cs);
+        formatDate(day, date);
+        coord(lat, sizeof(lat), _s.latDeg, 2);
+        coord(lon, sizeof(lon), _s.lonDeg, 3);
+        const char* ns = _s.latDeg < 0 ? "S" : "N";
+        const char* ew = _s.lonDeg < 0 ? "W" : "E";
+        float hdop = _s.sats ? 0.7f + 6.0f / _s.sats : 99.9f;
+
+        // Reported speed carries receiver-like jitter: ~0.15 km/h 1-sigma, never negative
+        float v = _s.speedKmh + 0.15f * gaussish();
+        if (v < 0.0f) v = -v;
+
+        if (_s.fix) {
+            ok = ok && put(out, cap, n, "GPGGA,%s,%s,%s,%s,%s,1,%02u,%.1f,%.1f,M,47.0,M,,",
+                           t, lat, ns, lon, ew, (unsigned)_s.sats, hdop, _s.altM);
+            ok = ok && put(out, cap, n, "GPRMC,%s,A,%s,%s,%s,%s,%.3f,%.1f,%s,,,A",
+                           t, lat, ns, lon, ew, v / 1.852f, _s.courseDeg, date);
+        } else {
+            ok = ok && put(out, cap, n, "GPGGA,%s,,,,,0,%02u,,,M,,M,,", t, (unsigned)_s.sats);
+            ok = ok && put(out, cap, n, "GPRMC,%s,V,,,,,,,%s,,,N", t, date);
+        }
+        if (withGsv) ok = ok && gsv(out, cap, n);
+        return ok ? n : 0;
+    }
+
+private:
+    void applyPhase() {
+        if (!_count) return;
+        _s.sats = _script[_phase].sats;
+        _s.fix = _script[_phase].fix;
+    }
+
+    // Deterministic xorshift32, mapped to roughly N(0,1) by summing uniforms
+    float gaussish() {
+        float sum = 0.0f;
+        for (int i = 0; i < 4; ++i) {
+            _rng ^= _rng << 13; _rng ^= _rng >> 17; _rng ^= _rng << 5;
+            sum += (_rng & 0xFFFF) / 65535.0f;
+        }
+        return (sum - 2.0f) * 1.732f;
+    }
+
+    // Degrees -> NMEA (d)ddmm.mmmmm, sign dropped (the hemisphere goes in its own field)
+    static void coord(char* out, size_t cap, double deg, int degDigits) {
+        deg = fabs(deg);
+        int d = (int)deg;
+        double m = (deg - d) * 60.0;
+        snprintf(out, cap, degDigits == 2 ? "%02d%08.5f" : "%03d%08.5f", d, m);
+    }
+
+    // Days since 1970-01-01 -> DDMMYY
+    static void formatDate(uint32_t days, char* out) {
+        int32_t z = (int32_t)days + 719468;
+        int32_t era = z / 146097, doe = z - era * 146097;
+        int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100), mp = (5 * doy + 2) / 153;
+        int32_t d = doy - (153 * mp + 2) / 5 + 1, m = mp < 10 ? mp + 3 : mp - 9;
+        int32_t y = yoe + era * 400 + (m <= 2);
+        snprintf(out, 8, "%02u%02u%02u", (unsigned)d % 100u, (unsigned)m % 100u, (unsigned)(y % 100));
+    }
+
+    // Append "$" + body + "*CS\r\n" at out[n]; false (n unchanged) if it does not fit
+    static bool put(char* out, size_t cap, size_t &n, const char* fmt, ...) __attribute__((format(printf, 4, 5))) {
+        char* p = out + n;
+        size_t room = cap - n;
+        if (room < 8) return false;
+        va_list ap;
+        va_start(ap, fmt);
+        int body = vsnprintf(p + 1, room - 1, fmt, ap);
+        va_end(ap);
+        if (body < 0 || (size_t)body + 6 > room) return false;
+        p[0] = '$';
+        uint8_t c = 0;
+        for (int i = 1; i <= body; ++i) c ^= (uint8_t)p[i];
+        snprintf(p + 1 + body, room - 1 - body, "*%02X\r\n", c);
+        n += (size_t)body + 6;
+        return true;
+    }
+
+    // One GSV cycle for the satellites in view: the used ones strong, a few extra weak or untracked
+    bool gsv(char* out, size_t cap, size_t &n) const {
+        unsigned inView = _s.sats + 3;
+        if (inView > 16) inView = 16;
+        unsigned msgs = (inView + 3) / 4;
+        for (unsigned m = 0; m < msgs; ++m) {
+            char body[80];
+            int len = snprintf(body, sizeof(body), "GPGSV,%u,%u,%02u", msgs, m + 1, inView);
+            for (unsigned k = m * 4; k < inView && k < m * 4 + 4; ++k) {
+                unsigned prn = 2 + k * 2, el = 15 + (k * 37) % 70, az = (k * 97) % 360;
+                if (k < _s.sats) len += snprintf(body + len, sizeof(body) - len, ",%02u,%02u,%03u,%02u", prn, el, az, 28 + (k * 7) % 20);
+                else len += snprintf(body + len, sizeof(body) - len, ",%02u,%02u,%03u,", prn, el, az);
+            }
+            if (!put(out, cap, n, "%s", body)) return false;
+        }
+        return true;
+    }
+
+    const Phase* _script;
+    size_t _count;
+    uint32_t _seed;
+    uint32_t _rng;
+    size_t _phase;
+    uint32_t _phaseMs;
+    DriveState _s;
+};
+
+// Emits the generator's NMEA at 'rateHz' (1..50) against a caller-supplied millisecond clock.
+// read() catches up on every epoch the clock has passed, so a slow consumer sees a burst rather
+// than a gap, like a UART ring buffer. Call from one task only; due() may be polled from others.
+class NmeaSource : public io::ByteSource {
+public:
+    typedef uint32_t (*ClockMs)();
+
+    NmeaSource(DriveGenerator &gen, uint8_t rateHz, ClockMs clock)
+        : _gen(gen), _clock(clock), _len(0), _pos(0) {
+        _periodMs = 1000u / (rateHz < 1 ? 1 : rateHz > 50 ? 50 : rateHz);
+        _nextMs = _clock();
+    }
+
+    size_t read(uint8_t* buf, size_t len) override {
+        fill();
+        size_t n = _len - _pos;
+        if (n > len) n = len;
+        memcpy(buf, _buf + _pos, n);
+        _pos += n;
+        return n;
+    }
+
+    int available() override {
+        fill();
+        return (int)(_len - _pos);
+    }
+
+    // Drop anything pending and start emitting from the clock's current time
+    void restart() {
+        _len = _pos = 0;
+        _nextMs = _clock();
+    }
+
+    // An epoch is waiting to be produced (cheap, for waking the reader)
+    bool due() const { return (int32_t)(_clock() - _nextMs) >= 0; }
+
+    uint32_t periodMs() const { return _periodMs; }
+
+private:
+    void fill() {
+        if (_pos < _len) return;
+        _len = _pos = 0;
+        uint32_t now = _clock();
+        // A full buffer leaves the rest of the backlog for the next read
+        while ((int32_t)(now - _nextMs) >= 0 && sizeof(_buf) - _len >= DRIVE_EPOCH_MAX) {
+            _gen.step(_periodMs);
+            bool gsv = (_gen.state().tMs % 1000) < _periodMs;
+            _len += _gen.nmea(_buf + _len, sizeof(_buf) - _len, gsv);
+            _nextMs += _periodMs;
+        }
+    }
+
+    DriveGenerator &_gen;
+    ClockMs _clock;
+    uint32_t _periodMs;
+    uint32_t _nextMs;
+    char _buf[3 * DRIVE_EPOCH_MAX];
+    size_t _len;
+    size_t _pos;
+};
+
+} // namespace demo
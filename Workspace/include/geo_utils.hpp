@@ -0,0 +1,83 @@
+#pragma once
+// Geodesy helpers for fixed-point coordinates (int32 in units of 1e-7 degree).
+// LocalFrame is a small-area equirectangular ENU projection around an origin: one cosine at
+// setOrigin() time, then every point is two integer subtractions and two multiplies. Error stays
+// well under 0.1% of distance within a few tens of km of the origin, which covers trip, lap and
+// track maths. Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <math.h>
+
+namespace geo {
+
+static constexpr int32_t E7 = 10000000;
+// Metres per degree of latitude on the mean-radius sphere (R = 6371008.8 m)
+static constexpr double METERS_PER_DEG = 111194.9266;
+static constexpr double METERS_PER_E7  = METERS_PER_DEG / E7;
+
+static inline double e7ToDeg(int32_t v) { return v * 1e-7; }
+static inline int32_t degToE7(double deg) { return (int32_t)lround(deg * E7); }
+
+// Longitude difference b - a in E7, wrapped into [-180, 180) degrees
+static inline int64_t lonDeltaE7(int32_t a, int32_t b) {
+    int64_t d = (int64_t)b - (int64_t)a;
+    if (d >= 1800000000LL) d -= 3600000000LL;
+    else if (d < -1800000000LL) d += 3600000000LL;
+    return d;
+}
+
+struct LocalFrame {
+    int32_t originLatE7 = 0;
+    int32_t originLonE7 = 0;
+    float kNorth = (float)METERS_PER_E7;   // metres per E7 of latitude
+    float kEast  = (float)METERS_PER_E7;   // metres per E7 of longitude at the origin latitude
+    bool valid = false;
+
+    void setOrigin(int32_t latE7, int32_t lonE7) {
+        originLatE7 = latE7; originLonE7 = lonE7;
+        kNorth = (float)METERS_PER_E7;
+        kEast = (float)(METERS_PER_E7 * cos(e7ToDeg(latE7) * (M_PI / 180.0)));
+        valid = true;
+    }
+
+    // Project to east/north metres relative to the origin
+    void toEnu(int32_t latE7, int32_t lonE7, float &east, float &north) const {
+        north = (float)((int64_t)latE7 - originLatE7) * kNorth;
+        east  = (float)lonDeltaE7(originLonE7, lonE7) * kEast;
+    }
+
+    // Inverse of toEnu()
+    void fromEnu(float east, float north, int32_t &latE7, int32_t &lonE7) const {
+        latE7 = originLatE7 + (int32_t)lroundf(north / kNorth);
+        int64_t lon = (int64_t)originLonE7 + (kEast > 0.0f ? (int64_t)llroundf(east / kEast) : 0);
+        if (lon >= 1800000000LL) lon -= 3600000000LL;
+        else if (lon < -1800000000LL) lon += 3600000000LL;
+        lonE7 = (int32_t)lon;
+    }
+
+    // True if the point is far enough from the origin that it should be re-centred
+    bool needsRecenter(int32_t latE7, int32_t lonE7, float maxRadiusM) const {
+        if (!valid) return true;
+        float e, n; toEnu(latE7, lonE7, e, n);
+        return (e * e + n * n) > maxRadiusM * maxRadiusM;
+    }
+};
+
+// Short-range distance in metres (equirectangular at the mid latitude)
+static inline float distanceM(int32_t lat1E7, int32_t lon1E7, int32_t lat2E7, int32_t lon2E7) {
+    double midLat = e7ToDeg((int32_t)(((int64_t)lat1E7 + lat2E7) / 2)) * (M_PI / 180.0);
+    float n = (float)(((int64_t)lat2E7 - lat1E7) * METERS_PER_E7);
+    float e = (float)(lonDeltaE7(lon1E7, lon2E7) * METERS_PER_E7 * cos(midLat));
+    return sqrtf(e * e + n * n);
+}
+
+// Initial bearing from point 1 to point 2 in degrees [0,360), 0 = north, clockwise
+static inline float bearingDeg(int32_t lat1E7, int32_t lon1E7, int32_t lat2E7, int32_t lon2E7) {
+    double midLat = e7ToDeg((int32_t)(((int64_t)lat1E7 + lat2E7) / 2)) * (M_PI / 180.0);
+    float n = (float)((int64_t)lat2E7 - lat1E7);
+    float e = (float)(lonDeltaE7(lon1E7, lon2E7) * cos(midLat));
+    float b = atan2f(e, n) * (180.0f / (float)M_PI);
+    return b < 0.0f ? b + 360.0f : b;
+}
+
+} // namespace geo
@@ -0,0 +1,120 @@
+#pragma once
+// Motion-adaptive receiver duty cycling.
+// The governor watches the gated speed and course from each snapshot and picks a receiver mode:
+// full navigation rate while moving, 1 Hz once parked for a while, and u-blox cyclic tracking
+// (power-save) when parked for longer with a good fix. Any speed above the noise gate, a course
+// swing or a lost fix returns straight to full rate, and so does a hold (a screen that times
+// runs needs every epoch while the car stands). A stationary receiver reports a random course
+// every fix, so a swing only counts once the new heading has held steady for courseWakeMs. It only decides; applying a mode is the
+// caller's job (gps_set_power_mode()). Time spent per mode and transition counts are kept so
+// the savings can be estimated. Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <math.h>
+
+namespace gnss {
+
+enum PowerMode : uint8_t { POWER_FULL, POWER_REDUCED, POWER_SAVE, POWER_MODE_COUNT };
+
+static inline const char* powerModeName(uint8_t m) {
+    static const char* NAMES[POWER_MODE_COUNT] = { "full", "1Hz", "psm" };
+    return m < POWER_MODE_COUNT ? NAMES[m] : "?";
+}
+
+// Nominal receiver supply current per mode (u-blox 7 class, mA), for savings estimates only
+static constexpr float POWER_MODE_MA[POWER_MODE_COUNT] = { 40.0f, 36.0f, 12.0f };
+
+struct PowerGovernorConfig {
+    uint32_t reduceAfterMs = 30000;     // parked this long -> 1 Hz
+    uint32_t powerSaveAfterMs = 300000; // parked this long (with a fix) -> cyclic tracking
+    float courseWakeDeg = 30.0f;        // course swing that counts as moving again
+    float courseSteadyDeg = 10.0f;      // ... if the new course stays within this
+    uint32_t courseWakeMs = 3000;       // ... for this long
+};
+
+class PowerGovernor {
+public:
+    struct Stats {
+        uint32_t timeMs[POWER_MODE_COUNT];
+        uint32_t transitions;
+    };
+
+    explicit PowerGovernor(const PowerGovernorConfig &cfg = PowerGovernorConfig()) : _cfg(cfg) { reset(0); }
+
+    void reset(uint32_t nowMs) {
+        _mode = POWER_FULL;
+        _lastMs = nowMs; _stillSinceMs = nowMs;
+        _still = false; _refCourse = 0.0f;
+        _swinging = false; _swingCourse = 0.0f; _swingSinceMs = nowMs;
+        for (int i = 0; i < POWER_MODE_COUNT; ++i) _stats.timeMs[i] = 0;
+        _stats.transitions = 0;
+    }
+
+    // Feed one snapshot; returns true when the mode changed (read it from mode()). While 'hold'
+    // is set the receiver stays at full rate and parked time counts from when it is cleared.
+    bool update(uint32_t nowMs, bool validFix, float gatedSpeedKmh, float courseDeg, bool hold = false) {
+        _stats.timeMs[_mode] += nowMs - _lastMs;
+        _lastMs = nowMs;
+
+        bool moving = gatedSpeedKmh > 0.0f || hold;
+        if (!moving && _still) moving = courseSwing(nowMs, courseDeg);
+        if (moving || !_still) {
+            _still = !moving;
+            _stillSinceMs = nowMs;
+            _refCourse = courseDeg;
+            _swinging = false;
+        }
+
+        PowerMode want = POWER_FULL;
+        if (_still && validFix) {
+            uint32_t parked = nowMs - _stillSinceMs;
+            if (parked >= _cfg.powerSaveAfterMs) want = POWER_SAVE;
+            else if (parked >= _cfg.reduceAfterMs) want = POWER_REDUCED;
+        }
+        if (want == _mode) return false;
+        _mode = want;
+        _stats.transitions++;
+        return true;
+    }
+
+    PowerMode mode() const { return _mode; }
+    const Stats& stats() const { return _stats; }
+
+    // Mean receiver current over the tracked time vs. running at full rate throughout (percent)
+    float estimatedSavingPct() const {
+        float total = 0.0f, charge = 0.0f;
+        for (int i = 0; i < POWER_MODE_COUNT; ++i) { total += _stats.timeMs[i]; charge += _stats.timeMs[i] * POWER_MODE_MA[i]; }
+        return total > 0.0f ? 100.0f * (1.0f - charge / (total * POWER_MODE_MA[POWER_FULL])) : 0.0f;
+    }
+
+private:
+    // True once the course has left the parked reference and held its new heading long enough
+    bool courseSwing(uint32_t nowMs, float courseDeg) {
+        if (courseDelta(courseDeg, _refCourse) <= _cfg.courseWakeDeg) { _swinging = false; return false; }
+        if (!_swinging || courseDelta(courseDeg, _swingCourse) > _cfg.courseSteadyDeg) {
+            _swinging = true;
+            _swingCourse = courseDeg;
+            _swingSinceMs = nowMs;
+            return false;
+        }
+        return nowMs - _swingSinceMs >= _cfg.courseWakeMs;
+    }
+
+    static float courseDelta(float a, float b) {
+        float d = fabsf(a - b);
+        return d > 180.0f ? 360.0f - d : d;
+    }
+
+    PowerGovernorConfig _cfg;
+    PowerMode _mode;
+    uint32_t _lastMs;
+    uint32_t _stillSinceMs;
+    bool _still;
+    float _refCourse;
+    bool _swinging;
+    float _swingCourse;
+    uint32_t _swingSinceMs;
+    Stats _stats;
+};
+
+} // namespace gnss
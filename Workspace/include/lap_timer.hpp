@@ -0,0 +1,354 @@
+#pragma once
+// Lap, split and segment timing against gate lines.
+// A gate is a short line across the road, crossed p1-on-the-left (the other direction is
+// ignored, so a pit lane or a drive back doesn't count). Kinds: the start/finish line, split
+// lines inside a lap, and start/end lines of free-standing segments (shared id). Gates are put in
+// a uniform grid over a local ENU plane; only occupied cells are stored, in an open-addressed hash
+// pointing into one flat reference array, so memory follows the number of gates, not the area.
+// Each fix tests only the gates in the cells its movement line touches (one to four cells at road
+// speeds), so the per-fix cost does not grow with the number of gates. Crossing times are
+// interpolated along the movement line between the two fixes instead of taking the fix time.
+// Fixed-size storage (template capacities), no heap. Pure C++ (no Arduino dependency) so it also
+// builds on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "geo_utils.hpp"
+
+namespace lap {
+
+enum GateKind : uint8_t { GATE_START_FINISH, GATE_SPLIT, GATE_SEGMENT_START, GATE_SEGMENT_END };
+
+struct Gate {
+    int32_t lat1E7, lon1E7;   // left end, seen in the direction of travel
+    int32_t lat2E7, lon2E7;   // right end
+    uint16_t id;              // segment id, below the gate capacity (a segment's start and end share it)
+    GateKind kind;
+};
+
+static constexpr float GRID_CELL_M = 200.0f;      // grid pitch
+static constexpr uint32_t LAP_MAX_GAP_MS = 3000;  // longer between fixes: no crossing is inferred
+static constexpr int LAP_MAX_SPLITS = 16;         // split lines timed per lap
+static constexpr int LAP_MAX_CROSSINGS = 8;       // gates crossed by one movement line
+
+// One line of a gate file: "kind,id,lat1,lon1,lat2,lon2" with kind L (start/finish), P (split),
+// S/E (segment start/end) and degrees as decimals. Returns false for comments, blanks and junk,
+// and for S/E ids at or above 'idLimit': the timer only keeps segment state for ids below its
+// gate capacity, so pass that and such a line is reported as bad instead of never timing.
+static inline bool parseGateLine(const char* s, Gate &g, uint32_t idLimit = 0x10000) {
+    while (*s == ' ' || *s == '\t') ++s;
+    switch (*s) {
+        case 'L': g.kind = GATE_START_FINISH; break;
+        case 'P': g.kind = GATE_SPLIT; break;
+        case 'S': g.kind = GATE_SEGMENT_START; break;
+        case 'E': g.kind = GATE_SEGMENT_END; break;
+        default: return false;
+    }
+    if (s[1] != ',') return false;
+    char* end;
+    long id = strtol(s + 2, &end, 10);
+    if (end == s + 2 || *end != ',' || id < 0 || id > 0xFFFF) return false;
+    if ((g.kind == GATE_SEGMENT_START || g.kind == GATE_SEGMENT_END) && (uint32_t)id >= idLimit) return false;
+    double v[4];
+    for (int i = 0; i < 4; ++i) {
+        const char* p = end + 1;
+        v[i] = strtod(p, &end);
+        if (end == p || (i < 3 && *end != ',')) return false;
+    }
+    if (fabs(v[0]) > 90.0 || fabs(v[2]) > 90.0 || fabs(v[1]) > 180.0 || fabs(v[3]) > 180.0) return false;
+    g.id = (uint16_t)id;
+    g.lat1E7 = geo::degToE7(v[0]); g.lon1E7 = geo::degToE7(v[1]);
+    g.lat2E7 = geo::degToE7(v[2]); g.lon2E7 = geo::degToE7(v[3]);
+    return true;
+}
+
+static constexpr size_t pow2AtLeast(size_t n, size_t p = 1) { return p >= n ? p : pow2AtLeast(n, p * 2); }
+
+template <size_t MAX_GATES, size_t MAX_REFS>
+class GateGrid {
+public:
+    static_assert(MAX_GATES <= 0xFFFF && MAX_REFS <= 0xFFFF, "gate and reference indices are 16-bit");
+    static constexpr size_t HASH = pow2AtLeast(2 * MAX_REFS);
+
+    GateGrid() { clear(); }
+
+    void clear() { _n = 0; _refs = 0; _cells = 0; _stamp = 0; _frame.valid = false; }
+
+    // Queue a gate; call build() once all are in. False when full.
+    bool add(const Gate &g) {
+        if (_n >= MAX_GATES) return false;
+        _gates[_n++] = g;
+        return true;
+    }
+
+    // Project the gates around the first one and index them; false if MAX_REFS is too small
+    bool build() {
+        for (size_t i = 0; i < HASH; ++i) { _key[i] = EMPTY; _count[i] = 0; }
+        _refs = 0; _cells = 0;
+        if (!_n) return true;
+        _frame.setOrigin(_gates[0].lat1E7, _gates[0].lon1E7);
+        for (size_t i = 0; i < _n; ++i) {
+            const Gate &g = _gates[i];
+            _frame.toEnu(g.lat1E7, g.lon1E7, _seg[i].x1, _seg[i].y1);
+            _frame.toEnu(g.lat2E7, g.lon2E7, _seg[i].x2, _seg[i].y2);
+            _seen[i] = 0;
+        }
+        // Pass 1: count references per cell; pass 2: hand out ranges; pass 3: fill them
+        for (size_t i = 0; i < _n; ++i) if (!cover(i, COUNT)) return false;
+        uint32_t at = 0;
+        for (size_t i = 0; i < HASH; ++i) {
+            if (_key[i] == EMPTY) continue;
+            _start[i] = (uint16_t)at; at += _count[i]; _count[i] = 0;
+        }
+        if (at > MAX_REFS) return false;
+        for (size_t i = 0; i < _n; ++i) cover(i, FILL);
+        _refs = at;
+        return true;
+    }
+
+    // Call f(gateIndex) once for every gate whose cells the segment (x1,y1)-(x2,y2) touches
+    template <class F>
+    void forEachNear(float x1, float y1, float x2, float y2, F f) {
+        if (++_stamp == 0) { for (size_t i = 0; i < _n; ++i) _seen[i] = 0; _stamp = 1; }
+        int cx0, cy0, cx1, cy1;
+        cellRange(x1, y1, x2, y2, cx0, cy0, cx1, cy1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                size_t slot;
+                if (!find(cellKey(cx, cy), slot)) continue;
+                for (uint32_t k = _start[slot], e = k + _count[slot]; k < e; ++k) {
+                    uint16_t gi = _ref[k];
+                    if (_seen[gi] == _stamp) continue;
+                    _seen[gi] = _stamp;
+                    f(gi);
+                }
+            }
+        }
+    }
+
+    struct Seg { float x1, y1, x2, y2; };
+
+    const geo::LocalFrame& frame() const { return _frame; }
+    const Gate& gate(size_t i) const { return _gates[i]; }
+    const Seg& seg(size_t i) const { return _seg[i]; }
+    size_t gates() const { return _n; }
+    size_t cells() const { return _cells; }
+    size_t refs() const { return _refs; }
+
+private:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+    enum Pass { COUNT, FILL };
+
+    static int cellOf(float v) { return (int)floorf(v / GRID_CELL_M); }
+    static uint32_t cellKey(int cx, int cy) { return ((uint32_t)(uint16_t)(int16_t)cx << 16) | (uint16_t)(int16_t)cy; }
+    static size_t hashKey(uint32_t k) { return (size_t)((k * 2654435761u) >> 7) & (HASH - 1); }
+
+    static void cellRange(float x1, float y1, float x2, float y2, int &cx0, int &cy0, int &cx1, int &cy1) {
+        cx0 = cellOf(x1 < x2 ? x1 : x2); cx1 = cellOf(x1 < x2 ? x2 : x1);
+        cy0 = cellOf(y1 < y2 ? y1 : y2); cy1 = cellOf(y1 < y2 ? y2 : y1);
+    }
+
+    bool find(uint32_t key, size_t &slot) const {
+        for (size_t i = hashKey(key), n = 0; n < HASH; i = (i + 1) & (HASH - 1), ++n) {
+            if (_key[i] == key) { slot = i; return true; }
+            if (_key[i] == EMPTY) return false;
+        }
+        return false;
+    }
+
+    // Visit every cell of gate i's bounding box: count it in, or store the reference
+    bool cover(size_t i, Pass pass) {
+        int cx0, cy0, cx1, cy1;
+        cellRange(_seg[i].x1, _seg[i].y1, _seg[i].x2, _seg[i].y2, cx0, cy0, cx1, cy1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                uint32_t key = cellKey(cx, cy);
+                size_t slot;
+                if (pass == FILL) {
+                    if (find(key, slot)) _ref[_start[slot] + _count[slot]++] = (uint16_t)i;
+                    continue;
+                }
+                if (!find(key, slot)) {
+                    if (_cells * 2 >= HASH) return false;   // keep the table at most half full
+                    slot = hashKey(key);
+                    while (_key[slot] != EMPTY) slot = (slot + 1) & (HASH - 1);
+                    _key[slot] = key;
+                    _cells++;
+                }
+                _count[slot]++;
+            }
+        }
+        return true;
+    }
+
+    Gate _gates[MAX_GATES];
+    Seg _seg[MAX_GATES];
+    uint32_t _seen[MAX_GATES];
+    uint16_t _ref[MAX_REFS];
+    uint32_t _key[HASH];
+    uint16_t _start[HASH];
+    uint16_t _count[HASH];
+    size_t _n, _refs, _cells;
+    uint32_t _stamp;
+    geo::LocalFrame _frame;
+};
+
+// What the timer reports after each fix
+struct LapEvent {
+    GateKind kind;
+    uint16_t id;
+    uint32_t tMs;        // interpolated crossing time
+    uint32_t timeMs;     // lap time (start/finish), split time into the lap, or segment time
+    int32_t deltaMs;     // against the best lap's split / best lap / best segment run
+    bool hasTime;        // false for the first start/finish crossing or an unmatched segment end
+    bool hasDelta;
+};
+
+template <size_t MAX_GATES, size_t MAX_REFS>
+class LapTimer {
+public:
+    LapTimer() { reset(); }
+
+    // Forget all timing (the gates stay)
+    void reset() {
+        _havePrev = false;
+        _lapRunning = false; _lapStartMs = 0; _laps = 0; _lastLapMs = 0; _bestLapMs = 0;
+        _splits = 0; _bestSplits = 0;
+        _events = 0;
+        _lastDeltaMs = 0; _lastDeltaAtMs = 0; _haveDelta = false;
+        for (size_t i = 0; i < MAX_GATES; ++i) { _segStartMs[i] = 0; _segOpen[i] = false; _bestSegMs[i] = 0; }
+    }
+
+    GateGrid<MAX_GATES, MAX_REFS>& grid() { return _grid; }
+
+    // Feed one fix (tMs on a steady clock); returns the number of events, read with event(i)
+    int update(uint32_t tMs, int32_t latE7, int32_t lonE7) {
+        _events = 0;
+        if (!_grid.gates()) return 0;
+        float x, y;
+        _grid.frame().toEnu(latE7, lonE7, x, y);
+        if (_havePrev && tMs - _prevMs <= LAP_MAX_GAP_MS && tMs != _prevMs) collect(x, y, tMs);
+        _prevX = x; _prevY = y; _prevMs = tMs; _havePrev = true;
+        return _events;
+    }
+
+    const LapEvent& event(int i) const { return _event[i]; }
+    bool lapRunning() const { return _lapRunning; }
+    uint32_t lapStartMs() const { return _lapStartMs; }
+    uint32_t laps() const { return _laps; }
+    uint32_t lastLapMs() const { return _lastLapMs; }
+    uint32_t bestLapMs() const { return _bestLapMs; }
+    // Latest split or lap delta against the best lap, and when it was taken
+    bool lastDelta(int32_t &deltaMs, uint32_t &atMs) const { deltaMs = _lastDeltaMs; atMs = _lastDeltaAtMs; return _haveDelta; }
+
+private:
+    struct Hit { uint16_t gate; float frac; };
+
+    static float cross(float ax, float ay, float bx, float by) { return ax * by - ay * bx; }
+
+    void collect(float x, float y, uint32_t tMs) {
+        Hit hits[LAP_MAX_CROSSINGS];
+        int nh = 0;
+        float mx = x - _prevX, my = y - _prevY;
+        const float px = _prevX, py = _prevY;
+        _grid.forEachNear(px, py, x, y, [&](uint16_t gi) {
+            const typename GateGrid<MAX_GATES, MAX_REFS>::Seg &s = _grid.seg(gi);
+            float dx = s.x2 - s.x1, dy = s.y2 - s.y1;
+            float den = cross(mx, my, dx, dy);
+            if (den >= 0.0f) return;                        // parallel, or crossed right to left
+            float qx = s.x1 - px, qy = s.y1 - py;
+            float t = cross(qx, qy, dx, dy) / den;          // along the movement
+            float u = cross(qx, qy, mx, my) / den;          // along the gate
+            if (t <= 0.0f || t > 1.0f || u < 0.0f || u > 1.0f) return;
+            // Keep crossings in time order (insertion sort; there are rarely more than one)
+            int k;
+            if (nh < LAP_MAX_CROSSINGS) k = nh++;
+            else if (hits[nh - 1].frac > t) k = nh - 1;
+            else return;
+            while (k > 0 && hits[k - 1].frac > t) { hits[k] = hits[k - 1]; --k; }
+            hits[k].gate = gi; hits[k].frac = t;
+        });
+        for (int i = 0; i < nh; ++i) {
+            uint32_t tc = _prevMs + (uint32_t)lroundf(hits[i].frac * (float)(tMs - _prevMs));
+            crossed(hits[i].gate, tc);
+        }
+    }
+
+    LapEvent& push(const Gate &g, uint32_t tc) {
+        LapEvent &e = _event[_events < LAP_MAX_CROSSINGS ? _events++ : LAP_MAX_CROSSINGS - 1];
+        e.kind = g.kind; e.id = g.id; e.tMs = tc;
+        e.timeMs = 0; e.deltaMs = 0; e.hasTime = false; e.hasDelta = false;
+        return e;
+    }
+
+    void setDelta(LapEvent &e, int32_t d) {
+        e.deltaMs = d; e.hasDelta = true;
+        _lastDeltaMs = d; _lastDeltaAtMs = e.tMs; _haveDelta = true;
+    }
+
+    void crossed(uint16_t gi, uint32_t tc) {
+        const Gate &g = _grid.gate(gi);
+        LapEvent &e = push(g, tc);
+        switch (g.kind) {
+            case GATE_START_FINISH:
+                if (_lapRunning) {
+                    e.timeMs = tc - _lapStartMs; e.hasTime = true;
+                    _lastLapMs = e.timeMs; _laps++;
+                    if (_bestLapMs) setDelta(e, (int32_t)(e.timeMs - _bestLapMs));
+                    if (!_bestLapMs || e.timeMs < _bestLapMs) {
+                        _bestLapMs = e.timeMs;
+                        memcpy(_bestSplitGate, _splitGate, sizeof(_splitGate));
+                        memcpy(_bestSplitMs, _splitMs, sizeof(_splitMs));
+                        _bestSplits = _splits;
+                    }
+                }
+                _lapRunning = true; _lapStartMs = tc; _splits = 0;
+                break;
+            case GATE_SPLIT:
+                if (!_lapRunning) break;
+                e.timeMs = tc - _lapStartMs; e.hasTime = true;
+                if (_splits < LAP_MAX_SPLITS) {
+                    if (_splits < _bestSplits && _bestSplitGate[_splits] == gi)
+                        setDelta(e, (int32_t)(e.timeMs - _bestSplitMs[_splits]));
+                    _splitGate[_splits] = gi; _splitMs[_splits] = e.timeMs; _splits++;
+                }
+                break;
+            case GATE_SEGMENT_START:
+                if (g.id < MAX_GATES) { _segStartMs[g.id] = tc; _segOpen[g.id] = true; }
+                break;
+            case GATE_SEGMENT_END:
+                if (g.id >= MAX_GATES || !_segOpen[g.id]) break;
+                _segOpen[g.id] = false;
+                e.timeMs = tc - _segStartMs[g.id]; e.hasTime = true;
+                if (_bestSegMs[g.id]) setDelta(e, (int32_t)(e.timeMs - _bestSegMs[g.id]));
+                if (!_bestSegMs[g.id] || e.timeMs < _bestSegMs[g.id]) _bestSegMs[g.id] = e.timeMs;
+                break;
+        }
+    }
+
+    GateGrid<MAX_GATES, MAX_REFS> _grid;
+    float _prevX, _prevY;
+    uint32_t _prevMs;
+    bool _havePrev;
+
+    bool _lapRunning;
+    uint32_t _lapStartMs, _laps, _lastLapMs, _bestLapMs;
+    uint16_t _splitGate[LAP_MAX_SPLITS], _bestSplitGate[LAP_MAX_SPLITS];
+    uint32_t _splitMs[LAP_MAX_SPLITS], _bestSplitMs[LAP_MAX_SPLITS];
+    int _splits, _bestSplits;
+
+    uint32_t _segStartMs[MAX_GATES];
+    bool _segOpen[MAX_GATES];
+    uint32_t _bestSegMs[MAX_GATES];
+
+    LapEvent _event[LAP_MAX_CROSSINGS];
+    int _events;
+    int32_t _lastDeltaMs;
+    uint32_t _lastDeltaAtMs;
+    bool _haveDelta;
+};
+
+} // namespace lap
@@ -0,0 +1,59 @@
+#pragma once
+// Fixed-size latency histogram with power-of-two microsecond buckets.
+// Bucket 0 holds 0-1 us, bucket k holds [2^k, 2^(k+1)) us, and the last bucket catches
+// everything from ~8 s up. Adding a sample is a count-leading-zeros and an increment, so it can
+// sit on the render path. Percentiles are reported as the upper edge of the bucket they fall in,
+// which is within a factor of two by construction; min/max/avg are exact.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+
+namespace perf {
+
+class LatencyHistogram {
+public:
+    static constexpr int BUCKETS = 24;
+
+    void add(uint32_t us) {
+        int b = us ? 31 - __builtin_clz(us) : 0;
+        if (b >= BUCKETS) b = BUCKETS - 1;
+        _buckets[b]++;
+        if (_count == 0 || us < _min) _min = us;
+        if (us > _max) _max = us;
+        _sum += us;
+        _count++;
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    uint32_t count() const { return _count; }
+    uint32_t minUs() const { return _min; }
+    uint32_t maxUs() const { return _max; }
+    uint32_t avgUs() const { return _count ? (uint32_t)(_sum / _count) : 0; }
+    uint32_t bucket(int i) const { return (i >= 0 && i < BUCKETS) ? _buckets[i] : 0; }
+
+    // Upper bound of the bucket holding the p-th percentile (p in 0..100), capped at max
+    uint32_t percentileUs(uint32_t p) const {
+        if (!_count) return 0;
+        uint64_t rank = ((uint64_t)_count * p + 99) / 100;
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += _buckets[i];
+            if (seen >= rank) {
+                uint32_t edge = (i >= 31) ? 0xFFFFFFFFu : ((2u << i) - 1);
+                return edge < _max ? edge : _max;
+            }
+        }
+        return _max;
+    }
+
+private:
+    uint32_t _buckets[BUCKETS] = {0};
+    uint32_t _count = 0;
+    uint32_t _min = 0;
+    uint32_t _max = 0;
+    uint64_t _sum = 0;
+};
+
+} // namespace perf
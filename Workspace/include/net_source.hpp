@@ -0,0 +1,128 @@
+#pragma once
+// NMEA over the network as a ByteSource.
+// Listens on one port for both UDP datagrams and a TCP connection (10110 is the registered
+// NMEA-0183-over-IP port), so phone apps that "send NMEA to host:port" and a bench PC running
+// netcat both work. Bytes are received straight into the caller's buffer: read() is the only
+// copy, the same as for the UART. One TCP client at a time, newest wins; while it is connected
+// UDP datagrams are drained and counted as ignored so two feeds never interleave mid-sentence.
+// Plain BSD sockets (lwIP on the ESP32), so it can be tested on a desktop against
+// `nc localhost 10110 < log.nmea` or a UDP feeder script.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include "byte_source.hpp"
+
+namespace io {
+
+static constexpr uint16_t NMEA_IP_PORT = 10110;
+
+class NetSource : public ByteSource {
+public:
+    struct Stats {
+        uint32_t bytes;        // bytes handed to the parser
+        uint32_t datagrams;    // UDP datagrams accepted
+        uint32_t truncated;    // datagrams that filled the whole read buffer (tail possibly lost)
+        uint32_t ignored;      // datagrams dropped because a TCP client was feeding
+        uint32_t connections;  // TCP clients accepted
+        uint32_t disconnects;  // TCP clients closed or replaced
+    };
+
+    explicit NetSource(uint16_t port = NMEA_IP_PORT) : _port(port), _udp(-1), _listen(-1), _client(-1) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+    ~NetSource() { end(); }
+
+    // Open the UDP socket and the TCP listener; false if neither could be bound
+    bool begin() {
+        end();
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+        _udp = socket(AF_INET, SOCK_DGRAM, 0);
+        if (_udp >= 0 && bind(_udp, (struct sockaddr*)&addr, sizeof(addr)) != 0) closeFd(_udp);
+
+        _listen = socket(AF_INET, SOCK_STREAM, 0);
+        if (_listen >= 0) {
+            int one = 1;
+            setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (bind(_listen, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listen, 1) != 0) closeFd(_listen);
+            else fcntl(_listen, F_SETFL, fcntl(_listen, F_GETFL, 0) | O_NONBLOCK);
+        }
+        return _udp >= 0 || _listen >= 0;
+    }
+
+    void end() {
+        if (_client >= 0) { closeFd(_client); _stats.disconnects++; }
+        closeFd(_udp);
+        closeFd(_listen);
+    }
+
+    size_t read(uint8_t* buf, size_t len) override {
+        if (!len) return 0;
+        acceptPending();
+        if (_client >= 0) {
+            ssize_t n = recv(_client, buf, len, MSG_DONTWAIT);
+            if (n > 0) { _stats.bytes += (uint32_t)n; return (size_t)n; }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) { closeFd(_client); _stats.disconnects++; }
+        }
+        while (_udp >= 0) {
+            ssize_t n = recv(_udp, buf, len, MSG_DONTWAIT);
+            if (n <= 0) break;
+            if (_client >= 0) { _stats.ignored++; continue; }
+            _stats.datagrams++;
+            if ((size_t)n == len) _stats.truncated++;
+            _stats.bytes += (uint32_t)n;
+            return (size_t)n;
+        }
+        return 0;
+    }
+
+    int available() override {
+        acceptPending();
+        return pending(_client) + pending(_udp);
+    }
+
+    bool connected() const { return _client >= 0; }
+    bool listening() const { return _udp >= 0 || _listen >= 0; }
+    uint16_t port() const { return _port; }
+    const Stats& stats() const { return _stats; }
+
+private:
+    static void closeFd(int &fd) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+
+    static int pending(int fd) {
+        int n = 0;
+        if (fd < 0 || ioctl(fd, FIONREAD, &n) != 0) return 0;
+        return n;
+    }
+
+    void acceptPending() {
+        if (_listen < 0) return;
+        int fd = accept(_listen, nullptr, nullptr);
+        if (fd < 0) return;
+        if (_client >= 0) { closeFd(_client); _stats.disconnects++; }
+        _client = fd;
+        _stats.connections++;
+    }
+
+    uint16_t _port;
+    int _udp;
+    int _listen;
+    int _client;
+    Stats _stats;
+};
+
+} // namespace io
@@ -0,0 +1,358 @@
+#pragma once
+// Header-only streaming NMEA 0183 parser shared by the app (gps_module), GPSService and the
+// gps_test sketch.
+//
+// The sentences a parser understands are a compile-time list of policy types:
+//
+//   nmea::Parser<nmea::Gga, nmea::Rmc> parser;
+//   parser.feed(c, sink);            // sink.onSentence(const nmea::Gga&) / (const nmea::Rmc&)
+//
+// Each policy names its 3-letter type as a constexpr id, the fields it subscribes to, and how to
+// convert them into its own staged members. The address field is reduced to that id once and
+// matched by integer compares unrolled over the list, so only the listed handlers are compiled
+// in. Bytes are consumed one at a time, unsubscribed fields are never buffered, and a sentence
+// reaches the sink only after its *hh checksum has been verified.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <string.h>
+#include "sat_table.hpp"
+
+namespace nmea {
+
+static constexpr int MAX_SENTENCE = 96;   // NMEA 0183 caps sentences at 82 chars; allow some slack
+static constexpr int FIELD_MAX = 16;      // longest field converted (dddmm.mmmmmmm)
+
+static constexpr uint32_t fieldBit(int n) { return 1UL << n; }
+
+// Sentence type id from the 3 characters after the talker ("GGA" -> 'G','G','A')
+static constexpr uint32_t typeId(char a, char b, char c) {
+    return ((uint32_t)(uint8_t)a << 16) | ((uint32_t)(uint8_t)b << 8) | (uint8_t)c;
+}
+
+struct Stats {
+    uint32_t sentences;         // accepted (checksum OK)
+    uint32_t checksumErrors;    // bad or missing checksum
+    uint32_t overflows;         // sentence or subscribed field longer than accepted
+    uint32_t unknownSentences;  // well-formed but not in the policy list
+};
+
+// ---------- Field conversion (no atof/atoi) ----------
+
+static inline int toInt(const char* s, int len) {
+    int v = 0;
+    for (int i = 0; i < len && s[i] >= '0' && s[i] <= '9'; ++i) v = v * 10 + (s[i] - '0');
+    return v;
+}
+
+// Accumulate up to 9 significant digits as an integer, then scale once
+static inline float toFloat(const char* s, int len) {
+    static const float POW10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f };
+    int i = 0; bool neg = false;
+    if (i < len && (s[i] == '-' || s[i] == '+')) { neg = (s[i] == '-'); ++i; }
+    int32_t mant = 0; int digits = 0; int frac = -1;
+    for (; i < len; ++i) {
+        char c = s[i];
+        if (c == '.') { if (frac >= 0) break; frac = 0; continue; }
+        if (c < '0' || c > '9') break;
+        if (digits >= 9) continue; // extra fractional precision is below float resolution anyway
+        mant = mant * 10 + (c - '0'); ++digits;
+        if (frac >= 0) ++frac;
+    }
+    float v = (frac > 0) ? mant / POW10[frac] : (float)mant;
+    return neg ? -v : v;
+}
+
+// ddmm.mmmm / dddmm.mmmm -> unsigned 1e-7 degrees, integer-only.
+// Minutes are accumulated in 1e-7 units (max 60e7, fits int32) and divided by 60 once, so the
+// result keeps the receiver's full resolution (5 decimals of minutes ~ 2 cm).
+static inline int32_t toCoordE7(const char* s, int len) {
+    int dot = 0;
+    while (dot < len && s[dot] != '.') ++dot;
+    if (dot < 3) return 0;
+    int32_t deg = toInt(s, dot - 2);
+    int32_t minE7 = ((s[dot - 2] - '0') * 10 + (s[dot - 1] - '0')) * 10000000;
+    int32_t scale = 1000000;
+    for (int i = dot + 1; i < len && scale > 0; ++i) {
+        char c = s[i];
+        if (c < '0' || c > '9') break;
+        minE7 += (c - '0') * scale;
+        scale /= 10;
+    }
+    return deg * 10000000 + (minE7 + 30) / 60;
+}
+
+static inline void copyField(char* dst, size_t dstSize, const char* s, int len) {
+    size_t n = (size_t)len < dstSize - 1 ? (size_t)len : dstSize - 1;
+    memcpy(dst, s, n);
+    dst[n] = '\0';
+}
+
+// ---------- Sentence policies ----------
+// Members are reset before every sentence; 'talker' holds the 2-char talker ("GP", "GN", ...).
+
+struct Sentence {
+    char talker[2];
+};
+
+struct Gga : Sentence {
+    // GGA: time,lat,N,lon,E,fix,sats,hdop,alt,M,geoid,...
+    static constexpr uint32_t ID = typeId('G', 'G', 'A');
+    static constexpr uint32_t FIELDS = fieldBit(2) | fieldBit(3) | fieldBit(4) | fieldBit(5) |
+                                       fieldBit(6) | fieldBit(7) | fieldBit(8) | fieldBit(9);
+    int32_t latE7, lonE7;   // signed 1e-7 degree
+    int fixQuality;
+    int satsUsed;
+    float hdop;
+    float altitude;         // metres MSL
+
+    void field(int idx, const char* f, int n) {
+        switch (idx) {
+            case 2: latE7 = toCoordE7(f, n); break;
+            case 3: if (n > 0 && f[0] == 'S') latE7 = -latE7; break;
+            case 4: lonE7 = toCoordE7(f, n); break;
+            case 5: if (n > 0 && f[0] == 'W') lonE7 = -lonE7; break;
+            case 6: fixQuality = toInt(f, n); break;
+            case 7: satsUsed = toInt(f, n); break;
+            case 8: hdop = toFloat(f, n); break;
+            case 9: altitude = toFloat(f, n); break;
+        }
+    }
+};
+
+struct Rmc : Sentence {
+    // RMC: time,status,lat,N,lon,E,sog,course,date,...
+    static constexpr uint32_t ID = typeId('R', 'M', 'C');
+    static constexpr uint32_t FIELDS = fieldBit(1) | fieldBit(2) | fieldBit(3) | fieldBit(4) | fieldBit(5) |
+                                       fieldBit(6) | fieldBit(7) | fieldBit(8) | fieldBit(9);
+    char timeUTC[10];       // HHMMSS.ss
+    bool active;            // status A
+    int32_t latE7, lonE7;
+    float speedKnots;
+    float courseDeg;
+    char date[8];           // DDMMYY
+
+    void field(int idx, const char* f, int n) {
+        switch (idx) {
+            case 1: copyField(timeUTC, sizeof(timeUTC), f, n); break;
+            case 2: active = (n > 0 && f[0] == 'A'); break;
+            case 3: latE7 = toCoordE7(f, n); break;
+            case 4: if (n > 0 && f[0] == 'S') latE7 = -latE7; break;
+            case 5: lonE7 = toCoordE7(f, n); break;
+            case 6: if (n > 0 && f[0] == 'W') lonE7 = -lonE7; break;
+            case 7: speedKnots = toFloat(f, n); break;
+            case 8: courseDeg = toFloat(f, n); break;
+            case 9: copyField(date, sizeof(date), f, n); break;
+        }
+    }
+};
+
+struct Gsv : Sentence {
+    // GSV: totalMsgs,msgIndex,svInView, then up to 4 x (prn,elevation,azimuth,cn0)[,signalId]
+    static constexpr uint32_t ID = typeId('G', 'S', 'V');
+    static constexpr uint32_t FIELDS = 0x000FFFFEUL;  // fields 1..19: header + 4 satellite groups
+    uint8_t total, index;
+    int inView;
+    uint8_t groups;         // bit k set once satellite group k was seen through its C/N0 field
+    gnss::SatInfo sats[4];
+
+    void field(int idx, const char* f, int n) {
+        if (idx == 1) { total = (uint8_t)toInt(f, n); return; }
+        if (idx == 2) { index = (uint8_t)toInt(f, n); return; }
+        if (idx == 3) { inView = toInt(f, n); return; }
+        int g = (idx - 4) >> 2;
+        gnss::SatInfo &sat = sats[g];
+        switch ((idx - 4) & 3) {
+            case 0: sat.prn = (uint8_t)toInt(f, n); break;
+            case 1: sat.elevation = (int8_t)toInt(f, n); break;
+            case 2: sat.azimuth = (uint16_t)toInt(f, n); break;
+            case 3: sat.cn0 = (uint8_t)toInt(f, n); groups |= (uint8_t)(1u << g); break; // empty = not tracked
+        }
+    }
+
+    // Complete satellite groups only; a trailing NMEA 4.10 signal id looks like a lone PRN field
+    int satellites(gnss::SatInfo* out) const {
+        int n = 0;
+        for (int g = 0; g < 4; ++g) if ((groups & (1u << g)) && sats[g].prn) out[n++] = sats[g];
+        return n;
+    }
+};
+
+struct Gsa : Sentence {
+    // GSA: opMode,fixMode,12 x PRN,pdop,hdop,vdop[,systemId]
+    static constexpr uint32_t ID = typeId('G', 'S', 'A');
+    static constexpr uint32_t FIELDS = fieldBit(2) | fieldBit(15) | fieldBit(16) | fieldBit(17); // PRN list skipped
+    int fixMode;            // 1 = no fix, 2 = 2D, 3 = 3D
+    float pdop, hdop, vdop;
+
+    void field(int idx, const char* f, int n) {
+        switch (idx) {
+            case 2: fixMode = toInt(f, n); break;
+            case 15: pdop = toFloat(f, n); break;
+            case 16: hdop = toFloat(f, n); break;
+            case 17: vdop = toFloat(f, n); break;
+        }
+    }
+};
+
+struct Gst : Sentence {
+    // GST: time,rms,semiMajor,semiMinor,orientation,latErr,lonErr,altErr (1-sigma metres)
+    static constexpr uint32_t ID = typeId('G', 'S', 'T');
+    static constexpr uint32_t FIELDS = fieldBit(6) | fieldBit(7) | fieldBit(8);
+    float latErrM, lonErrM, altErrM;
+
+    void field(int idx, const char* f, int n) {
+        switch (idx) {
+            case 6: latErrM = toFloat(f, n); break;
+            case 7: lonErrM = toFloat(f, n); break;
+            case 8: altErrM = toFloat(f, n); break;
+        }
+    }
+};
+
+struct Vtg : Sentence {
+    // VTG: courseT,T,courseM,M,knots,N,kmh,K[,mode]
+    static constexpr uint32_t ID = typeId('V', 'T', 'G');
+    static constexpr uint32_t FIELDS = fieldBit(1) | fieldBit(7) | fieldBit(9);
+    float courseDeg;
+    float speedKmh;         // VTG carries km/h directly
+    bool valid;
+
+    void field(int idx, const char* f, int n) {
+        switch (idx) {
+            case 1: courseDeg = toFloat(f, n); break;
+            case 7: speedKmh = toFloat(f, n); valid = (n > 0); break;
+            case 9: if (n > 0 && f[0] == 'N') valid = false; break; // NMEA 2.3+: data not valid
+        }
+    }
+};
+
+// ---------- Compile-time dispatch over the policy list ----------
+
+template <class... S> struct Dispatch;
+
+template <> struct Dispatch<> {
+    uint32_t begin(uint32_t, const char*) { return 0; }
+    void field(uint32_t, int, const char*, int) {}
+    template <class Sink> void commit(uint32_t, Sink&) {}
+};
+
+template <class S, class... Rest> struct Dispatch<S, Rest...> {
+    S sentence;
+    Dispatch<Rest...> rest;
+
+    // Field mask for the sentence, 0 if it is not in the list
+    uint32_t begin(uint32_t id, const char* talker) {
+        if (id != S::ID) return rest.begin(id, talker);
+        memset(&sentence, 0, sizeof(sentence));
+        sentence.talker[0] = talker[0]; sentence.talker[1] = talker[1];
+        return S::FIELDS;
+    }
+    void field(uint32_t id, int idx, const char* f, int n) {
+        if (id == S::ID) sentence.field(idx, f, n); else rest.field(id, idx, f, n);
+    }
+    template <class Sink> void commit(uint32_t id, Sink &sink) {
+        if (id == S::ID) sink.onSentence(static_cast<const S&>(sentence)); else rest.commit(id, sink);
+    }
+};
+
+// ---------- Streaming parser ----------
+
+template <class... Sentences>
+class Parser {
+public:
+    // Consume one byte. Returns true when it completed a valid sentence (handed to the sink).
+    template <class Sink>
+    bool feed(char c, Sink &sink) {
+        if (c == '$') { begin(); return false; } // always resynchronise on a new start
+        switch (_state) {
+            case IDLE:
+                return false;
+
+            case FIELD:
+                if (c == '\r' || c == '\n') { _stats.checksumErrors++; _state = IDLE; return false; } // missing *hh
+                if (++_length > MAX_SENTENCE) { _stats.overflows++; _state = IDLE; return false; }
+                if (c == ',' || c == '*') {
+                    if (!fieldEnd()) { _state = IDLE; return false; }
+                    if (c == '*') { _state = CHECKSUM; return false; }
+                    _checksum ^= (uint8_t)c;
+                    _fieldIndex++; _fieldLen = 0;
+                    return false;
+                }
+                _checksum ^= (uint8_t)c;
+                if (subscribed(_fieldIndex)) {
+                    if (_fieldLen >= FIELD_MAX) { _stats.overflows++; _state = IDLE; return false; }
+                    _field[_fieldLen++] = c;
+                }
+                return false;
+
+            case CHECKSUM: {
+                uint8_t v = hexNibble(c);
+                if (v == 0xFF) { _stats.checksumErrors++; _state = IDLE; return false; }
+                _expected = (uint8_t)((_expected << 4) | v);
+                if (++_csDigits < 2) return false;
+                _state = IDLE;
+                if (_expected != _checksum) { _stats.checksumErrors++; return false; }
+                _stats.sentences++;
+                _dispatch.commit(_type, sink);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const Stats& stats() const { return _stats; }
+    void reset() { _state = IDLE; _stats = Stats(); }
+
+private:
+    enum State : uint8_t { IDLE, FIELD, CHECKSUM };
+
+    void begin() {
+        _state = FIELD;
+        _type = 0;
+        _checksum = 0; _expected = 0; _csDigits = 0;
+        _fieldIndex = 0; _fieldLen = 0; _length = 0;
+        _fieldMask = fieldBit(0);
+    }
+
+    bool subscribed(int idx) const { return idx < 32 && (_fieldMask & fieldBit(idx)); }
+
+    // Returns false if the sentence should be dropped
+    bool fieldEnd() {
+        if (_fieldIndex == 0) {
+            // Address: 2-char talker + 3-char type ("GPGGA", "GNRMC", ...)
+            uint32_t mask = 0;
+            if (_fieldLen == 5) {
+                _type = typeId(_field[2], _field[3], _field[4]);
+                mask = _dispatch.begin(_type, _field);
+            }
+            if (!mask) { _stats.unknownSentences++; return false; }
+            _fieldMask = mask;
+            return true;
+        }
+        if (subscribed(_fieldIndex)) _dispatch.field(_type, _fieldIndex, _field, _fieldLen);
+        return true;
+    }
+
+    static uint8_t hexNibble(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return 0xFF;
+    }
+
+    Dispatch<Sentences...> _dispatch;
+    Stats _stats = Stats();
+    State _state = IDLE;
+    uint32_t _type = 0;
+    uint32_t _fieldMask = 0;
+    uint8_t _checksum = 0;   // running XOR of bytes between '$' and '*'
+    uint8_t _expected = 0;   // value of the *hh suffix
+    uint8_t _csDigits = 0;
+    uint8_t _fieldIndex = 0;
+    uint8_t _fieldLen = 0;
+    uint8_t _length = 0;     // bytes since '$'
+    char _field[FIELD_MAX];
+};
+
+} // namespace nmea
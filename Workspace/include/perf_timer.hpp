@@ -0,0 +1,432 @@
+#pragma once
+// Acceleration and braking timer: 0-60 mph, 0-100 km/h, quarter mile (ET and trap speed) and
+// 100-0 km/h, from every speed epoch the receiver reports.
+// The timer arms after PERF_ARM_MS below PERF_LAUNCH_KMH and starts on the first sample above
+// it. The moment of launch is not that sample but where speed left zero. Acceleration takes a
+// moment to build up (clutch, traction control), so a straight line through the first moving
+// samples reaches zero about half of that build-up late. Instead the samples from
+// PERF_LAUNCH_BACK_MS before the last one at or below PERF_STILL_KMH up to PERF_FIT_SAMPLES
+// moving ones (or PERF_FIT_MAX_KMH) are fitted, least squares, with standing, then acceleration
+// rising linearly over up to PERF_FIT_MAX_BUILDUP_MS, then constant; the launch is where that
+// model leaves zero. With Doppler noise the build-up is only loosely determined, so the launch
+// still wanders by a few tens of ms (test/test_perf_timer); at 0.15 km/h of noise a 0.3 s
+// build-up spans only three samples and the launch is good to about +-50 ms, not better.
+// Between samples speed is taken as linear, so a distance is crossed where its integral (a
+// quadratic) does, rather than up to a whole sample late. A speed threshold is placed a few
+// samples later, where a least-squares line through the PERF_CROSS_SAMPLES around it meets it:
+// between two noisy samples alone it would move by noise / acceleration.
+// Braking is timed from the interpolated 100 km/h crossing on the way down to the extrapolated
+// stop, whether or not a run is in progress. Every sample of the latest run is kept, 4 bytes
+// each, for export.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+namespace perf {
+
+static constexpr float PERF_LAUNCH_KMH = 3.0f;       // deadband: below is standing, above is launch
+static constexpr float PERF_STILL_KMH = 0.5f;        // at or below is not moving yet (Doppler noise)
+static constexpr int PERF_HISTORY = 16;              // samples kept before a launch to find first motion
+static constexpr uint32_t PERF_LAUNCH_BACK_MS = 250; // how far before the last still sample motion may start
+static constexpr uint32_t PERF_ARM_MS = 1000;        // standing this long arms the timer
+static constexpr uint32_t PERF_MAX_GAP_MS = 400;     // a longer hole between samples ends the run
+static constexpr uint32_t PERF_MAX_RUN_MS = 60000;   // and so does a run this long
+static constexpr uint32_t PERF_DUP_MS = 20;          // closer samples are the same epoch (RMC + VTG)
+static constexpr float PERF_MPH60_KMH = 96.56064f;
+static constexpr float PERF_KMH100 = 100.0f;
+static constexpr float PERF_QUARTER_M = 402.336f;
+static constexpr float PERF_BRAKE_FROM_KMH = 100.0f;
+static constexpr float PERF_BRAKE_REACCEL_KMH = 2.0f; // speeding up this much abandons a stop
+static constexpr int PERF_FIT_SAMPLES = 11;           // moving samples the launch is fitted to
+static constexpr float PERF_FIT_MAX_KMH = 25.0f;      // and below this speed: before drag and the first shift
+static constexpr float PERF_FIT_MAX_BUILDUP_MS = 500.0f;
+static constexpr float PERF_FIT_STEP_MS = 2.0f;       // launch time resolution of the fit
+static constexpr float PERF_FIT_BUILDUP_STEP_MS = 20.0f;
+static constexpr float PERF_FIT_NOISE_KMH = 0.15f;    // speed noise the fit allows for
+static constexpr int PERF_CROSS_SAMPLES = 6;          // a speed threshold is placed on a line through this many
+
+enum PerfState : uint8_t {
+    PERF_WAITING,   // moving, or not standing long enough yet
+    PERF_ARMED,     // standing: the next move starts a run
+    PERF_RUNNING
+};
+
+// update() reports what happened on that sample as a set of these bits
+enum PerfEvent : uint32_t {
+    PERF_EV_ARMED   = 1u << 0,
+    PERF_EV_LAUNCH  = 1u << 1,
+    PERF_EV_60MPH   = 1u << 2,
+    PERF_EV_100KMH  = 1u << 3,
+    PERF_EV_QUARTER = 1u << 4,
+    PERF_EV_END     = 1u << 5,   // the run is over (see RunResult::gap for why)
+    PERF_EV_BRAKE   = 1u << 6    // a 100-0 stop completed
+};
+
+struct RunResult {
+    uint32_t mph60Ms;        // times from launch, 0 = not reached
+    uint32_t kmh100Ms;
+    uint32_t quarterMs;
+    float quarterTrapKmh;    // speed at the quarter-mile line
+    float maxKmh;
+    float distanceM;
+    uint32_t durationMs;     // launch to the last sample of the run
+    bool gap;                // ended by missing samples or the time limit, not by stopping
+};
+
+struct BrakeResult {
+    uint32_t timeMs;
+    float distanceM;
+};
+
+// One logged sample: time since the first logged sample (standing, before the launch) and speed
+struct Sample {
+    uint16_t tMs;
+    uint16_t speedCkmh;      // 0.01 km/h
+};
+
+template <int MAX_SAMPLES>
+class PerfTimer {
+public:
+    PerfTimer() { reset(); }
+
+    void reset() {
+        memset(&_run, 0, sizeof(_run));
+        memset(&_brake, 0, sizeof(_brake));
+        _state = PERF_WAITING;
+        _have = false;
+        _standSince = 0;
+        _braking = false;
+        _haveBrake = false;
+        _runs = _brakes = 0;
+        _logCount = 0;
+        _logDropped = 0;
+        _launchOffsetMs = 0.0f;
+        _histN = 0;
+        _recN = 0;
+        _crossWait[0] = _crossWait[1] = -1;
+    }
+
+    // Feed one speed epoch: its time (ms, any monotonic clock; receiver time is best) and the
+    // ungated speed. Returns PerfEvent bits.
+    uint32_t update(uint32_t tMs, float kmh) {
+        if (kmh < 0.0f) kmh = 0.0f;
+        if (!_have) { setPrev(tMs, kmh); _standSince = tMs; return 0; }
+        uint32_t dtMs = tMs - _prevMs;
+        if (dtMs < PERF_DUP_MS) return 0;
+        uint32_t ev = 0;
+        bool gap = dtMs > PERF_MAX_GAP_MS;
+        float dt = (float)dtMs;
+
+        ev |= brakeStep(dt, kmh, gap);
+
+        if (_state == PERF_RUNNING) {
+            ev |= runStep(tMs, dt, kmh, gap);
+        } else if (kmh < PERF_LAUNCH_KMH) {
+            if (_prevKmh >= PERF_LAUNCH_KMH || gap) _standSince = tMs;
+            if (_state == PERF_WAITING && tMs - _standSince >= PERF_ARM_MS) { _state = PERF_ARMED; ev |= PERF_EV_ARMED; }
+        } else if (_state == PERF_ARMED && !gap) {
+            launch(tMs, kmh);
+            ev |= PERF_EV_LAUNCH;
+        } else {
+            _state = PERF_WAITING;
+        }
+        setPrev(tMs, kmh);
+        return ev;
+    }
+
+    PerfState state() const { return _state; }
+    // The run in progress, or the latest one
+    const RunResult& run() const { return _run; }
+    uint32_t runs() const { return _runs; }
+    // Time from launch to the latest sample while running
+    uint32_t elapsedMs() const { return _state == PERF_RUNNING ? (uint32_t)(_prevMs - _runAnchorMs + 0.5f - _launchOffsetMs) : _run.durationMs; }
+    uint32_t lastSampleMs() const { return _prevMs; }
+    float speedKmh() const { return _prevKmh; }
+
+    bool braking() const { return _braking; }
+    bool haveBrake() const { return _haveBrake; }
+    const BrakeResult& brake() const { return _brake; }
+    uint32_t brakes() const { return _brakes; }
+
+    // Sample log of the latest run; the launch is launchOffsetMs() after the first sample
+    int logCount() const { return _logCount; }
+    const Sample& logSample(int i) const { return _log[i]; }
+    uint32_t logDropped() const { return _logDropped; }
+    float launchOffsetMs() const { return _launchOffsetMs; }
+
+private:
+    void setPrev(uint32_t tMs, float kmh) {
+        _prevMs = tMs; _prevKmh = kmh; _have = true;
+        if (_state == PERF_RUNNING) return;
+        if (_histN == PERF_HISTORY) { memmove(_histT, _histT + 1, sizeof(_histT) - sizeof(_histT[0])); memmove(_histV, _histV + 1, sizeof(_histV) - sizeof(_histV[0])); _histN--; }
+        _histT[_histN] = tMs; _histV[_histN] = kmh; _histN++;
+    }
+
+    void logSampleAt(uint32_t tMs, float kmh) {
+        uint32_t rel = tMs - _runAnchorMs;
+        if (_logCount >= MAX_SAMPLES || rel > 0xFFFF) { _logDropped++; return; }
+        float c = kmh * 100.0f + 0.5f;
+        _log[_logCount].tMs = (uint16_t)rel;
+        _log[_logCount].speedCkmh = (uint16_t)(c > 65535.0f ? 65535.0f : c);
+        _logCount++;
+    }
+
+    void launch(uint32_t tMs, float kmh) {
+        memset(&_run, 0, sizeof(_run));
+        _state = PERF_RUNNING;
+        _runs++;
+        // Back to the last still sample (the one before the launch sample if none is)
+        int z = _histN - 1;
+        while (z > 0 && _histV[z] > PERF_STILL_KMH) --z;
+        if (_histV[z] > PERF_STILL_KMH) z = _histN - 1;
+        // That sample may already be creeping, so times inside the run are float ms from one
+        // PERF_LAUNCH_BACK_MS earlier, and the launch may be placed anywhere after it
+        int a = z;
+        while (a > 0 && _histT[z] - _histT[a] < PERF_LAUNCH_BACK_MS) --a;
+        _runAnchorMs = _histT[a];
+        _logCount = 0;
+        _logDropped = 0;
+        for (int i = a; i < _histN; ++i) logSampleAt(_histT[i], _histV[i]);
+        logSampleAt(tMs, kmh);
+        _launchOffsetMs = (float)(_histT[z] - _runAnchorMs);   // for the live clock until the fit places it
+        _distM = 0.0f;
+        _run.maxKmh = kmh;
+        _launchFixed = false;
+        _recN = 0;
+        _crossWait[0] = _crossWait[1] = -1;
+        _pendN = 0;
+        _pendStill = z - a + 1;
+        // Replay the samples from the anchor up to the launch one
+        for (int i = a; i < _histN; ++i) advance(_histT[i], _histV[i], i > 0 ? (float)(_histT[i] - _histT[i - 1]) : 0.0f, i > 0 ? _histV[i - 1] : 0.0f);
+        advance(tMs, kmh, (float)(tMs - _prevMs), _prevKmh);
+    }
+
+    // Advance the run over [prev, now]; speed is linear in between
+    uint32_t runStep(uint32_t tMs, float dt, float kmh, bool gap) {
+        if (gap) return endRun(true);
+        logSampleAt(tMs, kmh);
+        uint32_t ev = advance(tMs, kmh, dt, _prevKmh);
+        if (kmh > _run.maxKmh) _run.maxKmh = kmh;
+        _run.durationMs = (uint32_t)((float)(tMs - _runAnchorMs) - _launchOffsetMs + 0.5f);
+        if (kmh < PERF_LAUNCH_KMH) { ev |= endRun(false); _standSince = tMs; }
+        else if (_run.durationMs > PERF_MAX_RUN_MS) ev |= endRun(true);
+        return ev;
+    }
+
+    uint32_t advance(uint32_t tMs, float kmh, float dt, float prevKmh) {
+        uint32_t ev = 0;
+        float tc = (float)(tMs - _runAnchorMs);
+        if (_launchFixed) return sampleSegment(tc - dt, prevKmh, tc, kmh);
+        _pendT[_pendN] = tc; _pendV[_pendN] = kmh;
+        int moving = ++_pendN - _pendStill;
+        if (moving < 2 || (moving < PERF_FIT_SAMPLES && kmh < PERF_FIT_MAX_KMH)) return 0;
+        float t0 = fitLaunch();
+        _launchOffsetMs = t0;
+        _launchFixed = true;
+        int k = 0;
+        while (k < _pendN - 1 && _pendT[k] <= t0) ++k;
+        for (int i = 0; i < k; ++i) pushRecent(_pendT[i], _pendV[i]);
+        ev |= sampleSegment(t0, 0.0f, _pendT[k], _pendV[k]);
+        for (++k; k < _pendN; ++k) ev |= sampleSegment(_pendT[k - 1], _pendV[k - 1], _pendT[k], _pendV[k]);
+        return ev;
+    }
+
+    void pushRecent(float t, float kmh) {
+        if (_recN == PERF_CROSS_SAMPLES) { memmove(_recT, _recT + 1, sizeof(_recT) - sizeof(_recT[0])); memmove(_recV, _recV + 1, sizeof(_recV) - sizeof(_recV[0])); _recN--; }
+        _recT[_recN] = t; _recV[_recN] = kmh; _recN++;
+    }
+
+    // The interval up to a new sample: settle crossings waiting for it, then look for new ones
+    uint32_t sampleSegment(float ta, float va, float tb, float vb) {
+        pushRecent(tb, vb);
+        uint32_t ev = settleCrossings(false);
+        return ev | segment(ta, va, tb, vb);
+    }
+
+    // Speed per unit acceleration 'tl' ms after a launch whose acceleration builds up over 'r' ms
+    static float buildUp(float tl, float r) {
+        if (tl <= 0.0f) return 0.0f;
+        return tl < r ? tl * tl / (2.0f * r) : tl - 0.5f * r;
+    }
+
+    // Launch time (ms from the run anchor) from the pending samples, searched between the anchor
+    // and the first moving sample. For each candidate launch and build-up the best acceleration is
+    // closed-form, leaving a sum of squares; the candidates are averaged weighted by how likely
+    // that residual is under PERF_FIT_NOISE_KMH of noise. A build-up shorter than the sample
+    // interval fits a range of launch times equally well, and the average lands in its middle
+    // where the best single fit would land at an end chosen by the noise.
+    float fitLaunch() const {
+        float hi = _pendT[_pendStill];
+        float svv = 0.0f;
+        for (int i = 0; i < _pendN; ++i) svv += _pendV[i] * _pendV[i];
+        const float k = 0.5f / (PERF_FIT_NOISE_KMH * PERF_FIT_NOISE_KMH);
+        float bestRes = 0.0f, sumW = 0.0f, sumWT = 0.0f;
+        for (float r = 0.0f; r <= PERF_FIT_MAX_BUILDUP_MS; r += PERF_FIT_BUILDUP_STEP_MS) {
+            for (float t0 = 0.0f; t0 <= hi; t0 += PERF_FIT_STEP_MS) {
+                float sff = 0.0f, sfv = 0.0f;
+                for (int i = 0; i < _pendN; ++i) {
+                    float f = buildUp(_pendT[i] - t0, r);
+                    sff += f * f;
+                    sfv += f * _pendV[i];
+                }
+                if (sff <= 0.0f || sfv <= 0.0f) continue;
+                float res = svv - sfv * sfv / sff;
+                // Weights are relative to the best residual so far, rescaled when it improves
+                if (sumW == 0.0f || res < bestRes) {
+                    float scale = sumW == 0.0f ? 0.0f : expf(-(bestRes - res) * k);
+                    sumW *= scale; sumWT *= scale;
+                    bestRes = res;
+                }
+                float w = expf(-(res - bestRes) * k);
+                sumW += w;
+                sumWT += w * t0;
+            }
+        }
+        return sumW > 0.0f ? sumWT / sumW : hi;
+    }
+
+    // One linear-speed interval of a run (times in ms from the run anchor)
+    uint32_t segment(float ta, float va, float tb, float vb) {
+        uint32_t ev = 0;
+        float dt = tb - ta;
+        if (dt <= 0.0f) return 0;
+        for (int i = 0; i < 2; ++i) {
+            if (_crossWait[i] >= 0 || *crossResult(i) || !(va < crossTarget(i) && vb >= crossTarget(i))) continue;
+            _crossTa[i] = ta; _crossTb[i] = tb;
+            _crossWait[i] = PERF_CROSS_SAMPLES / 2 - 1;
+        }
+        float a = va / 3600.0f, b = vb / 3600.0f;     // m/ms
+        float segM = 0.5f * (a + b) * dt;
+        if (!_run.quarterMs && _distM + segM >= PERF_QUARTER_M) {
+            // d(tau) = a tau + k tau^2 / 2 with k = (b - a) / dt; solve d = remaining
+            float rem = PERF_QUARTER_M - _distM, k = (b - a) / dt, tau;
+            if (fabsf(k) < 1e-9f) tau = a > 0.0f ? rem / a : dt;
+            else tau = (-a + sqrtf(a * a + 2.0f * k * rem)) / k;
+            if (tau < 0.0f) tau = 0.0f;
+            if (tau > dt) tau = dt;
+            _run.quarterMs = msFromLaunch(ta + tau);
+            _run.quarterTrapKmh = va + (vb - va) * tau / dt;
+            ev |= PERF_EV_QUARTER;
+        }
+        _distM += segM;
+        _run.distanceM = _distM;
+        return ev;
+    }
+
+    static float crossTarget(int i) { return i ? PERF_KMH100 : PERF_MPH60_KMH; }
+    uint32_t* crossResult(int i) { return i ? &_run.kmh100Ms : &_run.mph60Ms; }
+
+    // Place the thresholds crossed PERF_CROSS_SAMPLES / 2 - 1 samples ago on the line through the
+    // latest samples; it may put them up to one interval outside the two samples either side, no
+    // further. 'force' places any still waiting with the samples there are (the run is ending).
+    uint32_t settleCrossings(bool force) {
+        uint32_t ev = 0;
+        for (int i = 0; i < 2; ++i) {
+            if (_crossWait[i] < 0 || (--_crossWait[i] > 0 && !force)) continue;
+            _crossWait[i] = -1;
+            float target = crossTarget(i), ta = _crossTa[i], tb = _crossTb[i];
+            float mt = 0.0f, mv = 0.0f;
+            for (int k = 0; k < _recN; ++k) { mt += _recT[k]; mv += _recV[k]; }
+            mt /= _recN; mv /= _recN;
+            float stv = 0.0f, stt = 0.0f;
+            for (int k = 0; k < _recN; ++k) { stv += (_recT[k] - mt) * (_recV[k] - mv); stt += (_recT[k] - mt) * (_recT[k] - mt); }
+            float t = stv > 0.0f ? mt + (target - mv) * stt / stv : 0.5f * (ta + tb);
+            float span = tb - ta;
+            if (t < ta - span) t = ta - span;
+            if (t > tb + span) t = tb + span;
+            uint32_t ms = msFromLaunch(t);
+            *crossResult(i) = ms ? ms : 1;   // 0 means "not reached"
+            ev |= i ? PERF_EV_100KMH : PERF_EV_60MPH;
+        }
+        return ev;
+    }
+
+    uint32_t msFromLaunch(float t) const {
+        float ms = t - _launchOffsetMs;
+        return ms <= 0.0f ? 0 : (uint32_t)(ms + 0.5f);
+    }
+
+    uint32_t endRun(bool gap) {
+        uint32_t ev = _state == PERF_RUNNING ? settleCrossings(true) : 0;
+        _run.gap = gap;
+        _state = PERF_WAITING;
+        return ev | PERF_EV_END;
+    }
+
+    // 100-0: from the downward crossing of PERF_BRAKE_FROM_KMH to the extrapolated stop
+    uint32_t brakeStep(float dt, float kmh, bool gap) {
+        float vp = _prevKmh;
+        if (_braking) {
+            if (gap || kmh > _brakeMinKmh + PERF_BRAKE_REACCEL_KMH) { _braking = false; return 0; }
+            if (kmh < _brakeMinKmh) _brakeMinKmh = kmh;
+            if (kmh >= PERF_LAUNCH_KMH) {
+                _brakeT += dt;
+                _brakeM += 0.5f * (vp + kmh) / 3600.0f * dt;
+                _brakeSlope = (vp - kmh) / dt;
+                return 0;
+            }
+            // Stopped. A sample still rolling puts zero on the line through it; one already
+            // standing says nothing about when the car stopped, so carry on the last deceleration.
+            float tz = dt;
+            if (kmh > PERF_STILL_KMH && vp > kmh) tz = vp / (vp - kmh) * dt;
+            else if (_brakeSlope > 0.0f) tz = vp / _brakeSlope;
+            float maxT = kmh > PERF_STILL_KMH ? dt * (PERF_LAUNCH_KMH / PERF_STILL_KMH + 1.0f) : dt;
+            if (tz > maxT) tz = maxT;
+            _brakeT += tz;
+            _brakeM += 0.5f * vp / 3600.0f * tz;
+            _brake.timeMs = (uint32_t)(_brakeT + 0.5f);
+            _brake.distanceM = _brakeM;
+            _braking = false;
+            _haveBrake = true;
+            _brakes++;
+            return PERF_EV_BRAKE;
+        }
+        if (!gap && vp >= PERF_BRAKE_FROM_KMH && kmh < PERF_BRAKE_FROM_KMH) {
+            float tb = (vp - PERF_BRAKE_FROM_KMH) / (vp - kmh) * dt;
+            _brakeT = dt - tb;
+            _brakeM = 0.5f * (PERF_BRAKE_FROM_KMH + kmh) / 3600.0f * _brakeT;
+            _brakeMinKmh = kmh;
+            _brakeSlope = (vp - kmh) / dt;
+            _braking = true;
+        }
+        return 0;
+    }
+
+    PerfState _state;
+    bool _have;
+    uint32_t _prevMs;
+    float _prevKmh;
+    uint32_t _standSince;
+    uint32_t _runs;
+    // Run in progress
+    RunResult _run;
+    uint32_t _runAnchorMs;
+    float _pendT[PERF_HISTORY + PERF_FIT_SAMPLES];   // samples until the launch is placed:
+    float _pendV[PERF_HISTORY + PERF_FIT_SAMPLES];   // the still ones, then the moving ones
+    int _pendN, _pendStill;
+    float _launchOffsetMs;
+    bool _launchFixed;
+    float _recT[PERF_CROSS_SAMPLES], _recV[PERF_CROSS_SAMPLES];   // the latest samples of the run
+    int _recN;
+    float _crossTa[2], _crossTb[2];   // 60 mph, 100 km/h: the samples either side of a crossing
+    int8_t _crossWait[2];             // samples still to come before it is placed, -1 = none pending
+    // Before a launch
+    uint32_t _histT[PERF_HISTORY];
+    float _histV[PERF_HISTORY];
+    int _histN;
+    float _distM;
+    // Braking
+    bool _braking, _haveBrake;
+    float _brakeT, _brakeM, _brakeMinKmh;
+    float _brakeSlope;       // km/h per ms over the last interval
+    BrakeResult _brake;
+    uint32_t _brakes;
+    // Sample log
+    Sample _log[MAX_SAMPLES];
+    int _logCount;
+    uint32_t _logDropped;
+};
+
+} // namespace perf
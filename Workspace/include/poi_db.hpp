@@ -0,0 +1,248 @@
+#pragma once
+// Read-only POI table (speed cameras, speed-limit zones) queried in place.
+// The image (tools/build_poi_image.py) is a 32-byte header and fixed 16-byte records sorted by a
+// 32-bit geohash: longitude and latitude quantised to 16 bits each and bit-interleaved, longitude
+// first, which is the binary form of a 6-7 character geohash. A point's neighbourhood is then a
+// handful of contiguous key ranges: the query picks the geohash level whose cells are at least
+// the search radius, and binary-searches the 3x3 cells around the fix. A cell holding more than
+// POI_MAX_SCAN records (a city centre) is split into its four sub-cells, keeping only those that
+// reach the search circle, until each fits the cap; only at the finest level is a scan cut short,
+// and the query reports that. The cost follows the density around the fix, not the table size.
+// Records are only ever read through a const pointer, so the table can stay in memory-mapped
+// flash. Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "geo_utils.hpp"
+#include "track_codec.hpp"   // crc32, the same one zlib.crc32 computes in the build tool
+
+namespace poi {
+
+enum PoiType : uint8_t { POI_CAMERA = 1, POI_ZONE = 2 };
+
+// On-flash record, little-endian, 16 bytes
+struct Record {
+    int32_t latE7;
+    int32_t lonE7;
+    uint32_t key;        // geohash of the position
+    uint8_t type;        // PoiType
+    uint8_t limitKmh;    // 0 = none
+    uint8_t radius10m;   // camera: alert distance; zone: radius (10 m units, 0 = default)
+    uint8_t heading2;    // enforced direction of travel in 2-degree steps, 0xFF = any
+};
+static_assert(sizeof(Record) == 16, "POI record layout is fixed by the image format");
+
+struct Header {
+    char magic[4];       // "POI1"
+    uint32_t version;    // 1
+    uint32_t count;
+    uint32_t recordSize; // 16
+    uint32_t crc;        // CRC-32 of the records
+    uint32_t created;    // unix time of the build
+    uint32_t reserved[2];
+};
+static_assert(sizeof(Header) == 32, "POI header layout is fixed by the image format");
+
+static constexpr uint32_t POI_VERSION = 1;
+static constexpr int POI_MAX_SCAN = 48;           // records examined per cell before splitting it
+static constexpr float POI_DEFAULT_RADIUS_M = 400.0f;
+static constexpr float POI_QUERY_RADIUS_M = 1000.0f;  // largest record radius the tool accepts
+static constexpr float POI_HEADING_TOL_DEG = 45.0f;
+static constexpr float POI_AHEAD_TOL_DEG = 60.0f;
+
+// Longitude/latitude quantised to 16 bits each
+static inline uint32_t quantLat(int32_t latE7) {
+    int64_t v = ((int64_t)latE7 + 900000000LL) * 65536 / 1800000000LL;
+    return (uint32_t)(v < 0 ? 0 : (v > 65535 ? 65535 : v));
+}
+static inline uint32_t quantLon(int32_t lonE7) {
+    int64_t v = ((int64_t)lonE7 + 1800000000LL) * 65536 / 3600000000LL;
+    return (uint32_t)(v < 0 ? 0 : (v > 65535 ? 65535 : v));
+}
+
+// Interleave 16 longitude and 16 latitude bits, longitude first (geohash bit order)
+static inline uint32_t interleave(uint32_t qlon, uint32_t qlat) {
+    uint32_t key = 0;
+    for (int b = 15; b >= 0; --b) key = (key << 2) | (((qlon >> b) & 1) << 1) | ((qlat >> b) & 1);
+    return key;
+}
+
+static inline uint32_t geohashKey(int32_t latE7, int32_t lonE7) { return interleave(quantLon(lonE7), quantLat(latE7)); }
+
+// Image validation: header, size and (optionally, it reads the whole table) the CRC
+static inline bool checkImage(const uint8_t* base, size_t size, bool checkCrc) {
+    if (!base || size < sizeof(Header)) return false;
+    Header h;
+    memcpy(&h, base, sizeof(h));
+    if (memcmp(h.magic, "POI1", 4) != 0 || h.version != POI_VERSION || h.recordSize != sizeof(Record)) return false;
+    if ((uint64_t)h.count * sizeof(Record) > size - sizeof(Header)) return false;
+    return !checkCrc || track::crc32(base + sizeof(Header), (size_t)h.count * sizeof(Record)) == h.crc;
+}
+
+// One hit of a proximity query
+struct Hit {
+    uint32_t index;
+    float distM;
+    float bearingDeg;    // from the query point
+};
+
+class PoiDb {
+public:
+    PoiDb() : _rec(nullptr), _count(0) {}
+
+    // Point at a validated image (see checkImage); the memory must stay mapped
+    void attach(const uint8_t* base) {
+        Header h;
+        memcpy(&h, base, sizeof(h));
+        _rec = reinterpret_cast<const Record*>(base + sizeof(Header));
+        _count = h.count;
+    }
+
+    uint32_t count() const { return _count; }
+    const Record& record(uint32_t i) const { return _rec[i]; }
+
+    // Up to 'maxHits' records within radiusM, nearest first. Returns the number found.
+    // 'truncated' (optional) is set when a finest-level cell held more than POI_MAX_SCAN records,
+    // so some were not examined.
+    int query(int32_t latE7, int32_t lonE7, float radiusM, Hit* hits, int maxHits, bool* truncated = nullptr) const {
+        if (truncated) *truncated = false;
+        if (!_count || maxHits <= 0) return 0;
+        geo::LocalFrame f;
+        f.setOrigin(latE7, lonE7);
+        // Coarsest level whose cells are still at least radiusM on both axes
+        double cosLat = f.kEast / f.kNorth;
+        int bits = 16;
+        while (bits > 1) {
+            double latCell = 180.0 / (1u << bits) * geo::METERS_PER_DEG;
+            double lonCell = 360.0 / (1u << bits) * geo::METERS_PER_DEG * cosLat;
+            if (latCell >= radiusM && lonCell >= radiusM) break;
+            --bits;
+        }
+        int shift = 16 - bits;
+        int32_t cLat = (int32_t)(quantLat(latE7) >> shift), cLon = (int32_t)(quantLon(lonE7) >> shift);
+        int32_t cells = 1 << bits;
+        int n = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+            int32_t y = cLat + dy;
+            if (y < 0 || y >= cells) continue;
+            for (int dx = -1; dx <= 1; ++dx) {
+                int32_t x = (cLon + dx + cells) % cells;   // longitude wraps
+                cell((uint32_t)x, (uint32_t)y, shift, f, radiusM, hits, maxHits, n, truncated);
+            }
+        }
+        return n;
+    }
+
+private:
+    uint32_t lowerBound(uint32_t key) const {
+        uint32_t lo = 0, hi = _count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (_rec[mid].key < key) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    // Quantised cell (x, y) of 2^shift units a side: scan it, or its sub-cells if it is too full
+    void cell(uint32_t x, uint32_t y, int shift, const geo::LocalFrame &f, float radiusM, Hit* hits, int maxHits,
+              int &n, bool* truncated) const {
+        if (!reaches(x, y, shift, f, radiusM)) return;
+        uint32_t lo = interleave(x << shift, y << shift);
+        uint64_t hi = (uint64_t)lo + (1ULL << (2 * shift));
+        uint32_t i = lowerBound(lo);
+        if (i + (uint32_t)POI_MAX_SCAN < _count && _rec[i + POI_MAX_SCAN].key < hi) {
+            if (shift > 0) {
+                for (uint32_t k = 0; k < 4; ++k)
+                    cell(2 * x + (k & 1), 2 * y + (k >> 1), shift - 1, f, radiusM, hits, maxHits, n, truncated);
+                return;
+            }
+            if (truncated) *truncated = true;
+        }
+        scan(i, hi, f, radiusM, hits, maxHits, n);
+    }
+
+    // Whether any of the cell lies within radiusM of the frame origin
+    static bool reaches(uint32_t x, uint32_t y, int shift, const geo::LocalFrame &f, float radiusM) {
+        int64_t lat0 = (int64_t)(y << shift) * 1800000000LL / 65536 - 900000000LL;
+        int64_t lat1 = (int64_t)((y + 1) << shift) * 1800000000LL / 65536 - 900000000LL;
+        int64_t lon0 = (int64_t)(x << shift) * 3600000000LL / 65536 - 1800000000LL;
+        int64_t lon1 = (int64_t)((x + 1) << shift) * 3600000000LL / 65536 - 1800000000LL;
+        int64_t qLat = f.originLatE7, qLon = f.originLonE7;
+        // The query's longitude moved into the cell's 360-degree span (the 3x3 neighbourhood wraps)
+        if (qLon < lon0 - 1800000000LL) qLon += 3600000000LL;
+        else if (qLon >= lon0 + 1800000000LL) qLon -= 3600000000LL;
+        float dn = (float)(qLat < lat0 ? lat0 - qLat : (qLat >= lat1 ? qLat - lat1 : 0)) * f.kNorth;
+        float de = (float)(qLon < lon0 ? lon0 - qLon : (qLon >= lon1 ? qLon - lon1 : 0)) * f.kEast;
+        return de * de + dn * dn <= radiusM * radiusM;
+    }
+
+    void scan(uint32_t i, uint64_t hi, const geo::LocalFrame &f, float radiusM, Hit* hits, int maxHits, int &n) const {
+        for (int k = 0; k < POI_MAX_SCAN && i < _count && _rec[i].key < hi; ++k, ++i) {
+            const Record &r = _rec[i];
+            float e, nn;
+            f.toEnu(r.latE7, r.lonE7, e, nn);
+            float d = sqrtf(e * e + nn * nn);
+            if (d > radiusM) continue;
+            // Insert by distance, dropping the farthest when full
+            int at;
+            if (n < maxHits) at = n++;
+            else if (hits[n - 1].distM > d) at = n - 1;
+            else continue;
+            while (at > 0 && hits[at - 1].distM > d) { hits[at] = hits[at - 1]; --at; }
+            float b = atan2f(e, nn) * (180.0f / (float)M_PI);
+            hits[at].index = i;
+            hits[at].distM = d;
+            hits[at].bearingDeg = b < 0.0f ? b + 360.0f : b;
+        }
+    }
+
+    const Record* _rec;
+    uint32_t _count;
+};
+
+// What the gauge shows for one fix
+struct Alert {
+    bool camera;          // a camera ahead within its alert distance
+    float cameraDistM;
+    uint8_t cameraLimitKmh;
+    uint8_t zoneLimitKmh; // limit of the zone(s) we are in, 0 = none
+    uint8_t limitKmh;     // the limit that applies now: zone, or an imminent camera's
+    bool overspeed;       // speed above limitKmh + tolerance
+};
+
+static inline float angleDiff(float a, float b) {
+    float d = fabsf(a - b);
+    while (d > 360.0f) d -= 360.0f;
+    return d > 180.0f ? 360.0f - d : d;
+}
+
+// Turn the hits around a fix into an alert. Cameras count only when ahead of the course and,
+// if they have a direction, when we travel that way; zones count when we are inside them.
+static inline Alert evaluate(const PoiDb &db, const Hit* hits, int n, float speedKmh, float courseDeg, bool courseValid, float toleranceKmh) {
+    Alert a;
+    memset(&a, 0, sizeof(a));
+    for (int i = 0; i < n; ++i) {
+        const Record &r = db.record(hits[i].index);
+        float radius = r.radius10m ? r.radius10m * 10.0f : POI_DEFAULT_RADIUS_M;
+        if (hits[i].distM > radius) continue;
+        if (r.type == POI_ZONE) {
+            if (r.limitKmh && (!a.zoneLimitKmh || r.limitKmh < a.zoneLimitKmh)) a.zoneLimitKmh = r.limitKmh;
+        } else if (r.type == POI_CAMERA && !a.camera) {
+            if (courseValid) {
+                if (r.heading2 != 0xFF && angleDiff(courseDeg, r.heading2 * 2.0f) > POI_HEADING_TOL_DEG) continue;
+                if (hits[i].distM > 30.0f && angleDiff(courseDeg, hits[i].bearingDeg) > POI_AHEAD_TOL_DEG) continue;
+            }
+            a.camera = true;
+            a.cameraDistM = hits[i].distM;
+            a.cameraLimitKmh = r.limitKmh;
+        }
+    }
+    a.limitKmh = a.zoneLimitKmh;
+    if (a.camera && a.cameraLimitKmh && (!a.limitKmh || a.cameraLimitKmh < a.limitKmh)) a.limitKmh = a.cameraLimitKmh;
+    a.overspeed = a.limitKmh && speedKmh > a.limitKmh + toleranceKmh;
+    return a;
+}
+
+} // namespace poi
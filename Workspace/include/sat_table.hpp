@@ -0,0 +1,143 @@
+#pragma once
+// Per-satellite table assembled from NMEA GSV message cycles.
+// Each constellation (talker GP/GL/GA/GB...) reports its satellites in a cycle of 1..n GSV
+// messages; receivers that send one combined cycle use the GN talker, kept as its own system. Messages are collected per constellation; when the last one of a cycle arrives the
+// published snapshot is rebuilt in the back buffer (other constellations carried over) and the
+// buffers are flipped, so readers always see a complete, consistent set. Fixed capacity, no heap.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <string.h>
+
+namespace gnss {
+
+// SYS_COMBINED: a GN cycle, satellites of several constellations under one talker
+enum System : uint8_t { SYS_GPS, SYS_GLONASS, SYS_GALILEO, SYS_BEIDOU, SYS_QZSS, SYS_COMBINED, SYS_OTHER, SYS_COUNT };
+
+// Map a 2-char NMEA talker to a constellation
+static inline System systemFromTalker(char a, char b) {
+    if (a == 'G') {
+        switch (b) {
+            case 'P': return SYS_GPS;
+            case 'L': return SYS_GLONASS;
+            case 'A': return SYS_GALILEO;
+            case 'B': return SYS_BEIDOU;
+            case 'Q': return SYS_QZSS;
+            case 'N': return SYS_COMBINED;
+        }
+    }
+    if (a == 'B' && b == 'D') return SYS_BEIDOU;
+    if (a == 'Q' && b == 'Z') return SYS_QZSS;
+    return SYS_OTHER;
+}
+
+static inline const char* systemName(uint8_t s) {
+    static const char* NAMES[SYS_COUNT] = { "GPS", "GLO", "GAL", "BDS", "QZS", "GNS", "OTH" };
+    return s < SYS_COUNT ? NAMES[s] : "?";
+}
+
+struct SatInfo {
+    uint8_t system;     // gnss::System
+    uint8_t prn;
+    int8_t elevation;   // degrees, 0..90
+    uint8_t cn0;        // dB-Hz, 0 = not tracked
+    uint16_t azimuth;   // degrees, 0..359
+};
+
+static constexpr int SAT_TABLE_CAPACITY = 48;   // all constellations together
+static constexpr int SATS_PER_CYCLE = 16;       // per constellation (4 GSV messages)
+
+struct SatSnapshot {
+    SatInfo sats[SAT_TABLE_CAPACITY];
+    uint8_t count = 0;
+    uint8_t inView[SYS_COUNT] = {0};            // as reported by each constellation's GSV
+    uint32_t cycles = 0;                        // completed cycles (any constellation)
+
+    int totalInView() const {
+        int n = 0;
+        for (int i = 0; i < SYS_COUNT; ++i) n += inView[i];
+        return n;
+    }
+
+    // Mean C/N0 over tracked satellites (cn0 > 0), 0 if none
+    int averageCn0() const {
+        int sum = 0, n = 0;
+        for (int i = 0; i < count; ++i) if (sats[i].cn0) { sum += sats[i].cn0; ++n; }
+        return n ? (sum + n / 2) / n : 0;
+    }
+
+    // Strongest 'n' C/N0 values in descending order; returns how many were written
+    int topCn0(uint8_t* out, int n) const {
+        int filled = 0;
+        for (int i = 0; i < count; ++i) {
+            uint8_t v = sats[i].cn0;
+            if (!v || (filled == n && v <= out[n - 1])) continue;
+            int pos = (filled < n) ? filled++ : n - 1; // when full, replace the weakest
+            while (pos > 0 && out[pos - 1] < v) { out[pos] = out[pos - 1]; --pos; }
+            out[pos] = v;
+        }
+        return filled;
+    }
+
+    // Mean of the strongest 'n' (the usual "top-N C/N0" signal quality figure)
+    int topCn0Average(int n) const {
+        uint8_t top[8];
+        if (n > 8) n = 8;
+        int k = topCn0(top, n);
+        int sum = 0;
+        for (int i = 0; i < k; ++i) sum += top[i];
+        return k ? (sum + k / 2) / k : 0;
+    }
+};
+
+class SatTable {
+public:
+    // Add one decoded GSV message. 'sats' holds the complete satellite groups it carried.
+    // Returns true when this message completed a cycle and a new snapshot was published.
+    bool addMessage(System sys, uint8_t total, uint8_t index, uint8_t inView, const SatInfo* sats, int n) {
+        Cycle &c = _cycles[sys];
+        if (index == 1) { c.count = 0; c.next = 1; c.total = total; }
+        if (index != c.next || total != c.total || total == 0) { c.next = 0; return false; } // lost a message
+        for (int i = 0; i < n && c.count < SATS_PER_CYCLE; ++i) {
+            c.sats[c.count] = sats[i];
+            c.sats[c.count].system = sys;
+            c.count++;
+        }
+        c.inView = inView;
+        if (++c.next <= total) return false;
+        c.next = 0;
+        publish(sys, c);
+        return true;
+    }
+
+    const SatSnapshot& snapshot() const { return _buf[_front]; }
+
+private:
+    struct Cycle {
+        SatInfo sats[SATS_PER_CYCLE];
+        uint8_t count = 0;
+        uint8_t total = 0;
+        uint8_t next = 0;      // expected message index, 0 = waiting for a cycle start
+        uint8_t inView = 0;
+    };
+
+    void publish(System sys, const Cycle &c) {
+        const SatSnapshot &front = _buf[_front];
+        SatSnapshot &back = _buf[_front ^ 1];
+        back.count = 0;
+        for (int i = 0; i < front.count; ++i) {
+            if (front.sats[i].system != sys) back.sats[back.count++] = front.sats[i];
+        }
+        for (int i = 0; i < c.count && back.count < SAT_TABLE_CAPACITY; ++i) back.sats[back.count++] = c.sats[i];
+        memcpy(back.inView, front.inView, sizeof(back.inView));
+        back.inView[sys] = c.inView;
+        back.cycles = front.cycles + 1;
+        _front ^= 1;
+    }
+
+    Cycle _cycles[SYS_COUNT];
+    SatSnapshot _buf[2];
+    uint8_t _front = 0;
+};
+
+} // namespace gnss
@@ -0,0 +1,91 @@
+#pragma once
+// Picks which of several GNSS data sources feeds the app.
+// Every source is parsed all the time; the parsers report each sentence (noteData) and each fix
+// status (noteFix) here, and select() decides which one GPSData follows. A source scores by what
+// it has delivered recently: nothing, data without a fix, or a fix of a given quality. The
+// active source is replaced at once when it goes stale or loses its fix; a source that is merely
+// better must stay better for ARBITER_HOLD_MS so two similar feeds don't flap. On a tie the
+// active source stays; source 0 is active at start, so put the local receiver there.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+
+namespace gnss {
+
+static constexpr int ARBITER_MAX_SOURCES = 2;
+static constexpr uint32_t ARBITER_STALE_MS = 2500;  // no sentence / fix for this long -> stale
+static constexpr uint32_t ARBITER_HOLD_MS = 3000;   // a better source must stay better this long
+
+class SourceArbiter {
+public:
+    SourceArbiter() { reset(); }
+
+    void reset() {
+        for (int i = 0; i < ARBITER_MAX_SOURCES; ++i) _src[i] = Health();
+        _active = 0; _candidate = -1; _candidateSinceMs = 0; _switches = 0;
+    }
+
+    // A checksum-valid sentence/frame arrived from 'src'
+    void noteData(int src, uint32_t nowMs) {
+        if (src < 0 || src >= ARBITER_MAX_SOURCES) return;
+        _src[src].lastDataMs = nowMs; _src[src].seen = true;
+    }
+
+    // 'src' reported its fix status: 0 = no fix, otherwise the GGA quality scale
+    void noteFix(int src, uint8_t quality, uint32_t nowMs) {
+        if (src < 0 || src >= ARBITER_MAX_SOURCES) return;
+        _src[src].quality = quality;
+        if (quality) { _src[src].lastFixMs = nowMs; _src[src].hadFix = true; }
+    }
+
+    // Re-evaluate and return the source GPSData should follow
+    int select(uint32_t nowMs) {
+        int best = _active, bestScore = score(_active, nowMs);
+        for (int i = 0; i < ARBITER_MAX_SOURCES; ++i) {
+            int s = score(i, nowMs);
+            if (s > bestScore) { best = i; bestScore = s; }
+        }
+        if (best == _active) { _candidate = -1; return _active; }
+        // Take over at once from a source without a fix; otherwise only after the hold time
+        bool now = score(_active, nowMs) <= SCORE_DATA;
+        if (!now) {
+            if (_candidate != best) { _candidate = best; _candidateSinceMs = nowMs; }
+            now = nowMs - _candidateSinceMs >= ARBITER_HOLD_MS;
+        }
+        if (now) { _active = best; _candidate = -1; _switches++; }
+        return _active;
+    }
+
+    int active() const { return _active; }
+    uint32_t switches() const { return _switches; }
+    uint8_t quality(int src) const { return valid(src) ? _src[src].quality : 0; }
+    uint32_t lastDataMs(int src) const { return valid(src) ? _src[src].lastDataMs : 0; }
+
+private:
+    enum { SCORE_NONE = 0, SCORE_DATA = 1, SCORE_FIX = 2 };
+
+    struct Health {
+        uint32_t lastDataMs = 0, lastFixMs = 0;
+        uint8_t quality = 0;
+        bool seen = false, hadFix = false;
+    };
+
+    static bool valid(int src) { return src >= 0 && src < ARBITER_MAX_SOURCES; }
+
+    // 0 = silent/stale, 1 = data without a fix, 2.. = fix: estimated < GPS < DGPS/RTK
+    int score(int src, uint32_t nowMs) const {
+        const Health &h = _src[src];
+        if (!h.seen || nowMs - h.lastDataMs > ARBITER_STALE_MS) return SCORE_NONE;
+        if (!h.hadFix || !h.quality || nowMs - h.lastFixMs > ARBITER_STALE_MS) return SCORE_DATA;
+        if (h.quality == 6) return SCORE_FIX;             // dead reckoning: any real fix beats it
+        return SCORE_FIX + (h.quality == 1 ? 1 : 2);      // GPS < DGPS/RTK
+    }
+
+    Health _src[ARBITER_MAX_SOURCES];
+    int _active;
+    int _candidate;
+    uint32_t _candidateSinceMs;
+    uint32_t _switches;
+};
+
+} // namespace gnss
@@ -0,0 +1,160 @@
+#pragma once
+// Constant-acceleration Kalman filter on ground velocity, for a needle that moves smoothly
+// between GNSS fixes instead of stepping once per epoch.
+// Speed and course are resolved into east/north velocity; each axis carries [velocity,
+// acceleration] with its own 2x2 covariance (the axes are independent under this model, so two
+// 2-state filters replace one 4-state one). speedKmhAt() extrapolates the last estimate to any
+// millis() timestamp, bounded so a lost receiver cannot run the needle away. Speeds inside
+// GATE_SIGMA x the filter's own velocity uncertainty read as zero, which replaces a fixed
+// deadband when the receiver reports its speed accuracy (UBX sAcc). An accuracy estimated from
+// HDOP (NMEA) is far too optimistic for a parked receiver, so then the 1.8 km/h deadband stays as
+// the floor. About 60 bytes of state, no heap. Pure C++ (no Arduino dependency) so it also
+// builds on the host.
+
+#include <stdint.h>
+#include <math.h>
+
+namespace nav {
+
+static constexpr float GATE_SIGMA = 2.0f;         // zero-speed gate in filter standard deviations
+static constexpr float MIN_GATE_KMH = 0.3f;       // below the receivers' speed resolution
+static constexpr float DEFAULT_SACC_KMH = 1.0f;   // measurement noise when none is reported
+static constexpr float ESTIMATED_GATE_KMH = 1.8f; // gate floor when the accuracy is estimated or unknown
+static constexpr float MAX_GATE_KMH = 5.0f;       // poor geometry must not swallow walking pace
+static constexpr float SACC_KMH_PER_HDOP = 0.36f; // NMEA estimate: ~0.1 m/s 1-sigma per unit HDOP
+static constexpr float MAX_GAP_S = 5.0f;          // longer without a fix restarts the filter
+static constexpr float MAX_EXTRAPOLATE_S = 2.0f;  // never predict further ahead than this
+
+// Zero-speed gate for one raw receiver report: 'sigma' x its speed accuracy, bounded. 'measured'
+// says the receiver reported sAcc itself; a HDOP-derived or missing one keeps the fixed deadband.
+static inline float speedGateKmh(float sigma, float sAccKmh, bool measured) {
+    float floor = measured && sAccKmh > 0.0f ? MIN_GATE_KMH : ESTIMATED_GATE_KMH;
+    float g = sigma * sAccKmh;
+    if (g < floor) g = floor;
+    return g > MAX_GATE_KMH ? MAX_GATE_KMH : g;
+}
+
+class SpeedFilter {
+public:
+    // jerk: process noise as jerk spectral density (m^2/s^5). Higher follows hard acceleration
+    // changes faster, lower smooths more. 2 suits road vehicles.
+    explicit SpeedFilter(float jerk = 2.0f) : _q(jerk) { reset(); }
+
+    void reset() {
+        _e = Axis(); _n = Axis();
+        _tMs = 0; _epoch = 0; _intervalS = 1.0f; _valid = false;
+        _gateFloor = ESTIMATED_GATE_KMH;
+    }
+
+    // Feed one receiver solution. tMs is when it was decoded (millis()), speed is ungated, sAcc
+    // is its 1-sigma accuracy (0 = unknown) and 'measured' says the receiver reported it rather
+    // than it being estimated from HDOP. 'epoch' identifies the fix the report belongs to (0 =
+    // unknown): RMC and VTG repeat the same solution a few ms apart, and taking both would
+    // count one measurement twice. Samples must arrive in time order.
+    void update(uint32_t tMs, float speedKmh, float courseDeg, float sAccKmh, bool measured, uint32_t epoch = 0) {
+        if (_valid && epoch && epoch == _epoch) return; // another report of the same fix
+        _epoch = epoch;
+        float v = speedKmh / 3.6f;
+        float c = courseDeg * (float)(M_PI / 180.0);
+        float zE = v * sinf(c), zN = v * cosf(c);
+        measured = measured && sAccKmh > 0.0f;
+        _gateFloor = measured ? MIN_GATE_KMH : ESTIMATED_GATE_KMH;
+        // An estimate is no better than the default noise: it only scales with geometry
+        if (!measured && sAccKmh < DEFAULT_SACC_KMH) sAccKmh = DEFAULT_SACC_KMH;
+        float sAcc = sAccKmh / 3.6f;
+        float r = sAcc * sAcc;
+        float dt = (tMs - _tMs) * 0.001f;
+        if (!_valid || dt > MAX_GAP_S) {
+            _e.init(zE, r); _n.init(zN, r);
+            _tMs = tMs; _valid = true;
+            return;
+        }
+        if (dt <= 0.0f) return; // out of order
+        _e.predict(dt, _q); _n.predict(dt, _q);
+        _e.correct(zE, r); _n.correct(zN, r);
+        _intervalS += 0.25f * (dt - _intervalS); // smoothed fix interval bounds extrapolation
+        _tMs = tMs;
+    }
+
+    // Predicted ground speed at tMs (km/h), zero inside the noise gate
+    float speedKmhAt(uint32_t tMs) const {
+        if (!_valid) return 0.0f;
+        float dt = horizon(tMs);
+        float vE = _e.v + _e.a * dt, vN = _n.v + _n.a * dt;
+        float speed = sqrtf(vE * vE + vN * vN) * 3.6f;
+        return speed < gateKmh(dt) ? 0.0f : speed;
+    }
+
+    // Filtered speed at the last fix (km/h), ungated
+    float speedKmh() const { return sqrtf(_e.v * _e.v + _n.v * _n.v) * 3.6f; }
+
+    // Along-track acceleration estimate (m/s^2), positive when speeding up
+    float accelMs2() const {
+        float v = sqrtf(_e.v * _e.v + _n.v * _n.v);
+        return v > 0.1f ? (_e.v * _e.a + _n.v * _n.a) / v : 0.0f;
+    }
+
+    // Zero-speed gate from the filter's velocity uncertainty (km/h), dt seconds after the last fix:
+    // extrapolating on a noisy acceleration estimate widens it, or a parked needle would twitch
+    float gateKmh(float dt = 0.0f) const {
+        float p = 0.5f * (_e.predictedP00(dt) + _n.predictedP00(dt));
+        float g = GATE_SIGMA * sqrtf(p) * 3.6f;
+        return g < _gateFloor ? _gateFloor : g;
+    }
+
+    bool valid() const { return _valid; }
+    uint32_t lastUpdateMs() const { return _tMs; }
+
+private:
+    // One axis: state [v, a], symmetric covariance [[p00, p01], [p01, p11]]
+    struct Axis {
+        float v = 0.0f, a = 0.0f;
+        float p00 = 0.0f, p01 = 0.0f, p11 = 0.0f;
+
+        void init(float z, float r) {
+            v = z; a = 0.0f;
+            p00 = r; p01 = 0.0f; p11 = 4.0f; // +-2 m/s^2 until the second fix
+        }
+
+        // x = F x, P = F P F' + Q with F = [[1, dt], [0, 1]] and the white-jerk Q
+        void predict(float dt, float q) {
+            float dt2 = dt * dt, dt3 = dt2 * dt;
+            v += a * dt;
+            p00 += dt * (2.0f * p01 + dt * p11) + q * dt3 / 3.0f;
+            p01 += dt * p11 + q * dt2 / 2.0f;
+            p11 += q * dt;
+        }
+
+        // Velocity variance extrapolated dt ahead on the current acceleration (no process noise)
+        float predictedP00(float dt) const { return p00 + dt * (2.0f * p01 + dt * p11); }
+
+        // Scalar velocity measurement, H = [1, 0]
+        void correct(float z, float r) {
+            float s = p00 + r;
+            float k0 = p00 / s, k1 = p01 / s;
+            float y = z - v;
+            v += k0 * y; a += k1 * y;
+            p11 -= k1 * p01;
+            p01 -= k1 * p00;
+            p00 -= k0 * p00;
+        }
+    };
+
+    float horizon(uint32_t tMs) const {
+        float dt = (int32_t)(tMs - _tMs) * 0.001f;
+        if (dt < 0.0f) return 0.0f;
+        float limit = 1.5f * _intervalS;
+        if (limit > MAX_EXTRAPOLATE_S) limit = MAX_EXTRAPOLATE_S;
+        return dt < limit ? dt : limit;
+    }
+
+    Axis _e, _n;
+    float _q;
+    float _intervalS;
+    float _gateFloor;
+    uint32_t _tMs;
+    uint32_t _epoch;
+    bool _valid;
+};
+
+} // namespace nav
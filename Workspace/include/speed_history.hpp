@@ -0,0 +1,203 @@
+#pragma once
+// Rolling speed/altitude history over the last hours in a few KB: a min/max/avg pyramid.
+// Level 0 keeps one bucket per second, and each level above folds RATIO buckets of the one below
+// into one, so with N buckets per level the history reaches N * RATIO^(LEVELS-1) seconds back.
+// Every level is a ring indexed by time slot (slot index % N), and each bucket remembers its slot,
+// so gaps in the fix simply leave stale buckets that are skipped on the way out. A level is only
+// touched when the one below closes a bucket, so an update costs O(1) amortised (O(LEVELS) worst
+// case). A graph of any span reads the finest level that covers it, which holds at most N buckets
+// in the span, so drawing W columns costs O(N + W) however many samples went in.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+namespace nav {
+
+static constexpr int16_t HIST_NO_ALT = INT16_MIN;     // bucket has no altitude
+static constexpr uint32_t HIST_EMPTY = 0xFFFFFFFFu;   // slot never written
+
+// One closed bucket: speed in 0.01 km/h, altitude in whole metres
+struct HistBucket {
+    uint32_t slot;       // time slot it covers (seconds / level period)
+    uint16_t vMin, vMax, vAvg;
+    int16_t aMin, aMax, aAvg;
+};
+static_assert(sizeof(HistBucket) == 16, "history bucket is meant to stay 16 bytes");
+
+// One graph column
+struct HistColumn {
+    bool valid;          // any speed in the column
+    bool altValid;       // any altitude in the column
+    float vMin, vMax, vAvg;
+    float aMin, aMax, aAvg;
+};
+
+template<int N, int LEVELS, int RATIO>
+class SpeedHistory {
+public:
+    SpeedHistory() { clear(); }
+
+    void clear() {
+        for (int l = 0; l < LEVELS; ++l) {
+            for (int i = 0; i < N; ++i) _ring[l][i].slot = HIST_EMPTY;
+            _acc[l].open = false;
+        }
+        _haveLast = false;
+        _samples = 0;
+    }
+
+    // Seconds of history one level covers
+    static uint32_t period(int level) { uint32_t p = 1; for (int l = 0; l < level; ++l) p *= RATIO; return p; }
+    static uint32_t levelSpan(int level) { return period(level) * N; }
+    static uint32_t maxSpan() { return levelSpan(LEVELS - 1); }
+
+    // Add one sample taken at second 'sec' (any monotonic clock). Time going backwards restarts.
+    void add(uint32_t sec, float kmh, float altM, bool altValid) {
+        if (_haveLast && sec < _lastSec) clear();
+        _haveLast = true;
+        _lastSec = sec;
+        _samples++;
+        Acc &a = _acc[0];
+        if (a.open && a.slot != sec) close(0);
+        if (!a.open) start(a, sec);
+        float v = kmh < 0.0f ? 0.0f : kmh;
+        if (v < a.vMin) a.vMin = v;
+        if (v > a.vMax) a.vMax = v;
+        a.vSum += v; a.n++;
+        if (altValid) {
+            if (altM < a.aMin) a.aMin = altM;
+            if (altM > a.aMax) a.aMax = altM;
+            a.aSum += altM; a.an++;
+        }
+    }
+
+    uint32_t samples() const { return _samples; }
+    bool empty() const { return !_haveLast; }
+    uint32_t lastSec() const { return _lastSec; }
+
+    // Finest level whose ring covers 'spanSec' (the coarsest if none does)
+    static int levelFor(uint32_t spanSec) {
+        for (int l = 0; l < LEVELS; ++l) if (levelSpan(l) >= spanSec) return l;
+        return LEVELS - 1;
+    }
+
+    // Fill 'cols' columns covering the 'spanSec' seconds up to and including 'nowSec', oldest
+    // first. Returns the level read.
+    int query(uint32_t nowSec, uint32_t spanSec, HistColumn* out, int cols) const {
+        if (cols <= 0) return 0;
+        int level = levelFor(spanSec);
+        if (spanSec > levelSpan(level)) spanSec = levelSpan(level);
+        if (spanSec < (uint32_t)cols) spanSec = (uint32_t)cols;
+        uint32_t p = period(level);
+        // t0..nowSec inclusive; a clock younger than the span starts at zero
+        uint32_t t0 = nowSec + 1 >= spanSec ? nowSec + 1 - spanSec : 0;
+        Acc cur;
+        bool haveCur = current(level, cur);
+        for (int c = 0; c < cols; ++c) {
+            HistColumn &col = out[c];
+            col.valid = col.altValid = false;
+            uint32_t cs = t0 + (uint32_t)((uint64_t)spanSec * c / cols);
+            uint32_t ce = t0 + (uint32_t)((uint64_t)spanSec * (c + 1) / cols);
+            if (ce <= cs) ce = cs + 1;
+            float vSum = 0.0f, aSum = 0.0f; int vn = 0, an = 0;
+            for (uint32_t s = cs / p; s <= (ce - 1) / p; ++s) {
+                HistBucket b;
+                if (haveCur && s == cur.slot) toBucket(cur, b);
+                else { b = _ring[level][s % N]; if (b.slot != s) continue; }
+                merge(col, b, vSum, vn, aSum, an);
+            }
+            if (vn) col.vAvg = vSum / vn;
+            if (an) col.aAvg = aSum / an;
+        }
+        return level;
+    }
+
+private:
+    // Open bucket being accumulated (exact sums; rounded only when closed)
+    struct Acc {
+        bool open;
+        uint32_t slot;
+        float vMin, vMax, vSum;
+        uint32_t n;
+        float aMin, aMax, aSum;
+        uint32_t an;
+    };
+
+    static void start(Acc &a, uint32_t slot) {
+        a.open = true; a.slot = slot;
+        a.vMin = 1e9f; a.vMax = -1e9f; a.vSum = 0.0f; a.n = 0;
+        a.aMin = 1e9f; a.aMax = -1e9f; a.aSum = 0.0f; a.an = 0;
+    }
+
+    // Fold a child's sums into its parent
+    static void fold(Acc &p, const Acc &a) {
+        if (a.n) {
+            if (a.vMin < p.vMin) p.vMin = a.vMin;
+            if (a.vMax > p.vMax) p.vMax = a.vMax;
+            p.vSum += a.vSum; p.n += a.n;
+        }
+        if (a.an) {
+            if (a.aMin < p.aMin) p.aMin = a.aMin;
+            if (a.aMax > p.aMax) p.aMax = a.aMax;
+            p.aSum += a.aSum; p.an += a.an;
+        }
+    }
+
+    // Write the open bucket of 'level' to its ring and pass it up
+    void close(int level) {
+        Acc &a = _acc[level];
+        toBucket(a, _ring[level][a.slot % N]);
+        a.open = false;
+        if (level + 1 >= LEVELS) return;
+        Acc &p = _acc[level + 1];
+        uint32_t ps = a.slot / RATIO;
+        if (p.open && p.slot != ps) close(level + 1);
+        if (!p.open) start(p, ps);
+        fold(p, a);
+    }
+
+    // The still-open bucket of 'level' including what the open buckets below it hold
+    bool current(int level, Acc &out) const {
+        if (!_acc[0].open) return false;
+        uint32_t slot = _acc[0].slot / period(level);
+        // After a gap this level may still hold an older slot; it reaches the ring on its next close
+        if (_acc[level].open && _acc[level].slot == slot) out = _acc[level];
+        else start(out, slot);
+        for (int l = level - 1; l >= 0; --l)
+            if (_acc[l].open && _acc[l].slot / period(level - l) == out.slot) fold(out, _acc[l]);
+        return out.n > 0;
+    }
+
+    static uint16_t toCkmh(float v) { float c = v * 100.0f + 0.5f; return c > 65535.0f ? 65535 : (uint16_t)c; }
+    static int16_t toAlt(float m) { float r = roundf(m); return r < -32767.0f ? -32767 : (r > 32767.0f ? 32767 : (int16_t)r); }
+
+    static void toBucket(const Acc &a, HistBucket &b) {
+        b.slot = a.slot;
+        if (a.n) { b.vMin = toCkmh(a.vMin); b.vMax = toCkmh(a.vMax); b.vAvg = toCkmh(a.vSum / a.n); }
+        else b.vMin = b.vMax = b.vAvg = 0;
+        if (a.an) { b.aMin = toAlt(a.aMin); b.aMax = toAlt(a.aMax); b.aAvg = toAlt(a.aSum / a.an); }
+        else b.aMin = b.aMax = b.aAvg = HIST_NO_ALT;
+    }
+
+    // Column statistics: min of minima, max of maxima, mean of the bucket averages
+    static void merge(HistColumn &col, const HistBucket &b, float &vSum, int &vn, float &aSum, int &an) {
+        float vMin = b.vMin * 0.01f, vMax = b.vMax * 0.01f;
+        if (!col.valid) { col.vMin = vMin; col.vMax = vMax; col.valid = true; }
+        else { if (vMin < col.vMin) col.vMin = vMin; if (vMax > col.vMax) col.vMax = vMax; }
+        vSum += b.vAvg * 0.01f; vn++;
+        if (b.aAvg == HIST_NO_ALT) return;
+        if (!col.altValid) { col.aMin = b.aMin; col.aMax = b.aMax; col.altValid = true; }
+        else { if (b.aMin < col.aMin) col.aMin = b.aMin; if (b.aMax > col.aMax) col.aMax = b.aMax; }
+        aSum += b.aAvg; an++;
+    }
+
+    HistBucket _ring[LEVELS][N];
+    Acc _acc[LEVELS];
+    uint32_t _lastSec;
+    bool _haveLast;
+    uint32_t _samples;
+};
+
+} // namespace nav
@@ -0,0 +1,377 @@
+#pragma once
+// Store-and-forward upload of the recorded tracks to an HTTP endpoint.
+// The track files are already compressed (track_codec batches, 5-8 bytes a fix), so a request
+// body is simply the next run of whole batches from the upload cursor (file, offset), up to the
+// buffer size, sent as-is: the server can decode it with the same codec, and (file, offset) in
+// the headers lets it drop a repeat. Uploads happen in sessions: bring the radio up, send
+// everything pending over one keep-alive connection, drop the radio. A session is only started
+// once enough has piled up (or it has waited long enough), failures back off exponentially, and
+// the cursor only moves on a 2xx, so nothing is lost to a dropped link or a reboot.
+// The store (where the files are) and the transport (radio + socket) are interfaces, so the same
+// code runs on the device and against a local stub server on the host.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "track_codec.hpp"
+
+namespace telemetry {
+
+struct Cursor {
+    uint32_t file;
+    uint32_t offset;
+};
+
+// Exponential backoff with +-25% jitter; 'rnd' is any 32-bit random value
+class Backoff {
+public:
+    Backoff(uint32_t baseMs, uint32_t maxMs) : _base(baseMs), _max(maxMs), _failures(0), _until(0) {}
+
+    bool ready(uint32_t nowMs) const { return !_failures || (int32_t)(nowMs - _until) >= 0; }
+    void succeed() { _failures = 0; }
+    uint32_t fail(uint32_t nowMs, uint32_t rnd) {
+        uint32_t d = _base;
+        for (uint32_t i = 0; i < _failures && d < _max; ++i) d *= 2;
+        if (d > _max) d = _max;
+        d = d - d / 4 + (uint32_t)((uint64_t)(d / 2) * (rnd & 0xFFFF) / 0xFFFF);
+        _failures++;
+        _until = nowMs + d;
+        return d;
+    }
+    uint32_t failures() const { return _failures; }
+
+private:
+    uint32_t _base, _max, _failures, _until;
+};
+
+// Length of the whole, CRC-valid track batches at the start of p[0..n). Stops at a batch that is
+// not all there yet. When p starts with something that is not a valid batch (a torn write from a
+// power cut, a corrupt batch), returns 0 and sets 'skip' to the bytes to step over.
+static inline size_t wholeBatches(const uint8_t* p, size_t n, size_t &skip) {
+    size_t used = 0;
+    skip = 0;
+    while (n - used >= track::BATCH_HEADER) {
+        track::BatchHeader h;
+        const uint8_t* b = p + used;
+        if (!h.parse(b)) {
+            if (used) return used;
+            // Resynchronise on the next magic
+            size_t k = 1;
+            while (k + 1 < n && !(p[k] == track::BATCH_MAGIC0 && p[k + 1] == track::BATCH_MAGIC1)) ++k;
+            skip = k;
+            return 0;
+        }
+        size_t len = track::BATCH_HEADER + h.payload;
+        if (len > n - used) return used;
+        if (!h.check(b + track::BATCH_HEADER)) {
+            if (used) return used;
+            skip = len;
+            return 0;
+        }
+        used += len;
+    }
+    return used;
+}
+
+// "http://host[:port]/path" split up. Plain HTTP only: no TLS stack is linked, so point it at a
+// trusted network or a TLS-terminating proxy.
+struct Url {
+    char host[64];
+    uint16_t port;
+    char path[96];
+
+    bool parse(const char* url) {
+        if (strncmp(url, "http://", 7) != 0) return false;
+        const char* h = url + 7;
+        const char* slash = strchr(h, '/');
+        const char* colon = strchr(h, ':');
+        if (colon && slash && colon > slash) colon = nullptr;
+        size_t hl = (size_t)((colon ? colon : (slash ? slash : h + strlen(h))) - h);
+        if (!hl || hl >= sizeof(host)) return false;
+        memcpy(host, h, hl);
+        host[hl] = 0;
+        port = 80;
+        if (colon) { long p = strtol(colon + 1, nullptr, 10); if (p <= 0 || p > 65535) return false; port = (uint16_t)p; }
+        const char* path0 = slash ? slash : "/";
+        if (strlen(path0) >= sizeof(path)) return false;
+        strcpy(path, path0);
+        return true;
+    }
+};
+
+// Request head for one upload; 'trip' is an optional "key=value;..." line of trip totals
+static inline int formatRequest(char* out, size_t n, const Url &u, const char* deviceId, const Cursor &c, size_t bodyLen, const char* trip) {
+    return snprintf(out, n,
+                    "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/octet-stream\r\nContent-Length: %u\r\n"
+                    "X-Device: %s\r\nX-Track-File: %u\r\nX-Track-Offset: %u\r\n%s%s%sConnection: keep-alive\r\n\r\n",
+                    u.path, u.host, (unsigned)bodyLen, deviceId, (unsigned)c.file, (unsigned)c.offset,
+                    trip && *trip ? "X-Trip: " : "", trip && *trip ? trip : "", trip && *trip ? "\r\n" : "");
+}
+
+// Incremental HTTP/1.1 response reader: status, Content-Length, X-Next-Offset, Connection: close.
+// Feed it what arrives; done() once the head and the body (discarded) are in.
+class ResponseParser {
+public:
+    ResponseParser() { reset(); }
+    void reset() { _len = 0; _headDone = false; _status = 0; _bodyLeft = 0; _nextOffset = -1; _close = false; _error = false; _bytes = 0; }
+
+    // Returns bytes consumed (the rest belongs to whatever follows)
+    size_t feed(const uint8_t* p, size_t n) {
+        size_t i = 0;
+        while (i < n && !done() && !_error) {
+            if (_headDone) {
+                size_t take = n - i < _bodyLeft ? n - i : (size_t)_bodyLeft;
+                _bodyLeft -= take; i += take;
+                continue;
+            }
+            char ch = (char)p[i++];
+            if (ch == '\n') {
+                if (_len && _line[_len - 1] == '\r') _len--;
+                _line[_len] = 0;
+                line();
+                _len = 0;
+            } else if (_len + 1 < sizeof(_line)) _line[_len++] = ch;
+        }
+        _bytes += i;
+        return i;
+    }
+
+    bool done() const { return _headDone && _bodyLeft == 0; }
+    bool error() const { return _error; }
+    int status() const { return _status; }
+    int64_t nextOffset() const { return _nextOffset; }
+    bool closes() const { return _close; }
+    uint32_t bytes() const { return _bytes; }
+
+private:
+    void line() {
+        if (!_status) {
+            int maj, min, st;
+            if (sscanf(_line, "HTTP/%d.%d %d", &maj, &min, &st) != 3) { _error = true; return; }
+            _status = st;
+            if (maj == 1 && min == 0) _close = true;
+            return;
+        }
+        if (!_line[0]) { _headDone = true; return; }
+        const char* v = strchr(_line, ':');
+        if (!v) return;
+        size_t k = (size_t)(v - _line);
+        for (++v; *v == ' '; ++v) {}
+        if (k == 14 && !strncasecmp(_line, "Content-Length", k)) _bodyLeft = strtoul(v, nullptr, 10);
+        else if (k == 13 && !strncasecmp(_line, "X-Next-Offset", k)) _nextOffset = strtoll(v, nullptr, 10);
+        else if (k == 10 && !strncasecmp(_line, "Connection", k)) _close = !strncasecmp(v, "close", 5);
+    }
+
+    char _line[128];
+    size_t _len;
+    bool _headDone;
+    int _status;
+    uint32_t _bodyLeft;
+    int64_t _nextOffset;
+    bool _close, _error;
+    uint32_t _bytes;
+};
+
+// Where the track files live
+class Store {
+public:
+    virtual ~Store() {}
+    // Lowest and highest file index present (the highest is being written); false if none
+    virtual bool range(uint32_t &first, uint32_t &last) = 0;
+    // Current size of a file, -1 if it is gone
+    virtual int64_t size(uint32_t file) = 0;
+    // Read up to n bytes at 'offset'; returns how many
+    virtual size_t read(uint32_t file, uint32_t offset, uint8_t* buf, size_t n) = 0;
+};
+
+// Radio and connection
+class Transport {
+public:
+    virtual ~Transport() {}
+    // Bring the radio up and connect; false if there is no network
+    virtual bool open() = 0;
+    // Send one request and read the reply into 'resp'; false on a socket error or timeout.
+    // bytesOut/bytesIn count everything written and read, headers included.
+    virtual bool exchange(const char* head, size_t headLen, const uint8_t* body, size_t bodyLen, ResponseParser &resp, uint32_t &bytesOut, uint32_t &bytesIn) = 0;
+    // Drop the connection and, if this session raised it, the radio
+    virtual void close() = 0;
+};
+
+struct Policy {
+    uint32_t minBytes;        // a session starts once this much is pending...
+    uint32_t maxDelayMs;      // ...or anything is, and the last session was this long ago
+    uint32_t maxRequests;     // per session, to bound radio-on time
+    uint32_t backoffBaseMs;
+    uint32_t backoffMaxMs;
+};
+
+struct Stats {
+    uint32_t sessions;
+    uint32_t connectFailures;
+    uint32_t requests;
+    uint32_t failures;        // socket errors and non-2xx replies
+    uint32_t bodyBytes;       // track bytes accepted by the server
+    uint32_t bytesOut;        // on the wire, headers included
+    uint32_t bytesIn;
+    uint32_t skippedBytes;    // torn or corrupt data stepped over
+    uint32_t lostFiles;       // deleted for space before they were all sent
+    uint32_t cursorResets;    // cursor did not fit the files there are, restarted at the oldest
+    uint32_t radioOnMs;
+    uint32_t latencyLastMs, latencyMaxMs;
+    uint64_t latencyTotalMs;
+};
+
+class Uploader {
+public:
+    Uploader(Store &store, Transport &transport, uint8_t* buf, size_t cap, const Url &url, const char* deviceId, const Policy &policy, uint32_t (*clockMs)())
+        : _store(store), _tx(transport), _buf(buf), _cap(cap), _url(url), _device(deviceId), _policy(policy),
+          _clockMs(clockMs), _backoff(policy.backoffBaseMs, policy.backoffMaxMs), _lastSessionMs(0) {
+        _cursor.file = _cursor.offset = 0;
+        memset(&_stats, 0, sizeof(_stats));
+        _trip[0] = 0;
+    }
+
+    void setCursor(const Cursor &c) { _cursor = c; }
+    const Cursor& cursor() const { return _cursor; }
+    const Stats& stats() const { return _stats; }
+    const Backoff& backoff() const { return _backoff; }
+    void setTrip(const char* trip) { strncpy(_trip, trip, sizeof(_trip) - 1); _trip[sizeof(_trip) - 1] = 0; }
+
+    // Bytes between the cursor and the end of the newest file
+    uint64_t pendingBytes() {
+        uint32_t first, last;
+        if (!_store.range(first, last)) return 0;
+        checkCursor(first, last);
+        uint64_t total = 0;
+        for (uint32_t f = _cursor.file > first ? _cursor.file : first; f <= last; ++f) {
+            int64_t s = _store.size(f);
+            if (s <= 0) continue;
+            uint64_t from = f == _cursor.file ? _cursor.offset : 0;
+            if ((uint64_t)s > from) total += (uint64_t)s - from;
+        }
+        return total;
+    }
+
+    // Worth raising the radio now? With the link already up for something else, any whole batch is.
+    bool due(uint32_t nowMs, bool linkUp) {
+        if (!_backoff.ready(nowMs)) return false;
+        uint64_t p = pendingBytes();
+        if (p < track::BATCH_HEADER + 1) return false;
+        return linkUp || p >= _policy.minBytes || nowMs - _lastSessionMs >= _policy.maxDelayMs;
+    }
+
+    // One session. Returns true when everything pending was sent.
+    bool session(uint32_t rnd) {
+        uint32_t t0 = _clockMs();
+        _lastSessionMs = t0;
+        _stats.sessions++;
+        if (!_tx.open()) {
+            _stats.connectFailures++;
+            _backoff.fail(_clockMs(), rnd);
+            _stats.radioOnMs += _clockMs() - t0;
+            return false;
+        }
+        bool caughtUp = false, failed = false;
+        for (uint32_t r = 0; r < _policy.maxRequests && !failed; ++r) {
+            size_t n = next();
+            if (!n) { caughtUp = true; break; }
+            failed = !send(n);
+        }
+        _tx.close();
+        if (failed) _backoff.fail(_clockMs(), rnd); else _backoff.succeed();
+        _stats.radioOnMs += _clockMs() - t0;
+        return caughtUp;
+    }
+
+private:
+    // Fill _buf with the next whole batches at the cursor, moving past finished files, deleted
+    // files and bad data. Returns the body length, 0 when there is nothing to send yet.
+    size_t next() {
+        for (;;) {
+            uint32_t first, last;
+            if (!_store.range(first, last)) return 0;
+            if (_cursor.file < first) {
+                _stats.lostFiles += first - _cursor.file;
+                _cursor.file = first; _cursor.offset = 0;
+            }
+            checkCursor(first, last);
+            int64_t size = _store.size(_cursor.file);
+            if (size < 0 || (uint64_t)_cursor.offset >= (uint64_t)size) {
+                if (_cursor.file >= last) return 0;              // the newest file: wait for more
+                _cursor.file++; _cursor.offset = 0;
+                continue;
+            }
+            size_t want = (uint64_t)size - _cursor.offset < _cap ? (size_t)((uint64_t)size - _cursor.offset) : _cap;
+            size_t got = _store.read(_cursor.file, _cursor.offset, _buf, want);
+            size_t skip;
+            size_t n = wholeBatches(_buf, got, skip);
+            if (n) return n;
+            if (skip) { _cursor.offset += (uint32_t)skip; _stats.skippedBytes += (uint32_t)skip; continue; }
+            // Only a partial batch left: still being written, or torn at the end of an old file
+            if (_cursor.file >= last) return 0;
+            _stats.skippedBytes += (uint32_t)got;
+            _cursor.file++; _cursor.offset = 0;
+        }
+    }
+
+    // Files only grow, so a cursor beyond the newest file or past the end of one was saved for
+    // other files (the filesystem was formatted and the numbering restarted): start over
+    void checkCursor(uint32_t first, uint32_t last) {
+        int64_t size = _cursor.file <= last ? _store.size(_cursor.file) : -1;
+        if (_cursor.file > last || (size >= 0 && (uint64_t)_cursor.offset > (uint64_t)size)) {
+            _stats.cursorResets++;
+            _cursor.file = first; _cursor.offset = 0;
+        }
+    }
+
+    bool send(size_t n) {
+        char head[384];
+        int hl = formatRequest(head, sizeof(head), _url, _device, _cursor, n, _trip);
+        if (hl <= 0 || (size_t)hl >= sizeof(head)) return false;
+        ResponseParser resp;
+        uint32_t out = 0, in = 0, t0 = _clockMs();
+        bool ok = _tx.exchange(head, (size_t)hl, _buf, n, resp, out, in);
+        uint32_t ms = _clockMs() - t0;
+        _stats.requests++;
+        _stats.bytesOut += out;
+        _stats.bytesIn += in;
+        _stats.latencyLastMs = ms;
+        if (ms > _stats.latencyMaxMs) _stats.latencyMaxMs = ms;
+        _stats.latencyTotalMs += ms;
+        if (!ok || resp.status() < 200 || resp.status() >= 300) {
+            // 409: the server already has this range and says where it wants us to carry on
+            if (ok && resp.status() == 409 && resp.nextOffset() >= 0) { adopt(resp.nextOffset()); return true; }
+            _stats.failures++;
+            return false;
+        }
+        _stats.bodyBytes += (uint32_t)n;
+        if (resp.nextOffset() >= 0) adopt(resp.nextOffset());
+        else _cursor.offset += (uint32_t)n;
+        return true;
+    }
+
+    void adopt(int64_t off) {
+        int64_t size = _store.size(_cursor.file);
+        if (off >= 0 && size >= 0 && off <= size) _cursor.offset = (uint32_t)off;
+    }
+
+    Store &_store;
+    Transport &_tx;
+    uint8_t* _buf;
+    size_t _cap;
+    Url _url;
+    const char* _device;
+    Policy _policy;
+    uint32_t (*_clockMs)();
+    Backoff _backoff;
+    uint32_t _lastSessionMs;
+    Cursor _cursor;
+    Stats _stats;
+    char _trip[96];
+};
+
+} // namespace telemetry
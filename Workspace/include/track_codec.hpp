@@ -0,0 +1,212 @@
+#pragma once
+// Compact track encoding: fixes packed into self-contained, CRC-checked batches.
+// Within a batch the first fix is stored whole and every later one as zig-zag varint deltas:
+// second-order for time, latitude and longitude (a steady 10 Hz drive in a straight line costs
+// one byte each), first-order for speed and altitude. A typical fix takes 5-8 bytes against
+// ~70 of NMEA. Each batch starts from scratch, so a torn or corrupt batch loses only itself.
+//
+// Batch layout (little-endian):
+//   0  'T' 'K'     magic
+//   2  u8          version (1)
+//   3  u8          reserved (0)
+//   4  u16         payload length
+//   6  u16         fix count
+//   8  u32         CRC-32 of the payload
+//   12 payload
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace track {
+
+struct Fix {
+    uint64_t utcMs;      // unix time of the fix in ms
+    int32_t latE7;
+    int32_t lonE7;
+    int32_t speedCms;    // ground speed, cm/s
+    int32_t altDm;       // altitude MSL, decimetres
+};
+
+static constexpr uint8_t BATCH_MAGIC0 = 'T';
+static constexpr uint8_t BATCH_MAGIC1 = 'K';
+static constexpr uint8_t BATCH_VERSION = 1;
+static constexpr size_t BATCH_HEADER = 12;
+static constexpr size_t BATCH_MAX = 4096;        // largest batch a reader must accept
+static constexpr size_t FIX_MAX_BYTES = 10 + 4 * 5; // worst case for one fix
+
+// CRC-32 (IEEE, reflected), nibble table: small and fast enough for a batch per few seconds
+static inline uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0) {
+    static const uint32_t T[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C };
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) {
+        crc = (crc >> 4) ^ T[(crc ^ p[i]) & 0x0F];
+        crc = (crc >> 4) ^ T[(crc ^ (p[i] >> 4)) & 0x0F];
+    }
+    return ~crc;
+}
+
+static inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static inline int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+// Append a varint at p; returns bytes written (1..10)
+static inline size_t putVarint(uint8_t* p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) { p[n++] = (uint8_t)(v | 0x80); v >>= 7; }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Read a varint from [p, end); returns bytes consumed, 0 if truncated or overlong
+static inline size_t getVarint(const uint8_t* p, const uint8_t* end, uint64_t &v) {
+    v = 0;
+    for (size_t n = 0; n < 10 && p + n < end; ++n) {
+        v |= (uint64_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n] & 0x80)) return n + 1;
+    }
+    return 0;
+}
+
+// Delta state shared by the encoder and decoder
+struct DeltaState {
+    Fix prev;
+    int64_t dt, dlat, dlon;   // previous first-order deltas
+    bool first;
+    void reset() { memset(&prev, 0, sizeof(prev)); dt = dlat = dlon = 0; first = true; }
+};
+
+// Builds one batch in a caller-owned buffer of 'cap' bytes (BATCH_HEADER + payload)
+class BatchEncoder {
+public:
+    BatchEncoder(uint8_t* buf, size_t cap) : _buf(buf), _cap(cap > BATCH_MAX ? BATCH_MAX : cap) { reset(); }
+
+    void reset() { _len = BATCH_HEADER; _count = 0; _st.reset(); }
+
+    // Append a fix; false when it does not fit (seal, write and reset, then add it again)
+    bool add(const Fix &f) {
+        uint8_t tmp[FIX_MAX_BYTES];
+        size_t n = 0;
+        if (_st.first) {
+            n += putVarint(tmp + n, f.utcMs);
+            n += putVarint(tmp + n, zigzag(f.latE7));
+            n += putVarint(tmp + n, zigzag(f.lonE7));
+        } else {
+            int64_t dt = (int64_t)(f.utcMs - _st.prev.utcMs);
+            int64_t dlat = (int64_t)f.latE7 - _st.prev.latE7, dlon = (int64_t)f.lonE7 - _st.prev.lonE7;
+            n += putVarint(tmp + n, zigzag(dt - _st.dt));
+            n += putVarint(tmp + n, zigzag(dlat - _st.dlat));
+            n += putVarint(tmp + n, zigzag(dlon - _st.dlon));
+        }
+        n += putVarint(tmp + n, zigzag((int64_t)f.speedCms - _st.prev.speedCms));
+        n += putVarint(tmp + n, zigzag((int64_t)f.altDm - _st.prev.altDm));
+        if (_len + n > _cap || _count == 0xFFFF) return false;
+
+        memcpy(_buf + _len, tmp, n);
+        _len += n;
+        _count++;
+        if (!_st.first) {
+            _st.dt = (int64_t)(f.utcMs - _st.prev.utcMs);
+            _st.dlat = (int64_t)f.latE7 - _st.prev.latE7;
+            _st.dlon = (int64_t)f.lonE7 - _st.prev.lonE7;
+        }
+        _st.prev = f;
+        _st.first = false;
+        return true;
+    }
+
+    // Fill in the header; returns the batch size to write (0 if empty). The buffer stays valid
+    // until reset().
+    size_t seal() {
+        if (!_count) return 0;
+        uint16_t payload = (uint16_t)(_len - BATCH_HEADER);
+        uint32_t crc = crc32(_buf + BATCH_HEADER, payload);
+        _buf[0] = BATCH_MAGIC0; _buf[1] = BATCH_MAGIC1; _buf[2] = BATCH_VERSION; _buf[3] = 0;
+        _buf[4] = (uint8_t)payload; _buf[5] = (uint8_t)(payload >> 8);
+        _buf[6] = (uint8_t)_count; _buf[7] = (uint8_t)(_count >> 8);
+        for (int i = 0; i < 4; ++i) _buf[8 + i] = (uint8_t)(crc >> (8 * i));
+        return _len;
+    }
+
+    uint16_t count() const { return _count; }
+    size_t size() const { return _len; }
+    const uint8_t* data() const { return _buf; }
+
+private:
+    uint8_t* _buf;
+    size_t _cap;
+    size_t _len;
+    uint16_t _count;
+    DeltaState _st;
+};
+
+// Header fields of a batch; parse() checks magic and version, check() the payload CRC and that
+// the payload holds exactly 'count' fixes (the count is outside the CRC)
+struct BatchHeader {
+    uint16_t payload;
+    uint16_t count;
+    uint32_t crc;
+
+    bool parse(const uint8_t* p) {
+        if (p[0] != BATCH_MAGIC0 || p[1] != BATCH_MAGIC1 || p[2] != BATCH_VERSION) return false;
+        payload = (uint16_t)(p[4] | (p[5] << 8));
+        count = (uint16_t)(p[6] | (p[7] << 8));
+        crc = (uint32_t)p[8] | ((uint32_t)p[9] << 8) | ((uint32_t)p[10] << 16) | ((uint32_t)p[11] << 24);
+        return payload > 0 && count > 0 && BATCH_HEADER + payload <= BATCH_MAX;
+    }
+
+    bool check(const uint8_t* payloadBytes) const {
+        if (crc32(payloadBytes, payload) != crc || (payloadBytes[payload - 1] & 0x80)) return false;
+        // Five varints per fix: count the bytes that end one
+        uint32_t ends = 0;
+        for (uint16_t i = 0; i < payload; ++i) ends += !(payloadBytes[i] & 0x80);
+        return ends == 5u * count;
+    }
+};
+
+// Walks the fixes of one verified batch payload
+class BatchDecoder {
+public:
+    BatchDecoder(const uint8_t* payload, size_t len, uint16_t count)
+        : _p(payload), _end(payload + len), _left(count) { _st.reset(); }
+
+    bool next(Fix &f) {
+        if (!_left) return false;
+        uint64_t a, b, c, d, e;
+        if (!get(a) || !get(b) || !get(c) || !get(d) || !get(e)) { _left = 0; return false; }
+        if (_st.first) {
+            f.utcMs = a;
+            f.latE7 = (int32_t)unzigzag(b);
+            f.lonE7 = (int32_t)unzigzag(c);
+        } else {
+            _st.dt += unzigzag(a); _st.dlat += unzigzag(b); _st.dlon += unzigzag(c);
+            f.utcMs = _st.prev.utcMs + (uint64_t)_st.dt;
+            f.latE7 = (int32_t)(_st.prev.latE7 + _st.dlat);
+            f.lonE7 = (int32_t)(_st.prev.lonE7 + _st.dlon);
+        }
+        f.speedCms = (int32_t)(_st.prev.speedCms + unzigzag(d));
+        f.altDm = (int32_t)(_st.prev.altDm + unzigzag(e));
+        _st.prev = f;
+        _st.first = false;
+        _left--;
+        return true;
+    }
+
+    uint16_t left() const { return _left; }
+
+private:
+    bool get(uint64_t &v) {
+        size_t n = getVarint(_p, _end, v);
+        _p += n;
+        return n != 0;
+    }
+
+    const uint8_t* _p;
+    const uint8_t* _end;
+    uint16_t _left;
+    DeltaState _st;
+};
+
+} // namespace track
@@ -0,0 +1,255 @@
+#pragma once
+// Track export: turns a track file into GPX 1.0 or CSV text as a pull stream.
+// Nothing is held but the reader's batch buffer and one formatted row, so memory use is the
+// same for a ten-second track and a ten-hour one. Every row has a fixed width (signed,
+// zero-padded numbers, still valid decimals for both formats), which makes the byte offset of any
+// fix computable: seek() jumps to an offset by skipping whole batches on their header counts and
+// decoding only the batch that holds it. That is what lets HTTP Range requests resume a download.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "track_codec.hpp"
+#include "track_file.hpp"
+
+namespace track {
+
+enum ExportFormat : uint8_t { EXPORT_GPX, EXPORT_CSV };
+
+static constexpr size_t EXPORT_ROW_MAX = 160;
+static constexpr size_t EXPORT_HEAD_MAX = 192;
+static const char* const EXPORT_GPX_FOOT = "</trkseg></trk>\n</gpx>\n";
+
+// Append 'v' as [sign] int digits '.' frac digits, zero-padded and clamped to the field width
+static inline char* putFixed(char* p, int64_t v, int intDigits, int fracDigits, bool sign) {
+    if (sign) *p++ = v < 0 ? '-' : '+';
+    uint64_t m = v < 0 ? (uint64_t)(-v) : (uint64_t)v;
+    if (!sign && v < 0) m = 0;
+    uint64_t lim = 1;
+    for (int i = 0; i < intDigits + fracDigits; ++i) lim *= 10;
+    if (m >= lim) m = lim - 1;
+    for (int i = intDigits + fracDigits; i > intDigits; --i) { p[i] = (char)('0' + m % 10); m /= 10; }
+    p[intDigits] = '.';
+    for (int i = intDigits - 1; i >= 0; --i) { p[i] = (char)('0' + m % 10); m /= 10; }
+    return p + intDigits + 1 + fracDigits;
+}
+
+static inline char* putDigits(char* p, uint32_t v, int n) {
+    for (int i = n - 1; i >= 0; --i) { p[i] = (char)('0' + v % 10); v /= 10; }
+    return p + n;
+}
+
+static inline char* putText(char* p, const char* s) {
+    size_t n = strlen(s);
+    memcpy(p, s, n);
+    return p + n;
+}
+
+// ISO 8601 UTC with milliseconds, always 24 characters: 2024-06-01T12:00:00.000Z
+static inline char* putTime(char* p, uint64_t utcMs) {
+    int64_t days = (int64_t)(utcMs / 86400000ULL);
+    uint32_t ms = (uint32_t)(utcMs % 86400000ULL);
+    // civil-from-days (proleptic Gregorian)
+    days += 719468;
+    int64_t era = days / 146097;
+    uint32_t doe = (uint32_t)(days - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+    uint32_t mo = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t y = (uint32_t)(yoe + era * 400) + (mo <= 2);
+    p = putDigits(p, y > 9999 ? 9999 : y, 4); *p++ = '-';
+    p = putDigits(p, mo, 2); *p++ = '-';
+    p = putDigits(p, d, 2); *p++ = 'T';
+    p = putDigits(p, ms / 3600000, 2); *p++ = ':';
+    p = putDigits(p, ms / 60000 % 60, 2); *p++ = ':';
+    p = putDigits(p, ms / 1000 % 60, 2); *p++ = '.';
+    p = putDigits(p, ms % 1000, 3); *p++ = 'Z';
+    return p;
+}
+
+// One fix as a row; returns its length, which depends only on the format
+static inline size_t formatRow(ExportFormat fmt, const Fix &f, char* out) {
+    char* p = out;
+    if (fmt == EXPORT_CSV) {
+        p = putTime(p, f.utcMs); *p++ = ',';
+        p = putFixed(p, f.latE7, 2, 7, true); *p++ = ',';
+        p = putFixed(p, f.lonE7, 3, 7, true); *p++ = ',';
+        p = putFixed(p, f.altDm, 5, 1, true); *p++ = ',';
+        p = putFixed(p, f.speedCms, 3, 2, false); *p++ = '\n';
+    } else {
+        p = putText(p, "<trkpt lat=\"");
+        p = putFixed(p, f.latE7, 2, 7, true);
+        p = putText(p, "\" lon=\"");
+        p = putFixed(p, f.lonE7, 3, 7, true);
+        p = putText(p, "\"><ele>");
+        p = putFixed(p, f.altDm, 5, 1, true);
+        p = putText(p, "</ele><time>");
+        p = putTime(p, f.utcMs);
+        p = putText(p, "</time><speed>");
+        p = putFixed(p, f.speedCms, 3, 2, false);
+        p = putText(p, "</speed></trkpt>\n");
+    }
+    return (size_t)(p - out);
+}
+
+static inline size_t rowLength(ExportFormat fmt) {
+    Fix z;
+    memset(&z, 0, sizeof(z));
+    char tmp[EXPORT_ROW_MAX];
+    return formatRow(fmt, z, tmp);
+}
+
+static inline const char* exportMime(ExportFormat fmt) { return fmt == EXPORT_CSV ? "text/csv" : "application/gpx+xml"; }
+static inline const char* exportExt(ExportFormat fmt) { return fmt == EXPORT_CSV ? "csv" : "gpx"; }
+
+// Number of fixes in the good batches from the current position of 'f' that end within the
+// first 'endOffset' bytes (call on a fresh file)
+static inline uint32_t countFixes(FILE* f, uint8_t* buf, long endOffset = LONG_MAX) {
+    TrackReader r(f, buf);
+    BatchHeader h;
+    uint32_t n = 0;
+    while (r.next(h) && ftell(f) <= endOffset) n += h.count;
+    return n;
+}
+
+class ExportStream {
+public:
+    // 'f' is positioned at the start of the track, 'buf' holds BATCH_MAX bytes; 'name' goes into
+    // the GPX header and must have the same length for every track (e.g. the 6-digit index)
+    ExportStream(FILE* f, uint8_t* buf, ExportFormat fmt, const char* name)
+        : _reader(f, buf), _dec(nullptr, 0, 0), _fmt(fmt), _rowLen(rowLength(fmt)),
+          _limit(UINT32_MAX), _emitted(0), _part(HEAD), _pos(0), _len(0) {
+        char* p = _head;
+        if (fmt == EXPORT_CSV) {
+            p = putText(p, "time,lat,lon,alt_m,speed_ms\n");
+            _footLen = 0;
+        } else {
+            p = putText(p, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                           "<gpx version=\"1.0\" creator=\"esp32-speedometer\" xmlns=\"http://www.topografix.com/GPX/1/0\">\n"
+                           "<trk><name>");
+            p = putText(p, name);
+            p = putText(p, "</name><trkseg>\n");
+            _footLen = strlen(EXPORT_GPX_FOOT);
+        }
+        _headLen = (size_t)(p - _head);
+        load(_head, _headLen);
+    }
+
+    ExportStream(const ExportStream&) = delete;   // _src may point into _head
+    ExportStream& operator=(const ExportStream&) = delete;
+
+    // Stop after 'fixes' fixes, so the length stays what length() promised while the file grows
+    void setLimit(uint32_t fixes) { _limit = fixes; }
+
+    // Document length for 'fixes' fixes
+    uint64_t length(uint32_t fixes) const { return _headLen + (uint64_t)fixes * _rowLen + _footLen; }
+
+    // Position the stream at byte 'offset' of the document; call before the first read().
+    // False if the track holds fewer fixes than the offset implies.
+    bool seek(uint64_t offset) {
+        if (offset < _headLen) { _pos = (size_t)offset; return true; }
+        offset -= _headLen;
+        uint64_t idx = offset / _rowLen;
+        size_t within = (size_t)(offset % _rowLen);
+        if (idx >= _limit) {
+            // In the footer: every fix has to exist for the offset to mean anything
+            uint64_t rest = offset - (uint64_t)_limit * _rowLen;
+            if (rest >= _footLen || !skip(_limit)) return false;
+            _emitted = _limit;
+            _part = FOOT;
+            load(footer(), _footLen);
+            _pos = (size_t)rest;
+            return true;
+        }
+        if (!skip((uint32_t)idx)) return false;
+        _emitted = (uint32_t)idx;
+        _part = ROWS;
+        if (!nextRow()) return false;
+        _pos = within;
+        return true;
+    }
+
+    // Fill up to 'cap' bytes; returns 0 at the end of the document
+    size_t read(char* out, size_t cap) {
+        size_t n = 0;
+        while (n < cap) {
+            if (_pos == _len) {
+                if (_part == DONE) break;
+                if (_part == HEAD) _part = ROWS;
+                if (_part == ROWS && !nextRow()) { _part = FOOT; load(footer(), _footLen); }
+                else if (_part == FOOT) { _part = DONE; _len = _pos = 0; }
+                continue;
+            }
+            size_t k = _len - _pos;
+            if (k > cap - n) k = cap - n;
+            memcpy(out + n, _src + _pos, k);
+            _pos += k;
+            n += k;
+        }
+        return n;
+    }
+
+    uint32_t fixes() const { return _emitted; }
+    const TrackReader& reader() const { return _reader; }
+
+private:
+    enum Part : uint8_t { HEAD, ROWS, FOOT, DONE };
+    const char* footer() const { return _fmt == EXPORT_CSV ? "" : EXPORT_GPX_FOOT; }
+
+    void load(const char* src, size_t len) { _src = src; _len = len; _pos = 0; }
+
+    bool nextFix(Fix &f) {
+        if (_emitted >= _limit) return false;
+        while (!_dec.next(f)) {
+            BatchHeader h;
+            if (!_reader.next(h)) return false;
+            _dec = BatchDecoder(_reader.payload(), h.payload, h.count);
+        }
+        return true;
+    }
+
+    bool nextRow() {
+        Fix f;
+        if (!nextFix(f)) return false;
+        _emitted++;
+        load(_row, formatRow(_fmt, f, _row));
+        return true;
+    }
+
+    // Pass over 'n' fixes, decoding only the batch the last of them is in
+    bool skip(uint32_t n) {
+        BatchHeader h;
+        while (n) {
+            if (_dec.left()) {
+                Fix f;
+                if (!_dec.next(f)) return false;
+                n--;
+                continue;
+            }
+            if (!_reader.next(h)) return false;
+            if (h.count <= n) { n -= h.count; continue; }
+            _dec = BatchDecoder(_reader.payload(), h.payload, h.count);
+        }
+        return true;
+    }
+
+    TrackReader _reader;
+    BatchDecoder _dec;
+    ExportFormat _fmt;
+    size_t _rowLen;
+    uint32_t _limit;
+    uint32_t _emitted;
+    Part _part;
+    const char* _src;
+    size_t _pos, _len;
+    size_t _headLen, _footLen;
+    char _head[EXPORT_HEAD_MAX];
+    char _row[EXPORT_ROW_MAX];
+};
+
+} // namespace track
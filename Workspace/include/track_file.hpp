@@ -0,0 +1,121 @@
+#pragma once
+// Track files: sealed batches (track_codec.hpp) appended back to back.
+// TrackWriter makes each batch durable (fflush + fsync) before returning, so after a crash or
+// power cut the file ends either at a batch boundary or in one torn batch that readers drop. A
+// write that fails while running is cut off again (truncated to the last good size) so later
+// batches do not land behind it; if even that fails the writer closes and the caller moves on to
+// a new file. TrackReader walks the batches with a single BATCH_MAX buffer; after a bad header,
+// a short batch or a CRC failure it resynchronises on the next batch magic, so one torn or
+// corrupt batch never hides the good ones behind it.
+// stdio only: LittleFS through the ESP-IDF VFS on the device, plain files on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "track_codec.hpp"
+
+namespace track {
+
+class TrackWriter {
+public:
+    TrackWriter() : _f(nullptr), _size(0) { _path[0] = 0; }
+    ~TrackWriter() { close(); }
+
+    // Open for appending (created if missing)
+    bool open(const char* path) {
+        close();
+        if (strlen(path) >= sizeof(_path)) return false;
+        strcpy(_path, path);
+        _f = fopen(path, "ab");
+        if (!_f) return false;
+        fseek(_f, 0, SEEK_END);
+        _size = (uint32_t)ftell(_f);
+        return true;
+    }
+
+    // Write one sealed batch and flush it to the medium. False on a short or failed write, with
+    // the partial batch removed again; isOpen() is false afterwards if that was not possible.
+    bool append(const uint8_t* batch, size_t len) {
+        if (!_f) return false;
+        size_t n = fwrite(batch, 1, len, _f);
+        if (n == len && fflush(_f) == 0 && fsync(fileno(_f)) == 0) {
+            _size += (uint32_t)len;
+            return true;
+        }
+        rollback();
+        return false;
+    }
+
+    void close() {
+        if (_f) fclose(_f);
+        _f = nullptr;
+    }
+
+    bool isOpen() const { return _f != nullptr; }
+    uint32_t size() const { return _size; }
+
+private:
+    // Cut the file back to its last batch boundary. Anything still buffered is flushed by the
+    // close first, so the truncate removes all of the torn batch.
+    void rollback() {
+        fclose(_f);
+        _f = nullptr;
+        if (truncate(_path, (off_t)_size) != 0) return;
+        _f = fopen(_path, "ab");
+        if (_f && (fseek(_f, 0, SEEK_END) != 0 || (uint32_t)ftell(_f) != _size)) close();
+    }
+
+    FILE* _f;
+    uint32_t _size;
+    char _path[64];
+};
+
+class TrackReader {
+public:
+    // 'buf' must hold BATCH_MAX bytes; the file stays owned by the caller
+    TrackReader(FILE* f, uint8_t* buf) : _f(f), _buf(buf), _corrupt(0), _batches(0) {}
+
+    // Load the next good batch. On success 'h' describes it and payload() points at its bytes.
+    bool next(BatchHeader &h) {
+        while (_f) {
+            long at = ftell(_f);
+            size_t got = fread(_buf, 1, BATCH_HEADER, _f);
+            if (got == 0) return false;
+            // A torn batch's length cannot be trusted: a good batch may start inside it, so look
+            // for the next magic one byte on rather than skipping by the length
+            if (got == BATCH_HEADER && h.parse(_buf) &&
+                fread(_buf + BATCH_HEADER, 1, h.payload, _f) == h.payload && h.check(_buf + BATCH_HEADER)) {
+                _batches++;
+                return true;
+            }
+            _corrupt++;
+            if (at < 0 || !resync(at + 1)) return false;
+        }
+        return false;
+    }
+
+    const uint8_t* payload() const { return _buf + BATCH_HEADER; }
+    uint32_t batches() const { return _batches; }
+    uint32_t corrupt() const { return _corrupt; }
+
+private:
+    // Position the file at the next BATCH_MAGIC0/1 pair at or after 'from'; false if there is none
+    bool resync(long from) {
+        if (fseek(_f, from, SEEK_SET) != 0) return false;
+        int prev = EOF, c;
+        while ((c = fgetc(_f)) != EOF) {
+            if (prev == BATCH_MAGIC0 && c == BATCH_MAGIC1) return fseek(_f, -2, SEEK_CUR) == 0;
+            prev = c;
+        }
+        return false;
+    }
+
+    FILE* _f;
+    uint8_t* _buf;
+    uint32_t _corrupt;
+    uint32_t _batches;
+};
+
+} // namespace track
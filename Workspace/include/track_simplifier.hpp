@@ -0,0 +1,267 @@
+#pragma once
+// Breadcrumb track for the map screen: a bounded, incrementally simplified polyline and a
+// heading-up view of it with cached screen coordinates.
+//
+// TrackSimplifier keeps at most CAP vertices in a local east/north plane (metres from the first
+// fix). It is streaming Visvalingam-Whyatt: every interior vertex carries the area of the
+// triangle it forms with its neighbours, kept in a min-heap, and when the pool is full the vertex
+// that adds least to the shape goes. A neighbour's area never drops below the area just removed,
+// so the running threshold only grows and the line degrades evenly however long the drive. Each
+// add is O(log CAP). Run ends (a gap in the fix) are pinned, so a gap never turns into a chord.
+//
+// TrackView projects vertices to the screen once per view (centre, heading, scale) and keeps the
+// result per vertex slot, so a frame is a walk over the cached points. New vertices are projected
+// as they arrive; everything is re-projected only when the view moves: the car drifts more than
+// pan px from the centre, turns by more than the heading step, or the zoom changes.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <math.h>
+
+namespace track {
+
+static constexpr float MAP_MIN_STEP_M = 5.0f;        // closer fixes are not kept (parking jitter)
+
+template<int CAP>
+class TrackSimplifier {
+public:
+    static constexpr int16_t NONE = -1;
+
+    TrackSimplifier() { clear(); }
+
+    void clear() {
+        _head = _tail = NONE;
+        _count = _heapSize = 0;
+        _seq = 0;
+        _threshold = 0.0f;
+        _removed = 0;
+        for (int i = 0; i < CAP; ++i) _next[i] = (int16_t)(i + 1 < CAP ? i + 1 : NONE);
+        _free = 0;
+    }
+
+    // Append a point; 'newRun' starts a new run (the previous point is not joined to it).
+    // Returns false when the point was too close to the last one to keep.
+    bool add(float e, float n, bool newRun) {
+        if (_tail != NONE && !newRun) {
+            float de = e - _e[_tail], dn = n - _n[_tail];
+            if (de * de + dn * dn < MAP_MIN_STEP_M * MAP_MIN_STEP_M) return false;
+        }
+        if (_free == NONE) {
+            if (_heapSize) removeAt(_heap[0]);
+            else removeHead();              // all pinned: only run ends left, drop the oldest
+        }
+        int16_t i = _free;
+        _free = _next[i];
+        _e[i] = e; _n[i] = n;
+        _runStart[i] = newRun || _tail == NONE;
+        _seqOf[i] = _seq++;
+        _prev[i] = _tail; _next[i] = NONE;
+        _heapPos[i] = NONE;
+        if (_tail != NONE) _next[_tail] = i; else _head = i;
+        int16_t t = _tail;
+        _tail = i;
+        _count++;
+        if (t != NONE && !_runStart[i]) refresh(t);   // the old tail is now interior
+        return true;
+    }
+
+    int count() const { return _count; }
+    int16_t head() const { return _head; }
+    int16_t tail() const { return _tail; }
+    int16_t next(int16_t i) const { return _next[i]; }
+    int16_t prev(int16_t i) const { return _prev[i]; }
+    float east(int16_t i) const { return _e[i]; }
+    float north(int16_t i) const { return _n[i]; }
+    bool runStart(int16_t i) const { return _runStart[i]; }
+    uint32_t seq(int16_t i) const { return _seqOf[i]; }     // order of arrival, never reused
+    uint32_t added() const { return _seq; }
+    uint32_t removed() const { return _removed; }
+    float threshold() const { return _threshold; }          // largest area removed so far (m^2)
+
+private:
+    static float triArea(float ax, float ay, float bx, float by, float cx, float cy) {
+        return 0.5f * fabsf((bx - ax) * (cy - ay) - (cx - ax) * (by - ay));
+    }
+
+    bool pinned(int16_t i) const {
+        return _runStart[i] || _next[i] == NONE || _runStart[_next[i]];
+    }
+
+    // Recompute a vertex's area and its place in the heap (or take it out if it became pinned)
+    void refresh(int16_t i) {
+        if (pinned(i)) { if (_heapPos[i] != NONE) heapRemove(i); return; }
+        int16_t p = _prev[i], q = _next[i];
+        float a = triArea(_e[p], _n[p], _e[i], _n[i], _e[q], _n[q]);
+        if (a < _threshold) a = _threshold;
+        _area[i] = a;
+        if (_heapPos[i] == NONE) { _heapPos[i] = (int16_t)_heapSize; _heap[_heapSize++] = i; siftUp(_heapPos[i]); }
+        else { siftUp(_heapPos[i]); siftDown(_heapPos[i]); }
+    }
+
+    void removeAt(int16_t i) {
+        if (_area[i] > _threshold) _threshold = _area[i];
+        heapRemove(i);
+        int16_t p = _prev[i], q = _next[i];
+        _next[p] = q; _prev[q] = p;          // interior: both exist
+        release(i);
+        refresh(p);
+        refresh(q);
+    }
+
+    void removeHead() {
+        int16_t i = _head, q = _next[i];
+        if (_heapPos[i] != NONE) heapRemove(i);
+        _head = q;
+        if (q != NONE) { _prev[q] = NONE; _runStart[q] = true; if (_heapPos[q] != NONE) heapRemove(q); }
+        else _tail = NONE;
+        release(i);
+    }
+
+    void release(int16_t i) { _next[i] = _free; _free = i; _count--; _removed++; }
+
+    // Binary min-heap on _area
+    void swapHeap(int a, int b) {
+        int16_t t = _heap[a]; _heap[a] = _heap[b]; _heap[b] = t;
+        _heapPos[_heap[a]] = (int16_t)a; _heapPos[_heap[b]] = (int16_t)b;
+    }
+    void siftUp(int k) { while (k > 0 && _area[_heap[(k - 1) / 2]] > _area[_heap[k]]) { swapHeap(k, (k - 1) / 2); k = (k - 1) / 2; } }
+    void siftDown(int k) {
+        for (;;) {
+            int l = 2 * k + 1, r = l + 1, m = k;
+            if (l < _heapSize && _area[_heap[l]] < _area[_heap[m]]) m = l;
+            if (r < _heapSize && _area[_heap[r]] < _area[_heap[m]]) m = r;
+            if (m == k) return;
+            swapHeap(k, m); k = m;
+        }
+    }
+    void heapRemove(int16_t i) {
+        int k = _heapPos[i];
+        _heapPos[i] = NONE;
+        if (--_heapSize == k) return;
+        int16_t moved = _heap[_heapSize];
+        _heap[k] = moved;
+        _heapPos[moved] = (int16_t)k;
+        siftUp(k);
+        siftDown(_heapPos[moved]);
+    }
+
+    float _e[CAP], _n[CAP], _area[CAP];
+    uint32_t _seqOf[CAP];
+    int16_t _prev[CAP], _next[CAP], _heapPos[CAP], _heap[CAP];
+    bool _runStart[CAP];
+    int16_t _head, _tail, _free;
+    int _count, _heapSize;
+    uint32_t _seq, _removed;
+    float _threshold;
+};
+
+// Zoom steps (metres per pixel) for the map, 1-2-5
+static const float MAP_ZOOM_STEPS[] = { 0.5f, 1.0f, 2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f, 200.0f, 500.0f };
+static constexpr int MAP_ZOOM_COUNT = sizeof(MAP_ZOOM_STEPS) / sizeof(MAP_ZOOM_STEPS[0]);
+
+template<int CAP>
+class TrackView {
+public:
+    // Screen centre and the radius the track is fitted into, the pan distance (px) and heading
+    // change (degrees) that trigger a re-projection
+    TrackView(int cx, int cy, int fitRadiusPx, int panPx, float headingStepDeg)
+        : _cx(cx), _cy(cy), _fitPx(fitRadiusPx), _panPx(panPx), _headingStep(headingStepDeg),
+          _valid(false), _projectedSeq(0), _zoom(-1), _auto(true), _reprojections(0) {}
+
+    // Fixed zoom step, or -1 to fit the whole track
+    void setZoom(int step) { _auto = step < 0; if (!_auto) _zoom = step < MAP_ZOOM_COUNT ? step : MAP_ZOOM_COUNT - 1; _valid = false; }
+    bool autoZoom() const { return _auto; }
+    int zoom() const { return _zoom; }
+    float metersPerPx() const { return MAP_ZOOM_STEPS[_zoom < 0 ? 0 : _zoom]; }
+    uint32_t reprojections() const { return _reprojections; }
+
+    // Bring the cache up to date for the car at (e, n) heading 'headingDeg'. Returns true when
+    // everything was re-projected.
+    bool update(const TrackSimplifier<CAP> &t, float e, float n, float headingDeg) {
+        bool full = !_valid;
+        if (!full) {
+            int x, y;
+            toScreen(e, n, x, y);
+            int dx = x - _cx, dy = y - _cy;
+            float dh = fabsf(headingDeg - _heading);
+            if (dh > 180.0f) dh = 360.0f - dh;
+            full = dx * dx + dy * dy > _panPx * _panPx || dh > _headingStep;
+        }
+        if (!full) {
+            // Project the vertices added since, newest first, until one is already cached
+            for (int16_t i = t.tail(); i != TrackSimplifier<CAP>::NONE && t.seq(i) >= _projectedSeq; i = t.prev(i)) {
+                project(t, i);
+                if (_auto && outsideFit(i)) full = true;
+            }
+            _projectedSeq = t.added();
+        }
+        if (!full) return false;
+
+        _ce = e; _cn = n; _heading = headingDeg;
+        float rad = headingDeg * (float)(M_PI / 180.0);
+        _sin = sinf(rad); _cos = cosf(rad);
+        if (_auto) _zoom = fitZoom(t);
+        _scale = 1.0f / MAP_ZOOM_STEPS[_zoom];
+        for (int16_t i = t.head(); i != TrackSimplifier<CAP>::NONE; i = t.next(i)) project(t, i);
+        _projectedSeq = t.added();
+        _valid = true;
+        _reprojections++;
+        return true;
+    }
+
+    int16_t x(int16_t i) const { return _x[i]; }
+    int16_t y(int16_t i) const { return _y[i]; }
+
+    // Car position and heading relative to the view (the car drifts until the next re-projection)
+    void toScreen(float e, float n, int &x, int &y) const {
+        float fx, fy;
+        toScreenF(e, n, fx, fy);
+        x = _cx + clampPx(fx - _cx);
+        y = _cy + clampPx(fy - _cy);
+    }
+    // Unrounded and unclamped, for callers that build their own transform (the basemap)
+    void toScreenF(float e, float n, float &x, float &y) const {
+        float de = e - _ce, dn = n - _cn;
+        x = _cx + (de * _cos - dn * _sin) * _scale;
+        y = _cy - (de * _sin + dn * _cos) * _scale;
+    }
+    float headingDeg() const { return _heading; }
+
+private:
+    static int clampPx(float v) { return v > 30000.0f ? 30000 : (v < -30000.0f ? -30000 : (int)lroundf(v)); }
+
+    void project(const TrackSimplifier<CAP> &t, int16_t i) {
+        int x, y;
+        toScreen(t.east(i), t.north(i), x, y);
+        _x[i] = (int16_t)x; _y[i] = (int16_t)y;
+    }
+
+    bool outsideFit(int16_t i) const {
+        int dx = _x[i] - _cx, dy = _y[i] - _cy;
+        return dx * dx + dy * dy > _fitPx * _fitPx;
+    }
+
+    // Smallest zoom step that fits every vertex within the fit radius around the car
+    int fitZoom(const TrackSimplifier<CAP> &t) const {
+        float r2 = 0.0f;
+        for (int16_t i = t.head(); i != TrackSimplifier<CAP>::NONE; i = t.next(i)) {
+            float de = t.east(i) - _ce, dn = t.north(i) - _cn, d2 = de * de + dn * dn;
+            if (d2 > r2) r2 = d2;
+        }
+        float need = sqrtf(r2) / _fitPx;
+        for (int z = 0; z < MAP_ZOOM_COUNT; ++z) if (MAP_ZOOM_STEPS[z] >= need) return z;
+        return MAP_ZOOM_COUNT - 1;
+    }
+
+    int _cx, _cy, _fitPx, _panPx;
+    float _headingStep;
+    bool _valid;
+    uint32_t _projectedSeq;
+    int _zoom;
+    bool _auto;
+    uint32_t _reprojections;
+    float _ce = 0.0f, _cn = 0.0f, _heading = 0.0f, _sin = 0.0f, _cos = 1.0f, _scale = 1.0f;
+    int16_t _x[CAP], _y[CAP];
+};
+
+} // namespace track
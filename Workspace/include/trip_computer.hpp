@@ -0,0 +1,170 @@
+#pragma once
+// Trip computer: odometer, two resettable trips (A/B), moving/stopped time, average and max speed.
+// Distance integrates the fused (Kalman-filtered, zero-gated) speed between fixes, so standing
+// still adds nothing however much the position wanders. Speed alone would carry any receiver
+// scale bias, so it is cross-checked against position: while driving steadily with a decent fix,
+// chords of about TRIP_CAL_STEP_M between anchor points, projected to a local plane, are summed
+// over a TRIP_CAL_WINDOW_M window and compared with the raw speed integral over the same window.
+// The ratio slowly trims a bounded scale factor. Gaps in the fix (tunnels, a brief power dip) are
+// bridged with the straight-line chord when the fix returns, if that chord is plausible.
+// Everything is O(1) per fix; TripState is the part worth keeping across reboots.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "geo_utils.hpp"
+
+namespace nav {
+
+static constexpr uint32_t TRIP_MAX_GAP_MS = 5000;     // longer between fixes: bridge the gap
+static constexpr float TRIP_BRIDGE_MAX_KMH = 250.0f;  // a bridge faster than this is dropped
+static constexpr float TRIP_BRIDGE_MOVING_M = 50.0f;  // a bridged gap longer than this was driven
+static constexpr float TRIP_CAL_STEP_M = 25.0f;       // chord length for the position path
+static constexpr float TRIP_CAL_WINDOW_M = 500.0f;    // speed-integrated length of one comparison
+static constexpr float TRIP_CAL_MIN_KMH = 15.0f;      // slower, position noise dominates the chords
+static constexpr float TRIP_CAL_MAX_HACC_M = 5.0f;    // worse fixes don't calibrate (0 = unknown: ok)
+static constexpr float TRIP_CAL_GAIN = 0.1f;          // share of each window's ratio taken
+static constexpr float TRIP_SCALE_MIN = 0.95f;
+static constexpr float TRIP_SCALE_MAX = 1.05f;
+static constexpr float TRIP_RECENTER_M = 20000.0f;    // local plane re-centred beyond this
+
+enum { TRIP_A, TRIP_B, TRIP_COUNT };
+
+struct TripTotals {
+    double distanceM;
+    uint64_t movingMs;
+    uint64_t stoppedMs;
+    float maxKmh;
+
+    void clear() { distanceM = 0.0; movingMs = stoppedMs = 0; maxKmh = 0.0f; }
+    // Average over moving time (km/h)
+    float avgKmh() const { return movingMs ? (float)(distanceM * 3600.0 / (double)movingMs) : 0.0f; }
+};
+
+// What survives a reboot
+struct TripState {
+    uint32_t version;
+    double odometerM;
+    TripTotals trip[TRIP_COUNT];
+    float scale;             // speed -> distance correction learnt from position
+    uint32_t calibrations;   // windows that updated the scale
+};
+
+static constexpr uint32_t TRIP_STATE_VERSION = 1;
+
+class TripComputer {
+public:
+    TripComputer() {
+        memset(&_st, 0, sizeof(_st));
+        _st.version = TRIP_STATE_VERSION;
+        _st.scale = 1.0f;
+        _havePrev = false;
+        _moving = false;
+        resetWindow();
+    }
+
+    // Adopt saved totals; false (and nothing changed) if they are from another version or corrupt
+    bool restore(const TripState &s) {
+        if (s.version != TRIP_STATE_VERSION || !(s.scale >= TRIP_SCALE_MIN && s.scale <= TRIP_SCALE_MAX)) return false;
+        if (!(s.odometerM >= 0.0)) return false;
+        _st = s;
+        return true;
+    }
+
+    // Feed one fix: tMs when it was decoded, fused speed (zero when stopped), horizontal accuracy
+    // (0 = unknown). Returns the metres added.
+    float update(uint32_t tMs, int32_t latE7, int32_t lonE7, float speedKmh, float hAccM) {
+        if (speedKmh < 0.0f) speedKmh = 0.0f;
+        if (!_frame.valid || _frame.needsRecenter(latE7, lonE7, TRIP_RECENTER_M)) {
+            _frame.setOrigin(latE7, lonE7);
+            if (_havePrev) _frame.toEnu(_prevLatE7, _prevLonE7, _prevE, _prevN);
+            resetWindow();
+        }
+        float e, n;
+        _frame.toEnu(latE7, lonE7, e, n);
+        if (!_havePrev) {
+            savePrev(tMs, latE7, lonE7, e, n, speedKmh);
+            return 0.0f;
+        }
+
+        uint32_t dtMs = tMs - _prevMs;
+        float added = 0.0f;
+        bool moving;
+        if (dtMs > TRIP_MAX_GAP_MS) {
+            // Bridge the gap with the chord, unless it implies an impossible speed
+            float chord = hypotf(e - _prevE, n - _prevN);
+            moving = chord > TRIP_BRIDGE_MOVING_M;
+            if (moving && chord * 3.6f <= TRIP_BRIDGE_MAX_KMH * dtMs * 0.001f) added = chord;
+            resetWindow();
+        } else {
+            float rawM = 0.5f * (_prevKmh + speedKmh) / 3.6f * dtMs * 0.001f;
+            added = rawM * _st.scale;
+            moving = speedKmh > 0.0f || _prevKmh > 0.0f;
+            calibrate(rawM, e, n, speedKmh, hAccM);
+        }
+
+        _st.odometerM += added;
+        for (int i = 0; i < TRIP_COUNT; ++i) {
+            TripTotals &t = _st.trip[i];
+            t.distanceM += added;
+            if (moving) t.movingMs += dtMs; else t.stoppedMs += dtMs;
+            if (speedKmh > t.maxKmh) t.maxKmh = speedKmh;
+        }
+        _moving = moving;
+        savePrev(tMs, latE7, lonE7, e, n, speedKmh);
+        return added;
+    }
+
+    void resetTrip(int i) { if (i >= 0 && i < TRIP_COUNT) _st.trip[i].clear(); }
+
+    const TripState& state() const { return _st; }
+    const TripTotals& trip(int i) const { return _st.trip[i < 0 || i >= TRIP_COUNT ? 0 : i]; }
+    double odometerM() const { return _st.odometerM; }
+    float scale() const { return _st.scale; }
+    bool moving() const { return _moving; }
+
+private:
+    void savePrev(uint32_t tMs, int32_t latE7, int32_t lonE7, float e, float n, float kmh) {
+        _prevMs = tMs; _prevLatE7 = latE7; _prevLonE7 = lonE7; _prevE = e; _prevN = n; _prevKmh = kmh;
+        _havePrev = true;
+    }
+
+    void resetWindow() { _calRawM = _calPosM = _stepRawM = 0.0f; _anchored = false; }
+
+    // Compare the speed integral with the chord path over one window, then nudge the scale
+    void calibrate(float rawM, float e, float n, float speedKmh, float hAccM) {
+        bool good = speedKmh >= TRIP_CAL_MIN_KMH && hAccM <= TRIP_CAL_MAX_HACC_M;
+        if (!good) { resetWindow(); return; }
+        if (!_anchored) { _anchorE = e; _anchorN = n; _anchored = true; return; }
+        _stepRawM += rawM;
+        if (_stepRawM < TRIP_CAL_STEP_M) return;
+        _calPosM += hypotf(e - _anchorE, n - _anchorN);
+        _calRawM += _stepRawM;
+        _stepRawM = 0.0f;
+        _anchorE = e; _anchorN = n;
+        if (_calRawM < TRIP_CAL_WINDOW_M) return;
+        float ratio = _calPosM / _calRawM;
+        // A ratio this far off is a multipath burst or a bad window, not a scale error
+        if (ratio > 0.8f && ratio < 1.2f) {
+            float s = _st.scale + TRIP_CAL_GAIN * (ratio - _st.scale);
+            _st.scale = s < TRIP_SCALE_MIN ? TRIP_SCALE_MIN : (s > TRIP_SCALE_MAX ? TRIP_SCALE_MAX : s);
+            _st.calibrations++;
+        }
+        _calRawM = _calPosM = 0.0f;
+    }
+
+    TripState _st;
+    geo::LocalFrame _frame;
+    uint32_t _prevMs;
+    int32_t _prevLatE7, _prevLonE7;
+    float _prevE, _prevN, _prevKmh;
+    bool _havePrev;
+    bool _moving;
+    // Calibration window
+    float _anchorE, _anchorN;
+    float _stepRawM, _calRawM, _calPosM;
+    bool _anchored;
+};
+
+} // namespace nav
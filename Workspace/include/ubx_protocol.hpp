@@ -0,0 +1,381 @@
+#pragma once
+// u-blox UBX binary protocol: streaming frame decoder and NAV message views.
+// Frame: 0xB5 0x62 | class | id | length (LE u16) | payload | CK_A CK_B (8-bit Fletcher over
+// class..payload). Payload fields are little-endian and unaligned, so they are read bytewise.
+// Pure C++ (no Arduino dependency) so it can be fed captured .ubx streams on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+namespace ubx {
+
+static constexpr uint8_t SYNC1 = 0xB5;
+static constexpr uint8_t SYNC2 = 0x62;
+
+// Message classes / ids used by this project
+static constexpr uint8_t CLS_NAV = 0x01;
+static constexpr uint8_t NAV_SOL    = 0x06;
+static constexpr uint8_t NAV_PVT    = 0x07;
+static constexpr uint8_t NAV_VELNED = 0x12;
+
+static constexpr uint8_t CLS_ACK = 0x05;
+static constexpr uint8_t ACK_NAK = 0x00;
+static constexpr uint8_t ACK_ACK = 0x01;
+
+static constexpr uint8_t CLS_CFG = 0x06;
+static constexpr uint8_t CFG_PRT  = 0x00;
+static constexpr uint8_t CFG_MSG  = 0x01;
+static constexpr uint8_t CFG_RATE = 0x08;
+static constexpr uint8_t CFG_CFG  = 0x09;
+static constexpr uint8_t CFG_RXM  = 0x11;
+static constexpr uint8_t CFG_PM2  = 0x3B;
+
+static constexpr uint8_t CLS_AID = 0x0B;
+static constexpr uint8_t AID_INI  = 0x01;
+
+// Standard NMEA sentences as UBX message ids (for CFG-MSG)
+static constexpr uint8_t CLS_NMEA = 0xF0;
+static constexpr uint8_t NMEA_GGA = 0x00;
+static constexpr uint8_t NMEA_GLL = 0x01;
+static constexpr uint8_t NMEA_GSA = 0x02;
+static constexpr uint8_t NMEA_GSV = 0x03;
+static constexpr uint8_t NMEA_RMC = 0x04;
+static constexpr uint8_t NMEA_VTG = 0x05;
+static constexpr uint8_t NMEA_GST = 0x07;
+static constexpr uint8_t NMEA_ZDA = 0x08;
+
+// CFG-PRT protocol masks
+static constexpr uint16_t PROTO_UBX  = 0x0001;
+static constexpr uint16_t PROTO_NMEA = 0x0002;
+
+// Little-endian readers
+static inline uint8_t  u1(const uint8_t* p) { return p[0]; }
+static inline uint16_t u2(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t u4(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static inline int32_t  i4(const uint8_t* p) { return (int32_t)u4(p); }
+
+// 8-bit Fletcher checksum, accumulated into a/b
+static inline void fletcher(const uint8_t* p, size_t n, uint8_t &a, uint8_t &b) {
+    for (size_t i = 0; i < n; ++i) { a += p[i]; b += a; }
+}
+
+static inline void put2(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put4(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24); }
+
+// Wrap a payload into a complete frame. Returns the frame size, or 0 if 'out' is too small.
+static inline size_t encode(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len,
+                            uint8_t* out, size_t outSize) {
+    size_t total = (size_t)len + 8;
+    if (outSize < total) return 0;
+    out[0] = SYNC1; out[1] = SYNC2; out[2] = cls; out[3] = id; put2(out + 4, len);
+    for (uint16_t i = 0; i < len; ++i) out[6 + i] = payload[i];
+    uint8_t a = 0, b = 0;
+    fletcher(out + 2, (size_t)len + 4, a, b);
+    out[6 + len] = a; out[7 + len] = b;
+    return total;
+}
+
+// ---------- CFG builders (payload only; pass to encode()) ----------
+
+// CFG-PRT for UART1, 8N1, at 'baud' with the given in/out protocol masks. 20-byte payload.
+static inline uint16_t cfgPrtUart(uint8_t* p, uint32_t baud, uint16_t inProto, uint16_t outProto) {
+    for (int i = 0; i < 20; ++i) p[i] = 0;
+    p[0] = 1;                 // portID: UART1
+    put4(p + 4, 0x000008D0);  // mode: 8 data bits, no parity, 1 stop bit
+    put4(p + 8, baud);
+    put2(p + 12, inProto);
+    put2(p + 14, outProto);
+    return 20;
+}
+
+// CFG-RATE: measurement period in ms, one navigation solution per measurement, GPS time
+static inline uint16_t cfgRate(uint8_t* p, uint16_t measRateMs) {
+    put2(p + 0, measRateMs); put2(p + 2, 1); put2(p + 4, 1);
+    return 6;
+}
+
+// CFG-MSG (current port form): output 'msgCls/msgId' every 'rate' navigation solutions (0 = off)
+static inline uint16_t cfgMsg(uint8_t* p, uint8_t msgCls, uint8_t msgId, uint8_t rate) {
+    p[0] = msgCls; p[1] = msgId; p[2] = rate;
+    return 3;
+}
+
+// CFG-CFG: save the current configuration to BBR, flash and EEPROM (whatever is fitted)
+static inline uint16_t cfgSave(uint8_t* p) {
+    for (int i = 0; i < 13; ++i) p[i] = 0;
+    put4(p + 4, 0x0000FFFF);  // saveMask: all sections
+    p[12] = 0x17;             // deviceMask: BBR | flash | EEPROM | SPI flash
+    return 13;
+}
+
+// CFG-RXM: receiver power mode, 0 = continuous, 1 = power save (as configured by CFG-PM2)
+static constexpr uint8_t LP_CONTINUOUS = 0;
+static constexpr uint8_t LP_POWER_SAVE = 1;
+
+static inline uint16_t cfgRxm(uint8_t* p, uint8_t lpMode) {
+    p[0] = 8;                 // reserved, must be 8
+    p[1] = lpMode;
+    return 2;
+}
+
+// CFG-PM2 (version 1, u-blox 7/M8): cyclic tracking with one fix per 'updatePeriodMs', retrying
+// acquisition every 'searchPeriodMs' when the fix is lost. Ephemeris is kept up to date and the
+// receiver never drops to the inactive state on its own. 44-byte payload.
+static inline uint16_t cfgPm2Cyclic(uint8_t* p, uint32_t updatePeriodMs, uint32_t searchPeriodMs) {
+    for (int i = 0; i < 44; ++i) p[i] = 0;
+    p[0] = 1;                                   // version
+    put4(p + 4, (1UL << 17) | (1UL << 16) | (1UL << 12)); // mode cyclic, doNotEnterOff, updateEPH
+    put4(p + 8, updatePeriodMs);
+    put4(p + 12, searchPeriodMs);
+    return 44;
+}
+
+// ---------- AID builders ----------
+
+// AID-INI with an LLA position and, optionally, UTC time. 48-byte payload. Not acknowledged by
+// the receiver. Time is packed as YYMM / DDHHMMSS decimal when the UTC flag is set.
+struct AidUtc {
+    uint16_t year; uint8_t month, day, hour, min, sec;
+    uint32_t accMs;     // time accuracy
+};
+
+static inline uint16_t aidIniLla(uint8_t* p, int32_t latE7, int32_t lonE7, int32_t altCm, uint32_t posAccCm,
+                                 const AidUtc* utc) {
+    for (int i = 0; i < 48; ++i) p[i] = 0;
+    put4(p + 0, (uint32_t)latE7);
+    put4(p + 4, (uint32_t)lonE7);
+    put4(p + 8, (uint32_t)altCm);
+    put4(p + 12, posAccCm);
+    uint32_t flags = 0x01 | 0x20;             // pos valid, position is LLA
+    if (utc) {
+        put2(p + 18, (uint16_t)((utc->year % 100) * 100 + utc->month));
+        put4(p + 20, (uint32_t)utc->day * 1000000u + utc->hour * 10000u + utc->min * 100u + utc->sec);
+        put4(p + 28, utc->accMs);
+        flags |= 0x02 | 0x400;                // time valid, time is UTC
+    }
+    put4(p + 44, flags);
+    return 48;
+}
+
+// Streaming decoder. feed() returns true when a checksum-valid frame is available through
+// msgClass()/msgId()/payload()/length(); the view stays valid until the next feed().
+class Decoder {
+public:
+    // Largest payload kept in RAM. NAV-PVT (92 bytes on M8, 84 on u-blox 7) is the biggest
+    // message we decode; anything longer is skipped without buffering.
+    static constexpr uint16_t MAX_PAYLOAD = 100;
+    // Longest frame skipped over. The biggest messages a receiver sends unprompted (NAV-SAT,
+    // NAV-SIG, MON-VER) stay well under this; a longer length field is taken for line noise and
+    // the decoder goes straight back to hunting for sync instead of dropping up to 64 KB.
+    static constexpr uint16_t MAX_FRAME = 1024;
+
+    struct Stats {
+        uint32_t frames = 0;          // checksum-valid frames
+        uint32_t checksumErrors = 0;
+        uint32_t oversize = 0;        // frames longer than MAX_PAYLOAD (skipped)
+        uint32_t badLength = 0;       // length fields over MAX_FRAME (header dropped, resynced)
+    };
+
+    void reset() { _state = SYNC_1; }
+
+    bool feed(uint8_t b) {
+        switch (_state) {
+            case SYNC_1:
+                if (b == SYNC1) _state = SYNC_2;
+                return false;
+            case SYNC_2:
+                _state = (b == SYNC2) ? CLASS : (b == SYNC1 ? SYNC_2 : SYNC_1);
+                return false;
+            case CLASS:
+                _cls = b; _ckA = b; _ckB = b; _state = ID;
+                return false;
+            case ID:
+                _id = b; step(b); _state = LEN_1;
+                return false;
+            case LEN_1:
+                _len = b; step(b); _state = LEN_2;
+                return false;
+            case LEN_2:
+                _len |= (uint16_t)b << 8; step(b); _pos = 0;
+                if (_len > MAX_FRAME) { _stats.badLength++; _state = (b == SYNC1) ? SYNC_2 : SYNC_1; return false; }
+                _skip = (_len > MAX_PAYLOAD);
+                _state = (_len == 0) ? CK_A : PAYLOAD;
+                return false;
+            case PAYLOAD:
+                step(b);
+                if (!_skip) _buf[_pos] = b;
+                if (++_pos >= _len) _state = CK_A;
+                return false;
+            case CK_A:
+                _rxA = b; _state = CK_B;
+                return false;
+            case CK_B:
+                _state = SYNC_1;
+                if (_skip) { _stats.oversize++; return false; }
+                if (_rxA != _ckA || b != _ckB) { _stats.checksumErrors++; return false; }
+                _stats.frames++;
+                return true;
+        }
+        return false;
+    }
+
+    uint8_t msgClass() const { return _cls; }
+    uint8_t msgId() const { return _id; }
+    uint16_t length() const { return _len; }
+    const uint8_t* payload() const { return _buf; }
+    const Stats& stats() const { return _stats; }
+
+private:
+    enum State : uint8_t { SYNC_1, SYNC_2, CLASS, ID, LEN_1, LEN_2, PAYLOAD, CK_A, CK_B };
+    void step(uint8_t b) { _ckA += b; _ckB += _ckA; }
+
+    State _state = SYNC_1;
+    uint8_t _cls = 0, _id = 0;
+    uint16_t _len = 0, _pos = 0;
+    uint8_t _ckA = 0, _ckB = 0, _rxA = 0;
+    bool _skip = false;
+    uint8_t _buf[MAX_PAYLOAD];
+    Stats _stats;
+};
+
+// ---------- NAV message views (decoded straight from the payload, integer units) ----------
+
+// UBX-NAV-PVT (0x01 0x07): 84 bytes on u-blox 7, 92 on u-blox 8+. Common prefix is decoded.
+struct NavPvt {
+    uint32_t iTOW;      // ms
+    uint16_t year; uint8_t month, day, hour, min, sec;
+    uint8_t valid;      // bit0 validDate, bit1 validTime
+    int32_t nano;       // ns, signed fraction of second
+    uint8_t fixType;    // 0 none, 1 DR, 2 2D, 3 3D, 4 GNSS+DR, 5 time only
+    uint8_t flags;      // bit0 gnssFixOK, bit1 diffSoln
+    uint8_t numSV;
+    int32_t lonE7, latE7;
+    int32_t heightMm, hMSLmm;
+    uint32_t hAccMm, vAccMm;
+    int32_t velNmms, velEmms, velDmms;
+    int32_t gSpeedMms;
+    int32_t headMotE5;  // 1e-5 deg
+    uint32_t sAccMms;
+    uint32_t headAccE5;
+    uint16_t pDOPx100;
+};
+
+static inline bool parseNavPvt(const uint8_t* p, uint16_t len, NavPvt &o) {
+    if (len < 84) return false;
+    o.iTOW = u4(p + 0);
+    o.year = u2(p + 4); o.month = u1(p + 6); o.day = u1(p + 7);
+    o.hour = u1(p + 8); o.min = u1(p + 9); o.sec = u1(p + 10);
+    o.valid = u1(p + 11);
+    o.nano = i4(p + 16);
+    o.fixType = u1(p + 20); o.flags = u1(p + 21); o.numSV = u1(p + 23);
+    o.lonE7 = i4(p + 24); o.latE7 = i4(p + 28);
+    o.heightMm = i4(p + 32); o.hMSLmm = i4(p + 36);
+    o.hAccMm = u4(p + 40); o.vAccMm = u4(p + 44);
+    o.velNmms = i4(p + 48); o.velEmms = i4(p + 52); o.velDmms = i4(p + 56);
+    o.gSpeedMms = i4(p + 60); o.headMotE5 = i4(p + 64);
+    o.sAccMms = u4(p + 68); o.headAccE5 = u4(p + 72);
+    o.pDOPx100 = u2(p + 76);
+    return true;
+}
+
+// UBX-NAV-VELNED (0x01 0x12), 36 bytes
+struct NavVelned {
+    uint32_t iTOW;
+    int32_t velNcms, velEcms, velDcms;
+    uint32_t speedCms, gSpeedCms;
+    int32_t headingE5;
+    uint32_t sAccCms;
+    uint32_t cAccE5;
+};
+
+static inline bool parseNavVelned(const uint8_t* p, uint16_t len, NavVelned &o) {
+    if (len < 36) return false;
+    o.iTOW = u4(p + 0);
+    o.velNcms = i4(p + 4); o.velEcms = i4(p + 8); o.velDcms = i4(p + 12);
+    o.speedCms = u4(p + 16); o.gSpeedCms = u4(p + 20);
+    o.headingE5 = i4(p + 24);
+    o.sAccCms = u4(p + 28); o.cAccE5 = u4(p + 32);
+    return true;
+}
+
+// UBX-NAV-SOL (0x01 0x06), 52 bytes. Position is ECEF, so only fix/accuracy fields are used.
+struct NavSol {
+    uint32_t iTOW;
+    uint8_t gpsFix;     // 0 none, 1 DR, 2 2D, 3 3D, 4 GNSS+DR, 5 time only
+    uint8_t flags;      // bit0 gpsFixOk, bit1 diffSoln
+    uint32_t pAccCm;    // 3D position accuracy
+    uint32_t sAccCms;
+    uint16_t pDOPx100;
+    uint8_t numSV;
+};
+
+static inline bool parseNavSol(const uint8_t* p, uint16_t len, NavSol &o) {
+    if (len < 52) return false;
+    o.iTOW = u4(p + 0);
+    o.gpsFix = u1(p + 10); o.flags = u1(p + 11);
+    o.pAccCm = u4(p + 24);
+    o.sAccCms = u4(p + 40);
+    o.pDOPx100 = u2(p + 44);
+    o.numSV = u1(p + 47);
+    return true;
+}
+
+// ---------- Mapping onto GPSData (src/gps_module.h) ----------
+// Templated on the target so the mapping also runs on the host; 'D' needs GPSData's members of
+// the same names. Speeds land ungated: the caller applies its speed gate afterwards.
+
+// NAV fix type/flags on the GGA quality scale: 0 = none, 1 = GPS, 2 = differential
+static inline uint8_t fixQuality(uint8_t fixType, uint8_t flags) {
+    bool fixOk = (flags & 0x01) && fixType >= 2 && fixType <= 4;
+    return fixOk ? ((flags & 0x02) ? 2 : 1) : 0;
+}
+
+template <class D>
+static inline void applyFix(D &d, uint8_t fixType, uint8_t flags, uint8_t numSV) {
+    d.fixQuality = fixQuality(fixType, flags);
+    bool fixOk = d.fixQuality > 0;
+    d.fixMode = fixOk ? (fixType == 2 ? 2 : 3) : 1;       // same scale as GSA
+    d.validFix = fixOk;
+    d.satsUsed = numSV;
+}
+
+template <class D>
+static inline void applySpeed(D &d, int32_t gSpeedMms, int32_t headingE5, uint32_t sAccMms) {
+    d.speedKmh = gSpeedMms * 0.0036f;
+    d.speedKnots = d.speedKmh / 1.852f;
+    d.courseDeg = headingE5 * 1e-5f;
+    d.sAccKmh = sAccMms * 0.0036f;
+    d.sAccMeasured = true;
+}
+
+template <class D>
+static inline void applyNavPvt(D &d, const NavPvt &m) {
+    applyFix(d, m.fixType, m.flags, m.numSV);
+    d.latE7 = m.latE7;
+    d.lonE7 = m.lonE7;
+    d.altitude = m.hMSLmm * 0.001f;
+    d.hAccM = m.hAccMm * 0.001f;
+    d.vAccM = m.vAccMm * 0.001f;
+    d.pdop = m.pDOPx100 * 0.01f;
+    applySpeed(d, m.gSpeedMms, m.headMotE5, m.sAccMms);
+    if (m.valid & 0x01) snprintf(d.date, sizeof(d.date), "%02u%02u%02u", m.day % 32u, m.month % 13u, m.year % 100u);
+    if (m.valid & 0x02) {
+        unsigned cs = m.nano > 0 ? (unsigned)(m.nano / 10000000) % 100u : 0; // hundredths, like "HHMMSS.ss" from NMEA
+        snprintf(d.timeUTC, sizeof(d.timeUTC), "%02u%02u%02u.%02u", m.hour % 24u, m.min % 60u, m.sec % 61u, cs);
+    }
+}
+
+template <class D>
+static inline void applyNavVelned(D &d, const NavVelned &m) {
+    applySpeed(d, (int32_t)m.gSpeedCms * 10, m.headingE5, m.sAccCms * 10);
+}
+
+template <class D>
+static inline void applyNavSol(D &d, const NavSol &m) {
+    applyFix(d, m.gpsFix, m.flags, m.numSV);
+    d.hAccM = m.pAccCm * 0.01f; // 3D estimate; NAV-SOL has no horizontal-only figure
+    d.pdop = m.pDOPx100 * 0.01f;
+}
+
+} // namespace ubx
@@ -0,0 +1,445 @@
+#pragma once
+// Offline vector basemap: pre-tiled roads and coastline read in place from memory-mapped flash,
+// decoded on demand into a small LRU cache.
+// The image (tools/build_tile_image.py) holds one Web Mercator zoom level: a 32-byte header, an
+// index of (key, offset) pairs sorted by key = x << 16 | y with one sentinel entry whose offset
+// is the end of the data, then the tile payloads. A payload is a run of polylines, each a kind
+// byte, a varint point count and zig-zag varint deltas of tile-local coordinates (0..4096 across
+// the tile, a little over at the edges where lines are clipped with a margin). Decoding one is a
+// binary search plus a single pass over its bytes; the cache keeps the last few decoded tiles,
+// so a drive decodes each tile once while it stays in view. Their points share one pool sized for
+// what a frame shows, so a sparse tile costs what it holds rather than TILE_MAX_POINTS.
+// Pure C++ (no Arduino dependency) so it also builds on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "track_codec.hpp"   // crc32 and varints, the same encoding the build tool writes
+
+namespace tiles {
+
+enum FeatureKind : uint8_t { KIND_MAJOR = 1, KIND_MINOR = 2, KIND_WATER = 3 };
+
+struct Header {
+    char magic[4];       // "VTL1"
+    uint32_t version;    // 1
+    uint32_t zoom;
+    uint32_t count;      // tiles (the index has count + 1 entries)
+    uint32_t dataSize;   // bytes after the header: index and payloads
+    uint32_t crc;        // CRC-32 of those bytes
+    uint32_t created;    // unix time of the build
+    uint32_t reserved;
+};
+static_assert(sizeof(Header) == 32, "tile header layout is fixed by the image format");
+
+struct IndexEntry {
+    uint32_t key;
+    uint32_t offset;     // from the start of the image
+};
+
+static constexpr uint32_t TILE_VERSION = 1;
+static constexpr int TILE_EXTENT = 4096;
+static constexpr int TILE_MAX_POINTS = 1024;      // per decoded tile; the rest is dropped (counted)
+static constexpr int TILE_MAX_FEATURES = 160;
+static constexpr double EARTH_CIRCUMFERENCE_M = 40075016.686;
+
+static inline uint32_t tileKey(uint32_t x, uint32_t y) { return x << 16 | (y & 0xFFFF); }
+
+// Fractional Web Mercator tile coordinates
+static inline double lonToTileX(double lonDeg, int zoom) { return (lonDeg + 180.0) / 360.0 * (double)(1u << zoom); }
+static inline double latToTileY(double latDeg, int zoom) {
+    double r = latDeg * (M_PI / 180.0);
+    return (1.0 - log(tan(r) + 1.0 / cos(r)) / M_PI) * 0.5 * (double)(1u << zoom);
+}
+static inline double tileXToLon(double x, int zoom) { return x / (double)(1u << zoom) * 360.0 - 180.0; }
+static inline double tileYToLat(double y, int zoom) {
+    double n = M_PI * (1.0 - 2.0 * y / (double)(1u << zoom));
+    return atan(sinh(n)) * (180.0 / M_PI);
+}
+// Ground metres per tile unit at a latitude (Mercator is conformal: the same east and south)
+static inline double metersPerUnit(double latDeg, int zoom) {
+    return EARTH_CIRCUMFERENCE_M * cos(latDeg * (M_PI / 180.0)) / (double)(1u << zoom) / TILE_EXTENT;
+}
+
+// Keys of the tiles within 'radius' (in tiles) of the fractional tile position, nearest first
+static inline int tilesAround(double fx, double fy, double radius, int zoom, uint32_t* keys, int maxKeys) {
+    int n = 0;
+    float dist[64];
+    int64_t lim = (int64_t)1 << zoom;
+    int64_t x0 = (int64_t)floor(fx - radius), x1 = (int64_t)floor(fx + radius);
+    int64_t y0 = (int64_t)floor(fy - radius), y1 = (int64_t)floor(fy + radius);
+    if (maxKeys > 64) maxKeys = 64;
+    for (int64_t ty = y0; ty <= y1; ++ty) {
+        if (ty < 0 || ty >= lim) continue;
+        for (int64_t tx = x0; tx <= x1; ++tx) {
+            if (tx < 0 || tx >= lim) continue;
+            // Distance from the point to the tile's square
+            double dx = fx < tx ? tx - fx : (fx > tx + 1 ? fx - tx - 1 : 0.0);
+            double dy = fy < ty ? ty - fy : (fy > ty + 1 ? fy - ty - 1 : 0.0);
+            float d = (float)(dx * dx + dy * dy);
+            if (d > radius * radius) continue;
+            int at;
+            if (n < maxKeys) at = n++;
+            else if (dist[n - 1] > d) at = n - 1;
+            else continue;
+            while (at > 0 && dist[at - 1] > d) { dist[at] = dist[at - 1]; keys[at] = keys[at - 1]; --at; }
+            dist[at] = d;
+            keys[at] = tileKey((uint32_t)tx, (uint32_t)ty);
+        }
+    }
+    return n;
+}
+
+// Image validation: header, index bounds and (optionally, it reads the whole image) the CRC
+static inline bool checkImage(const uint8_t* base, size_t size, bool checkCrc) {
+    if (!base || size < sizeof(Header)) return false;
+    Header h;
+    memcpy(&h, base, sizeof(h));
+    if (memcmp(h.magic, "VTL1", 4) != 0 || h.version != TILE_VERSION || h.zoom > 16) return false;
+    if (h.dataSize > size - sizeof(Header) || ((uint64_t)h.count + 1) * sizeof(IndexEntry) > h.dataSize) return false;
+    if (checkCrc && track::crc32(base + sizeof(Header), h.dataSize) != h.crc) return false;
+    IndexEntry last;
+    memcpy(&last, base + sizeof(Header) + (size_t)h.count * sizeof(IndexEntry), sizeof(last));
+    return last.offset <= sizeof(Header) + h.dataSize;
+}
+
+// One tile, decoded: polylines as runs of points. The arrays belong to whoever decoded it (a
+// TileCache's pool or a TileBuffer).
+struct DecodedTile {
+    uint32_t key;
+    uint16_t points;
+    uint16_t features;
+    uint16_t* featStart;   // first point of each feature, then 'points' (features + 1 entries)
+    uint8_t* kind;
+    int16_t* x;
+    int16_t* y;
+    bool truncated;
+
+    void clear(uint32_t k) { key = k; points = features = 0; truncated = false; }
+};
+
+// Room for one tile at the full TILE_MAX_POINTS/FEATURES, for decoding outside a cache (tools,
+// tests). Holds pointers into itself, so it is not copyable.
+struct TileBuffer {
+    DecodedTile tile;
+    uint16_t featStart[TILE_MAX_FEATURES + 1];
+    uint8_t kind[TILE_MAX_FEATURES];
+    int16_t x[TILE_MAX_POINTS];
+    int16_t y[TILE_MAX_POINTS];
+
+    TileBuffer() { tile.featStart = featStart; tile.kind = kind; tile.x = x; tile.y = y; tile.clear(0); }
+    TileBuffer(const TileBuffer &) = delete;
+    TileBuffer& operator=(const TileBuffer &) = delete;
+};
+
+class TileSet {
+public:
+    TileSet() : _base(nullptr), _index(nullptr), _count(0), _zoom(0) {}
+
+    // Point at a validated image (see checkImage); the memory must stay mapped
+    void attach(const uint8_t* base) {
+        Header h;
+        memcpy(&h, base, sizeof(h));
+        _base = base;
+        _index = base + sizeof(Header);
+        _count = h.count;
+        _zoom = (int)h.zoom;
+    }
+
+    uint32_t count() const { return _count; }
+    int zoom() const { return _zoom; }
+
+    // Payload of a tile; false when the set has no such tile (open sea, outside the region)
+    bool find(uint32_t key, const uint8_t* &data, size_t &len) const {
+        uint32_t lo = 0, hi = _count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (entry(mid).key < key) lo = mid + 1; else hi = mid;
+        }
+        if (lo >= _count) return false;
+        IndexEntry e = entry(lo);
+        if (e.key != key) return false;
+        IndexEntry nx = entry(lo + 1);
+        data = _base + e.offset;
+        len = nx.offset - e.offset;
+        return true;
+    }
+
+    // Decode a payload into 'out', whose arrays have room for 'maxPoints' points and
+    // 'maxFeatures' features (plus the closing featStart). Whatever does not fit is dropped and
+    // the tile marked truncated. False if it is malformed (what was decoded so far is kept).
+    static bool decode(const uint8_t* p, size_t len, uint32_t key, DecodedTile &out,
+                       int maxPoints = TILE_MAX_POINTS, int maxFeatures = TILE_MAX_FEATURES) {
+        out.clear(key);
+        out.featStart[0] = 0;
+        const uint8_t* end = p + len;
+        while (p < end) {
+            uint8_t kind = *p++;
+            uint64_t n;
+            size_t used = track::getVarint(p, end, n);
+            if (!used) return false;
+            p += used;
+            bool keep = out.features < maxFeatures;
+            if (keep) out.kind[out.features] = kind;
+            int32_t x = 0, y = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t dx, dy;
+                if (!(used = track::getVarint(p, end, dx))) return false;
+                p += used;
+                if (!(used = track::getVarint(p, end, dy))) return false;
+                p += used;
+                x += (int32_t)track::unzigzag(dx);
+                y += (int32_t)track::unzigzag(dy);
+                if (!keep) continue;
+                if (out.points >= maxPoints) { out.truncated = true; keep = false; continue; }
+                out.x[out.points] = (int16_t)x;
+                out.y[out.points] = (int16_t)y;
+                out.points++;
+            }
+            if (out.features < maxFeatures) {
+                if (out.points > out.featStart[out.features]) out.featStart[++out.features] = out.points;
+            } else out.truncated = true;
+        }
+        return true;
+    }
+
+private:
+    IndexEntry entry(uint32_t i) const { IndexEntry e; memcpy(&e, _index + (size_t)i * sizeof(IndexEntry), sizeof(e)); return e; }
+
+    const uint8_t* _base;
+    const uint8_t* _index;
+    uint32_t _count;
+    int _zoom;
+};
+
+// Fixed-size LRU of decoded tiles. Lookups are a scan of SLOTS keys, which for a handful of slots
+// beats any structure. The tiles' points and features sit packed, in slot order, in pools of
+// POOL_POINTS and POOL_FEATURES entries; evicting a tile moves the ones after it down. A decode
+// that does not fit evicts further least recently used tiles, but never one handed out since
+// beginFrame(); if it still does not fit the tile is dropped (not cached, counted).
+// 'clockUs' times the decodes for the counters.
+template<int SLOTS, int POOL_POINTS, int POOL_FEATURES>
+class TileCache {
+public:
+    struct Stats {
+        uint32_t hits;
+        uint32_t misses;       // decoded on demand
+        uint32_t absent;       // not in the set (nothing to draw), cached as such
+        uint32_t prefetched;   // decoded ahead of need
+        uint32_t prefetchHits; // demand lookups served by a prefetch
+        uint32_t errors;       // malformed payloads
+        uint32_t truncated;    // tiles cut at TILE_MAX_POINTS/FEATURES
+        uint32_t dropped;      // tiles that did not fit the pools beside the ones on screen
+        uint32_t decodeLastUs, decodeMaxUs;
+        uint64_t decodeTotalUs;
+        uint16_t peakPoints, peakFeatures;   // pool high-water marks
+    };
+
+    explicit TileCache(uint32_t (*clockUs)()) : _clockUs(clockUs), _tick(0) { clear(); }
+    // The slots point into the pools
+    TileCache(const TileCache &) = delete;
+    TileCache& operator=(const TileCache &) = delete;
+
+    void clear() {
+        for (int i = 0; i < SLOTS; ++i) { _slot[i].used = 0; _slot[i].state = EMPTY; }
+        _held = 0;
+        _points = _features = 0;
+        _pinFrom = ~0u;
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    // Tiles handed out from here on are in use until the next call: room for a decode is never
+    // made by evicting them
+    void beginFrame() { _pinFrom = _tick + 1; }
+
+    // The decoded tile, or nullptr when the set has no such tile or 'mayDecode' is false and it
+    // is not cached yet (the caller ran out of decode budget this frame)
+    const DecodedTile* get(const TileSet &set, uint32_t key, bool mayDecode, bool* decoded = nullptr) {
+        if (decoded) *decoded = false;
+        int i = lookup(key);
+        if (i >= 0) {
+            _slot[i].used = ++_tick;
+            if (_slot[i].state == ABSENT) return nullptr;
+            _stats.hits++;
+            if (_slot[i].prefetched) { _stats.prefetchHits++; _slot[i].prefetched = false; }
+            return &_slot[i].tile;
+        }
+        if (!mayDecode) return nullptr;
+        if (decoded) *decoded = true;
+        i = load(set, key, false);
+        return _slot[i].state == READY ? &_slot[i].tile : nullptr;
+    }
+
+    // Decode a tile before it is needed (no-op when cached). Returns true if it decoded one.
+    bool prefetch(const TileSet &set, uint32_t key) {
+        if (lookup(key) >= 0) return false;
+        load(set, key, true);
+        return true;
+    }
+
+    bool cached(uint32_t key) const { return lookup(key) >= 0; }
+    const Stats& stats() const { return _stats; }
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    enum SlotState : uint8_t { EMPTY, READY, ABSENT };
+    struct Slot {
+        DecodedTile tile;
+        uint32_t used;
+        SlotState state;
+        bool prefetched;
+    };
+
+    int lookup(uint32_t key) const {
+        for (int i = 0; i < SLOTS; ++i) if (_slot[i].state != EMPTY && _slot[i].tile.key == key) return i;
+        return -1;
+    }
+
+    // Give back a READY slot's share of the pools, moving the tiles after it down
+    void release(int v) {
+        DecodedTile &t = _slot[v].tile;
+        int np = t.points, nf = t.features + 1;
+        int at = 0;
+        while (_order[at] != v) ++at;
+        size_t tailP = _x + _points - (t.x + np), tailF = _featStart + _features - (t.featStart + nf);
+        memmove(t.x, t.x + np, tailP * sizeof(int16_t));
+        memmove(t.y, t.y + np, tailP * sizeof(int16_t));
+        memmove(t.featStart, t.featStart + nf, tailF * sizeof(uint16_t));
+        memmove(t.kind, t.kind + nf, tailF * sizeof(uint8_t));
+        for (int k = at + 1; k < _held; ++k) {
+            DecodedTile &m = _slot[_order[k]].tile;
+            m.x -= np; m.y -= np; m.featStart -= nf; m.kind -= nf;
+            _order[k - 1] = _order[k];
+        }
+        _held--;
+        _points -= np;
+        _features -= nf;
+        _slot[v].state = EMPTY;
+    }
+
+    // Evict the least recently used tile that is not in use this frame (nor 'keep'); false if none
+    bool evictForRoom(int keep) {
+        int v = -1;
+        for (int i = 0; i < SLOTS; ++i)
+            if (i != keep && _slot[i].state == READY && _slot[i].used < _pinFrom && (v < 0 || _slot[i].used < _slot[v].used)) v = i;
+        if (v < 0) return false;
+        release(v);
+        _slot[v].used = 0;
+        return true;
+    }
+
+    int load(const TileSet &set, uint32_t key, bool prefetch) {
+        // Least recently used slot (empty ones have used == 0)
+        int v = 0;
+        for (int i = 1; i < SLOTS; ++i) if (_slot[i].used < _slot[v].used) v = i;
+        Slot &s = _slot[v];
+        if (s.state == READY) release(v);
+        s.used = ++_tick;
+        s.prefetched = prefetch;
+        const uint8_t* data; size_t len;
+        if (!set.find(key, data, len)) { s.tile.clear(key); s.state = ABSENT; _stats.absent++; return v; }
+        uint32_t t0 = _clockUs();
+        bool ok, fits;
+        do {
+            // Into the free tail of the pools; cut short there means it needs more room
+            int roomP = POOL_POINTS - _points, roomF = POOL_FEATURES - _features - 1;
+            int maxP = roomP < TILE_MAX_POINTS ? roomP : TILE_MAX_POINTS, maxF = roomF < TILE_MAX_FEATURES ? roomF : TILE_MAX_FEATURES;
+            s.tile.x = _x + _points; s.tile.y = _y + _points;
+            s.tile.featStart = _featStart + _features; s.tile.kind = _kind + _features;
+            if (maxF < 0) { ok = true; fits = false; continue; }
+            ok = TileSet::decode(data, len, key, s.tile, maxP, maxF);
+            fits = !s.tile.truncated || (maxP == TILE_MAX_POINTS && maxF == TILE_MAX_FEATURES);
+        } while (!fits && evictForRoom(v));
+        uint32_t us = _clockUs() - t0;
+        if (!fits) { s.state = EMPTY; s.used = 0; _stats.dropped++; return v; }
+        s.state = READY;
+        _order[_held++] = (uint8_t)v;
+        _points += s.tile.points;
+        _features += s.tile.features + 1;
+        if (_points > _stats.peakPoints) _stats.peakPoints = (uint16_t)_points;
+        if (_features > _stats.peakFeatures) _stats.peakFeatures = (uint16_t)_features;
+        if (!ok) _stats.errors++;
+        if (s.tile.truncated) _stats.truncated++;
+        if (prefetch) _stats.prefetched++; else _stats.misses++;
+        _stats.decodeLastUs = us;
+        if (us > _stats.decodeMaxUs) _stats.decodeMaxUs = us;
+        _stats.decodeTotalUs += us;
+        return v;
+    }
+
+    uint32_t (*_clockUs)();
+    uint32_t _tick;
+    uint32_t _pinFrom;       // slots used since beginFrame() have used >= this
+    Slot _slot[SLOTS];
+    uint8_t _order[SLOTS];   // READY slots in pool order
+    int _held;
+    int _points, _features;  // pool entries in use
+    int16_t _x[POOL_POINTS];
+    int16_t _y[POOL_POINTS];
+    uint16_t _featStart[POOL_FEATURES];
+    uint8_t _kind[POOL_FEATURES];
+    Stats _stats;
+};
+
+// Per-frame tile selection over a TileSet: the tiles covering a circle around the car, nearest
+// first, decoding at most 'decodeBudget' of them per frame (the rest come on later frames), and
+// with budget to spare one tile ahead along the course, so it is ready before it scrolls in.
+template<int SLOTS, int POOL_POINTS, int POOL_FEATURES>
+class Basemap {
+public:
+    typedef TileCache<SLOTS, POOL_POINTS, POOL_FEATURES> Cache;
+    struct FrameStats {
+        uint32_t frames;
+        uint32_t deferred;     // visible tiles left for a later frame (decode budget spent)
+        uint32_t overflow;     // visible tiles beyond SLOTS - 1 or the pools, not drawn
+    };
+
+    Basemap(uint32_t (*clockUs)(), int decodeBudget, float prefetchSeconds)
+        : _cache(clockUs), _budget(decodeBudget), _aheadS(prefetchSeconds) { memset(&_fs, 0, sizeof(_fs)); }
+
+    void attach(const uint8_t* base) { _set.attach(base); _cache.clear(); }
+    const TileSet& set() const { return _set; }
+    const typename Cache::Stats& cacheStats() const { return _cache.stats(); }
+    const FrameStats& frameStats() const { return _fs; }
+
+    // Decoded tiles within radiusM of the position; returns how many were written to 'out'
+    int frame(double latDeg, double lonDeg, float courseDeg, float speedKmh, float radiusM, const DecodedTile** out, int maxOut) {
+        _fs.frames++;
+        int z = _set.zoom();
+        double fx = lonToTileX(lonDeg, z), fy = latToTileY(latDeg, z);
+        double tileM = metersPerUnit(latDeg, z) * TILE_EXTENT;
+        uint32_t keys[SLOTS];
+        // One slot stays free for the prefetch, so it never evicts a tile on screen
+        int want = SLOTS - 1 < maxOut ? SLOTS - 1 : maxOut;
+        int n = tilesAround(fx, fy, radiusM / tileM, z, keys, SLOTS);
+        if (n > want) { _fs.overflow += n - want; n = want; }
+        int budget = _budget, got = 0;
+        _cache.beginFrame();
+        for (int i = 0; i < n; ++i) {
+            bool decoded;
+            const DecodedTile* t = _cache.get(_set, keys[i], budget > 0, &decoded);
+            if (decoded) { budget--; if (!t && !_cache.cached(keys[i])) _fs.overflow++; }
+            else if (!t && !_cache.cached(keys[i])) _fs.deferred++;
+            if (t) out[got++] = t;
+        }
+        // Ahead: the edge of the circle plus how far we get in _aheadS
+        if (budget > 0 && speedKmh > 5.0f) {
+            double d = (radiusM + speedKmh / 3.6f * _aheadS) / tileM;
+            double c = courseDeg * (M_PI / 180.0);
+            double ax = fx + d * sin(c), ay = fy - d * cos(c);
+            int64_t lim = (int64_t)1 << z;
+            if (ax >= 0 && ay >= 0 && ax < lim && ay < lim) _cache.prefetch(_set, tileKey((uint32_t)ax, (uint32_t)ay));
+        }
+        return got;
+    }
+
+private:
+    TileSet _set;
+    Cache _cache;
+    int _budget;
+    float _aheadS;
+    FrameStats _fs;
+};
+
+} // namespace tiles
@@ -0,0 +1,199 @@
+#include "gps_aiding.h"
+#include <Preferences.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/time.h>
+#include "ubx_protocol.hpp"
+#include "geo_utils.hpp"
+
+// Coalesced NVS writes: the first fix of each boot, then at most once per period and only
+// after moving some distance. The RTC copy is refreshed on every fix for free.
+#ifndef GPS_AIDING_SAVE_MS
+#define GPS_AIDING_SAVE_MS (15UL * 60UL * 1000UL)
+#endif
+#ifndef GPS_AIDING_SAVE_MIN_M
+#define GPS_AIDING_SAVE_MIN_M 500.0f
+#endif
+
+static const char* PREFS_NS = "gpsaid";
+static const char* PREFS_FIX = "fix";
+static const char* PREFS_TTFF = "ttff";
+
+static const uint32_t FIX_MAGIC = 0x47505346;          // "GPSF"
+static const time_t CLOCK_VALID_AFTER = 1704067200;    // 2024-01-01: anything earlier is unset
+static const uint32_t POS_ACC_UNKNOWN_AGE_CM = 5000000; // 50 km when we can't tell how old it is
+static const uint32_t POS_ACC_MAX_CM = 30000000;        // 300 km
+static const uint32_t TIME_ACC_MS = 2000;               // RTC drift over a reset is well inside this
+
+struct SavedFix {
+  uint32_t magic;
+  int32_t latE7, lonE7;
+  int32_t altCm;
+  uint32_t utc;          // unix seconds of the fix, 0 = unknown
+  uint8_t fixQuality;
+  uint8_t check;         // XOR of the bytes above
+};
+
+// Last TTFFs (newest last), in tenths of a second, with how the boot was aided
+struct TtffLog {
+  uint16_t ds[8];
+  uint8_t aided[8];      // bit0 position, bit1 time
+  uint8_t count;
+};
+
+// Survives software resets, watchdog resets and deep sleep; not power loss
+RTC_NOINIT_ATTR static SavedFix rtcFix;
+
+static SavedFix lastSaved;             // what NVS holds
+static bool haveSaved = false;
+static uint8_t bootAided = 0;
+static uint32_t ttffMs = 0;
+static uint32_t lastSaveMs = 0;
+static uint32_t lastClockSetMs = 0;
+
+static uint8_t fixCheck(const SavedFix &f) {
+  const uint8_t* p = (const uint8_t*)&f;
+  uint8_t x = 0x5A;
+  for (size_t i = 0; i < offsetof(SavedFix, check); ++i) x ^= p[i];
+  return x;
+}
+
+static bool fixValid(const SavedFix &f) {
+  return f.magic == FIX_MAGIC && f.check == fixCheck(f);
+}
+
+static bool loadNvs(SavedFix &f) {
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, true)) return false;
+  bool ok = prefs.getBytes(PREFS_FIX, &f, sizeof(f)) == sizeof(f) && fixValid(f);
+  prefs.end();
+  return ok;
+}
+
+static void storeNvs(const SavedFix &f) {
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, false)) return;
+  prefs.putBytes(PREFS_FIX, &f, sizeof(f));
+  prefs.end();
+}
+
+static void loadTtffLog(TtffLog &log) {
+  memset(&log, 0, sizeof(log));
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, true)) return;
+  if (prefs.getBytes(PREFS_TTFF, &log, sizeof(log)) != sizeof(log) || log.count > 8) memset(&log, 0, sizeof(log));
+  prefs.end();
+}
+
+static void appendTtff(uint32_t ms, uint8_t aided) {
+  TtffLog log;
+  loadTtffLog(log);
+  if (log.count == 8) {
+    memmove(log.ds, log.ds + 1, sizeof(log.ds[0]) * 7);
+    memmove(log.aided, log.aided + 1, 7);
+    log.count = 7;
+  }
+  uint32_t ds = (ms + 50) / 100;
+  log.ds[log.count] = (uint16_t)(ds > 0xFFFF ? 0xFFFF : ds);
+  log.aided[log.count] = aided;
+  log.count++;
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, false)) return;
+  prefs.putBytes(PREFS_TTFF, &log, sizeof(log));
+  prefs.end();
+}
+
+static const char* aidedName(uint8_t a) {
+  switch (a & 3) { case 1: return "pos"; case 2: return "time"; case 3: return "pos+time"; default: return "cold"; }
+}
+
+void gps_aiding_begin(GPSAidingReport* report) {
+  GPSAidingReport rep;
+  memset(&rep, 0, sizeof(rep));
+
+  haveSaved = loadNvs(lastSaved);
+  SavedFix use = lastSaved;
+  bool have = haveSaved;
+  if (fixValid(rtcFix)) { use = rtcFix; have = true; rep.fromRtc = true; }
+
+  time_t now = time(nullptr);
+  bool clockValid = now > CLOCK_VALID_AFTER;
+
+  if (have) {
+    ubx::AidUtc utc = { 0, 0, 0, 0, 0, 0, 0 };
+    if (clockValid) {
+      struct tm t;
+      gmtime_r(&now, &t);
+      utc.year = (uint16_t)(t.tm_year + 1900); utc.month = (uint8_t)(t.tm_mon + 1); utc.day = (uint8_t)t.tm_mday;
+      utc.hour = (uint8_t)t.tm_hour; utc.min = (uint8_t)t.tm_min; utc.sec = (uint8_t)t.tm_sec;
+      utc.accMs = TIME_ACC_MS;
+      if (use.utc && (uint32_t)now > use.utc) rep.fixAgeS = (uint32_t)now - use.utc;
+    }
+    // The receiver may have been carried since: widen the uncertainty with the fix age
+    uint32_t posAcc = POS_ACC_UNKNOWN_AGE_CM;
+    if (rep.fixAgeS) {
+      uint64_t acc = 10000ULL + (uint64_t)rep.fixAgeS * 3000ULL; // 100 m + 30 m/s
+      posAcc = acc > POS_ACC_MAX_CM ? POS_ACC_MAX_CM : (uint32_t)acc;
+    }
+    uint8_t payload[48], frame[56];
+    uint16_t len = ubx::aidIniLla(payload, use.latE7, use.lonE7, use.altCm, posAcc, clockValid ? &utc : nullptr);
+    size_t n = ubx::encode(ubx::CLS_AID, ubx::AID_INI, payload, len, frame, sizeof(frame));
+    rep.injected = n > 0 && gps_write(frame, n) == n;
+    rep.position = rep.injected;
+    rep.time = rep.injected && clockValid;
+  }
+  bootAided = (uint8_t)((rep.position ? 1 : 0) | (rep.time ? 2 : 0));
+
+  Serial.printf("[GPS-AID] saved fix: %s, clock %s -> injected %s (age %us)\n",
+                have ? (rep.fromRtc ? "RTC" : "NVS") : "none", clockValid ? "valid" : "unset",
+                rep.injected ? aidedName(bootAided) : "nothing", rep.fixAgeS);
+  TtffLog log;
+  loadTtffLog(log);
+  if (log.count) {
+    Serial.print("[GPS-AID] recent TTFF:");
+    for (int i = 0; i < log.count; ++i) Serial.printf(" %u.%us(%s)", log.ds[i] / 10, log.ds[i] % 10, aidedName(log.aided[i]));
+    Serial.println();
+  }
+  if (report) *report = rep;
+}
+
+void gps_aiding_update(const GPSData* gd, uint32_t nowMs) {
+  if (!gd || !gd->validFix) return;
+
+  bool firstFix = (ttffMs == 0);
+  if (firstFix) {
+    ttffMs = nowMs ? nowMs : 1;
+    Serial.printf("[GPS-AID] TTFF %.1fs (%s)\n", ttffMs / 1000.0f, aidedName(bootAided));
+    appendTtff(ttffMs, bootAided);
+  }
+
+  SavedFix f;
+  f.magic = FIX_MAGIC;
+  f.latE7 = gd->latE7; f.lonE7 = gd->lonE7;
+  f.altCm = (int32_t)(gd->altitude * 100.0f);
+  f.utc = (uint32_t)(gps_data_utc_ms(gd) / 1000);
+  f.fixQuality = (uint8_t)gd->fixQuality;
+  f.check = fixCheck(f);
+  rtcFix = f;
+
+  // Keep the system clock on GPS time so a reset can aid with time as well as position
+  if (f.utc && (firstFix || nowMs - lastClockSetMs > 60000UL)) {
+    struct timeval tv = { (time_t)f.utc, 0 };
+    settimeofday(&tv, nullptr);
+    lastClockSetMs = nowMs;
+  }
+
+  bool due = firstFix || !haveSaved ||
+             (nowMs - lastSaveMs > GPS_AIDING_SAVE_MS &&
+              geo::distanceM(lastSaved.latE7, lastSaved.lonE7, f.latE7, f.lonE7) > GPS_AIDING_SAVE_MIN_M);
+  if (due) {
+    storeNvs(f);
+    lastSaved = f; haveSaved = true;
+    lastSaveMs = nowMs;
+  }
+}
+
+uint32_t gps_aiding_ttff_ms(void) {
+  return ttffMs;
+}
@@ -0,0 +1,26 @@
+// Hot-start aiding: keep the last good fix across resets and power cycles and hand it back to
+// the receiver at boot (UBX AID-INI), so it searches for the right satellites immediately.
+#pragma once
+#include <Arduino.h>
+#include "gps_module.h"
+
+// Outcome of gps_aiding_begin()
+typedef struct GPSAidingReport {
+  bool     injected;      // AID-INI sent
+  bool     position;      // position included
+  bool     time;          // UTC time included (system clock survived the reset)
+  bool     fromRtc;       // fix came from RTC memory (reset) rather than NVS (power cycle)
+  uint32_t fixAgeS;       // age of the saved fix, 0 if unknown
+} GPSAidingReport;
+
+// Load the saved fix (RTC memory first, then NVS), inject it into the receiver and print the
+// recent time-to-first-fix log. Call once after gps_init_auto(), before gps_start_task().
+void gps_aiding_begin(GPSAidingReport* report);
+
+// Feed every GPS snapshot. Records TTFF once per boot, keeps the RTC copy current, sets the
+// system clock from GPS UTC, and writes NVS on the first fix and then only every
+// GPS_AIDING_SAVE_MS if the position moved GPS_AIDING_SAVE_MIN_M.
+void gps_aiding_update(const GPSData* gd, uint32_t nowMs);
+
+// Time to first fix of this boot in ms, 0 while there is no fix yet
+uint32_t gps_aiding_ttff_ms(void);
@@ -0,0 +1,209 @@
+#include "gps_config.h"
+#include <Preferences.h>
+#include <string.h>
+#include "ubx_protocol.hpp"
+
+// Candidate rates, most likely first (u-blox default is 9600)
+static const uint32_t BAUDS[] = {9600, 115200, 38400, 57600, 230400, 19200, 4800};
+static constexpr size_t BAUDS_LEN = sizeof(BAUDS) / sizeof(BAUDS[0]);
+
+// Listen window per baud: the default 1 Hz output guarantees a sentence within ~1 s
+static const uint32_t DETECT_WINDOW_MS = 1100;
+static const uint32_t ACK_TIMEOUT_MS = 300;
+
+static const char* PREFS_NS = "gps";
+static const char* PREFS_BAUD = "baud";
+
+// Minimal NMEA checksum validator used only for baud detection
+struct NmeaCheck {
+  uint8_t state = 0;   // 0 idle, 1 body, 2/3 checksum digits
+  uint8_t sum = 0, rx = 0;
+  uint8_t len = 0;
+
+  static int hex(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  }
+
+  bool feed(uint8_t c) {
+    if (c == '$') { state = 1; sum = 0; rx = 0; len = 0; return false; }
+    if (state == 1) {
+      if (c == '*') { state = 2; return false; }
+      if (c < 0x20 || c > 0x7E || ++len > 90) { state = 0; return false; }
+      sum ^= c;
+      return false;
+    }
+    if (state == 2 || state == 3) {
+      int v = hex(c);
+      if (v < 0) { state = 0; return false; }
+      rx = (uint8_t)((rx << 4) | v);
+      if (state++ == 2) return false;
+      state = 0;
+      return rx == sum && len >= 6;
+    }
+    return false;
+  }
+};
+
+static void drainInput(HardwareSerial &port) {
+  while (port.available()) port.read();
+}
+
+static bool listenForTraffic(HardwareSerial &port, uint32_t windowMs) {
+  NmeaCheck nmea;
+  ubx::Decoder dec;
+  uint32_t t0 = millis();
+  while (millis() - t0 < windowMs) {
+    int c = port.read();
+    if (c < 0) { delay(2); continue; }
+    if (nmea.feed((uint8_t)c) || dec.feed((uint8_t)c)) return true;
+  }
+  return false;
+}
+
+static uint32_t loadBaud() {
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, true)) return 0;
+  uint32_t b = prefs.getUInt(PREFS_BAUD, 0);
+  prefs.end();
+  return b;
+}
+
+static void storeBaud(uint32_t baud) {
+  if (loadBaud() == baud) return; // avoid needless NVS writes
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, false)) return;
+  prefs.putUInt(PREFS_BAUD, baud);
+  prefs.end();
+}
+
+uint32_t gps_config_detect_baud(HardwareSerial &port) {
+  uint32_t preferred = loadBaud();
+  for (size_t i = 0; i <= BAUDS_LEN; ++i) {
+    uint32_t b = (i == 0) ? preferred : BAUDS[i - 1];
+    if (b == 0 || (i > 0 && b == preferred)) continue;
+    port.updateBaudRate(b);
+    drainInput(port);
+    if (listenForTraffic(port, DETECT_WINDOW_MS)) return b;
+  }
+  return 0;
+}
+
+static int waitAck(HardwareSerial &port, uint8_t cls, uint8_t id, uint32_t timeoutMs) {
+  ubx::Decoder dec;
+  uint32_t t0 = millis();
+  while (millis() - t0 < timeoutMs) {
+    int c = port.read();
+    if (c < 0) { delay(1); continue; }
+    if (!dec.feed((uint8_t)c) || dec.msgClass() != ubx::CLS_ACK || dec.length() < 2) continue;
+    const uint8_t* p = dec.payload();
+    if (p[0] != cls || p[1] != id) continue;
+    return dec.msgId() == ubx::ACK_ACK ? 1 : 0;
+  }
+  return -1;
+}
+
+static void sendFrame(HardwareSerial &port, uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+  uint8_t frame[64];
+  size_t n = ubx::encode(cls, id, payload, len, frame, sizeof(frame));
+  if (n) port.write(frame, n);
+}
+
+int gps_config_send(HardwareSerial &port, uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    sendFrame(port, cls, id, payload, len);
+    int r = waitAck(port, cls, id, ACK_TIMEOUT_MS);
+    if (r >= 0) return r;
+  }
+  return -1;
+}
+
+static bool step(HardwareSerial &port, GPSConfigReport &report, uint8_t cls, uint8_t id,
+                 const uint8_t* payload, uint16_t len) {
+  int r = gps_config_send(port, cls, id, payload, len);
+  if (r > 0) report.acked++;
+  else if (r == 0) report.naked++;
+  else report.timeouts++;
+  return r > 0;
+}
+
+static bool setRate(HardwareSerial &port, GPSConfigReport &report, uint8_t rateHz) {
+  uint8_t p[8];
+  uint16_t len = ubx::cfgRate(p, (uint16_t)(1000 / rateHz));
+  return step(port, report, ubx::CLS_CFG, ubx::CFG_RATE, p, len);
+}
+
+void gps_config_run(HardwareSerial &port, GPSProtocol protocol, uint32_t targetBaud, uint8_t rateHz,
+                    GPSConfigReport &report) {
+  memset(&report, 0, sizeof(report));
+  if (rateHz < 1) rateHz = 1;
+  if (rateHz > 10) rateHz = 10; // u-blox 7 ceiling for GPS-only navigation
+
+  uint32_t baud = gps_config_detect_baud(port);
+  report.detectedBaud = baud;
+  if (!baud) {
+    port.updateBaudRate(9600);
+    report.finalBaud = 9600;
+    Serial.println("[GPS-CFG] Receiver not heard at any baud, leaving defaults");
+    return;
+  }
+  report.finalBaud = baud;
+
+  // UBX output stays on in NMEA mode: ACK/NAK replies are UBX frames
+  uint16_t outProto = (protocol == GPS_PROTOCOL_UBX) ? ubx::PROTO_UBX : (ubx::PROTO_UBX | ubx::PROTO_NMEA);
+  uint8_t p[24];
+  uint16_t len = ubx::cfgPrtUart(p, targetBaud, ubx::PROTO_UBX | ubx::PROTO_NMEA, outProto);
+
+  bool rateOk;
+  if (baud != targetBaud) {
+    // The receiver switches baud right after CFG-PRT, so its ACK is unreliable. The CFG-RATE ACK
+    // at the new baud is the verification; revert if it never arrives.
+    sendFrame(port, ubx::CLS_CFG, ubx::CFG_PRT, p, len);
+    port.flush();
+    delay(100);
+    port.updateBaudRate(targetBaud);
+    drainInput(port);
+    rateOk = setRate(port, report, rateHz);
+    if (rateOk) {
+      report.finalBaud = targetBaud;
+      report.acked++; // CFG-PRT, verified by the ACK above
+    } else {
+      port.updateBaudRate(baud);
+      drainInput(port);
+      rateOk = setRate(port, report, rateHz);
+    }
+  } else {
+    step(port, report, ubx::CLS_CFG, ubx::CFG_PRT, p, len);
+    rateOk = setRate(port, report, rateHz);
+  }
+  if (rateOk) report.rateHz = rateHz;
+
+  // Output message set: only what the selected decoder consumes. GSV (satellites in view) is
+  // throttled to ~1 Hz since it is the bulkiest sentence and changes slowly.
+  struct MsgRate { uint8_t cls, id, rate; };
+  uint8_t gsvRate = report.rateHz ? report.rateHz : 1;
+  const bool nmea = (protocol == GPS_PROTOCOL_NMEA);
+  const MsgRate msgs[] = {
+    { ubx::CLS_NMEA, ubx::NMEA_GGA, (uint8_t)(nmea ? 1 : 0) },
+    { ubx::CLS_NMEA, ubx::NMEA_RMC, (uint8_t)(nmea ? 1 : 0) },
+    { ubx::CLS_NMEA, ubx::NMEA_GSV, (uint8_t)(nmea ? gsvRate : 0) },
+    { ubx::CLS_NMEA, ubx::NMEA_GLL, 0 },
+    { ubx::CLS_NMEA, ubx::NMEA_GSA, (uint8_t)(nmea ? 1 : 0) },  // DOP + fix mode
+    { ubx::CLS_NMEA, ubx::NMEA_VTG, 0 },                        // same speed as RMC
+    { ubx::CLS_NMEA, ubx::NMEA_GST, (uint8_t)(nmea ? 1 : 0) },  // error estimates
+    { ubx::CLS_NMEA, ubx::NMEA_ZDA, 0 },
+    { ubx::CLS_NAV,  ubx::NAV_PVT,  (uint8_t)(nmea ? 0 : 1) },
+  };
+  for (size_t i = 0; i < sizeof(msgs) / sizeof(msgs[0]); ++i) {
+    len = ubx::cfgMsg(p, msgs[i].cls, msgs[i].id, msgs[i].rate);
+    step(port, report, ubx::CLS_CFG, ubx::CFG_MSG, p, len);
+  }
+
+  len = ubx::cfgSave(p);
+  report.saved = step(port, report, ubx::CLS_CFG, ubx::CFG_CFG, p, len);
+  report.ok = (report.naked == 0 && report.timeouts == 0);
+
+  storeBaud(report.finalBaud);
+  drainInput(port);
+}
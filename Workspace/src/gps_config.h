@@ -0,0 +1,17 @@
+// u-blox receiver configuration engine (auto-baud, rate, message set), used by gps_init_auto()
+#pragma once
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include "gps_module.h"
+
+// Cycle common baud rates (the last working one from NVS first) until a checksum-valid NMEA
+// sentence or UBX frame is heard. Leaves the port at the found baud; returns 0 if silent.
+uint32_t gps_config_detect_baud(HardwareSerial &port);
+
+// Send one UBX CFG message and wait for its ACK/NAK. Returns 1 = ACK, 0 = NAK, -1 = timeout.
+// Retries once on timeout. Only valid while nothing else is draining the port.
+int gps_config_send(HardwareSerial &port, uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len);
+
+// Full startup sequence on an already-begun port; see gps_init_auto() in gps_module.h
+void gps_config_run(HardwareSerial &port, GPSProtocol protocol, uint32_t targetBaud, uint8_t rateHz,
+                    GPSConfigReport &report);
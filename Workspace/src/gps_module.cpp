@@ -1,126 +1,588 @@
 #include "gps_module.h"
 #include <HardwareSerial.h>
 #include <string.h>
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "ubx_protocol.hpp"
+#include "gps_config.h"
+#include "sat_table.hpp"
+#include "nmea_parser.hpp"
+#include "byte_source.hpp"
+#include "source_arbiter.hpp"
+#include "speed_filter.hpp"
+
+// UART driver ring buffer, filled from the RX interrupt. 2 KB is ~180 ms at 115200 baud,
+// enough to ride out a long render even while the parse task is starved.
+#ifndef GPS_RX_BUFFER_SIZE
+#define GPS_RX_BUFFER_SIZE 2048
+#endif
+// RX FIFO threshold interrupt (bytes) and idle-line timeout (symbol times) for event mode
+#ifndef GPS_RX_FIFO_THRESHOLD
+#define GPS_RX_FIFO_THRESHOLD 64
+#endif
+#ifndef GPS_RX_IDLE_SYMBOLS
+#define GPS_RX_IDLE_SYMBOLS 2
+#endif
+#ifndef GPS_TASK_STACK
+#define GPS_TASK_STACK 4096
+#endif
+#ifndef GPS_TASK_PRIORITY
+#define GPS_TASK_PRIORITY 5    // above loop() (1) so parsing pre-empts rendering
+#endif
+// Speeds below this many standard deviations of the reported speed accuracy read as zero
+#ifndef GPS_SPEED_GATE_SIGMA
+#define GPS_SPEED_GATE_SIGMA 2.0f
+#endif
+// Receiver 1PPS output pin for epoch timestamping, -1 = not wired
+#ifndef GPS_PPS_PIN
+#define GPS_PPS_PIN -1
+#endif
+// RX silence that separates one navigation epoch's burst of sentences from the next
+#ifndef GPS_EPOCH_GAP_US
+#define GPS_EPOCH_GAP_US 20000
+#endif
+
+// Parse task wake interval while a secondary source is attached (it raises no RX events)
+#ifndef GPS_AUX_POLL_MS
+#define GPS_AUX_POLL_MS 10
+#endif
+// Bytes read per source call; large enough for a whole NMEA-over-UDP datagram
+#ifndef GPS_DRAIN_CHUNK
+#define GPS_DRAIN_CHUNK 512
+#endif
+// Speed epochs queued for gps_read_speed_samples() (about 1.5 s at 10 Hz)
+#ifndef GPS_SPEED_QUEUE
+#define GPS_SPEED_QUEUE 16
+#endif
 
 static HardwareSerial GPS(1);
+static io::PortSource<HardwareSerial> uartSource(GPS);
+static io::ByteSource* volatile g_source = &uartSource;  // what gpsDrain() reads from
+static io::ByteSource* volatile g_auxSource = nullptr;   // optional second feed, e.g. network NMEA
 
 // Internal state mirrors GPSData
 static GPSData g_data = {0};
+static GPSParserStats g_stats = {0};
+static GPSProtocol g_protocol = GPS_PROTOCOL_NMEA;
+static gnss::SatTable satTable;  // double-buffered, flips under g_mux when a GSV cycle completes
+static ubx::Decoder ubxDecoder;  // also runs in NMEA mode to catch ACK/NAK for gps_send_ubx()
+static GPSCommandStats g_cmd = {0};
+
+// Event-driven ingestion state. g_mux guards g_data/g_stats against the parse task.
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t g_rxTask = nullptr;
+static GPSIngestStats g_ingest = {0};
+static uint64_t g_latencySumUs = 0;
+static uint32_t g_latencyCount = 0;
+static volatile uint32_t g_eventUs = 0;  // oldest RX event not yet drained (0 = none)
+
+// Source arbitration. Both sources are always parsed; only the active one writes g_data.
+// The arbiter lives in the parse task; g_active is its decision, read by the sinks under g_mux.
+static gnss::SourceArbiter g_arbiter;
+static volatile int g_active = GPS_SOURCE_PRIMARY;
+static uint32_t g_srcBytes[GPS_SOURCE_COUNT] = {0};
+static uint32_t g_srcLatencyMaxUs[GPS_SOURCE_COUNT] = {0};
+static uint64_t g_srcLatencySumUs[GPS_SOURCE_COUNT] = {0};
+static uint32_t g_srcLatencyCount[GPS_SOURCE_COUNT] = {0};
 
-// Buffers
-static char lineBuf[128];
-static int linePos = 0;
-
-// Tokenizer helper
-static int tokenize(char* s, const char* tokens[], int maxTok) {
-  int count = 0; char* p = s;
-  while (p && *p && count < maxTok) {
-    tokens[count++] = p;
-    char* comma = strchr(p, ',');
-    if (!comma) break;
-    *comma = '\0';
-    p = comma + 1;
-  }
-  return count;
-}
-
-static float nmeaCoordToDeg(const char* fld) {
-  if (!fld || !*fld) return 0.0f;
-  float v = atof(fld);
-  int deg = (int)(v / 100.0f);
-  float minutes = v - deg * 100.0f;
-  return deg + minutes / 60.0f;
-}
-
-static void parseGGA(char* sentence) {
-  // GGA: time,lat,N,lon,E,fix,sats,hdop,alt,M,geoid,...
-  const char* t[20] = {0};
-  int n = tokenize(sentence, t, 20);
-  if (n < 10) return;
-  g_data.fixQuality = atoi(t[6]);
-  g_data.satsUsed = atoi(t[7]);
-  g_data.altitude = atof(t[9]);
-  g_data.lat = nmeaCoordToDeg(t[2]);
-  if (t[3] && t[3][0] == 'S') g_data.lat = -g_data.lat;
-  g_data.lon = nmeaCoordToDeg(t[4]);
-  if (t[5] && t[5][0] == 'W') g_data.lon = -g_data.lon;
-  g_data.validFix = (g_data.fixQuality > 0);
-}
-
-static void parseRMC(char* sentence) {
-  // RMC: time,status,lat,N,lon,E,sog,course,date,...
-  const char* t[20] = {0};
-  int n = tokenize(sentence, t, 20);
-  if (n < 10) return;
-  if (t[1]) strncpy(g_data.timeUTC, t[1], sizeof(g_data.timeUTC)-1);
-  g_data.timeUTC[sizeof(g_data.timeUTC)-1] = '\0';
-  bool active = (t[2] && t[2][0] == 'A');
-  g_data.speedKnots = t[7] ? atof(t[7]) : 0.0f;
-  g_data.courseDeg = t[8] ? atof(t[8]) : 0.0f;
-  if (t[9]) strncpy(g_data.date, t[9], sizeof(g_data.date)-1);
-  g_data.date[sizeof(g_data.date)-1] = '\0';
-  if (!g_data.validFix && active) {
-    g_data.lat = nmeaCoordToDeg(t[3]);
-    if (t[4] && t[4][0] == 'S') g_data.lat = -g_data.lat;
-    g_data.lon = nmeaCoordToDeg(t[5]);
-    if (t[6] && t[6][0] == 'W') g_data.lon = -g_data.lon;
-  }
-  if (active) g_data.validFix = true; // active RMC implies usable solution
-}
-
-static void parseGSV(char* sentence) {
-  // GSV: totalMsgs,msgIndex,svInView,...
-  const char* t[30] = {0};
-  int n = tokenize(sentence, t, 30);
-  if (n < 4) return;
-  g_data.satsInView = atoi(t[3]);
+// Epoch timing for latency tracing, per source (parse-task context only, except the PPS pair)
+static uint32_t g_epochUs[GPS_SOURCE_COUNT] = {0};  // arrival of the first chunk of the current epoch
+static uint32_t g_lastRxUs[GPS_SOURCE_COUNT] = {0}; // arrival of the previous chunk
+static volatile uint32_t g_ppsUs = 0;    // last PPS rising edge
+static volatile uint32_t g_ppsCount = 0;
+
+// Every speed epoch, for consumers that must not miss one however long a frame takes (under g_mux)
+static GPSSpeedSample g_speedQueue[GPS_SPEED_QUEUE];
+static uint32_t g_speedHead = 0, g_speedTail = 0, g_speedDropped = 0;
+
+// ---------- NMEA ----------
+// Sentences are decoded by the shared streaming parser (include/nmea_parser.hpp); this sink maps
+// each checksum-verified sentence into g_data under g_mux.
+
+// Noise gate on ground speed. A stationary receiver still reports a few tenths of a km/h, and
+// how much depends on the sky: zero speeds that sit inside GPS_SPEED_GATE_SIGMA x the speed
+// accuracy (nav::speedGateKmh). UBX reports sAcc directly and the gate follows it. NMEA has no
+// speed accuracy; it is estimated from HDOP for the filter, but that estimate sits inside
+// ordinary stationary Doppler noise, so NMEA keeps the 1.8 km/h deadband as the floor.
+static void applySpeedGate() {
+  // Every speed update passes through here; stamp it for the speed filter and latency tracing
+  g_data.speedRawKmh = g_data.speedKmh;
+  g_data.speedMs = millis() | 1; // 0 means "never"
+  g_data.epochUs = g_epochUs[g_active];
+  g_data.parsedUs = micros();
+  // Queue the epoch, timed by its first byte so where the sentence sits in the burst doesn't matter
+  uint32_t sinceEpochUs = g_data.epochUs ? g_data.parsedUs - g_data.epochUs : 0;
+  if (g_speedHead - g_speedTail == GPS_SPEED_QUEUE) { g_speedTail++; g_speedDropped++; }
+  GPSSpeedSample &q = g_speedQueue[g_speedHead++ % GPS_SPEED_QUEUE];
+  q.tMs = g_data.speedMs - (sinceEpochUs < 1000000 ? sinceEpochUs / 1000 : 0);
+  q.speedRawKmh = g_data.speedRawKmh;
+  q.validFix = g_data.validFix;
+  if (g_data.speedKmh < nav::speedGateKmh(GPS_SPEED_GATE_SIGMA, g_data.sAccKmh, g_data.sAccMeasured)) {
+    g_data.speedKmh = 0.0f;
+    g_data.speedKnots = 0.0f;
+  }
 }
 
-void gps_init(int rxPin, int txPin, uint32_t baud) {
-  memset(&g_data, 0, sizeof(g_data));
-  GPS.begin(baud, SERIAL_8N1, rxPin, txPin);
+// Only the NMEA sinks call this, so the UBX-reported sAcc is never overwritten
+static void setHdop(float hdop) {
+  g_data.hdop = hdop;
+  g_data.sAccKmh = hdop * nav::SACC_KMH_PER_HDOP;
+  g_data.sAccMeasured = false;
 }
 
-void gps_poll(void) {
-  while (GPS.available()) {
-    char c = GPS.read();
-    if (c == '\r') continue;
-    if (c == '\n') {
-      lineBuf[linePos] = '\0';
-      if (linePos > 6 && lineBuf[0] == '$') {
-        char* s = lineBuf + 1; // skip '$'
-        // match by type after talker ID (chars 2-4 of full)
-        if (strncmp(s+2, "GGA", 3) == 0) {
-          parseGGA(s);
-        } else if (strncmp(s+2, "RMC", 3) == 0) {
-          parseRMC(s);
-        } else if (strncmp(s+2, "GSV", 3) == 0) {
-          parseGSV(s);
+
+// One sink per source. Every sentence updates that source's arbitration health; only the active
+// source's sentences reach g_data.
+struct AppSink {
+  int src;
+
+  // Call under g_mux: note the sentence and say whether this source feeds g_data
+  bool take() const {
+    g_arbiter.noteData(src, millis());
+    return src == g_active;
+  }
+
+  void onSentence(const nmea::Gga &s) {
+    portENTER_CRITICAL(&g_mux);
+    g_arbiter.noteFix(src, (uint8_t)s.fixQuality, millis());
+    if (take()) {
+      g_data.fixQuality = s.fixQuality;
+      g_data.satsUsed = s.satsUsed;
+      g_data.altitude = s.altitude;
+      g_data.latE7 = s.latE7;
+      g_data.lonE7 = s.lonE7;
+      g_data.validFix = (g_data.fixQuality > 0);
+      if (s.hdop > 0.0f) setHdop(s.hdop);
+    }
+    portEXIT_CRITICAL(&g_mux);
+  }
+
+  void onSentence(const nmea::Rmc &s) {
+    portENTER_CRITICAL(&g_mux);
+    // RMC-only feeds (many phone apps) count as a plain GPS fix; GGA refines the quality
+    uint8_t q = g_arbiter.quality(src);
+    g_arbiter.noteFix(src, s.active ? (q ? q : 1) : 0, millis());
+    if (take()) {
+      memcpy(g_data.timeUTC, s.timeUTC, sizeof(g_data.timeUTC));
+      memcpy(g_data.date, s.date, sizeof(g_data.date));
+      g_data.speedKnots = s.speedKnots;
+      g_data.courseDeg = s.courseDeg;
+      if (!g_data.validFix && s.active) {
+        g_data.latE7 = s.latE7;
+        g_data.lonE7 = s.lonE7;
+      }
+      if (s.active) g_data.validFix = true; // active RMC implies usable solution
+
+      // Convert knots to km/h
+      g_data.speedKmh = g_data.speedKnots * 1.852f;
+      applySpeedGate();
+    }
+    portEXIT_CRITICAL(&g_mux);
+  }
+
+  void onSentence(const nmea::Gsv &s) {
+    gnss::SatInfo sats[4];
+    int n = s.satellites(sats);
+    gnss::System sys = gnss::systemFromTalker(s.talker[0], s.talker[1]);
+    portENTER_CRITICAL(&g_mux);
+    if (take() && satTable.addMessage(sys, s.total, s.index, (uint8_t)s.inView, sats, n)) {
+      const gnss::SatSnapshot &snap = satTable.snapshot();
+      g_data.satsInView = snap.totalInView(); // summed over constellations
+      g_data.cn0Avg = snap.averageCn0();
+      g_data.cn0Top4 = snap.topCn0Average(4);
+    }
+    portEXIT_CRITICAL(&g_mux);
+  }
+
+  void onSentence(const nmea::Gsa &s) {
+    // GNSS receivers send one GSA per constellation with the same combined DOPs
+    portENTER_CRITICAL(&g_mux);
+    if (s.fixMode == 1) g_arbiter.noteFix(src, 0, millis());
+    if (take()) {
+      g_data.fixMode = s.fixMode;
+      g_data.pdop = s.pdop;
+      g_data.vdop = s.vdop;
+      if (s.hdop > 0.0f) setHdop(s.hdop);
+      if (s.fixMode == 1) g_data.validFix = false; // GGA/RMC from a stale solution
+    }
+    portEXIT_CRITICAL(&g_mux);
+  }
+
+  void onSentence(const nmea::Gst &s) {
+    float hAcc = sqrtf(s.latErrM * s.latErrM + s.lonErrM * s.lonErrM);
+    portENTER_CRITICAL(&g_mux);
+    if (take()) {
+      g_data.hAccM = hAcc;
+      g_data.vAccM = s.altErrM;
+    }
+    portEXIT_CRITICAL(&g_mux);
+  }
+
+  void onSentence(const nmea::Vtg &s) {
+    if (!s.valid) return;
+    portENTER_CRITICAL(&g_mux);
+    if (take()) {
+      g_data.courseDeg = s.courseDeg;
+      g_data.speedKmh = s.speedKmh;
+      g_data.speedKnots = s.speedKmh / 1.852f;
+      applySpeedGate();
+    }
+    portEXIT_CRITICAL(&g_mux);
+  }
+};
+
+typedef nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsv, nmea::Gsa, nmea::Gst, nmea::Vtg> AppParser;
+static AppSink nmeaSink = { GPS_SOURCE_PRIMARY };
+static AppParser nmeaParser;
+static AppSink auxSink = { GPS_SOURCE_AUX };
+static AppParser auxParser;   // the secondary source is always NMEA
+
+// ---------- UBX decoding ----------
+// Frames are mapped straight from integer payload fields into g_data (ubx::applyNav*, shared
+// with the host tests); no text conversion.
+static void ubxFeed(uint8_t b) {
+  if (!ubxDecoder.feed(b)) return;
+  const uint8_t* p = ubxDecoder.payload(); uint16_t len = ubxDecoder.length();
+  bool handled = false;
+  portENTER_CRITICAL(&g_mux);
+  if (ubxDecoder.msgClass() == ubx::CLS_ACK && len >= 2) {
+    handled = true;
+    if (ubxDecoder.msgId() == ubx::ACK_ACK) g_cmd.acked++;
+    else { g_cmd.naked++; g_cmd.lastNakClass = p[0]; g_cmd.lastNakId = p[1]; }
+  } else if (ubxDecoder.msgClass() == ubx::CLS_NAV && g_protocol == GPS_PROTOCOL_UBX) {
+    // Fix status always feeds arbitration; g_data only while the receiver is the active source
+    bool active = (g_active == GPS_SOURCE_PRIMARY);
+    uint32_t nowMs = millis();
+    switch (ubxDecoder.msgId()) {
+      case ubx::NAV_PVT: {
+        ubx::NavPvt m;
+        if ((handled = ubx::parseNavPvt(p, len, m))) {
+          g_arbiter.noteFix(GPS_SOURCE_PRIMARY, ubx::fixQuality(m.fixType, m.flags), nowMs);
+          if (active) { ubx::applyNavPvt(g_data, m); applySpeedGate(); }
         }
+        break;
+      }
+      case ubx::NAV_VELNED: {
+        ubx::NavVelned m;
+        if ((handled = ubx::parseNavVelned(p, len, m)) && active) { ubx::applyNavVelned(g_data, m); applySpeedGate(); }
+        break;
+      }
+      case ubx::NAV_SOL: {
+        ubx::NavSol m;
+        if ((handled = ubx::parseNavSol(p, len, m))) {
+          g_arbiter.noteFix(GPS_SOURCE_PRIMARY, ubx::fixQuality(m.gpsFix, m.flags), nowMs);
+          if (active) ubx::applyNavSol(g_data, m);
+        }
+        break;
       }
-      linePos = 0;
-    } else if (linePos < (int)sizeof(lineBuf)-1) {
-      lineBuf[linePos++] = c;
-    } else {
-      linePos = 0; // overflow reset
     }
+    if (handled) g_arbiter.noteData(GPS_SOURCE_PRIMARY, nowMs);
   }
-  
-  // Convert knots to km/h
-  g_data.speedKmh = g_data.speedKnots * 1.852f;
-  
-  // Apply deadband filter to suppress GPS drift when stationary
-  // GPS modules typically have ~0.1-0.5 knots of noise when stationary
-  // This translates to ~0.2-0.9 km/h, but can reach 1.5 km/h in some conditions
-  // Set threshold at 1.8 km/h (just under walking pace ~2-3 km/h)
-  const float SPEED_DEADBAND_KMH = 1.8f;
-  if (g_data.speedKmh < SPEED_DEADBAND_KMH) {
-    g_data.speedKmh = 0.0f;
-    g_data.speedKnots = 0.0f;
+  if (g_protocol == GPS_PROTOCOL_UBX) {
+    const ubx::Decoder::Stats &ds = ubxDecoder.stats();
+    g_stats.sentences = ds.frames;
+    g_stats.checksumErrors = ds.checksumErrors;
+    g_stats.overflows = ds.oversize + ds.badLength;
+    if (!handled) g_stats.unknownSentences++;
   }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+// A chunk arriving after GPS_EPOCH_GAP_US of silence starts a new epoch
+static void markArrival(int idx, uint32_t arrivalUs) {
+  if (arrivalUs - g_lastRxUs[idx] > GPS_EPOCH_GAP_US) g_epochUs[idx] = arrivalUs;
+  g_lastRxUs[idx] = arrivalUs;
+}
+
+#if GPS_PPS_PIN >= 0
+static void IRAM_ATTR onPps() {
+  g_ppsUs = micros();
+  g_ppsCount++;
+}
+#endif
+
+// Feed everything 'src' has ready to that source's parser; returns bytes consumed.
+// arrivalUs is when the data was signalled (RX event) or noticed (polling).
+static size_t drainSource(int idx, io::ByteSource* src, uint32_t arrivalUs) {
+  uint8_t buf[GPS_DRAIN_CHUNK];
+  size_t n, total = 0;
+  if (src->available() > 0) markArrival(idx, arrivalUs);
+  while ((n = src->read(buf, sizeof(buf))) > 0) {
+    if (idx == GPS_SOURCE_AUX) { for (size_t i = 0; i < n; ++i) auxParser.feed((char)buf[i], auxSink); }
+    else if (g_protocol == GPS_PROTOCOL_UBX) { for (size_t i = 0; i < n; ++i) ubxFeed(buf[i]); }
+    else { for (size_t i = 0; i < n; ++i) { nmeaParser.feed((char)buf[i], nmeaSink); ubxFeed(buf[i]); } }
+    total += n;
+  }
+  if (total) {
+    uint32_t latency = micros() - arrivalUs;
+    portENTER_CRITICAL(&g_mux);
+    g_srcBytes[idx] += total;
+    if (latency > g_srcLatencyMaxUs[idx]) g_srcLatencyMaxUs[idx] = latency;
+    g_srcLatencySumUs[idx] += latency; g_srcLatencyCount[idx]++;
+    portEXIT_CRITICAL(&g_mux);
+  }
+  return total;
+}
+
+// Drain the receiver and, if attached, the secondary source, then re-run arbitration.
+// Returns the bytes taken from the receiver (the UART ring buffer figures in GPSIngestStats).
+static size_t gpsDrain(uint32_t arrivalUs) {
+  size_t total = drainSource(GPS_SOURCE_PRIMARY, g_source, arrivalUs);
+  io::ByteSource* aux = g_auxSource;
+  if (aux) drainSource(GPS_SOURCE_AUX, aux, micros()); // polled: arrival is when we looked
+  int active = g_arbiter.select(millis());
+  if (active != g_active) {
+    portENTER_CRITICAL(&g_mux);
+    g_active = active;
+    portEXIT_CRITICAL(&g_mux);
+  }
+  return total;
+}
+
+// Runs in the HardwareSerial event task on FIFO-threshold or idle-line RX events
+static void onGpsReceive() {
+  uint32_t now = micros();
+  portENTER_CRITICAL(&g_mux);
+  if (g_eventUs == 0) g_eventUs = now | 1; // never store 0, it means "none pending"
+  g_ingest.rxEvents++;
+  portEXIT_CRITICAL(&g_mux);
+  if (g_rxTask) xTaskNotifyGive(g_rxTask);
+}
+
+static void onGpsReceiveError(hardwareSerial_error_t err) {
+  portENTER_CRITICAL(&g_mux);
+  if (err == UART_FIFO_OVF_ERROR || err == UART_BUFFER_FULL_ERROR) g_ingest.overflows++;
+  else if (err != UART_NO_ERROR) g_ingest.lineErrors++;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+static void gpsRxTask(void*) {
+  for (;;) {
+    // The timeout is only a safety net; normally every RX event wakes us
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(g_auxSource ? GPS_AUX_POLL_MS : 100));
+    portENTER_CRITICAL(&g_mux);
+    uint32_t eventUs = g_eventUs; g_eventUs = 0;
+    portEXIT_CRITICAL(&g_mux);
+    uint32_t nowUs = micros();
+    uint32_t latency = eventUs ? nowUs - eventUs : 0;
+    size_t n = gpsDrain(eventUs ? eventUs : nowUs);
+    portENTER_CRITICAL(&g_mux);
+    g_ingest.rxBytes += n;
+    if (n > g_ingest.maxChunk) g_ingest.maxChunk = n;
+    if (eventUs) {
+      g_ingest.latencyLastUs = latency;
+      if (latency > g_ingest.latencyMaxUs) g_ingest.latencyMaxUs = latency;
+      g_latencySumUs += latency; g_latencyCount++;
+      g_ingest.latencyAvgUs = (uint32_t)(g_latencySumUs / g_latencyCount);
+    }
+    portEXIT_CRITICAL(&g_mux);
+  }
+}
+
+void gps_init(int rxPin, int txPin, uint32_t baud) {
+  gps_init_protocol(rxPin, txPin, baud, GPS_PROTOCOL_NMEA);
+}
+
+void gps_init_protocol(int rxPin, int txPin, uint32_t baud, GPSProtocol protocol) {
+  memset(&g_data, 0, sizeof(g_data));
+  memset(&g_stats, 0, sizeof(g_stats));
+  memset(&g_cmd, 0, sizeof(g_cmd));
+  g_protocol = protocol;
+  nmeaParser.reset();
+  auxParser.reset();
+  g_arbiter.reset();
+  g_active = GPS_SOURCE_PRIMARY;
+  memset(g_srcBytes, 0, sizeof(g_srcBytes));
+  memset(g_srcLatencyMaxUs, 0, sizeof(g_srcLatencyMaxUs));
+  memset(g_srcLatencySumUs, 0, sizeof(g_srcLatencySumUs));
+  memset(g_srcLatencyCount, 0, sizeof(g_srcLatencyCount));
+  ubxDecoder = ubx::Decoder();
+  satTable = gnss::SatTable();
+  GPS.setRxBufferSize(GPS_RX_BUFFER_SIZE); // must precede begin()
+  GPS.begin(baud, SERIAL_8N1, rxPin, txPin);
+#if GPS_PPS_PIN >= 0
+  pinMode(GPS_PPS_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(GPS_PPS_PIN), onPps, RISING);
+#endif
+}
+
+void gps_init_auto(int rxPin, int txPin, GPSProtocol protocol, uint32_t targetBaud, uint8_t rateHz,
+                   GPSConfigReport* report) {
+  GPSConfigReport rep;
+  gps_init_protocol(rxPin, txPin, 9600, protocol);
+  gps_config_run(GPS, protocol, targetBaud, rateHz, rep); // leaves the port at the final baud
+  if (report) *report = rep;
+}
+
+bool gps_start_task(int coreId) {
+  if (g_rxTask) return true;
+  memset(&g_ingest, 0, sizeof(g_ingest));
+  g_latencySumUs = 0; g_latencyCount = 0; g_eventUs = 0;
+  BaseType_t ok = xTaskCreatePinnedToCore(gpsRxTask, "gps_rx", GPS_TASK_STACK, nullptr,
+                                          GPS_TASK_PRIORITY, &g_rxTask, coreId);
+  if (ok != pdPASS) { g_rxTask = nullptr; return false; }
+  GPS.setRxFIFOFull(GPS_RX_FIFO_THRESHOLD);
+  GPS.setRxTimeout(GPS_RX_IDLE_SYMBOLS);
+  GPS.onReceiveError(onGpsReceiveError);
+  GPS.onReceive(onGpsReceive, false);
+  xTaskNotifyGive(g_rxTask); // pick up anything buffered before the callback was attached
+  return true;
+}
+
+void gps_poll(void) {
+  if (g_rxTask) return; // parse task owns the UART
+  size_t n = gpsDrain(micros());
+  portENTER_CRITICAL(&g_mux);
+  g_ingest.rxBytes += n;
+  if (n > g_ingest.maxChunk) g_ingest.maxChunk = n;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+size_t gps_write(const uint8_t* data, size_t len) {
+  return GPS.write(data, len);
+}
+
+bool gps_send_ubx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+  uint8_t frame[64];
+  size_t n = ubx::encode(cls, id, payload, len, frame, sizeof(frame));
+  if (n == 0 || GPS.write(frame, n) != n) return false;
+  portENTER_CRITICAL(&g_mux);
+  g_cmd.sent++;
+  portEXIT_CRITICAL(&g_mux);
+  return true;
+}
+
+void gps_get_command_stats(GPSCommandStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_cmd;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+bool gps_set_power_mode(gnss::PowerMode mode, uint8_t fullRateHz) {
+  uint8_t p[44];
+  uint8_t hz = (mode == gnss::POWER_FULL && fullRateHz > 0) ? fullRateHz : 1;
+  bool ok = true;
+  // Leave power save before raising the rate; enter it only after dropping to 1 Hz
+  if (mode != gnss::POWER_SAVE) ok &= gps_send_ubx(ubx::CLS_CFG, ubx::CFG_RXM, p, ubx::cfgRxm(p, ubx::LP_CONTINUOUS));
+  ok &= gps_send_ubx(ubx::CLS_CFG, ubx::CFG_RATE, p, ubx::cfgRate(p, (uint16_t)(1000 / hz)));
+  if (mode == gnss::POWER_SAVE) {
+    ok &= gps_send_ubx(ubx::CLS_CFG, ubx::CFG_PM2, p, ubx::cfgPm2Cyclic(p, 1000, 10000));
+    ok &= gps_send_ubx(ubx::CLS_CFG, ubx::CFG_RXM, p, ubx::cfgRxm(p, ubx::LP_POWER_SAVE));
+  }
+  return ok;
 }
 
 void gps_get_data(GPSData* out) {
   if (!out) return;
+  portENTER_CRITICAL(&g_mux);
   *out = g_data; // shallow copy
+  out->ppsUs = g_ppsUs;
+  out->ppsCount = g_ppsCount;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+// Days since 1970-01-01 for a civil date (proleptic Gregorian)
+static int32_t daysFromCivil(int y, int m, int d) {
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  int32_t yoe = y - era * 400;
+  int32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static int twoDigits(const char* s) {
+  if (s[0] < '0' || s[0] > '9' || s[1] < '0' || s[1] > '9') return -1;
+  return (s[0] - '0') * 10 + (s[1] - '0');
+}
+
+// DDMMYY + HHMMSS(.ss) -> unix ms
+uint64_t gps_data_utc_ms(const GPSData* gd) {
+  if (!gd || strlen(gd->date) < 6 || strlen(gd->timeUTC) < 6) return 0;
+  int dd = twoDigits(gd->date), mo = twoDigits(gd->date + 2), yy = twoDigits(gd->date + 4);
+  int hh = twoDigits(gd->timeUTC), mi = twoDigits(gd->timeUTC + 2), ss = twoDigits(gd->timeUTC + 4);
+  if (dd < 1 || mo < 1 || mo > 12 || yy < 0 || hh < 0 || mi < 0 || ss < 0) return 0;
+  uint32_t ms = 0, scale = 100;
+  if (gd->timeUTC[6] == '.') {
+    for (const char* p = gd->timeUTC + 7; *p >= '0' && *p <= '9' && scale; ++p, scale /= 10) ms += (*p - '0') * scale;
+  }
+  uint64_t secs = (uint64_t)daysFromCivil(2000 + yy, mo, dd) * 86400u + hh * 3600u + mi * 60u + ss;
+  return secs * 1000u + ms;
+}
+
+void gps_get_stats(GPSParserStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  if (g_protocol == GPS_PROTOCOL_NMEA) {
+    // The parser counts on its own; 32-bit counters are read without tearing
+    const nmea::Stats &ns = nmeaParser.stats();
+    out->sentences = ns.sentences;
+    out->checksumErrors = ns.checksumErrors;
+    out->overflows = ns.overflows;
+    out->unknownSentences = ns.unknownSentences;
+  } else {
+    *out = g_stats;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void gps_set_source(io::ByteSource* source) {
+  g_source = source ? source : &uartSource;
+  if (g_rxTask) xTaskNotifyGive(g_rxTask);
+}
+
+void gps_source_ready(void) {
+  if (g_rxTask) xTaskNotifyGive(g_rxTask);
+}
+
+void gps_set_aux_source(io::ByteSource* source) {
+  g_auxSource = source;
+  if (g_rxTask) xTaskNotifyGive(g_rxTask);
+}
+
+void gps_get_source_stats(int source, GPSSourceStats* out) {
+  if (!out || source < 0 || source >= GPS_SOURCE_COUNT) return;
+  memset(out, 0, sizeof(*out));
+  portENTER_CRITICAL(&g_mux);
+  if (source == GPS_SOURCE_PRIMARY && g_protocol == GPS_PROTOCOL_UBX) {
+    out->sentences = g_stats.sentences;
+    out->drops = g_stats.checksumErrors + g_stats.overflows;
+  } else {
+    const nmea::Stats &ns = (source == GPS_SOURCE_AUX ? auxParser : nmeaParser).stats();
+    out->sentences = ns.sentences;
+    out->drops = ns.checksumErrors + ns.overflows;
+  }
+  out->bytes = g_srcBytes[source];
+  out->lastDataMs = g_arbiter.lastDataMs(source);
+  out->fixQuality = g_arbiter.quality(source);
+  out->active = (g_active == source);
+  out->switches = g_arbiter.switches();
+  out->latencyAvgUs = g_srcLatencyCount[source] ? (uint32_t)(g_srcLatencySumUs[source] / g_srcLatencyCount[source]) : 0;
+  out->latencyMaxUs = g_srcLatencyMaxUs[source];
+  portEXIT_CRITICAL(&g_mux);
+}
+
+size_t gps_read_speed_samples(GPSSpeedSample* out, size_t max, uint32_t* dropped) {
+  size_t n = 0;
+  portENTER_CRITICAL(&g_mux);
+  while (n < max && g_speedTail != g_speedHead) out[n++] = g_speedQueue[g_speedTail++ % GPS_SPEED_QUEUE];
+  if (dropped) *dropped = g_speedDropped;
+  portEXIT_CRITICAL(&g_mux);
+  return n;
+}
+
+void gps_get_satellites(gnss::SatSnapshot* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = satTable.snapshot();
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void gps_get_ingest_stats(GPSIngestStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_ingest;
+  portEXIT_CRITICAL(&g_mux);
 }
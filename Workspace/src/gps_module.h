@@ -7,29 +7,187 @@ extern "C" {
 
 // Minimal snapshot of GPS data for UI/app integration
 typedef struct GPSData {
-  bool validFix;      // true if fixQuality > 0 or RMC active
+  bool validFix;      // fixQuality > 0 or RMC active, and GSA not reporting "no fix"
   int  fixQuality;    // 0=no fix, 1=GPS, 2=DGPS, >2 augmentation
+  int  fixMode;       // GSA: 0=not reported, 1=no fix, 2=2D, 3=3D
   int  satsUsed;      // satellites used in solution (GGA)
-  int  satsInView;    // total satellites visible (GSV)
-  float lat;          // degrees
-  float lon;          // degrees
+  int  satsInView;    // total satellites visible (GSV, summed over constellations)
+  int  cn0Avg;        // mean C/N0 of tracked satellites (dB-Hz), 0 = none
+  int  cn0Top4;       // mean C/N0 of the 4 strongest satellites (dB-Hz)
+  int32_t latE7;      // latitude, 1e-7 degree
+  int32_t lonE7;      // longitude, 1e-7 degree
   float altitude;     // meters (MSL) from GGA
-  float speedKnots;   // from RMC
-  float speedKmh;     // derived
-  float courseDeg;    // from RMC
+  float speedKnots;   // from RMC/VTG, zeroed with speedKmh when inside the noise gate
+  float speedKmh;     // derived, accuracy-gated
+  float speedRawKmh;  // ungated ground speed
+  uint32_t speedMs;   // millis() when speed/course were last decoded, 0 = never
+  // Latency tracing, micros() clock. The epoch stamp is the RX event of the first chunk after a
+  // quiet line: up to GPS_RX_FIFO_THRESHOLD byte times after the first byte in event mode.
+  uint32_t epochUs;   // first-byte arrival of the epoch the current speed came from
+  uint32_t parsedUs;  // when that speed was committed by the parser
+  uint32_t ppsUs;     // last PPS rising edge (GPS_PPS_PIN), 0 = none
+  uint32_t ppsCount;  // PPS edges seen since boot
+  float courseDeg;    // from RMC/VTG
   char  date[8];      // DDMMYY, 0-terminated if available
   char  timeUTC[10];  // HHMMSS.sss, 0-terminated if available
+  float hAccM;        // horizontal accuracy estimate (m), 0 = not reported (GST / UBX)
+  float vAccM;        // vertical accuracy estimate (m), 0 = not reported (GST / UBX)
+  float sAccKmh;      // speed accuracy (km/h); UBX reports it, NMEA estimates it from HDOP
+  bool  sAccMeasured; // sAccKmh was reported by the receiver (UBX), not estimated
+  float pdop, hdop, vdop; // from GSA, 0 = not reported
 } GPSData;
 
-// Initialize the GPS on given UART1 pins. Typical: RX=16 (ESP reads), TX=15
+// Wire protocol decoded from the receiver, chosen at init time
+typedef enum GPSProtocol {
+  GPS_PROTOCOL_NMEA = 0,  // GGA/RMC/GSV/GSA/GST/VTG text sentences
+  GPS_PROTOCOL_UBX  = 1   // u-blox binary NAV-PVT / NAV-VELNED / NAV-SOL
+} GPSProtocol;
+
+// Outcome of the startup configuration sequence (gps_init_auto)
+typedef struct GPSConfigReport {
+  uint32_t detectedBaud;   // baud the receiver was found at, 0 = not heard
+  uint32_t finalBaud;      // baud the UART is left at
+  uint8_t  rateHz;         // navigation rate acknowledged by the receiver, 0 = unchanged
+  uint8_t  acked;          // CFG steps acknowledged (ACK-ACK)
+  uint8_t  naked;          // CFG steps rejected (ACK-NAK)
+  uint8_t  timeouts;       // CFG steps with no answer
+  bool     saved;          // configuration stored in receiver BBR/flash
+  bool     ok;             // every step acknowledged
+} GPSConfigReport;
+
+// Parser health counters (monotonic since gps_init). In UBX mode "sentences" are frames.
+typedef struct GPSParserStats {
+  uint32_t sentences;        // sentences/frames accepted (checksum OK)
+  uint32_t checksumErrors;   // bad or missing checksum
+  uint32_t overflows;        // sentence, field or frame longer than the parser accepts
+  uint32_t unknownSentences; // well-formed but no handler
+} GPSParserStats;
+
+// UART ingestion counters (monotonic since gps_start_task, or gps_init in polling mode)
+typedef struct GPSIngestStats {
+  uint32_t rxBytes;        // bytes handed to the parser
+  uint32_t rxEvents;       // RX notifications (FIFO threshold / idle line), event mode only
+  uint32_t overflows;      // RX FIFO or ring buffer overflow events; each one loses data
+  uint32_t lineErrors;     // framing / parity / break errors
+  uint32_t maxChunk;       // largest single drain in bytes (ring buffer high-water mark)
+  uint32_t latencyLastUs;  // RX event -> parse start, event mode only
+  uint32_t latencyMaxUs;
+  uint32_t latencyAvgUs;
+} GPSIngestStats;
+
+// One speed epoch as queued by the parse task (see gps_read_speed_samples)
+typedef struct GPSSpeedSample {
+  uint32_t tMs;        // millis() at the first byte of the epoch (decode time if not traced)
+  float speedRawKmh;   // ungated ground speed
+  bool  validFix;
+} GPSSpeedSample;
+
+// Data sources: the receiver (UART, or a replay set with gps_set_source) and an optional
+// secondary NMEA feed (gps_set_aux_source). GPSData follows whichever has the better fix.
+enum { GPS_SOURCE_PRIMARY = 0, GPS_SOURCE_AUX = 1, GPS_SOURCE_COUNT = 2 };
+
+// Per-source counters (monotonic since gps_init)
+typedef struct GPSSourceStats {
+  uint32_t bytes;          // bytes parsed from this source
+  uint32_t sentences;      // checksum-valid sentences (frames for a UBX receiver)
+  uint32_t drops;          // sentences lost on the way: bad checksum or overlong
+  uint32_t lastDataMs;     // millis() of the last valid sentence, 0 = never
+  uint8_t  fixQuality;     // latest fix quality reported (GGA scale), 0 = none
+  bool     active;         // currently feeding GPSData
+  uint32_t switches;       // source changes since gps_init (shared by all sources)
+  uint32_t latencyAvgUs;   // data ready -> parsed; for the polled secondary source add up to GPS_AUX_POLL_MS
+  uint32_t latencyMaxUs;
+} GPSSourceStats;
+
+// Commands sent with gps_send_ubx() and the receiver's answers (monotonic since gps_init)
+typedef struct GPSCommandStats {
+  uint32_t sent;           // frames written
+  uint32_t acked;          // ACK-ACK seen
+  uint32_t naked;          // ACK-NAK seen
+  uint8_t  lastNakClass;   // class/id of the most recent rejected command
+  uint8_t  lastNakId;
+} GPSCommandStats;
+
+// Initialize the GPS on given UART1 pins. Typical: RX=16 (ESP reads), TX=15. Decodes NMEA.
 void gps_init(int rxPin, int txPin, uint32_t baud);
 
-// Poll the UART, parse incoming NMEA, and update the internal snapshot
+// Bring the receiver up at its best settings: find the baud it is currently using, switch it to
+// 'targetBaud', set the navigation rate to 'rateHz', disable sentences/messages the decoder does
+// not use and save the result in the receiver. Each step is verified with ACK/NAK. The working
+// baud is also stored in NVS and tried first on the next boot. 'report' may be NULL.
+// Falls back to plain gps_init_protocol() at 9600 if the receiver is not heard at all.
+void gps_init_auto(int rxPin, int txPin, GPSProtocol protocol, uint32_t targetBaud, uint8_t rateHz,
+                   GPSConfigReport* report);
+
+// As gps_init(), selecting the decoder. UBX mode expects the receiver to already emit
+// NAV-PVT (or NAV-SOL + NAV-VELNED); NMEA bytes on the wire are ignored.
+void gps_init_protocol(int rxPin, int txPin, uint32_t baud, GPSProtocol protocol);
+
+// Switch to event-driven ingestion: UART RX interrupts fill the driver ring buffer and a
+// dedicated FreeRTOS task on 'coreId' parses as data arrives. gps_poll() becomes a no-op.
+// Returns false if the task could not be created (polling keeps working).
+bool gps_start_task(int coreId);
+
+// Send raw bytes (e.g. a UBX frame) to the receiver; returns bytes queued
+size_t gps_write(const uint8_t* data, size_t len);
+
+// Send a UBX command without waiting for its answer. The parse path watches for ACK-ACK/NAK in
+// either protocol mode and counts them (gps_get_command_stats). Returns false if not queued.
+bool gps_send_ubx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len);
+
+// Copy the command/ACK counters into 'out'
+void gps_get_command_stats(GPSCommandStats* out);
+
+// Copy the counters of GPS_SOURCE_PRIMARY or GPS_SOURCE_AUX into 'out'
+void gps_get_source_stats(int source, GPSSourceStats* out);
+
+// Poll the UART, parse incoming NMEA, and update the internal snapshot (polling mode only)
 void gps_poll(void);
 
-// Copy the latest snapshot into 'out'. Thread-safe for single-core cooperative use.
+// Copy the latest snapshot into 'out'. Safe to call from any task.
 void gps_get_data(GPSData* out);
 
+// Take up to 'max' queued speed epochs, oldest first; returns the number copied. Every speed
+// update is queued as it is parsed (GPS_SPEED_QUEUE deep, the oldest overwritten when full), so a
+// consumer polling from loop() sees every epoch at the receiver's full rate even when a frame is
+// slow. One consumer only. 'dropped' (may be NULL) gets the overwritten count since gps_init.
+size_t gps_read_speed_samples(GPSSpeedSample* out, size_t max, uint32_t* dropped);
+
+// Unix time of a snapshot in ms from its date/timeUTC strings, 0 if either is missing
+uint64_t gps_data_utc_ms(const GPSData* gd);
+
+// Copy the parser health counters into 'out'
+void gps_get_stats(GPSParserStats* out);
+
+// Copy the UART ingestion counters into 'out'
+void gps_get_ingest_stats(GPSIngestStats* out);
+
 #ifdef __cplusplus
 }
+
+#include "sat_table.hpp"
+#include "byte_source.hpp"
+#include "gps_power.hpp"
+
+// Copy the latest complete per-satellite table (all constellations)
+void gps_get_satellites(gnss::SatSnapshot* out);
+
+// Read receiver data from 'source' instead of the UART (nullptr restores the UART), e.g. a
+// recorded log for replay. The source is used from the parse task, or from gps_poll() when no
+// task runs, and must stay valid until replaced.
+void gps_set_source(io::ByteSource* source);
+
+// Wake the parse task after feeding a non-UART source (no-op in polling mode)
+void gps_source_ready(void);
+
+// Parse 'source' as NMEA alongside the receiver, e.g. an io::NetSource fed from a phone or a
+// bench PC. Both are parsed all the time; GPSData follows the one with the better, fresher fix
+// (gnss::SourceArbiter), staying with the current one on a tie. nullptr detaches. The source is
+// polled every GPS_AUX_POLL_MS from the parse task and must stay valid until replaced.
+void gps_set_aux_source(io::ByteSource* source);
+
+// Put the receiver into a power mode picked by gnss::PowerGovernor: POWER_FULL runs at
+// 'fullRateHz', POWER_REDUCED at 1 Hz, POWER_SAVE at 1 Hz in cyclic tracking. Non-blocking;
+// returns false if a command could not be queued. Rejections show up as NAKs in the command stats.
+bool gps_set_power_mode(gnss::PowerMode mode, uint8_t fullRateHz);
 #endif
@@ -1,8 +1,11 @@
 // Reusable lightweight NMEA GPS service for ESP32 (Arduino)
 // Parses GGA (fix/sats/alt/pos), RMC (speed/course/time/date), GSV (sats in view)
+// Header-only: sentences are decoded by the shared streaming parser in nmea_parser.hpp.
 
 #pragma once
 #include <Arduino.h>
+#include "nmea_parser.hpp"
+#include "byte_source.hpp"
 
 class GPSService {
 public:
@@ -10,8 +13,8 @@ public:
     bool validFix = false;
     int fixQuality = 0;   // 0=no fix, 1=GPS, 2=DGPS, >2 augmented
     int satsUsed = 0;     // satellites used in solution
-    float lat = 0;        // degrees
-    float lon = 0;        // degrees
+    int32_t latE7 = 0;    // 1e-7 degree
+    int32_t lonE7 = 0;    // 1e-7 degree
     float altitude = 0;   // meters MSL
   };
 
@@ -31,10 +34,27 @@ public:
   };
 
   // Initialize a HardwareSerial port for GPS (e.g., port 1)
-  void begin(HardwareSerial &serial, int rxPin, int txPin, uint32_t baud = 9600);
+  void begin(HardwareSerial &serial, int rxPin, int txPin, uint32_t baud = 9600) {
+    _serial = &serial;
+    _serial->begin(baud, SERIAL_8N1, rxPin, txPin);
+  }
 
   // Read bytes from the serial stream, parse any completed NMEA sentences
-  void updateFromStream(Stream &s);
+  void updateFromStream(Stream &s) {
+    while (s.available() > 0) _parser.feed((char)s.read(), *this);
+  }
+
+  // Same, from any byte source (UART, recorded log, memory buffer)
+  void updateFromSource(io::ByteSource &src) {
+    uint8_t buf[64];
+    size_t n;
+    while ((n = src.read(buf, sizeof(buf))) > 0) {
+      for (size_t i = 0; i < n; ++i) _parser.feed((char)buf[i], *this);
+    }
+  }
+
+  // Parser health counters
+  const nmea::Stats& stats() const { return _parser.stats(); }
 
   // Accessors
   const GGAInfo& gga() const { return _gga; }
@@ -43,8 +63,8 @@ public:
 
   // Convenience getters
   bool hasFix() const { return _gga.validFix || _rmc.active; }
-  float latitude() const { return _gga.lat; }
-  float longitude() const { return _gga.lon; }
+  double latitude() const { return _gga.latE7 * 1e-7; }
+  double longitude() const { return _gga.lonE7 * 1e-7; }
   float altitude() const { return _gga.altitude; }
   int satsUsed() const { return _gga.satsUsed; }
   int satsInView() const { return _gsv.inView; }
@@ -52,19 +72,33 @@ public:
   float speedKmh() const { return _rmc.speedKnots * 1.852f; }
   float courseDeg() const { return _rmc.courseDeg; }
 
-private:
-  // Helpers
-  static float nmeaCoordToDeg(const char* fld, bool isLat);
-  static int tokenize(char* s, const char* tokens[], int maxTok);
-
-  void parseSentence(char *sentenceNoDollar);
-  void parseGGA(char* s);
-  void parseRMC(char* s);
-  void parseGSV(char* s);
+  // Parser callbacks (checksum already verified)
+  void onSentence(const nmea::Gga &s) {
+    _gga.fixQuality = s.fixQuality;
+    _gga.satsUsed = s.satsUsed;
+    _gga.latE7 = s.latE7;
+    _gga.lonE7 = s.lonE7;
+    _gga.altitude = s.altitude;
+    _gga.validFix = s.fixQuality > 0;
+  }
+  void onSentence(const nmea::Rmc &s) {
+    _rmc.active = s.active;
+    _rmc.speedKnots = s.speedKnots;
+    _rmc.courseDeg = s.courseDeg;
+    memcpy(_rmc.date, s.date, sizeof(_rmc.date));
+    memcpy(_rmc.timeUTC, s.timeUTC, sizeof(_rmc.timeUTC));
+    if (!_gga.validFix && s.active) { _gga.latE7 = s.latE7; _gga.lonE7 = s.lonE7; }
+  }
+  void onSentence(const nmea::Gsv &s) {
+    _gsv.msgCount = s.total;
+    _gsv.currentMsg = s.index;
+    _gsv.inView = s.inView;
+    _gsv.lastUpdate = millis();
+  }
 
+private:
   HardwareSerial* _serial = nullptr;
-  char _lineBuf[128];
-  int _linePos = 0;
+  nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsv> _parser;
 
   GGAInfo _gga;
   RMCInfo _rmc;
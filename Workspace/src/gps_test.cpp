@@ -9,6 +9,8 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
+#include "nmea_parser.hpp"
+#include "wifi_link.h"
 
 HardwareSerial GPS(1);
 
@@ -17,8 +19,6 @@ static const int GPS_TX_PIN = 15; // ESP32 writes to GPS RX (optional)
 static uint32_t lastStatus = 0;
 static uint32_t lastSummary = 0;
 static uint32_t startMillis = 0;
-static char lineBuf[128];
-static int linePos = 0;
 
 struct GGAInfo {
   bool validFix = false;
@@ -44,110 +44,46 @@ struct GSVInfo {
   uint32_t lastUpdate = 0;
 } gsv;
 
-#ifndef WIFI_STA_SSID
-#define WIFI_STA_SSID ""
-#endif
-#ifndef WIFI_STA_PASS
-#define WIFI_STA_PASS ""
-#endif
-
 static WiFiServer telnetServer(2323);
 static WiFiClient telnetClient;
 static WebServer httpServer(80);
 
-static float nmeaCoordToDeg(const char* fld, bool isLat) {
-  // Format: ddmm.mmmm (lat) / dddmm.mmmm (lon)
-  if (!fld || !*fld) return 0;
-  float val = atof(fld);
-  int deg = (int)(val / 100);
-  float minutes = val - deg * 100;
-  float degVal = deg + minutes / 60.0f;
-  return degVal;
-}
-
-static int tokenize(char* s, const char* tokens[], int maxTok) {
-  int count = 0;
-  char* p = s;
-  while (p && *p && count < maxTok) {
-    tokens[count++] = p;
-    char* comma = strchr(p, ',');
-    if (!comma) break;
-    *comma = '\0';
-    p = comma + 1;
+// Sentences are decoded by the shared parser; only GGA/RMC/GSV handlers are compiled in
+struct TestSink {
+  void onSentence(const nmea::Gga &s) {
+    gga.fixQuality = s.fixQuality;
+    gga.sats = s.satsUsed;
+    gga.altitude = s.altitude;
+    gga.validFix = gga.fixQuality > 0;
+    gga.lat = s.latE7 * 1e-7f;
+    gga.lon = s.lonE7 * 1e-7f;
   }
-  return count;
-}
 
-static void parseGGA(char* s) {
-  // $GPGGA,time,lat,N,lon,E,fix,sats,hdop,alt,M,geoid,M,,*CS
-  const char* tokens[20] = {0};
-  int field = tokenize(s, tokens, 20);
-  if (field < 10) return;
-  gga.fixQuality = atoi(tokens[6]);
-  gga.sats = atoi(tokens[7]);
-  gga.altitude = atof(tokens[9]);
-  gga.validFix = gga.fixQuality > 0;
-  gga.lat = nmeaCoordToDeg(tokens[2], true);
-  if (tokens[3] && tokens[3][0] == 'S') gga.lat = -gga.lat;
-  gga.lon = nmeaCoordToDeg(tokens[4], false);
-  if (tokens[5] && tokens[5][0] == 'W') gga.lon = -gga.lon;
-}
+  void onSentence(const nmea::Rmc &s) {
+    memcpy(rmc.timeUTC, s.timeUTC, sizeof(rmc.timeUTC));
+    rmc.active = s.active;
+    rmc.speedKnots = s.speedKnots;
+    rmc.courseDeg = s.courseDeg;
+    memcpy(rmc.date, s.date, sizeof(rmc.date));
+    if (!gga.validFix && rmc.active) {
+      gga.lat = s.latE7 * 1e-7f;
+      gga.lon = s.lonE7 * 1e-7f;
+    }
+  }
 
-static void parseRMC(char* s) {
-  // $GPRMC,time,status,lat,N,lon,E,sog,course,date,magVar,E*CS
-  const char* tokens[20] = {0};
-  int field = tokenize(s, tokens, 20);
-  if (field < 10) return;
-  if (tokens[1]) strncpy(rmc.timeUTC, tokens[1], sizeof(rmc.timeUTC)-1);
-  rmc.active = (tokens[2] && tokens[2][0] == 'A');
-  rmc.speedKnots = tokens[7] ? atof(tokens[7]) : 0;
-  rmc.courseDeg = tokens[8] ? atof(tokens[8]) : 0;
-  if (tokens[9]) strncpy(rmc.date, tokens[9], sizeof(rmc.date)-1);
-  float lat = nmeaCoordToDeg(tokens[3], true);
-  if (tokens[4] && tokens[4][0] == 'S') lat = -lat;
-  float lon = nmeaCoordToDeg(tokens[5], false);
-  if (tokens[6] && tokens[6][0] == 'W') lon = -lon;
-  if (!gga.validFix && rmc.active) {
-    gga.lat = lat;
-    gga.lon = lon;
+  void onSentence(const nmea::Gsv &s) {
+    gsv.msgCount = s.total;
+    gsv.currentMsg = s.index;
+    gsv.inView = s.inView;
+    gsv.lastUpdate = millis();
   }
-}
+};
 
-static void parseGSV(char* s) {
-  // $GPGSV,totalMsgs,msgNum,svInView, ... up to 4 satellites per sentence
-  const char* tokens[30] = {0};
-  int field = tokenize(s, tokens, 30);
-  if (field < 4) return;
-  gsv.msgCount = atoi(tokens[1]);
-  gsv.currentMsg = atoi(tokens[2]);
-  gsv.inView = atoi(tokens[3]);
-  gsv.lastUpdate = millis();
-}
+static TestSink sink;
+static nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsv> parser;
 
 static void wifiStart() {
-  if (strlen(WIFI_STA_SSID) > 0) {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_STA_SSID, WIFI_STA_PASS);
-    Serial.printf("[WiFi] Connecting to %s...\n", WIFI_STA_SSID);
-    uint32_t t0 = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - t0 < 10000) {
-      delay(200);
-      Serial.print('.');
-    }
-    Serial.println();
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.printf("[WiFi] Connected: %s RSSI=%d dBm\n", WiFi.localIP().toString().c_str(), WiFi.RSSI());
-    } else {
-      Serial.println("[WiFi] STA connect failed, falling back to SoftAP");
-    }
-  }
-  if (WiFi.status() != WL_CONNECTED) {
-    WiFi.mode(WIFI_AP);
-    const char* apSsid = "ESP32-GPS";
-    const char* apPass = "gps12345"; // change for security
-    bool ok = WiFi.softAP(apSsid, apPass);
-    Serial.printf("[WiFi] SoftAP %s %s at %s\n", apSsid, ok?"started":"FAILED", WiFi.softAPIP().toString().c_str());
-  }
+  wifi_link_begin(10000);
   telnetServer.begin();
   telnetServer.setNoDelay(true);
   Serial.println("[WiFi] Telnet server listening on port 2323");
@@ -316,25 +252,7 @@ void gps_test_loop() {
   while (GPS.available()) {
     char c = GPS.read();
     logWrite(c);
-    if (c == '\r') continue;
-    if (c == '\n') {
-      lineBuf[linePos] = '\0';
-      if (linePos > 6 && lineBuf[0] == '$') {
-        char* sentence = lineBuf + 1;
-        if (strncmp(sentence+2, "GGA", 3) == 0) {
-          parseGGA(sentence);
-        } else if (strncmp(sentence+2, "RMC", 3) == 0) {
-          parseRMC(sentence);
-        } else if (strncmp(sentence+2, "GSV", 3) == 0) {
-          parseGSV(sentence);
-        }
-      }
-      linePos = 0;
-    } else if (linePos < (int)sizeof(lineBuf) - 1) {
-      lineBuf[linePos++] = c;
-    } else {
-      linePos = 0; // overflow reset
-    }
+    parser.feed(c, sink);
   }
   uint32_t now = millis();
   if (now - lastStatus > 3000) {
@@ -344,7 +262,7 @@ void gps_test_loop() {
   if (now - lastSummary > 5000) {
     lastSummary = now;
     float speedKmh = rmc.speedKnots * 1.852f;
-    logPrintf("[SUM] t=%lus fixQ=%d satsUsed=%d satsView=%d RMC=%s spd=%.1fkn(%.1fkm/h) alt=%.1fm lat=%.5f lon=%.5f\n",
+    logPrintf("[SUM] t=%lus fixQ=%d satsUsed=%d satsView=%d RMC=%s spd=%.1fkn(%.1fkm/h) alt=%.1fm lat=%.5f lon=%.5f nmea=%u csErr=%u\n",
               (unsigned long)((now - startMillis)/1000UL),
               gga.fixQuality,
               gga.sats,
@@ -354,7 +272,9 @@ void gps_test_loop() {
               speedKmh,
               gga.altitude,
               gga.lat,
-              gga.lon);
+              gga.lon,
+              (unsigned)parser.stats().sentences,
+              (unsigned)parser.stats().checksumErrors);
   }
   wifiPoll();
   httpServer.handleClient();
@@ -0,0 +1,91 @@
+#include "lap_timer.h"
+#include <LittleFS.h>
+#include <stdio.h>
+#include <new>
+#include "lap_timer.hpp"
+
+#ifndef LAP_GATES_PATH
+#define LAP_GATES_PATH "/littlefs/gates.csv"
+#endif
+// Capacity: gates (two per segment; segment ids must be below it) and grid references (a gate
+// straddling cells needs several)
+#ifndef LAP_MAX_GATES
+#define LAP_MAX_GATES 512
+#endif
+#ifndef LAP_MAX_REFS
+#define LAP_MAX_REFS 1024
+#endif
+// How long a lap/split/segment delta stays on screen
+#ifndef LAP_DELTA_SHOW_MS
+#define LAP_DELTA_SHOW_MS 8000
+#endif
+
+typedef lap::LapTimer<LAP_MAX_GATES, LAP_MAX_REFS> Timer;
+
+// loop() only. About 44 KB at the default capacities, so it is allocated (once, never freed)
+// when a gate file is first found rather than held by every unit that has none.
+static Timer* g_timer = nullptr;
+static bool g_active = false;
+static uint32_t g_lastFixMs = 0;
+
+static const char* kindName(lap::GateKind k) {
+  switch (k) {
+    case lap::GATE_START_FINISH: return "lap";
+    case lap::GATE_SPLIT: return "split";
+    case lap::GATE_SEGMENT_START: return "seg-start";
+    default: return "seg";
+  }
+}
+
+bool lap_timer_begin(void) {
+  g_active = false;
+  if (!LittleFS.begin(false)) return false;   // already mounted by track_log when it runs
+  FILE* f = fopen(LAP_GATES_PATH, "r");
+  if (!f) { Serial.printf("[LAP] no gate file %s, timer off\n", LAP_GATES_PATH); return false; }
+  if (!g_timer) g_timer = new (std::nothrow) Timer();
+  if (!g_timer) { fclose(f); Serial.printf("[LAP] no memory for the timer (%u bytes), timer off\n", (unsigned)sizeof(Timer)); return false; }
+  lap::GateGrid<LAP_MAX_GATES, LAP_MAX_REFS> &grid = g_timer->grid();
+  grid.clear();
+  char line[128];
+  uint32_t lines = 0, skipped = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lines++;
+    lap::Gate g;
+    if (!lap::parseGateLine(line, g, LAP_MAX_GATES)) { if (line[0] != '#' && line[0] != '\n' && line[0] != '\r') skipped++; continue; }
+    if (!grid.add(g)) { Serial.printf("[LAP] more than %u gates, rest ignored\n", (unsigned)LAP_MAX_GATES); break; }
+  }
+  fclose(f);
+  uint32_t t0 = micros();
+  if (!grid.build()) { Serial.printf("[LAP] index full (LAP_MAX_REFS=%u), timer off\n", (unsigned)LAP_MAX_REFS); return false; }
+  g_timer->reset();
+  g_active = grid.gates() > 0;
+  Serial.printf("[LAP] %u gates (%u lines, %u bad) in %u cells, %u refs, indexed in %u us\n", (unsigned)grid.gates(), lines, skipped, (unsigned)grid.cells(), (unsigned)grid.refs(), micros() - t0);
+  return g_active;
+}
+
+void lap_timer_update(const GPSData* gd) {
+  if (!g_active || !gd || !gd->validFix || gd->speedMs == g_lastFixMs) return;
+  g_lastFixMs = gd->speedMs;
+  int n = g_timer->update(gd->speedMs, gd->latE7, gd->lonE7);
+  for (int i = 0; i < n; ++i) {
+    const lap::LapEvent &e = g_timer->event(i);
+    if (e.hasDelta) Serial.printf("[LAP] %s %u: %u.%03u s (%+.3f)\n", kindName(e.kind), e.id, e.timeMs / 1000, e.timeMs % 1000, e.deltaMs / 1000.0f);
+    else if (e.hasTime) Serial.printf("[LAP] %s %u: %u.%03u s\n", kindName(e.kind), e.id, e.timeMs / 1000, e.timeMs % 1000);
+    else Serial.printf("[LAP] %s %u crossed\n", kindName(e.kind), e.id);
+  }
+}
+
+void lap_timer_get_status(LapTimerStatus* out, uint32_t nowMs) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  out->active = g_active;
+  if (!g_active) return;
+  out->gates = (uint16_t)g_timer->grid().gates();
+  out->lapRunning = g_timer->lapRunning();
+  out->laps = g_timer->laps();
+  out->lapElapsedMs = out->lapRunning ? nowMs - g_timer->lapStartMs() : 0;
+  out->lastLapMs = g_timer->lastLapMs();
+  out->bestLapMs = g_timer->bestLapMs();
+  uint32_t atMs;
+  if (g_timer->lastDelta(out->deltaMs, atMs)) out->showDelta = nowMs - atMs < LAP_DELTA_SHOW_MS;
+}
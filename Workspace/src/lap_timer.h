@@ -0,0 +1,28 @@
+// Lap and segment timing (include/lap_timer.hpp) against gate lines loaded from LAP_GATES_PATH on
+// LittleFS, one "kind,id,lat1,lon1,lat2,lon2" line per gate. Crossings are logged as [LAP] lines
+// and the running lap and the latest delta are shown on the main screen.
+#pragma once
+#include <Arduino.h>
+#include "gps_module.h"
+
+// What the main screen shows
+typedef struct LapTimerStatus {
+  bool     active;         // gates loaded
+  bool     lapRunning;     // the start/finish line has been crossed
+  uint32_t laps;           // completed laps
+  uint32_t lapElapsedMs;   // current lap, up to now
+  uint32_t lastLapMs;
+  uint32_t bestLapMs;
+  int32_t  deltaMs;        // latest lap/split/segment time minus the best one (negative = faster)
+  bool     showDelta;      // the delta is recent enough to show (LAP_DELTA_SHOW_MS)
+  uint16_t gates;
+} LapTimerStatus;
+
+// Load and index the gate file. Returns false (timer inactive) if it is missing or unusable.
+bool lap_timer_begin(void);
+
+// Feed every GPS snapshot; new fixes are tested against the nearby gates
+void lap_timer_update(const GPSData* gd);
+
+// Current timing for display at millis() 'nowMs'
+void lap_timer_get_status(LapTimerStatus* out, uint32_t nowMs);
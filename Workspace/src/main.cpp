@@ -4,15 +4,34 @@
 #include "display_config.hpp"
 #include "battery.hpp"
 #include "gps_module.h"
+#include "gps_aiding.h"
+#include "track_log.h"
+#include "track_export.h"
+#include "trip_store.h"
+#include "lap_timer.h"
+#include "poi_alerts.h"
+#include "perf_timer.h"
+#include "map_tiles.h"
+#include "telemetry_uploader.h"
 #include "arc_utils.hpp"
 #include "icon_utils.hpp"
+#include "speed_filter.hpp"
+#include "speed_history.hpp"
+#include "geo_utils.hpp"
+#include "track_simplifier.hpp"
+#include "latency_histogram.hpp"
+#include "gps_power.hpp"
+#include "wifi_link.h"
+#include "net_source.hpp"
+#include "demo_drive.hpp"
+#include "perf_timer.hpp"
 
 // Create display and battery instances
 LGFX display;
 Battery battery;
 
 // ---------- UI State ----------
-enum class Screen { MAIN, SETTINGS, METRICS };
+enum class Screen { MAIN, SETTINGS, METRICS, HISTORY, MAP, PERF };
 static Screen currentScreen = Screen::MAIN;
 
 struct UIState {
@@ -21,6 +40,9 @@ struct UIState {
   const char* units = "km/h";  // unit label
   int satellites = 0;          // sats used in solution
   int satsInView = 0;          // sats visible
+  int cn0Avg = 0;              // mean C/N0 of tracked sats (dB-Hz)
+  int cn0Top4 = 0;             // mean C/N0 of the 4 strongest (dB-Hz)
+  float hdop = 0.0f;           // horizontal dilution of precision
   int battery_pc = 0;          // battery percent
   double lat = 0.0;            // latitude
   double lon = 0.0;            // longitude
@@ -34,6 +56,10 @@ struct UIState {
   int prev_battery = -1;
   int prev_satellites = -1;
   BatteryState prev_battery_state = BatteryState::UNKNOWN;
+  uint32_t prev_lap_ds = 0;    // lap clock tenths last drawn
+  bool prev_lap_delta = false;
+  uint32_t prev_poi = 0;        // poiSignature() last drawn
+  uint32_t prev_perf = 0;       // perfSignature() last drawn
   bool needsFullRedraw = true;
 } ui;
 
@@ -61,6 +87,199 @@ static SwipeState swipe;
 #ifndef TAP_TIME_MS
 #define TAP_TIME_MS 300
 #endif
+// Receiver link settings applied at boot (auto-detected current baud -> target)
+#ifndef GPS_TARGET_BAUD
+#define GPS_TARGET_BAUD 115200
+#endif
+#ifndef GPS_RATE_HZ
+#define GPS_RATE_HZ 10
+#endif
+// Parse GPS in a dedicated RX-event task (1) or from loop() (0)
+#ifndef GPS_RX_TASK
+#define GPS_RX_TASK 1
+#endif
+// Replace the receiver with a synthetic drive (demo_drive.hpp) emitting NMEA at DEMO_NMEA_HZ (1..50)
+#ifndef DEMO_MODE
+#define DEMO_MODE 0
+#endif
+#ifndef DEMO_NMEA_HZ
+#define DEMO_NMEA_HZ 10
+#endif
+// Record every fix to LittleFS (track_log); DEMO_MODE drives are not recorded
+#ifndef TRACK_LOG
+#define TRACK_LOG 1
+#endif
+// Lap/segment timing against the gates in LAP_GATES_PATH (lap_timer)
+#ifndef LAP_TIMER
+#define LAP_TIMER 1
+#endif
+// Speed-camera / speed-limit alerts from the POI table in the "poi" partition (poi_alerts)
+#ifndef POI_ALERTS
+#define POI_ALERTS 1
+#endif
+// Acceleration/braking timer on its own screen, fed every speed epoch (perf_timer)
+#ifndef PERF_TIMER
+#define PERF_TIMER 1
+#endif
+// Roads/coastline under the MAP screen track from the "tiles" partition (map_tiles)
+#ifndef MAP_BASEMAP
+#define MAP_BASEMAP 1
+#endif
+// Coarser zooms than this (metres per pixel) draw the track alone
+#ifndef MAP_BASEMAP_MAX_MPP
+#define MAP_BASEMAP_MAX_MPP 20
+#endif
+// Serve the recorded tracks as GPX/CSV over WiFi (track_export)
+#ifndef TRACK_HTTP_EXPORT
+#define TRACK_HTTP_EXPORT 0
+#endif
+// Push the recorded tracks and trip totals to TELEMETRY_URL when the station network is in reach
+// (telemetry_uploader; needs TRACK_LOG and WIFI_STA_SSID)
+#ifndef TELEMETRY_UPLOAD
+#define TELEMETRY_UPLOAD 0
+#endif
+// Accept NMEA over WiFi (UDP/TCP port 10110) as a second source, arbitrated against the receiver
+#ifndef GPS_NET_NMEA
+#define GPS_NET_NMEA 0
+#endif
+// Drop the receiver to 1 Hz / cyclic tracking while parked (1) or always run at GPS_RATE_HZ (0)
+#ifndef GPS_POWER_ADAPTIVE
+#define GPS_POWER_ADAPTIVE 1
+#endif
+// Main screen frame interval; the needle is interpolated between fixes at this rate
+#ifndef UI_FRAME_MS
+#define UI_FRAME_MS 40
+#endif
+
+// Smooths GPS speed and predicts it between fixes for the needle
+static nav::SpeedFilter speedFilter;
+static uint32_t lastSpeedMs = 0;
+static nav::TripComputer tripComputer;
+
+// Speed/altitude history for the HISTORY graph: 200 buckets at 1 s, 10 s and 100 s (3.3 min,
+// 33 min and 5.5 h) in under 10 KB. The graph span cycles with a tap or the 'h' key.
+static nav::SpeedHistory<200, 3, 10> speedHistory;
+static const uint32_t HISTORY_SPANS_S[] = { 180, 1800, 7200, 19800 };
+static const char* const HISTORY_SPAN_NAMES[] = { "3 min", "30 min", "2 h", "5.5 h" };
+static const int HISTORY_SPAN_COUNT = sizeof(HISTORY_SPANS_S) / sizeof(HISTORY_SPANS_S[0]);
+static int historySpan = 1;
+
+// Breadcrumb map: the drive simplified to at most MAP_VERTICES points (about 12 KB with the view
+// cache), drawn heading-up around the car. A tap or the 'z' key steps through the zooms.
+#define MAP_VERTICES 400
+static track::TrackSimplifier<MAP_VERTICES> trackMap;
+static track::TrackView<MAP_VERTICES> trackView(120, 120, 100, 12, 15.0f);
+static geo::LocalFrame mapFrame;
+static struct { float e, n, headingDeg, speedKmh; int32_t latE7, lonE7; uint32_t lastMs; bool have; } mapCar = { 0.0f, 0.0f, 0.0f, 0.0f, 0, 0, 0, false };
+static const int MAP_ZOOMS[] = { -1, 1, 3, 5 };   // fit the track, then 1, 5 and 20 m per pixel
+static const int MAP_ZOOM_MODES = sizeof(MAP_ZOOMS) / sizeof(MAP_ZOOMS[0]);
+static int mapZoomMode = 0;
+static uint32_t mapDrawnFixMs = 0;
+
+static void mapOnFix(const GPSData &gd, float speedKmh) {
+  if (!mapFrame.valid) mapFrame.setOrigin(gd.latE7, gd.lonE7);
+  mapFrame.toEnu(gd.latE7, gd.lonE7, mapCar.e, mapCar.n);
+  // Course is noise when crawling; keep the last good heading
+  if (speedKmh > 5.0f) mapCar.headingDeg = gd.courseDeg;
+  mapCar.speedKmh = speedKmh; mapCar.latE7 = gd.latE7; mapCar.lonE7 = gd.lonE7;
+  trackMap.add(mapCar.e, mapCar.n, mapCar.have && gd.speedMs - mapCar.lastMs > 5000);
+  mapCar.lastMs = gd.speedMs;
+  mapCar.have = true;
+}
+
+#if DEMO_MODE
+static uint32_t demoClockMs() { return millis(); }
+static demo::DriveGenerator demoDrive;
+static demo::NmeaSource demoSource(demoDrive, DEMO_NMEA_HZ, demoClockMs);  // read by the GPS parse task
+static uint32_t demoStartMs = 0;
+#endif
+
+#if GPS_NET_NMEA
+static io::NetSource netSource;  // read only from the GPS parse task once attached
+#endif
+
+// Picks the receiver power mode from motion; transitions are logged with the time spent per mode.
+// The perf screen holds full rate: a launch is timed from a car that has been standing. It is fed
+// the speed filter's gated speed: a lone multipath spike gets through the raw gate and would
+// restart the parked timer.
+static gnss::PowerGovernor powerGovernor;
+
+static void powerOnSnapshot(const GPSData &gd, uint32_t nowMs) {
+#if GPS_POWER_ADAPTIVE
+  float speed = speedFilter.valid() ? speedFilter.speedKmhAt(gd.speedMs) : gd.speedKmh;
+  if (!powerGovernor.update(nowMs, gd.validFix, speed, gd.courseDeg, currentScreen == Screen::PERF)) return;
+  gnss::PowerMode m = powerGovernor.mode();
+  bool ok = gps_set_power_mode(m, GPS_RATE_HZ);
+  const gnss::PowerGovernor::Stats &st = powerGovernor.stats();
+  GPSCommandStats cs; gps_get_command_stats(&cs);
+  Serial.printf("[GPS-PWR] -> %s%s | full=%us 1Hz=%us psm=%us transitions=%u saving~%.0f%% | cmd sent=%u ack=%u nak=%u\n",
+                gnss::powerModeName(m), ok ? "" : " (write failed)", st.timeMs[gnss::POWER_FULL] / 1000, st.timeMs[gnss::POWER_REDUCED] / 1000,
+                st.timeMs[gnss::POWER_SAVE] / 1000, st.transitions, powerGovernor.estimatedSavingPct(), cs.sent, cs.acked, cs.naked);
+#else
+  (void)gd; (void)nowMs;
+#endif
+}
+
+// Trip computer: one update per new fix, NVS writes coalesced by trip_store (not in demo mode,
+// so a synthetic drive never lands on the real odometer)
+static void tripOnFix(const GPSData &gd, uint32_t nowMs) {
+  tripComputer.update(gd.speedMs, gd.latE7, gd.lonE7, speedFilter.speedKmhAt(gd.speedMs), gd.hAccM);
+  #if !DEMO_MODE
+  trip_store_update(&tripComputer.state(), nowMs, tripComputer.moving());
+  #endif
+  #if TELEMETRY_UPLOAD
+  static uint32_t lastTripPushMs = 0;
+  if (nowMs - lastTripPushMs >= 10000) { lastTripPushMs = nowMs; telemetry_uploader_set_trip(&tripComputer.state()); }
+  #endif
+}
+
+static void tripReset(int trip) {
+  tripComputer.resetTrip(trip);
+  #if !DEMO_MODE
+  trip_store_save(&tripComputer.state(), millis());
+  #endif
+  Serial.printf("[TRIP] trip %c reset\n", 'A' + trip);
+}
+
+// ---------- Fix-to-glass latency tracing ----------
+// Each new fix is followed from UART arrival through parse and snapshot to the first main-screen
+// push that shows it. Histograms are printed and cleared with the 'l' serial key.
+enum LatencyStage { LAT_PPS_RX, LAT_RX_PARSE, LAT_PARSE_SNAP, LAT_SNAP_RENDER, LAT_RENDER, LAT_PUSH, LAT_RX_GLASS, LAT_COUNT };
+static const char* LATENCY_STAGE_NAMES[LAT_COUNT] = { "pps>rx", "rx>parse", "parse>snap", "snap>render", "render", "push", "rx>glass" };
+static perf::LatencyHistogram latencyHist[LAT_COUNT];
+static struct { bool pending; uint32_t epochUs, snapUs; uint32_t superseded; } latencyTrace = { false, 0, 0, 0 };
+
+// A new fix reached the UI snapshot
+static void latencyOnSnapshot(const GPSData &gd, uint32_t snapUs) {
+  if (!gd.epochUs) return;
+  if (latencyTrace.pending) latencyTrace.superseded++; // previous fix never reached the glass
+  // PPS marks the top of the second the epoch describes; only pair it with the burst it precedes
+  if (gd.ppsUs && gd.epochUs - gd.ppsUs < 1000000UL) latencyHist[LAT_PPS_RX].add(gd.epochUs - gd.ppsUs);
+  latencyHist[LAT_RX_PARSE].add(gd.parsedUs - gd.epochUs);
+  latencyHist[LAT_PARSE_SNAP].add(snapUs - gd.parsedUs);
+  latencyTrace.pending = true; latencyTrace.epochUs = gd.epochUs; latencyTrace.snapUs = snapUs;
+}
+
+// The main screen finished pushing a frame
+static void latencyOnPush(uint32_t renderStartUs, uint32_t pushStartUs, uint32_t pushEndUs) {
+  if (!latencyTrace.pending) return;
+  latencyTrace.pending = false;
+  latencyHist[LAT_SNAP_RENDER].add(renderStartUs - latencyTrace.snapUs);
+  latencyHist[LAT_RENDER].add(pushStartUs - renderStartUs);
+  latencyHist[LAT_PUSH].add(pushEndUs - pushStartUs);
+  latencyHist[LAT_RX_GLASS].add(pushEndUs - latencyTrace.epochUs);
+}
+
+static void latencyReport() {
+  Serial.printf("[LAT] %-12s %6s %8s %8s %8s %8s (us)\n", "stage", "n", "avg", "p50", "p90", "max");
+  for (int i = 0; i < LAT_COUNT; ++i) {
+    const perf::LatencyHistogram &h = latencyHist[i];
+    Serial.printf("[LAT] %-12s %6u %8u %8u %8u %8u\n", LATENCY_STAGE_NAMES[i], h.count(), h.avgUs(), h.percentileUs(50), h.percentileUs(90), h.maxUs());
+    latencyHist[i].reset();
+  }
+  Serial.printf("[LAT] fixes not rendered: %u\n", latencyTrace.superseded);
+  latencyTrace.superseded = 0;
+}
 
 // ---------- Colour Schemes ----------
 struct ColorScheme {
@@ -121,7 +340,15 @@ using ui_arc::polarPoint;   // re-export for existing code
 // ========================================
 
 // ---------- Rendering: Main Gauge ----------
+#if POI_ALERTS
+// What the POI sign on the main screen depends on, so the gauge redraws only when it changes
+static uint32_t poiSignature(const PoiAlertStatus &pa) {
+  return (uint32_t)pa.limitKmh | (pa.camera ? (uint32_t)(pa.cameraDistM / 10 + 1) << 8 : 0) | (pa.overspeed && ui.lowBatFlashState ? 1u << 31 : 0);
+}
+#endif
+
 static void renderMain() {
+  const uint32_t renderStartUs = micros();
   const int W = display.width(); const int H = display.height(); const int cx = W/2, cy = H/2;
   ColorScheme& cs = getColors();
   if (!spriteInit) { sprite.createSprite(W, H); spriteInit = true; }
@@ -185,7 +412,40 @@ static void renderMain() {
   // Speed value
   sprite.setTextDatum(MC_DATUM); sprite.setFont(&fonts::FreeSansBold24pt7b); sprite.setTextColor(cs.speedText, cs.background); char spBuf[12]; if (ui.speed_kmh < 10.0f) snprintf(spBuf, sizeof(spBuf), "%.1f", ui.speed_kmh); else snprintf(spBuf, sizeof(spBuf), "%d", (int)roundf(ui.speed_kmh)); sprite.drawString(spBuf, cx, cy - 18); sprite.setFont(nullptr); sprite.setTextSize(2); sprite.setTextColor(cs.unitsText, cs.background); sprite.drawString(ui.units, cx, cy - 52); sprite.setTextSize(1);
 
+  #if LAP_TIMER
+  // Lap clock and the latest split/lap delta (green = faster than best), under the icons
+  LapTimerStatus ls; lap_timer_get_status(&ls, millis());
+  if (ls.lapRunning || ls.showDelta) {
+    char lapTxt[32]; uint32_t ds = ls.lapElapsedMs / 100;
+    snprintf(lapTxt, sizeof(lapTxt), "L%u %u:%02u.%u", (unsigned)(ls.laps + 1), (unsigned)(ds / 600), (unsigned)(ds / 10 % 60), (unsigned)(ds % 10));
+    sprite.setTextDatum(MC_DATUM); sprite.setFont(nullptr); sprite.setTextSize(1); sprite.setTextColor(cs.text, cs.background);
+    if (ls.lapRunning) sprite.drawString(lapTxt, cx, cy + 84);
+    if (ls.showDelta) { snprintf(lapTxt, sizeof(lapTxt), "%+.2f", ls.deltaMs / 1000.0f); sprite.setTextColor(ls.deltaMs <= 0 ? cs.arcLow : cs.arcHigh, cs.background); sprite.drawString(lapTxt, cx, cy + 96); }
+    ui.prev_lap_ds = ds;
+  }
+  ui.prev_lap_delta = ls.showDelta;
+  #endif
+
+  #if POI_ALERTS
+  // Speed-limit sign above the units, flashing red while over it; camera distance beside it
+  PoiAlertStatus pa; poi_alerts_get_status(&pa);
+  if (pa.limitKmh || pa.camera) {
+    const int signX = cx, signY = cy - 80;
+    bool flash = pa.overspeed && ui.lowBatFlashState;
+    sprite.fillCircle(signX, signY, 13, cs.arcHigh);
+    sprite.fillCircle(signX, signY, 10, flash ? cs.arcHigh : 0xFFFF);
+    sprite.setTextDatum(MC_DATUM); sprite.setFont(nullptr); sprite.setTextSize(1); sprite.setTextColor(flash ? 0xFFFF : 0x0000);
+    char poiTxt[12];
+    if (pa.limitKmh) snprintf(poiTxt, sizeof(poiTxt), "%u", pa.limitKmh); else snprintf(poiTxt, sizeof(poiTxt), "CAM");
+    sprite.drawString(poiTxt, signX, signY + 1);
+    if (pa.camera) { snprintf(poiTxt, sizeof(poiTxt), "%um", (unsigned)(pa.cameraDistM / 10 * 10)); sprite.setTextDatum(ML_DATUM); sprite.setTextColor(cs.arcHigh, cs.background); sprite.drawString(poiTxt, signX + 17, signY + 1); }
+  }
+  ui.prev_poi = poiSignature(pa);
+  #endif
+
+  const uint32_t pushStartUs = micros();
   sprite.pushSprite(0,0);
+  latencyOnPush(renderStartUs, pushStartUs, micros());
   ui.prev_speed = ui.speed_kmh; ui.prev_battery = ui.battery_pc; ui.prev_satellites = ui.satellites; ui.needsFullRedraw = false;
 }
 
@@ -215,30 +475,32 @@ static void renderMetrics() {
   } else {
     snprintf(line, sizeof(line), "Satellites: %d / %d (NO FIX)", ui.satellites, ui.satsInView);
   }
-  sprite.drawString(line, cx, 70);
+  sprite.drawString(line, cx, 62);
 
-  // Coordinates
+  // Coordinates and altitude
   sprite.setFont(nullptr);
   sprite.setTextColor(cs.iconDim, cs.background);
-  snprintf(line, sizeof(line), "Lat: %.5f", ui.lat);
-  sprite.drawString(line, cx, 95);
-  snprintf(line, sizeof(line), "Lon: %.5f", ui.lon);
-  sprite.drawString(line, cx, 110);
-
-  // Altitude
   if (ui.fixValid) {
     char altVal[16]; dtostrf(ui.altitude_m, 0, 1, altVal);
-    snprintf(line, sizeof(line), "Alt: %sm", altVal);
+    snprintf(line, sizeof(line), "%.6f, %.6f  Alt %sm", ui.lat, ui.lon, altVal);
   } else {
-    snprintf(line, sizeof(line), "Alt: ---");
+    snprintf(line, sizeof(line), "%.6f, %.6f  Alt ---", ui.lat, ui.lon);
   }
-  sprite.drawString(line, cx, 125);
+  sprite.drawString(line, cx, 82);
 
   // Speed line (shows ~ prefix if no fix yet)
   sprite.setFont(&fonts::FreeSans9pt7b);
   sprite.setTextColor(cs.text, cs.background);
   snprintf(line, sizeof(line), "Speed: %s%.1f %s", ui.fixValid ? "" : "~", ui.speed_kmh, ui.units);
-  sprite.drawString(line, cx, 140);
+  sprite.drawString(line, cx, 100);
+
+  // Signal quality from the GSV satellite table and GSA geometry
+  sprite.setFont(nullptr);
+  sprite.setTextColor(cs.iconDim, cs.background);
+  snprintf(line, sizeof(line), "C/N0 %d/%d dB-Hz  HDOP %.1f", ui.cn0Avg, ui.cn0Top4, ui.hdop);
+  sprite.drawString(line, cx, 117);
+  sprite.setFont(&fonts::FreeSans9pt7b);
+  sprite.setTextColor(cs.text, cs.background);
 
   // Power / Battery
   if (battery.isUSBPowered()) {
@@ -246,7 +508,20 @@ static void renderMetrics() {
   } else {
     snprintf(line, sizeof(line), "Battery: %d%% (%.2fV)", ui.battery_pc, battery.getVoltage());
   }
-  sprite.drawString(line, cx, 170);
+  sprite.drawString(line, cx, 134);
+
+  // Trip computer: distance, moving time, average and max speed per trip, then the odometer
+  sprite.setFont(nullptr);
+  for (int i = 0; i < nav::TRIP_COUNT; ++i) {
+    const nav::TripTotals &t = tripComputer.trip(i);
+    uint32_t mins = (uint32_t)(t.movingMs / 60000);
+    snprintf(line, sizeof(line), "%c %.1fkm %u:%02u avg %.0f max %.0f", 'A' + i, t.distanceM / 1000.0, (unsigned)(mins / 60), (unsigned)(mins % 60), t.avgKmh(), t.maxKmh);
+    sprite.setTextColor(i == nav::TRIP_A ? cs.text : cs.iconDim, cs.background);
+    sprite.drawString(line, cx, 152 + 12 * i);
+  }
+  sprite.setTextColor(cs.iconDim, cs.background);
+  snprintf(line, sizeof(line), "Odo %.1f km", tripComputer.odometerM() / 1000.0);
+  sprite.drawString(line, cx, 176);
 
   // Footer hint
   sprite.setFont(nullptr);
@@ -256,7 +531,223 @@ static void renderMetrics() {
   sprite.pushSprite(0,0);
 }
 
-static void renderActive() { switch (currentScreen) { case Screen::MAIN: renderMain(); break; case Screen::SETTINGS: renderSettings(); break; case Screen::METRICS: renderMetrics(); break; } }
+// Speed graph (min-max band with the average on top) and altitude trace over the chosen span.
+// The query reads at most one ring's worth of buckets, so a frame costs the same at any span.
+static void renderHistory() {
+  const int W = display.width(); const int H = display.height(); const int cx = W/2; ColorScheme& cs = getColors(); if (!spriteInit){ sprite.createSprite(W,H); spriteInit = true; }
+  static const int GX = 30, GW = 180, GY = 70, GH = 110;
+  static nav::HistColumn cols[GW];
+  sprite.fillSprite(cs.background);
+  sprite.setTextDatum(MC_DATUM);
+  sprite.setFont(&fonts::FreeSansBold12pt7b);
+  sprite.setTextColor(cs.text, cs.background);
+  sprite.drawString("History", cx, 35);
+  sprite.setFont(nullptr); sprite.setTextSize(1);
+  char line[40];
+
+  speedHistory.query(millis() / 1000, HISTORY_SPANS_S[historySpan], cols, GW);
+  float aLo = 1e9f, aHi = -1e9f, vPeak = 0.0f;
+  for (int i = 0; i < GW; ++i) {
+    if (cols[i].valid && cols[i].vMax > vPeak) vPeak = cols[i].vMax;
+    if (cols[i].altValid) { if (cols[i].aAvg < aLo) aLo = cols[i].aAvg; if (cols[i].aAvg > aHi) aHi = cols[i].aAvg; }
+  }
+  bool haveAlt = aHi >= aLo;
+  // Speed axis in 20 km/h steps, at least 40; altitude stretched over the graph, 10 m at least
+  float vTop = fmaxf(40.0f, ceilf(vPeak / 20.0f) * 20.0f);
+  if (haveAlt && aHi - aLo < 10.0f) { float m = 0.5f * (aHi + aLo); aLo = m - 5.0f; aHi = m + 5.0f; }
+
+  sprite.drawFastHLine(GX, GY, GW, cs.arcBackground);
+  sprite.drawFastHLine(GX, GY + GH, GW, cs.arcBackground);
+  int prevAy = -1;
+  for (int i = 0; i < GW; ++i) {
+    const nav::HistColumn &c = cols[i];
+    int x = GX + i;
+    if (c.altValid) {
+      int ay = GY + GH - (int)((c.aAvg - aLo) / (aHi - aLo) * GH);
+      if (prevAy >= 0) sprite.drawLine(x - 1, prevAy, x, ay, cs.iconDim); else sprite.drawPixel(x, ay, cs.iconDim);
+      prevAy = ay;
+    } else prevAy = -1;
+    if (!c.valid) continue;
+    int yMax = GY + GH - (int)(fminf(c.vMax, vTop) / vTop * GH);
+    int yMin = GY + GH - (int)(fminf(c.vMin, vTop) / vTop * GH);
+    int yAvg = GY + GH - (int)(fminf(c.vAvg, vTop) / vTop * GH);
+    sprite.drawFastVLine(x, yMax, yMin - yMax + 1, cs.arcLow);
+    sprite.drawPixel(x, yAvg, cs.text);
+  }
+
+  sprite.setTextColor(cs.iconDim, cs.background);
+  snprintf(line, sizeof(line), "%.0f", vTop); sprite.drawString(line, GX - 12, GY);
+  sprite.drawString("0", GX - 12, GY + GH);
+  sprite.setTextColor(cs.text, cs.background);
+  snprintf(line, sizeof(line), "Last %s  peak %.0f %s", HISTORY_SPAN_NAMES[historySpan], vPeak, ui.units);
+  sprite.drawString(line, cx, 58);
+  sprite.setTextColor(cs.iconDim, cs.background);
+  if (haveAlt) { snprintf(line, sizeof(line), "Alt %.0f-%.0f m", aLo, aHi); sprite.drawString(line, cx, GY + GH + 14); }
+  sprite.drawString("Tap to change span", cx, GY + GH + 28);
+  sprite.pushSprite(0,0);
+}
+
+// Heading-up track around the car. Screen positions are cached per vertex by trackView and only
+// recomputed when the car has drifted, turned or the zoom changed, so a frame is one walk over at
+// most MAP_VERTICES cached points.
+#if MAP_BASEMAP
+// Basemap tiles under the track. Each tile gets one affine transform from tile units to screen
+// (its corner through the current view), so a point costs two multiply-adds per axis.
+static void drawBasemap(int W, int H, const ColorScheme &cs) {
+  if (!map_tiles_active() || trackView.metersPerPx() > MAP_BASEMAP_MAX_MPP) return;
+  uint32_t t0 = micros();
+  const tiles::DecodedTile* vis[MAP_TILE_CACHE_SLOTS];
+  int n = map_tiles_frame(mapCar.latE7, mapCar.lonE7, mapCar.headingDeg, mapCar.speedKmh, W / 2 * trackView.metersPerPx(), vis, MAP_TILE_CACHE_SLOTS);
+  for (int t = 0; t < n; ++t) {
+    const tiles::DecodedTile &tile = *vis[t];
+    int32_t latE7, lonE7; float k, e0, n0, ox, oy, ex, ey, sx, sy;
+    map_tiles_tile_origin(tile.key, &latE7, &lonE7, &k);
+    mapFrame.toEnu(latE7, lonE7, e0, n0);
+    float span = k * tiles::TILE_EXTENT;
+    trackView.toScreenF(e0, n0, ox, oy);
+    trackView.toScreenF(e0 + span, n0, ex, ey);   // +u is east
+    trackView.toScreenF(e0, n0 - span, sx, sy);   // +v is south
+    float ux = (ex - ox) / tiles::TILE_EXTENT, uy = (ey - oy) / tiles::TILE_EXTENT, vx = (sx - ox) / tiles::TILE_EXTENT, vy = (sy - oy) / tiles::TILE_EXTENT;
+    for (int f = 0; f < tile.features; ++f) {
+      uint16_t color = tile.kind[f] == tiles::KIND_MAJOR ? cs.iconDim : (tile.kind[f] == tiles::KIND_WATER ? cs.unitsText : cs.arcBackground);
+      int px = 0, py = 0;
+      for (int i = tile.featStart[f]; i < tile.featStart[f + 1]; ++i) {
+        int x = (int)(ox + tile.x[i] * ux + tile.y[i] * vx), y = (int)(oy + tile.x[i] * uy + tile.y[i] * vy);
+        if (i > tile.featStart[f] && !((px < 0 && x < 0) || (py < 0 && y < 0) || (px >= W && x >= W) || (py >= H && y >= H))) sprite.drawLine(px, py, x, y, color);
+        px = x; py = y;
+      }
+    }
+  }
+  map_tiles_note_draw(micros() - t0);
+}
+#endif
+
+static void renderMap() {
+  const int W = display.width(); const int H = display.height(); const int cx = W/2; const int cy = H/2; ColorScheme& cs = getColors(); if (!spriteInit){ sprite.createSprite(W,H); spriteInit = true; }
+  sprite.fillSprite(cs.background);
+  sprite.setTextDatum(MC_DATUM);
+  sprite.setFont(nullptr); sprite.setTextSize(1);
+  mapDrawnFixMs = mapCar.lastMs;
+  if (!mapCar.have) {
+    sprite.setFont(&fonts::FreeSansBold12pt7b); sprite.setTextColor(cs.text, cs.background); sprite.drawString("Map", cx, 35);
+    sprite.setFont(&fonts::FreeSans9pt7b); sprite.setTextColor(cs.iconDim, cs.background); sprite.drawString("Waiting for a fix", cx, cy);
+    sprite.pushSprite(0,0);
+    return;
+  }
+  trackView.update(trackMap, mapCar.e, mapCar.n, mapCar.headingDeg);
+  #if MAP_BASEMAP
+  drawBasemap(W, H, cs);
+  #endif
+  sprite.drawCircle(cx, cy, 118, cs.arcBackground);
+
+  const int16_t NONE = track::TrackSimplifier<MAP_VERTICES>::NONE;
+  int16_t p = NONE;
+  for (int16_t i = trackMap.head(); i != NONE; i = trackMap.next(i)) {
+    if (p != NONE && !trackMap.runStart(i)) {
+      int x0 = trackView.x(p), y0 = trackView.y(p), x1 = trackView.x(i), y1 = trackView.y(i);
+      // Both ends off the same side: nothing to draw
+      if (!((x0 < 0 && x1 < 0) || (y0 < 0 && y1 < 0) || (x0 >= W && x1 >= W) || (y0 >= H && y1 >= H))) sprite.drawLine(x0, y0, x1, y1, cs.arcLow);
+    }
+    p = i;
+  }
+  // The car between re-projections: where it is now, turned by how far it has turned since
+  int carX, carY; trackView.toScreen(mapCar.e, mapCar.n, carX, carY);
+  float a = (mapCar.headingDeg - trackView.headingDeg()) * (float)(M_PI / 180.0), sa = sinf(a), ca = cosf(a);
+  sprite.fillTriangle(carX + (int)(9 * sa), carY - (int)(9 * ca), carX + (int)(-6 * ca - 6 * sa), carY + (int)(-6 * sa + 6 * ca), carX + (int)(6 * ca - 6 * sa), carY + (int)(6 * sa + 6 * ca), cs.speedText);
+  // North marker on the rim
+  float nr = -trackView.headingDeg() * (float)(M_PI / 180.0);
+  sprite.setTextColor(cs.text, cs.background);
+  sprite.drawString("N", cx + (int)(108 * sinf(nr)), cy - (int)(108 * cosf(nr)));
+
+  char line[32];
+  float mpp = trackView.metersPerPx();
+  const char* mode = trackView.autoZoom() ? "auto " : "";
+  if (mpp * 50 >= 1000.0f) snprintf(line, sizeof(line), "%s%.1f km", mode, mpp * 0.05f);
+  else snprintf(line, sizeof(line), "%s%.0f m", mode, mpp * 50);
+  sprite.drawFastHLine(cx - 25, H - 34, 50, cs.iconDim);
+  sprite.setTextColor(cs.iconDim, cs.background);
+  sprite.drawString(line, cx, H - 24);
+  sprite.pushSprite(0,0);
+}
+
+static void mapZoomStep() {
+  mapZoomMode = (mapZoomMode + 1) % MAP_ZOOM_MODES;
+  trackView.setZoom(MAP_ZOOMS[mapZoomMode]);
+}
+
+#if PERF_TIMER
+static void formatPerfTime(char* out, size_t n, uint32_t ms) { if (ms) snprintf(out, n, "%u.%02u s", (unsigned)(ms / 1000), (unsigned)(ms % 1000 / 10)); else snprintf(out, n, "--.-- s"); }
+
+// What the PERF screen shows, so it redraws only when that changes (every frame while running)
+static uint32_t perfSignature(const PerfTimerStatus &ps) {
+  return ps.state == perf::PERF_RUNNING ? ps.elapsedMs / 10 : (uint32_t)ps.state * 7919u + ps.runs * 31u + (uint32_t)roundf(ps.speedKmh) + (ps.haveBrake ? ps.brakeMs : 0);
+}
+
+// Own render path: the timer itself runs off the GPS speed queue, so a frame here never delays it
+static void renderPerf() {
+  const int W = display.width(); const int H = display.height(); const int cx = W/2; ColorScheme& cs = getColors(); if (!spriteInit){ sprite.createSprite(W,H); spriteInit = true; }
+  PerfTimerStatus ps; perf_timer_get_status(&ps, millis());
+  sprite.fillSprite(cs.background);
+  sprite.setTextDatum(MC_DATUM);
+  sprite.setFont(&fonts::FreeSansBold12pt7b);
+  sprite.setTextColor(cs.text, cs.background);
+  sprite.drawString("Performance", cx, 35);
+
+  // State and the big clock: the run in progress, or the last one
+  sprite.setFont(&fonts::FreeSans9pt7b);
+  const char* st = ps.state == perf::PERF_RUNNING ? "GO" : (ps.state == perf::PERF_ARMED ? "READY" : "Stop to arm");
+  sprite.setTextColor(ps.state == perf::PERF_ARMED ? cs.arcLow : (ps.state == perf::PERF_RUNNING ? cs.arcMid : cs.iconDim), cs.background);
+  sprite.drawString(st, cx, 58);
+  char line[40];
+  snprintf(line, sizeof(line), "%u.%02u", (unsigned)(ps.elapsedMs / 1000), (unsigned)(ps.elapsedMs % 1000 / 10));
+  sprite.setFont(&fonts::FreeSansBold24pt7b); sprite.setTextColor(cs.speedText, cs.background); sprite.drawString(line, cx, 92);
+  sprite.setFont(&fonts::FreeSans9pt7b); sprite.setTextColor(cs.text, cs.background);
+  snprintf(line, sizeof(line), "%.0f km/h", ps.speedKmh); sprite.drawString(line, cx, 124);
+
+  // Results of the latest run
+  char t[16];
+  sprite.setFont(nullptr); sprite.setTextSize(1); sprite.setTextColor(cs.text, cs.background);
+  formatPerfTime(t, sizeof(t), ps.mph60Ms); snprintf(line, sizeof(line), "0-60 mph   %s", t); sprite.drawString(line, cx, 146);
+  formatPerfTime(t, sizeof(t), ps.kmh100Ms); snprintf(line, sizeof(line), "0-100 km/h %s", t); sprite.drawString(line, cx, 160);
+  formatPerfTime(t, sizeof(t), ps.quarterMs);
+  if (ps.quarterMs) snprintf(line, sizeof(line), "1/4 mile %s @%.0f", t, ps.trapKmh); else snprintf(line, sizeof(line), "1/4 mile   %s", t);
+  sprite.drawString(line, cx, 174);
+  formatPerfTime(t, sizeof(t), ps.haveBrake ? ps.brakeMs : 0);
+  if (ps.haveBrake) snprintf(line, sizeof(line), "100-0 %s %.1f m", t, ps.brakeM); else snprintf(line, sizeof(line), "100-0 km/h %s", t);
+  sprite.drawString(line, cx, 188);
+  if (ps.gap) { sprite.setTextColor(cs.arcHigh, cs.background); sprite.drawString("run cut short (fix lost)", cx, 202); }
+
+  sprite.pushSprite(0,0);
+  ui.prev_perf = perfSignature(ps);
+}
+#endif
+
+static void renderActive() {
+  switch (currentScreen) {
+    case Screen::MAIN: renderMain(); break;
+    case Screen::SETTINGS: renderSettings(); break;
+    case Screen::METRICS: renderMetrics(); break;
+    case Screen::HISTORY: renderHistory(); break;
+    case Screen::MAP: renderMap(); break;
+    case Screen::PERF:
+      #if PERF_TIMER
+      renderPerf();
+      #endif
+      break;
+  }
+}
+
+// Swipe/key order: MAIN -> SETTINGS -> METRICS -> HISTORY -> MAP [-> PERF] -> MAIN
+static Screen nextScreen(Screen s, bool forward) {
+  #if PERF_TIMER
+  static const Screen order[] = { Screen::MAIN, Screen::SETTINGS, Screen::METRICS, Screen::HISTORY, Screen::MAP, Screen::PERF };
+  #else
+  static const Screen order[] = { Screen::MAIN, Screen::SETTINGS, Screen::METRICS, Screen::HISTORY, Screen::MAP };
+  #endif
+  const int n = sizeof(order) / sizeof(order[0]);
+  int i = 0; while (i < n && order[i] != s) ++i;
+  return order[(i + (forward ? 1 : n - 1)) % n];
+}
 
 // ---------- Splash Screen ----------
 static void renderSplash() {
@@ -277,8 +768,53 @@ void setup() {
   display.init(); display.setRotation(0); display.setBrightness(255); display.invertDisplay(true);
   renderSplash();
   battery.begin(); delay(1500); battery.update(); ui.battery_pc = battery.getPercentage(); delay(500);
-  // Initialize GPS (UART1 RX=16 TX=15)
+  // Initialize GPS (UART1 RX=16 TX=15): auto-baud, then switch to the target baud/rate
+  #if DEMO_MODE
+  // Synthetic drive instead of the receiver; no receiver setup, and no aiding so NVS and the
+  // system clock never see made-up fixes
   gps_init(16, 15, 9600);
+  demoSource.restart(); demoStartMs = millis();
+  gps_set_source(&demoSource);
+  Serial.printf("[DEMO] synthetic drive, %u phases, NMEA at %u Hz\n", (unsigned)demo::DEFAULT_DRIVE_LEN, 1000u / demoSource.periodMs());
+  #else
+  GPSConfigReport gcr; gps_init_auto(16, 15, GPS_PROTOCOL_NMEA, GPS_TARGET_BAUD, GPS_RATE_HZ, &gcr);
+  Serial.printf("[GPS-CFG] detected=%u final=%u rate=%uHz ack=%u nak=%u timeout=%u saved=%d ok=%d\n", gcr.detectedBaud, gcr.finalBaud, gcr.rateHz, gcr.acked, gcr.naked, gcr.timeouts, gcr.saved, gcr.ok);
+  gps_aiding_begin(nullptr); // hot-start: hand the last fix and time back to the receiver
+  #endif
+  powerGovernor.reset(millis());
+  #if !DEMO_MODE
+  nav::TripState saved;
+  if (trip_store_load(&saved) && tripComputer.restore(saved)) Serial.printf("[TRIP] odometer %.1f km, A %.1f km, B %.1f km, scale %.4f\n", saved.odometerM / 1000.0, saved.trip[nav::TRIP_A].distanceM / 1000.0, saved.trip[nav::TRIP_B].distanceM / 1000.0, saved.scale);
+  #endif
+  #if GPS_RX_TASK
+  if (!gps_start_task(0)) Serial.println("[GPS] RX task failed, polling from loop()");
+  #endif
+  #if GPS_NET_NMEA
+  if (wifi_link_begin(5000) != WIFI_LINK_OFF && netSource.begin()) {
+    gps_set_aux_source(&netSource);
+    Serial.printf("[NET] NMEA source on %s:%u (UDP and TCP)\n", wifi_link_ip().toString().c_str(), netSource.port());
+  } else {
+    Serial.println("[NET] NMEA source unavailable");
+  }
+  #endif
+  #if TRACK_LOG
+  track_log_begin(0);
+  #endif
+  #if TELEMETRY_UPLOAD && TRACK_LOG
+  telemetry_uploader_begin(0);
+  #endif
+  #if LAP_TIMER
+  lap_timer_begin();
+  #endif
+  #if POI_ALERTS
+  poi_alerts_begin();
+  #endif
+  #if MAP_BASEMAP
+  map_tiles_begin();
+  #endif
+  #if TRACK_HTTP_EXPORT
+  if (wifi_link_begin(5000) != WIFI_LINK_OFF && track_export_begin(0)) Serial.printf("[EXP] http://%s/tracks\n", wifi_link_ip().toString().c_str());
+  #endif
   Serial.println("[GPS] Init complete. Awaiting fix...");
   renderMain();
 }
@@ -289,26 +825,79 @@ void loop() {
   uint32_t now = millis();
 
   // Battery periodic update (~1Hz)
-  if (now - lastBatteryUpdate > 1000) { lastBatteryUpdate = now; battery.update(); ui.battery_pc = battery.getPercentage(); }
+  if (now - lastBatteryUpdate > 1000) { lastBatteryUpdate = now; battery.update(); ui.battery_pc = battery.getPercentage();
+    #if DEMO_MODE
+    ui.battery_pc = (int)demo::DriveGenerator::batteryPct(now - demoStartMs);
+    #endif
+  }
 
   // Low battery flash toggle (also triggers NO FIX warning flash)
   if (now - lastLowBatFlash > 1000) { lastLowBatFlash = now; ui.lowBatFlashState = !ui.lowBatFlashState; if ((battery.isLowBattery() && !battery.isUSBPowered()) || !ui.fixValid) { if (currentScreen == Screen::MAIN) renderMain(); } }
 
-  // GPS polling (fast) + data snapshot (every 250ms)
+  // GPS polling (no-op when the RX task is running) + data snapshot every frame
+  #if DEMO_MODE
+  if (demoSource.due()) gps_source_ready(); // the synthetic source raises no RX events
+  #endif
   gps_poll();
+  #if PERF_TIMER
+  perf_timer_update(currentScreen == Screen::PERF);
+  #endif
   static uint32_t lastGPSData = 0;
-  if (now - lastGPSData > 250) {
+  if (now - lastGPSData >= UI_FRAME_MS) {
     lastGPSData = now; GPSData gd; gps_get_data(&gd);
-    ui.speed_kmh = gd.speedKmh; ui.satellites = gd.satsUsed; ui.satsInView = gd.satsInView; ui.lat = gd.lat; ui.lon = gd.lon; ui.altitude_m = gd.altitude; ui.fixValid = gd.validFix; 
-    if (now - lastGPSUpdatePrint > 2000) { lastGPSUpdatePrint = now; Serial.printf("[GPS] fix=%d satsUsed=%d inView=%d speed=%.1fkm/h alt=%.1fm lat=%.5f lon=%.5f\n", gd.validFix, gd.satsUsed, gd.satsInView, gd.speedKmh, gd.altitude, gd.lat, gd.lon); }
+    if (!gd.validFix) { speedFilter.reset(); lastSpeedMs = 0; }
+    else if (gd.speedMs != lastSpeedMs) { lastSpeedMs = gd.speedMs; speedFilter.update(gd.speedMs, gd.speedRawKmh, gd.courseDeg, gd.sAccKmh, gd.sAccMeasured, gd.epochUs); tripOnFix(gd, now); mapOnFix(gd, speedFilter.speedKmhAt(gd.speedMs)); speedHistory.add(gd.speedMs / 1000, speedFilter.speedKmhAt(gd.speedMs), gd.altitude, true); latencyOnSnapshot(gd, micros()); }
+    #if !DEMO_MODE
+    gps_aiding_update(&gd, now);
+    #endif
+    powerOnSnapshot(gd, now);
+    #if TRACK_LOG && !DEMO_MODE
+    track_log_add(&gd);             // a synthetic drive is never recorded (or uploaded)
+    #endif
+    #if LAP_TIMER
+    lap_timer_update(&gd);
+    #endif
+    #if POI_ALERTS
+    poi_alerts_update(&gd, speedFilter.valid() ? speedFilter.speedKmhAt(gd.speedMs) : gd.speedKmh);
+    #endif
+    ui.speed_kmh = speedFilter.valid() ? speedFilter.speedKmhAt(now) : gd.speedKmh; ui.satellites = gd.satsUsed; ui.satsInView = gd.satsInView; ui.cn0Avg = gd.cn0Avg; ui.cn0Top4 = gd.cn0Top4; ui.hdop = gd.hdop; ui.lat = gd.latE7 * 1e-7; ui.lon = gd.lonE7 * 1e-7; ui.altitude_m = gd.altitude; ui.fixValid = gd.validFix; 
+    if (now - lastGPSUpdatePrint > 2000) { lastGPSUpdatePrint = now; GPSParserStats ps; gps_get_stats(&ps); Serial.printf("[GPS] fix=%d satsUsed=%d inView=%d cn0=%d/%d hdop=%.1f hAcc=%.1fm speed=%.1f(raw %.1f +-%.1f kf %.1f)km/h alt=%.1fm lat=%.7f lon=%.7f nmea=%u csErr=%u ovf=%u unk=%u\n", gd.validFix, gd.satsUsed, gd.satsInView, gd.cn0Avg, gd.cn0Top4, gd.hdop, gd.hAccM, gd.speedKmh, gd.speedRawKmh, gd.sAccKmh, speedFilter.speedKmh(), gd.altitude, ui.lat, ui.lon, ps.sentences, ps.checksumErrors, ps.overflows, ps.unknownSentences);
+      GPSIngestStats is; gps_get_ingest_stats(&is); Serial.printf("[GPS-RX] bytes=%u events=%u ovf=%u lineErr=%u maxChunk=%u lat(us) last=%u avg=%u max=%u\n", is.rxBytes, is.rxEvents, is.overflows, is.lineErrors, is.maxChunk, is.latencyLastUs, is.latencyAvgUs, is.latencyMaxUs);
+      #if GPS_NET_NMEA
+      GPSSourceStats su, sn; gps_get_source_stats(GPS_SOURCE_PRIMARY, &su); gps_get_source_stats(GPS_SOURCE_AUX, &sn); const io::NetSource::Stats &ns = netSource.stats();
+      uint32_t t = millis(), ageU = su.lastDataMs ? t - su.lastDataMs : 0, ageN = sn.lastDataMs ? t - sn.lastDataMs : 0;
+      Serial.printf("[GPS-SRC] active=%s switches=%u | uart q=%u age=%ums sent=%u drop=%u lat avg=%u max=%uus | net q=%u age=%ums sent=%u drop=%u lat avg=%u max=%uus udp=%u trunc=%u ign=%u tcp=%u/%u\n",
+                    sn.active ? "net" : "uart", su.switches, su.fixQuality, ageU, su.sentences, su.drops, su.latencyAvgUs, su.latencyMaxUs,
+                    sn.fixQuality, ageN, sn.sentences, sn.drops, sn.latencyAvgUs, sn.latencyMaxUs, ns.datagrams, ns.truncated, ns.ignored, ns.connections, ns.disconnects);
+      #endif
+    }
   }
 
-  // Redraw metrics/settings every second
-  if (now - lastMetricsRefresh > 1000) { lastMetricsRefresh = now; if (currentScreen == Screen::METRICS || currentScreen == Screen::SETTINGS) renderActive(); }
+  // Redraw metrics/settings/history every second
+  if (now - lastMetricsRefresh > 1000) { lastMetricsRefresh = now; if (currentScreen == Screen::METRICS || currentScreen == Screen::SETTINGS || currentScreen == Screen::HISTORY) renderActive(); }
 
   // Redraw main screen when speed or satellite count changes notably
-  if (currentScreen == Screen::MAIN && (now - lastMainCheck > 200)) {
-    lastMainCheck = now; if (fabs(ui.speed_kmh - ui.prev_speed) > 0.2f || ui.satellites != ui.prev_satellites || ui.needsFullRedraw) renderMain(); }
+  if (currentScreen == Screen::MAIN && (now - lastMainCheck >= UI_FRAME_MS)) {
+    bool overlayChanged = false;
+    #if LAP_TIMER
+    LapTimerStatus ls; lap_timer_get_status(&ls, now); overlayChanged = (ls.lapRunning && ls.lapElapsedMs / 100 != ui.prev_lap_ds) || ls.showDelta != ui.prev_lap_delta;
+    #endif
+    #if POI_ALERTS
+    PoiAlertStatus pa; poi_alerts_get_status(&pa); overlayChanged = overlayChanged || poiSignature(pa) != ui.prev_poi;
+    #endif
+    lastMainCheck = now; if (fabs(ui.speed_kmh - ui.prev_speed) > 0.2f || ui.satellites != ui.prev_satellites || ui.needsFullRedraw || overlayChanged) renderMain(); }
+
+  // Map screen: redraw for each new fix (the car moves even when no vertex is kept)
+  if (currentScreen == Screen::MAP && (now - lastMainCheck >= UI_FRAME_MS)) {
+    lastMainCheck = now; if (mapCar.lastMs != mapDrawnFixMs || ui.needsFullRedraw) { renderMap(); ui.needsFullRedraw = false; }
+  }
+
+  #if PERF_TIMER
+  // Perf screen: live clock every frame while a run is on, otherwise on change
+  if (currentScreen == Screen::PERF && (now - lastMainCheck >= UI_FRAME_MS)) {
+    lastMainCheck = now; PerfTimerStatus ps; perf_timer_get_status(&ps, now); if (perfSignature(ps) != ui.prev_perf || ui.needsFullRedraw) { renderPerf(); ui.needsFullRedraw = false; }
+  }
+  #endif
 
   // Battery state change triggers redraw
   BatteryState st = battery.getState(); if (st != ui.prev_battery_state) { ui.prev_battery_state = st; renderActive(); }
@@ -320,20 +909,47 @@ void loop() {
   else if (!pressed && swipe.touching) {
     int dx = swipe.lastX - swipe.startX; int dy = swipe.lastY - swipe.startY; uint32_t dt = now - swipe.startMs;
     if (abs(dx) >= SWIPE_THRESHOLD_PX && abs(dy) < SWIPE_THRESHOLD_PX) {
-      if (dx < 0) currentScreen = (currentScreen == Screen::MAIN) ? Screen::SETTINGS : (currentScreen == Screen::SETTINGS ? Screen::METRICS : Screen::MAIN);
-      else currentScreen = (currentScreen == Screen::MAIN) ? Screen::METRICS : (currentScreen == Screen::SETTINGS ? Screen::MAIN : Screen::SETTINGS);
+      currentScreen = nextScreen(currentScreen, dx < 0);
       ui.needsFullRedraw = true; renderActive();
+    } else if (abs(dx) < TAP_THRESHOLD_PX && abs(dy) < TAP_THRESHOLD_PX && dt <= TAP_TIME_MS && currentScreen == Screen::HISTORY) {
+      historySpan = (historySpan + 1) % HISTORY_SPAN_COUNT; renderHistory();
+    } else if (abs(dx) < TAP_THRESHOLD_PX && abs(dy) < TAP_THRESHOLD_PX && dt <= TAP_TIME_MS && currentScreen == Screen::MAP) {
+      mapZoomStep(); renderMap();
     } else if (abs(dx) < TAP_THRESHOLD_PX && abs(dy) < TAP_THRESHOLD_PX && dt <= TAP_TIME_MS) {
       int cx = display.width()/2; int cy = display.height()/2; if (abs(swipe.startX - cx) < 80 && abs(swipe.startY - cy) < 80) { ui.isDarkMode = !ui.isDarkMode; ui.needsFullRedraw = true; renderActive(); }
     }
     swipe.touching = false;
   }
 
-  // Serial key input (a/d/m)
+  // Serial key input (a/d/m, h = history span, z = map zoom, b = map/tile counters, r = perf log)
   if (Serial.available()) {
     char c = (char)Serial.read();
-    if (c == 'a' || c == 'A') { currentScreen = (currentScreen == Screen::MAIN) ? Screen::METRICS : (currentScreen == Screen::SETTINGS ? Screen::MAIN : Screen::SETTINGS); ui.needsFullRedraw = true; renderActive(); }
-    else if (c == 'd' || c == 'D') { currentScreen = (currentScreen == Screen::MAIN) ? Screen::SETTINGS : (currentScreen == Screen::SETTINGS ? Screen::METRICS : Screen::MAIN); ui.needsFullRedraw = true; renderActive(); }
+    if (c == 'a' || c == 'A') { currentScreen = nextScreen(currentScreen, false); ui.needsFullRedraw = true; renderActive(); }
+    else if (c == 'd' || c == 'D') { currentScreen = nextScreen(currentScreen, true); ui.needsFullRedraw = true; renderActive(); }
+    else if (c == 'l' || c == 'L') { latencyReport(); }
+    else if (c == 'z' || c == 'Z') { mapZoomStep(); Serial.printf("[MAP] zoom %s\n", MAP_ZOOMS[mapZoomMode] < 0 ? "auto" : "fixed"); if (currentScreen == Screen::MAP) renderMap(); }
+    else if (c == 'b' || c == 'B') { Serial.printf("[MAP] %d vertices (%u fixes, %u dropped, area %.0f m2), %u reprojections\n", trackMap.count(), trackMap.added(), trackMap.removed(), trackMap.threshold(), trackView.reprojections());
+      #if MAP_BASEMAP
+      MapTilesStats mt; map_tiles_get_stats(&mt); Serial.printf("[TILES] tiles=%u frames=%u hits=%u misses=%u prefetched=%u/%u deferred=%u overflow=%u errors=%u pool=%u/%u decode(us) avg=%u max=%u draw(us) last=%u max=%u\n", mt.tiles, mt.frames, mt.hits, mt.misses, mt.prefetchHits, mt.prefetched, mt.deferred, mt.overflow, mt.errors, mt.poolPeakPoints, (unsigned)MAP_TILE_POOL_POINTS, mt.decodeAvgUs, mt.decodeMaxUs, mt.drawLastUs, mt.drawMaxUs);
+      #endif
+    }
+    else if (c == 'h' || c == 'H') { historySpan = (historySpan + 1) % HISTORY_SPAN_COUNT; Serial.printf("[HIST] span %s, %u samples\n", HISTORY_SPAN_NAMES[historySpan], speedHistory.samples()); if (currentScreen == Screen::HISTORY) renderHistory(); }
+    #if PERF_TIMER
+    else if (c == 'r' || c == 'R') { PerfTimerStats pt; perf_timer_get_stats(&pt); Serial.printf("[PERF] samples=%u queueDropped=%u logged=%u logDropped=%u\n", pt.samples, pt.queueDropped, pt.logged, pt.logDropped); perf_timer_print_log(); }
+    #endif
+    #if POI_ALERTS
+    else if (c == 'p' || c == 'P') { PoiAlertStats ps; poi_alerts_get_stats(&ps); Serial.printf("[POI] records=%u queries=%u hits=%u truncated=%u alerts=%u query(us) last=%u max=%u\n", ps.records, ps.queries, ps.hits, ps.truncated, ps.alerts, ps.queryLastUs, ps.queryMaxUs); }
+    #endif
+    else if (c == 't' || c == 'T') { TrackLogStats ts; track_log_get_stats(&ts); Serial.printf("[TRK] ok=%d file=%06u fixes=%u dropped=%u batches=%u bytes=%u (%.1f B/fix) writeErr=%u write(us) last=%u max=%u deleted=%u\n", ts.ok, ts.fileIndex, ts.fixes, ts.dropped, ts.batches, ts.bytes, ts.fixes ? (float)ts.bytes / ts.fixes : 0.0f, ts.writeErrors, ts.writeLastUs, ts.writeMaxUs, ts.filesDeleted);
+      #if TRACK_HTTP_EXPORT
+      TrackExportStats es; track_export_get_stats(&es); Serial.printf("[EXP] requests=%u ranged=%u aborted=%u bytes=%u last=%uB/%u fixes/%ums heapDipMax=%u\n", es.requests, es.ranged, es.aborted, es.bytes, es.lastBytes, es.lastFixes, es.lastMs, es.heapDipMax);
+      #endif
+      #if TELEMETRY_UPLOAD && TRACK_LOG
+      TelemetryStats tl; telemetry_uploader_get_stats(&tl); Serial.printf("[TEL] sessions=%u connectFail=%u requests=%u failures=%u body=%u out=%u in=%u skipped=%u lostFiles=%u resets=%u radio=%ums latency(ms) avg=%u max=%u pending=%u cursor=%06u+%u backoff=%u\n", tl.sessions, tl.connectFailures, tl.requests, tl.failures, tl.bodyBytes, tl.bytesOut, tl.bytesIn, tl.skippedBytes, tl.lostFiles, tl.cursorResets, tl.radioOnMs, tl.latencyAvgMs, tl.latencyMaxMs, tl.pendingBytes, tl.cursorFile, tl.cursorOffset, tl.backoffFailures);
+      #endif
+    }
+    else if (c == '1' || c == '2') { tripReset(c == '1' ? nav::TRIP_A : nav::TRIP_B); if (currentScreen == Screen::METRICS) renderActive(); }
+    else if (c == 'o' || c == 'O') { const nav::TripTotals &a = tripComputer.trip(nav::TRIP_A), &b = tripComputer.trip(nav::TRIP_B); Serial.printf("[TRIP] odo=%.3fkm A=%.3fkm moving=%us stopped=%us avg=%.1f max=%.1f | B=%.3fkm moving=%us avg=%.1f max=%.1f | scale=%.4f cal=%u saves=%u\n", tripComputer.odometerM() / 1000.0, a.distanceM / 1000.0, (unsigned)(a.movingMs / 1000), (unsigned)(a.stoppedMs / 1000), a.avgKmh(), a.maxKmh, b.distanceM / 1000.0, (unsigned)(b.movingMs / 1000), b.avgKmh(), b.maxKmh, tripComputer.scale(), tripComputer.state().calibrations, trip_store_saves()); }
     else if (c == 'm' || c == 'M') { ui.isDarkMode = !ui.isDarkMode; ui.needsFullRedraw = true; Serial.printf("[MODE] %s\n", ui.isDarkMode ? "dark" : "light"); renderActive(); }
   }
 }
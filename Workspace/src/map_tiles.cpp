@@ -0,0 +1,87 @@
+#include "map_tiles.h"
+#include <esp_partition.h>
+
+#ifndef MAP_TILES_PARTITION_LABEL
+#define MAP_TILES_PARTITION_LABEL "tiles"
+#endif
+#ifndef MAP_TILES_PARTITION_SUBTYPE
+#define MAP_TILES_PARTITION_SUBTYPE 0x41
+#endif
+#ifndef MAP_TILE_DECODES_PER_FRAME
+#define MAP_TILE_DECODES_PER_FRAME 2
+#endif
+// Prefetch the tile this many seconds of travel beyond the edge of the view
+#ifndef MAP_TILE_PREFETCH_S
+#define MAP_TILE_PREFETCH_S 10
+#endif
+
+static uint32_t clockUs() { return micros(); }
+
+// loop() only
+static MapTilesBasemap g_map(clockUs, MAP_TILE_DECODES_PER_FRAME, MAP_TILE_PREFETCH_S);
+static spi_flash_mmap_handle_t g_handle;
+static bool g_active = false;
+static uint32_t g_drawLastUs = 0, g_drawMaxUs = 0;
+
+bool map_tiles_begin(void) {
+  g_active = false;
+  const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)MAP_TILES_PARTITION_SUBTYPE, MAP_TILES_PARTITION_LABEL);
+  if (!part) { Serial.println("[TILES] no '" MAP_TILES_PARTITION_LABEL "' partition, basemap off"); return false; }
+  const void* base = nullptr;
+  esp_err_t err = esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &base, &g_handle);
+  if (err != ESP_OK) { Serial.printf("[TILES] mmap of %u bytes failed (%d), basemap off\n", part->size, (int)err); return false; }
+  uint32_t t0 = micros();
+  if (!tiles::checkImage((const uint8_t*)base, part->size, true)) {
+    Serial.println("[TILES] no valid tile image (flash one with tools/build_tile_image.py), basemap off");
+    spi_flash_munmap(g_handle);
+    return false;
+  }
+  g_map.attach((const uint8_t*)base);
+  g_active = g_map.set().count() > 0;
+  Serial.printf("[TILES] %u tiles at zoom %d mapped at 0x%x, CRC checked in %u us\n", g_map.set().count(), g_map.set().zoom(), part->address, micros() - t0);
+  return g_active;
+}
+
+bool map_tiles_active(void) { return g_active; }
+
+int map_tiles_frame(int32_t latE7, int32_t lonE7, float courseDeg, float speedKmh, float radiusM, const tiles::DecodedTile** out, int max) {
+  if (!g_active || !out) return 0;
+  return g_map.frame(latE7 * 1e-7, lonE7 * 1e-7, courseDeg, speedKmh, radiusM, out, max);
+}
+
+void map_tiles_tile_origin(uint32_t key, int32_t* latE7, int32_t* lonE7, float* metersPerUnit) {
+  int z = g_map.set().zoom();
+  double lat = tiles::tileYToLat(key & 0xFFFF, z), lon = tiles::tileXToLon(key >> 16, z);
+  if (latE7) *latE7 = (int32_t)lround(lat * 1e7);
+  if (lonE7) *lonE7 = (int32_t)lround(lon * 1e7);
+  // Scale at the middle of the tile: it varies by well under 0.1% across one
+  if (metersPerUnit) *metersPerUnit = (float)tiles::metersPerUnit(tiles::tileYToLat((key & 0xFFFF) + 0.5, z), z);
+}
+
+void map_tiles_note_draw(uint32_t us) {
+  g_drawLastUs = us;
+  if (us > g_drawMaxUs) g_drawMaxUs = us;
+}
+
+void map_tiles_get_stats(MapTilesStats* out) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  const MapTilesBasemap::Cache::Stats &cs = g_map.cacheStats();
+  const MapTilesBasemap::FrameStats &fs = g_map.frameStats();
+  out->tiles = g_map.set().count();
+  out->frames = fs.frames;
+  out->hits = cs.hits;
+  out->misses = cs.misses;
+  out->prefetched = cs.prefetched;
+  out->prefetchHits = cs.prefetchHits;
+  out->deferred = fs.deferred;
+  out->overflow = fs.overflow;
+  out->errors = cs.errors;
+  out->poolPeakPoints = cs.peakPoints;
+  out->decodeLastUs = cs.decodeLastUs;
+  out->decodeMaxUs = cs.decodeMaxUs;
+  uint32_t n = cs.misses + cs.prefetched;
+  out->decodeAvgUs = n ? (uint32_t)(cs.decodeTotalUs / n) : 0;
+  out->drawLastUs = g_drawLastUs;
+  out->drawMaxUs = g_drawMaxUs;
+}
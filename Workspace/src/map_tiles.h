@@ -0,0 +1,57 @@
+// Offline basemap for the MAP screen: vector tiles (include/vector_tiles.hpp) read in place from
+// the memory-mapped "tiles" flash partition and decoded into a fixed LRU cache, with the tile
+// ahead along the course prefetched. Drawing stays in main.cpp; this module only hands out the
+// decoded tiles for a frame and keeps the counters.
+#pragma once
+#include <Arduino.h>
+#include "vector_tiles.hpp"
+
+// Decoded tiles kept; one is held back for the prefetch
+#ifndef MAP_TILE_CACHE_SLOTS
+#define MAP_TILE_CACHE_SLOTS 10
+#endif
+// Points (4 bytes each) and features (3 bytes) shared by the cached tiles. test_basemap peaks at
+// about 6100 points and 300 features driving the widest view (MAP_BASEMAP_MAX_MPP) over tiles
+// of up to 1000 points; fewer drop the outer tiles of that view. About 25 KB in all.
+#ifndef MAP_TILE_POOL_POINTS
+#define MAP_TILE_POOL_POINTS 6144
+#endif
+#ifndef MAP_TILE_POOL_FEATURES
+#define MAP_TILE_POOL_FEATURES 384
+#endif
+
+typedef tiles::Basemap<MAP_TILE_CACHE_SLOTS, MAP_TILE_POOL_POINTS, MAP_TILE_POOL_FEATURES> MapTilesBasemap;
+
+typedef struct MapTilesStats {
+  uint32_t tiles;           // in the mapped set
+  uint32_t frames;
+  uint32_t hits;            // cache lookups served from a decoded tile
+  uint32_t misses;          // decoded on demand
+  uint32_t prefetched;      // decoded ahead of need
+  uint32_t prefetchHits;    // of those, later drawn
+  uint32_t deferred;        // visible tiles pushed to a later frame by the decode budget
+  uint32_t overflow;        // visible tiles beyond the cache, not drawn
+  uint32_t errors;          // malformed payloads
+  uint32_t poolPeakPoints;  // most pool points in use at once (of MAP_TILE_POOL_POINTS)
+  uint32_t decodeLastUs;
+  uint32_t decodeMaxUs;
+  uint32_t decodeAvgUs;
+  uint32_t drawLastUs;      // as reported by map_tiles_note_draw
+  uint32_t drawMaxUs;
+} MapTilesStats;
+
+// Map the partition and validate the image (CRC over the whole set, once). False = no basemap.
+bool map_tiles_begin(void);
+bool map_tiles_active(void);
+
+// Decoded tiles within radiusM of the position, nearest first (at most 'max'). Decodes at most
+// MAP_TILE_DECODES_PER_FRAME tiles per call, so a missing tile may take a frame or two to appear.
+int map_tiles_frame(int32_t latE7, int32_t lonE7, float courseDeg, float speedKmh, float radiusM, const tiles::DecodedTile** out, int max);
+
+// North-west corner of a tile and the ground size of one tile unit there
+void map_tiles_tile_origin(uint32_t key, int32_t* latE7, int32_t* lonE7, float* metersPerUnit);
+
+// Time spent drawing the basemap this frame, for the stats
+void map_tiles_note_draw(uint32_t us);
+
+void map_tiles_get_stats(MapTilesStats* out);
@@ -0,0 +1,83 @@
+#include "perf_timer.h"
+#include "gps_module.h"
+#include "perf_timer.hpp"
+
+// Samples kept for the last run, 4 bytes each (60 s at 20 Hz)
+#ifndef PERF_LOG_SAMPLES
+#define PERF_LOG_SAMPLES 1200
+#endif
+
+// loop() only
+static perf::PerfTimer<PERF_LOG_SAMPLES> g_timer;
+static bool g_active = false;
+static uint32_t g_lastSampleMs = 0;   // millis() clock of the last sample fed, for the live clock
+static PerfTimerStats g_stats;
+
+static void logEvents(uint32_t ev) {
+  const perf::RunResult &r = g_timer.run();
+  if (ev & perf::PERF_EV_ARMED) Serial.println("[PERF] armed");
+  if (ev & perf::PERF_EV_LAUNCH) Serial.println("[PERF] launch");
+  if (ev & perf::PERF_EV_60MPH) Serial.printf("[PERF] 0-60 mph %u.%03u s\n", r.mph60Ms / 1000, r.mph60Ms % 1000);
+  if (ev & perf::PERF_EV_100KMH) Serial.printf("[PERF] 0-100 km/h %u.%03u s\n", r.kmh100Ms / 1000, r.kmh100Ms % 1000);
+  if (ev & perf::PERF_EV_QUARTER) Serial.printf("[PERF] 1/4 mile %u.%03u s @ %.1f km/h\n", r.quarterMs / 1000, r.quarterMs % 1000, r.quarterTrapKmh);
+  if (ev & perf::PERF_EV_END) Serial.printf("[PERF] run %u over%s: %.1f s, %.0f m, max %.1f km/h, %d samples\n", g_timer.runs(), r.gap ? " (cut short)" : "", r.durationMs / 1000.0f, r.distanceM, r.maxKmh, g_timer.logCount());
+  if (ev & perf::PERF_EV_BRAKE) Serial.printf("[PERF] 100-0 km/h %u.%03u s, %.1f m\n", g_timer.brake().timeMs / 1000, g_timer.brake().timeMs % 1000, g_timer.brake().distanceM);
+}
+
+void perf_timer_update(bool active) {
+  if (active != g_active) {
+    g_timer.reset();
+    g_active = active;
+    Serial.printf("[PERF] mode %s\n", active ? "on" : "off");
+  }
+  GPSSpeedSample q[8];
+  size_t n;
+  while ((n = gps_read_speed_samples(q, 8, &g_stats.queueDropped)) > 0) {
+    if (!active) continue;
+    for (size_t i = 0; i < n; ++i) {
+      if (!q[i].validFix) continue;   // the hole shows up as a gap to the timer
+      logEvents(g_timer.update(q[i].tMs, q[i].speedRawKmh));
+      g_stats.samples++;
+      g_lastSampleMs = q[i].tMs;
+    }
+  }
+}
+
+void perf_timer_get_status(PerfTimerStatus* out, uint32_t nowMs) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  out->active = g_active;
+  out->state = g_timer.state();
+  out->elapsedMs = g_timer.elapsedMs();
+  if (g_timer.state() == perf::PERF_RUNNING) out->elapsedMs += nowMs - g_lastSampleMs;
+  out->speedKmh = g_timer.speedKmh();
+  const perf::RunResult &r = g_timer.run();
+  out->mph60Ms = r.mph60Ms;
+  out->kmh100Ms = r.kmh100Ms;
+  out->quarterMs = r.quarterMs;
+  out->trapKmh = r.quarterTrapKmh;
+  out->maxKmh = r.maxKmh;
+  out->gap = r.gap;
+  out->haveBrake = g_timer.haveBrake();
+  out->brakeMs = g_timer.brake().timeMs;
+  out->brakeM = g_timer.brake().distanceM;
+  out->runs = g_timer.runs();
+}
+
+void perf_timer_get_stats(PerfTimerStats* out) {
+  if (!out) return;
+  *out = g_stats;
+  out->logged = g_timer.logCount();
+  out->logDropped = g_timer.logDropped();
+}
+
+void perf_timer_print_log(void) {
+  if (g_timer.state() == perf::PERF_RUNNING) { Serial.println("[PERF] run in progress"); return; }
+  int n = g_timer.logCount();
+  Serial.printf("[PERF] run %u: %d samples, launch %.1f ms after the first\n", g_timer.runs(), n, g_timer.launchOffsetMs());
+  Serial.println("t_s,speed_kmh");
+  for (int i = 0; i < n; ++i) {
+    const perf::Sample &s = g_timer.logSample(i);
+    Serial.printf("%.3f,%.2f\n", (s.tMs - g_timer.launchOffsetMs()) / 1000.0f, s.speedCkmh / 100.0f);
+  }
+}
@@ -0,0 +1,39 @@
+// Performance timing mode (include/perf_timer.hpp): 0-60 mph, 0-100 km/h, quarter mile and 100-0
+// km/h from every speed epoch, drained from the GPS parse task's queue so a slow frame never
+// costs a sample. Results are logged as [PERF] lines and shown on the PERF screen.
+#pragma once
+#include <Arduino.h>
+
+typedef struct PerfTimerStatus {
+  bool     active;         // perf mode on
+  uint8_t  state;          // perf::PerfState
+  uint32_t elapsedMs;      // the run in progress (live), or the last run's length
+  float    speedKmh;       // latest sample
+  uint32_t mph60Ms;        // latest run, 0 = not reached
+  uint32_t kmh100Ms;
+  uint32_t quarterMs;
+  float    trapKmh;
+  float    maxKmh;
+  bool     gap;            // the latest run was cut short by missing samples
+  bool     haveBrake;
+  uint32_t brakeMs;        // latest 100-0
+  float    brakeM;
+  uint32_t runs;
+} PerfTimerStatus;
+
+typedef struct PerfTimerStats {
+  uint32_t samples;        // speed epochs fed to the timer
+  uint32_t queueDropped;   // epochs the GPS queue overwrote before they were read
+  uint32_t logged;         // samples in the last run's log
+  uint32_t logDropped;     // samples that did not fit it (PERF_LOG_SAMPLES)
+} PerfTimerStats;
+
+// Call every loop() pass. While 'active' (the PERF screen is up) queued epochs feed the timer;
+// otherwise they are discarded and the timer waits to be armed afresh.
+void perf_timer_update(bool active);
+
+void perf_timer_get_status(PerfTimerStatus* out, uint32_t nowMs);
+void perf_timer_get_stats(PerfTimerStats* out);
+
+// Print the last run's samples to Serial as CSV (time from launch, km/h)
+void perf_timer_print_log(void);
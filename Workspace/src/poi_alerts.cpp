@@ -0,0 +1,90 @@
+#include "poi_alerts.h"
+#include <esp_partition.h>
+#include "poi_db.hpp"
+
+#ifndef POI_PARTITION_LABEL
+#define POI_PARTITION_LABEL "poi"
+#endif
+#ifndef POI_PARTITION_SUBTYPE
+#define POI_PARTITION_SUBTYPE 0x40
+#endif
+// Speed over the limit before the overspeed alert (km/h)
+#ifndef POI_TOLERANCE_KMH
+#define POI_TOLERANCE_KMH 3
+#endif
+// Below this the course is noise and cameras are taken in any direction
+#ifndef POI_COURSE_MIN_KMH
+#define POI_COURSE_MIN_KMH 5
+#endif
+#ifndef POI_MAX_HITS
+#define POI_MAX_HITS 8
+#endif
+
+// loop() only
+static poi::PoiDb g_db;
+static spi_flash_mmap_handle_t g_map;
+static bool g_active = false;
+static uint32_t g_lastFixMs = 0;
+static poi::Alert g_alert;
+static PoiAlertStats g_stats;
+
+bool poi_alerts_begin(void) {
+  g_active = false;
+  memset(&g_alert, 0, sizeof(g_alert));
+  memset(&g_stats, 0, sizeof(g_stats));
+  const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)POI_PARTITION_SUBTYPE, POI_PARTITION_LABEL);
+  if (!part) { Serial.println("[POI] no '" POI_PARTITION_LABEL "' partition, alerts off"); return false; }
+  const void* base = nullptr;
+  esp_err_t err = esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &base, &g_map);
+  if (err != ESP_OK) { Serial.printf("[POI] mmap of %u bytes failed (%d), alerts off\n", part->size, (int)err); return false; }
+  uint32_t t0 = micros();
+  if (!poi::checkImage((const uint8_t*)base, part->size, true)) {
+    Serial.println("[POI] no valid POI image (flash one with tools/build_poi_image.py), alerts off");
+    spi_flash_munmap(g_map);
+    return false;
+  }
+  g_db.attach((const uint8_t*)base);
+  g_stats.records = g_db.count();
+  g_active = g_db.count() > 0;
+  Serial.printf("[POI] %u records mapped at 0x%x, CRC checked in %u us\n", g_db.count(), part->address, micros() - t0);
+  return g_active;
+}
+
+void poi_alerts_update(const GPSData* gd, float speedKmh) {
+  if (!g_active || !gd) return;
+  if (!gd->validFix) { memset(&g_alert, 0, sizeof(g_alert)); return; }
+  if (gd->speedMs == g_lastFixMs) return;
+  g_lastFixMs = gd->speedMs;
+  poi::Hit hits[POI_MAX_HITS];
+  uint32_t t0 = micros();
+  bool truncated;
+  int n = g_db.query(gd->latE7, gd->lonE7, poi::POI_QUERY_RADIUS_M, hits, POI_MAX_HITS, &truncated);
+  uint32_t us = micros() - t0;
+  g_stats.queries++;
+  g_stats.hits += n;
+  if (truncated) g_stats.truncated++;
+  g_stats.queryLastUs = us;
+  if (us > g_stats.queryMaxUs) g_stats.queryMaxUs = us;
+  poi::Alert a = poi::evaluate(g_db, hits, n, speedKmh, gd->courseDeg, speedKmh >= POI_COURSE_MIN_KMH, POI_TOLERANCE_KMH);
+  if ((a.camera && !g_alert.camera) || (a.overspeed && !g_alert.overspeed)) {
+    g_stats.alerts++;
+    if (a.camera) Serial.printf("[POI] camera in %.0f m, limit %u km/h%s\n", a.cameraDistM, a.cameraLimitKmh, a.overspeed ? ", OVERSPEED" : "");
+    else Serial.printf("[POI] overspeed: %.0f km/h in a %u zone\n", speedKmh, a.limitKmh);
+  }
+  g_alert = a;
+}
+
+void poi_alerts_get_status(PoiAlertStatus* out) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  out->active = g_active;
+  if (!g_active) return;
+  out->camera = g_alert.camera;
+  out->cameraDistM = (uint16_t)(g_alert.cameraDistM + 0.5f);
+  out->limitKmh = g_alert.limitKmh;
+  out->overspeed = g_alert.overspeed;
+}
+
+void poi_alerts_get_stats(PoiAlertStats* out) {
+  if (out) *out = g_stats;
+}
@@ -0,0 +1,33 @@
+// Speed-camera and speed-limit alerts from the read-only POI table (include/poi_db.hpp) in the
+// "poi" flash partition. The partition is memory-mapped and queried in place, so the table costs
+// no heap whatever its size. Alerts are logged as [POI] lines and drawn on the main gauge.
+#pragma once
+#include <Arduino.h>
+#include "gps_module.h"
+
+typedef struct PoiAlertStatus {
+  bool     active;          // a valid table is mapped
+  bool     camera;          // a camera ahead within its alert distance
+  uint16_t cameraDistM;
+  uint8_t  limitKmh;        // the limit that applies now (zone or imminent camera), 0 = none
+  bool     overspeed;       // above limitKmh + POI_TOLERANCE_KMH
+} PoiAlertStatus;
+
+typedef struct PoiAlertStats {
+  uint32_t records;
+  uint32_t queries;
+  uint32_t hits;            // records found within the query radius, summed
+  uint32_t truncated;       // queries that could not examine every record near the fix (POI_MAX_SCAN)
+  uint32_t alerts;          // transitions into a camera or overspeed alert
+  uint32_t queryLastUs;
+  uint32_t queryMaxUs;
+} PoiAlertStats;
+
+// Map the partition and validate the image (CRC over the whole table, once). False = alerts off.
+bool poi_alerts_begin(void);
+
+// Feed every GPS snapshot with the fused speed; new fixes run one proximity query
+void poi_alerts_update(const GPSData* gd, float speedKmh);
+
+void poi_alerts_get_status(PoiAlertStatus* out);
+void poi_alerts_get_stats(PoiAlertStats* out);
@@ -0,0 +1,253 @@
+#include "telemetry_uploader.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <stdio.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "wifi_link.h"
+#include "track_log.h"
+#include "telemetry_upload.hpp"
+
+// Endpoint; the body is raw track batches, see include/telemetry_upload.hpp for the headers
+#ifndef TELEMETRY_URL
+#define TELEMETRY_URL "http://192.168.1.10:8080/upload"
+#endif
+#ifndef TELEMETRY_DEVICE_ID
+#define TELEMETRY_DEVICE_ID "speedo-1"
+#endif
+// Start a session once this much is pending (~10 min of driving at 10 Hz, ~180 KB/h)...
+#ifndef TELEMETRY_MIN_BYTES
+#define TELEMETRY_MIN_BYTES (32UL * 1024UL)
+#endif
+// ...or anything is and the last session was this long ago
+#ifndef TELEMETRY_MAX_DELAY_S
+#define TELEMETRY_MAX_DELAY_S 900
+#endif
+// Request body buffer (the largest request); whole batches only, so at least track::BATCH_MAX
+#ifndef TELEMETRY_BODY_BYTES
+#define TELEMETRY_BODY_BYTES 16384
+#endif
+// Requests per session: caps radio-on time when a long backlog is pending
+#ifndef TELEMETRY_MAX_REQUESTS
+#define TELEMETRY_MAX_REQUESTS 64
+#endif
+#ifndef TELEMETRY_BACKOFF_MIN_S
+#define TELEMETRY_BACKOFF_MIN_S 30
+#endif
+#ifndef TELEMETRY_BACKOFF_MAX_S
+#define TELEMETRY_BACKOFF_MAX_S 1800
+#endif
+#ifndef TELEMETRY_CHECK_MS
+#define TELEMETRY_CHECK_MS 60000
+#endif
+#ifndef TELEMETRY_WIFI_TIMEOUT_MS
+#define TELEMETRY_WIFI_TIMEOUT_MS 8000
+#endif
+#ifndef TELEMETRY_REPLY_TIMEOUT_MS
+#define TELEMETRY_REPLY_TIMEOUT_MS 10000
+#endif
+#ifndef TELEMETRY_TASK_PRIORITY
+#define TELEMETRY_TASK_PRIORITY 1
+#endif
+
+static_assert(TELEMETRY_BODY_BYTES >= track::BATCH_MAX, "a request must hold the largest batch");
+
+static const char* PREFS_NS = "telemetry";
+static const char* PREFS_CURSOR = "cursor";
+static const char* PREFS_STORE = "store";     // track_log_store_id() the cursor belongs to
+
+static uint32_t clockMs() { return millis(); }
+
+// Track files through the LittleFS stdio mount that track_log owns
+class TrackStore : public telemetry::Store {
+public:
+  bool range(uint32_t &first, uint32_t &last) override { return track_log_files(&first, &last); }
+  int64_t size(uint32_t file) override {
+    char path[48];
+    track_log_path(file, path, sizeof(path));
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fclose(f);
+    return n;
+  }
+  size_t read(uint32_t file, uint32_t offset, uint8_t* buf, size_t n) override {
+    char path[48];
+    track_log_path(file, path, sizeof(path));
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    size_t got = fseek(f, (long)offset, SEEK_SET) == 0 ? fread(buf, 1, n, f) : 0;
+    fclose(f);
+    return got;
+  }
+};
+
+// Station link (raised for the session when nothing else holds it) and one keep-alive socket
+class WifiTransport : public telemetry::Transport {
+public:
+  explicit WifiTransport(const telemetry::Url &url) : _url(url) {}
+
+  bool open() override {
+    if (!wifi_link_acquire_sta(TELEMETRY_WIFI_TIMEOUT_MS)) return false;
+    if (connect()) return true;
+    wifi_link_release();
+    return false;
+  }
+
+  bool exchange(const char* head, size_t headLen, const uint8_t* body, size_t bodyLen, telemetry::ResponseParser &resp, uint32_t &bytesOut, uint32_t &bytesIn) override {
+    if (!_client.connected() && !connect()) return false;
+    bytesOut += _client.write((const uint8_t*)head, headLen);
+    for (size_t sent = 0; sent < bodyLen; ) {
+      size_t w = _client.write(body + sent, bodyLen - sent);
+      if (!w) { _client.stop(); return false; }
+      sent += w;
+      bytesOut += w;
+    }
+    uint8_t buf[256];
+    uint32_t t0 = millis();
+    while (!resp.done() && !resp.error()) {
+      int n = _client.available() ? _client.read(buf, sizeof(buf)) : 0;
+      if (n > 0) { bytesIn += n; resp.feed(buf, (size_t)n); continue; }
+      if (!_client.connected() || millis() - t0 > TELEMETRY_REPLY_TIMEOUT_MS) break;
+      delay(5);
+    }
+    if (!resp.done() || resp.closes()) _client.stop();
+    return resp.done();
+  }
+
+  void close() override {
+    _client.stop();
+    wifi_link_release();
+  }
+
+private:
+  bool connect() { return _client.connect(_url.host, _url.port) != 0; }
+
+  telemetry::Url _url;
+  WiFiClient _client;
+};
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static TelemetryStats g_stats = {0};        // guarded by g_mux
+static char g_trip[96];                     // guarded by g_mux
+static TaskHandle_t g_task = nullptr;
+
+// Task-only state
+static uint8_t g_body[TELEMETRY_BODY_BYTES];
+static telemetry::Url g_url;
+static TrackStore g_store;
+static telemetry::Uploader* g_uploader = nullptr;
+
+static bool loadCursor(telemetry::Cursor &c) {
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, true)) return false;
+  bool ok = prefs.getBytes(PREFS_CURSOR, &c, sizeof(c)) == sizeof(c);
+  uint32_t store = prefs.getUInt(PREFS_STORE, 0);
+  prefs.end();
+  if (ok && store != track_log_store_id()) {
+    Serial.println("[TEL] saved cursor is for another filesystem, starting over");
+    return false;
+  }
+  return ok;
+}
+
+static void saveCursor(const telemetry::Cursor &c) {
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, false)) return;
+  prefs.putBytes(PREFS_CURSOR, &c, sizeof(c));
+  prefs.putUInt(PREFS_STORE, track_log_store_id());
+  prefs.end();
+}
+
+static void publishStats(uint64_t pending) {
+  const telemetry::Stats &s = g_uploader->stats();
+  TelemetryStats out;
+  out.sessions = s.sessions;
+  out.connectFailures = s.connectFailures;
+  out.requests = s.requests;
+  out.failures = s.failures;
+  out.bodyBytes = s.bodyBytes;
+  out.bytesOut = s.bytesOut;
+  out.bytesIn = s.bytesIn;
+  out.skippedBytes = s.skippedBytes;
+  out.lostFiles = s.lostFiles;
+  out.cursorResets = s.cursorResets;
+  out.radioOnMs = s.radioOnMs;
+  out.latencyAvgMs = s.requests ? (uint32_t)(s.latencyTotalMs / s.requests) : 0;
+  out.latencyMaxMs = s.latencyMaxMs;
+  out.pendingBytes = pending > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)pending;
+  out.cursorFile = g_uploader->cursor().file;
+  out.cursorOffset = g_uploader->cursor().offset;
+  out.backoffFailures = g_uploader->backoff().failures();
+  portENTER_CRITICAL(&g_mux);
+  g_stats = out;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+static void telemetryTask(void*) {
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(TELEMETRY_CHECK_MS));
+    bool linkUp = wifi_link_mode() == WIFI_LINK_STA;
+    if (!g_uploader->due(millis(), linkUp)) { publishStats(g_uploader->pendingBytes()); continue; }
+    char trip[sizeof(g_trip)];
+    portENTER_CRITICAL(&g_mux);
+    memcpy(trip, g_trip, sizeof(trip));
+    portEXIT_CRITICAL(&g_mux);
+    g_uploader->setTrip(trip);
+    telemetry::Cursor before = g_uploader->cursor();
+    uint32_t requests = g_uploader->stats().requests, body = g_uploader->stats().bodyBytes, radio = g_uploader->stats().radioOnMs;
+    bool caughtUp = g_uploader->session(esp_random());
+    telemetry::Cursor after = g_uploader->cursor();
+    if (after.file != before.file || after.offset != before.offset) saveCursor(after);
+    uint64_t pending = g_uploader->pendingBytes();
+    publishStats(pending);
+    Serial.printf("[TEL] session: %u requests, %u B accepted, radio %u ms, %s (%u B pending, at %06u+%u)\n",
+                  (unsigned)(g_uploader->stats().requests - requests), (unsigned)(g_uploader->stats().bodyBytes - body),
+                  (unsigned)(g_uploader->stats().radioOnMs - radio),
+                  caughtUp ? "caught up" : (g_uploader->backoff().failures() ? "failed, backing off" : "more pending"),
+                  (unsigned)pending, (unsigned)after.file, (unsigned)after.offset);
+  }
+}
+
+bool telemetry_uploader_begin(int coreId) {
+  if (g_task) return true;
+  if (!g_url.parse(TELEMETRY_URL)) {
+    Serial.printf("[TEL] bad TELEMETRY_URL %s (http://host[:port]/path)\n", TELEMETRY_URL);
+    return false;
+  }
+  telemetry::Policy policy;
+  policy.minBytes = TELEMETRY_MIN_BYTES;
+  policy.maxDelayMs = TELEMETRY_MAX_DELAY_S * 1000UL;
+  policy.maxRequests = TELEMETRY_MAX_REQUESTS;
+  policy.backoffBaseMs = TELEMETRY_BACKOFF_MIN_S * 1000UL;
+  policy.backoffMaxMs = TELEMETRY_BACKOFF_MAX_S * 1000UL;
+  static WifiTransport transport(g_url);
+  static telemetry::Uploader uploader(g_store, transport, g_body, sizeof(g_body), g_url, TELEMETRY_DEVICE_ID, policy, clockMs);
+  g_uploader = &uploader;
+  telemetry::Cursor c;
+  if (loadCursor(c)) g_uploader->setCursor(c);
+  BaseType_t ok = xTaskCreatePinnedToCore(telemetryTask, "telemetry", 4096, nullptr, TELEMETRY_TASK_PRIORITY, &g_task, coreId);
+  if (ok != pdPASS) { g_task = nullptr; return false; }
+  Serial.printf("[TEL] uploading to %s as %s from %06u+%u\n", TELEMETRY_URL, TELEMETRY_DEVICE_ID, (unsigned)g_uploader->cursor().file, (unsigned)g_uploader->cursor().offset);
+  return true;
+}
+
+void telemetry_uploader_set_trip(const nav::TripState* s) {
+  if (!s) return;
+  char line[sizeof(g_trip)];
+  snprintf(line, sizeof(line), "odo_m=%.0f;a_m=%.0f;a_moving_s=%u;b_m=%.0f;b_moving_s=%u",
+           s->odometerM, s->trip[nav::TRIP_A].distanceM, (unsigned)(s->trip[nav::TRIP_A].movingMs / 1000),
+           s->trip[nav::TRIP_B].distanceM, (unsigned)(s->trip[nav::TRIP_B].movingMs / 1000));
+  portENTER_CRITICAL(&g_mux);
+  memcpy(g_trip, line, sizeof(g_trip));
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void telemetry_uploader_get_stats(TelemetryStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  portEXIT_CRITICAL(&g_mux);
+}
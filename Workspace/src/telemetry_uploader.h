@@ -0,0 +1,39 @@
+// Telemetry upload: a low-priority task that pushes the recorded tracks (track_log) and the trip
+// totals to TELEMETRY_URL over HTTP, store-and-forward (include/telemetry_upload.hpp). The radio
+// is only raised for a session once enough has piled up, everything pending goes over one
+// keep-alive connection, and the radio is dropped again. The upload cursor lives in NVS, so a
+// reboot or a dead link resumes where the server last acknowledged.
+#pragma once
+#include <Arduino.h>
+#include "trip_computer.hpp"
+
+// Upload counters (since telemetry_uploader_begin)
+typedef struct TelemetryStats {
+  uint32_t sessions;        // radio-on sessions started
+  uint32_t connectFailures; // of which could not join the network or reach the server
+  uint32_t requests;        // POSTs sent
+  uint32_t failures;        // socket errors and non-2xx replies
+  uint32_t bodyBytes;       // track bytes the server accepted
+  uint32_t bytesOut;        // on the wire, headers included
+  uint32_t bytesIn;
+  uint32_t skippedBytes;    // torn batches stepped over
+  uint32_t lostFiles;       // tracks deleted for space before they were sent
+  uint32_t cursorResets;    // cursor did not fit the tracks there are, restarted at the oldest
+  uint32_t radioOnMs;       // total time in sessions
+  uint32_t latencyAvgMs;    // per request
+  uint32_t latencyMaxMs;
+  uint32_t pendingBytes;    // not yet uploaded (at the last check)
+  uint32_t cursorFile;      // upload position: track file and byte offset
+  uint32_t cursorOffset;
+  uint32_t backoffFailures; // consecutive failed sessions
+} TelemetryStats;
+
+// Parse TELEMETRY_URL, load the cursor and start the task on 'coreId'. Needs track_log_begin for
+// the filesystem. Returns false if the URL is invalid or the task failed.
+bool telemetry_uploader_begin(int coreId);
+
+// Latest trip totals, sent with the next request (X-Trip header)
+void telemetry_uploader_set_trip(const nav::TripState* s);
+
+// Copy the upload counters into 'out'
+void telemetry_uploader_get_stats(TelemetryStats* out);
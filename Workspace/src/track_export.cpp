@@ -0,0 +1,185 @@
+#include "track_export.h"
+#include <WebServer.h>
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "track_log.h"
+#include "track_export.hpp"
+
+#ifndef TRACK_EXPORT_PORT
+#define TRACK_EXPORT_PORT 80
+#endif
+// Body bytes per chunk: one TCP segment
+#ifndef TRACK_EXPORT_CHUNK
+#define TRACK_EXPORT_CHUNK 1436
+#endif
+// Longest wait for the recorder to write the batch being filled before exporting the current track
+#ifndef TRACK_EXPORT_FLUSH_MS
+#define TRACK_EXPORT_FLUSH_MS 1000
+#endif
+#ifndef TRACK_EXPORT_TASK_PRIORITY
+#define TRACK_EXPORT_TASK_PRIORITY 1
+#endif
+
+static WebServer g_server(TRACK_EXPORT_PORT);
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static TrackExportStats g_stats;             // guarded by g_mux
+// Server-task only: the whole working set of an export, allocated once
+static uint8_t g_batch[track::BATCH_MAX];
+static char g_chunk[TRACK_EXPORT_CHUNK];
+
+// Parse "bytes=a-b", "bytes=a-" or "bytes=-n" against a document of 'total' bytes
+static bool parseRange(const String &h, uint64_t total, uint64_t &first, uint64_t &last) {
+  if (!h.startsWith("bytes=") || h.indexOf(',') >= 0 || !total) return false;
+  const char* s = h.c_str() + 6;
+  char* end;
+  if (*s == '-') {
+    uint64_t n = strtoull(s + 1, &end, 10);
+    if (end == s + 1 || !n) return false;
+    first = n >= total ? 0 : total - n;
+    last = total - 1;
+    return true;
+  }
+  first = strtoull(s, &end, 10);
+  if (end == s || *end != '-') return false;
+  s = end + 1;
+  last = *s ? strtoull(s, &end, 10) : total - 1;
+  if (*s && *end) return false;
+  if (last >= total) last = total - 1;
+  return first <= last;
+}
+
+static void handleList() {
+  uint32_t lo = 0, hi = 0;
+  bool any = track_log_files(&lo, &hi);
+  g_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  g_server.send(200, "application/json", "");
+  g_server.sendContent("[");
+  for (uint32_t i = lo; any && i <= hi; ++i) {
+    char path[48];
+    track_log_path(i, path, sizeof(path));
+    FILE* f = fopen(path, "rb");
+    if (!f) continue;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    int n = snprintf(g_chunk, sizeof(g_chunk), "%s{\"index\":%u,\"bytes\":%ld,\"current\":%s}", i == lo ? "" : ",", (unsigned)i, size, i == hi ? "true" : "false");
+    g_server.sendContent(g_chunk, n);
+  }
+  g_server.sendContent("]");
+  g_server.sendContent("");
+}
+
+static void handleExport() {
+  uint32_t lo = 0, hi = 0;
+  if (!track_log_files(&lo, &hi)) { g_server.send(404, "text/plain", "no tracks\n"); return; }
+  uint32_t index = g_server.hasArg("file") ? (uint32_t)g_server.arg("file").toInt() : hi;
+  track::ExportFormat fmt = g_server.arg("format") == "csv" ? track::EXPORT_CSV : track::EXPORT_GPX;
+  // Include the batch being filled; a slow flash write only costs that batch, not the export
+  if (index == hi && !track_log_flush_wait(TRACK_EXPORT_FLUSH_MS)) Serial.println("[EXP] flush timed out");
+
+  char path[48], name[8];
+  track_log_path(index, path, sizeof(path));
+  snprintf(name, sizeof(name), "%06u", (unsigned)index);
+  FILE* f = fopen(path, "rb");
+  if (!f) { g_server.send(404, "text/plain", "no such track\n"); return; }
+  fseek(f, 0, SEEK_END);
+  long fileBytes = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  // The validator changes whenever the file grows, so a resume never splices two versions
+  char etag[32];
+  snprintf(etag, sizeof(etag), "\"%06u-%ld-%s\"", (unsigned)index, fileBytes, track::exportExt(fmt));
+  bool ranged = g_server.hasHeader("Range") && (!g_server.hasHeader("If-Range") || g_server.header("If-Range") == etag);
+
+  uint32_t heap0 = ESP.getFreeHeap(), heapMin = heap0;
+  uint32_t t0 = millis();
+  // The body must be the document the ETag names, even while the writer appends: count the fixes
+  // in the first fileBytes (one pass over the batch headers and CRCs, no decoding) and stop there
+  uint32_t fixes = track::countFixes(f, g_batch, fileBytes);
+  fseek(f, 0, SEEK_SET);
+  track::ExportStream ex(f, g_batch, fmt, name);
+  ex.setLimit(fixes);
+  uint64_t remaining = UINT64_MAX;
+  int code = 200;
+  if (ranged) {
+    uint64_t total = ex.length(fixes), first = 0, last = 0;
+    char cr[64];
+    if (!parseRange(g_server.header("Range"), total, first, last) || !ex.seek(first)) {
+      fclose(f);
+      snprintf(cr, sizeof(cr), "bytes */%llu", (unsigned long long)total);
+      g_server.sendHeader("Content-Range", cr);
+      g_server.send(416, "text/plain", "");
+      return;
+    }
+    snprintf(cr, sizeof(cr), "bytes %llu-%llu/%llu", (unsigned long long)first, (unsigned long long)last, (unsigned long long)total);
+    g_server.sendHeader("Content-Range", cr);
+    remaining = last - first + 1;
+    code = 206;
+  }
+
+  char disp[48];
+  snprintf(disp, sizeof(disp), "attachment; filename=\"%s.%s\"", name, track::exportExt(fmt));
+  g_server.sendHeader("Content-Disposition", disp);
+  g_server.sendHeader("Accept-Ranges", "bytes");
+  g_server.sendHeader("ETag", etag);
+  g_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  g_server.send(code, track::exportMime(fmt), "");
+
+  uint32_t sent = 0;
+  bool aborted = false;
+  while (remaining) {
+    size_t want = remaining < sizeof(g_chunk) ? (size_t)remaining : sizeof(g_chunk);
+    size_t n = ex.read(g_chunk, want);
+    if (!n) break;
+    if (!g_server.client().connected()) { aborted = true; break; }
+    g_server.sendContent(g_chunk, n);
+    sent += n;
+    remaining -= n;
+    uint32_t heap = ESP.getFreeHeap();
+    if (heap < heapMin) heapMin = heap;
+  }
+  if (!aborted) g_server.sendContent("");
+  fclose(f);
+
+  uint32_t dt = millis() - t0;
+  portENTER_CRITICAL(&g_mux);
+  g_stats.requests++;
+  if (ranged) g_stats.ranged++;
+  if (aborted) g_stats.aborted++;
+  g_stats.bytes += sent;
+  g_stats.lastBytes = sent;
+  g_stats.lastFixes = ex.fixes();
+  g_stats.lastMs = dt;
+  if (heap0 - heapMin > g_stats.heapDipMax) g_stats.heapDipMax = heap0 - heapMin;
+  portEXIT_CRITICAL(&g_mux);
+  Serial.printf("[EXP] %s.%s %d %u B %u fixes in %u ms, heap dip %u B%s\n", name, track::exportExt(fmt), code, sent, ex.fixes(), dt, heap0 - heapMin, aborted ? " (aborted)" : "");
+}
+
+static void exportTask(void*) {
+  for (;;) {
+    g_server.handleClient();
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+}
+
+bool track_export_begin(int coreId) {
+  memset(&g_stats, 0, sizeof(g_stats));
+  static const char* HEADERS[] = { "Range", "If-Range" };
+  g_server.collectHeaders(HEADERS, 2);
+  g_server.on("/tracks", HTTP_GET, handleList);
+  g_server.on("/tracks/export", HTTP_GET, handleExport);
+  g_server.begin();
+  BaseType_t ok = xTaskCreatePinnedToCore(exportTask, "track_http", 6144, nullptr, TRACK_EXPORT_TASK_PRIORITY, nullptr, coreId);
+  if (ok != pdPASS) return false;
+  Serial.printf("[EXP] track download on port %u: /tracks, /tracks/export?file=N&format=gpx|csv\n", (unsigned)TRACK_EXPORT_PORT);
+  return true;
+}
+
+void track_export_get_stats(TrackExportStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  portEXIT_CRITICAL(&g_mux);
+}
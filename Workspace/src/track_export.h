@@ -0,0 +1,27 @@
+// Track download over HTTP: a small web server on its own task that lists the recorded tracks
+// and streams any of them as GPX or CSV (include/track_export.hpp). Responses use chunked
+// transfer from one fixed buffer, so heap use does not depend on the track length, and byte
+// Range requests are honoured so an interrupted download can resume.
+//   GET /tracks                           JSON list of tracks: index, bytes, current
+//   GET /tracks/export?file=N&format=gpx  track N (default: the current one) as gpx or csv
+#pragma once
+#include <Arduino.h>
+
+// Export counters (since track_export_begin)
+typedef struct TrackExportStats {
+  uint32_t requests;       // export requests served (200 or 206)
+  uint32_t ranged;         // of which were Range requests
+  uint32_t aborted;        // client went away mid-stream
+  uint32_t bytes;          // body bytes sent
+  uint32_t lastBytes;      // body bytes of the last export
+  uint32_t lastFixes;      // fixes in the last export
+  uint32_t lastMs;         // duration of the last export
+  uint32_t heapDipMax;     // largest drop in free heap seen during an export (bytes)
+} TrackExportStats;
+
+// Start the HTTP server on TRACK_EXPORT_PORT and its task on 'coreId'. Needs the network up
+// (wifi_link_begin) and track_log_begin for the filesystem. Returns false if the task failed.
+bool track_export_begin(int coreId);
+
+// Copy the export counters into 'out'
+void track_export_get_stats(TrackExportStats* out);
@@ -0,0 +1,259 @@
+#include "track_log.h"
+#include <LittleFS.h>
+#include <dirent.h>
+#include <string.h>
+#include <math.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "track_codec.hpp"
+#include "track_file.hpp"
+
+// Batch size: four 256-byte flash pages, ~150 fixes (15 s at 10 Hz)
+#ifndef TRACK_BATCH_BYTES
+#define TRACK_BATCH_BYTES 1024
+#endif
+// A part-filled batch is written anyway once its first fix is this old
+#ifndef TRACK_BATCH_MAX_MS
+#define TRACK_BATCH_MAX_MS 30000
+#endif
+// RAM ring between loop() and the writer: ~12 s at 10 Hz
+#ifndef TRACK_RING_LEN
+#define TRACK_RING_LEN 128
+#endif
+// Delete the oldest tracks while less than this is free
+#ifndef TRACK_MIN_FREE_BYTES
+#define TRACK_MIN_FREE_BYTES (64UL * 1024UL)
+#endif
+#ifndef TRACK_TASK_PRIORITY
+#define TRACK_TASK_PRIORITY 1
+#endif
+
+static const char* MOUNT = "/littlefs";  // LittleFS VFS mount point (stdio paths)
+static const char* DIR_NAME = "/tracks";
+static const char* STORE_ID_NAME = "store.id";   // next to the tracks; not an NNNNNN.trk name
+
+static uint32_t g_storeId = 0;                 // set once by track_log_begin
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static track::Fix g_ring[TRACK_RING_LEN];
+static uint16_t g_head = 0, g_count = 0;      // guarded by g_mux
+static TrackLogStats g_stats = {0};           // guarded by g_mux
+static TaskHandle_t g_task = nullptr;
+static volatile bool g_flushRequest = false;
+static TaskHandle_t volatile g_flushWaiter = nullptr;  // notified once a requested flush is written
+static uint32_t g_lastSpeedMs = 0;             // loop() only
+
+// Writer-task state
+static uint8_t g_batch[TRACK_BATCH_BYTES];
+static track::BatchEncoder g_encoder(g_batch, sizeof(g_batch));
+static track::TrackWriter g_writer;
+static uint32_t g_batchStartMs = 0;
+
+static void trackPath(char* out, size_t n, uint32_t index) {
+  snprintf(out, n, "%s%s/%06u.trk", MOUNT, DIR_NAME, (unsigned)index);
+}
+
+// Lowest and highest track index on the filesystem; false if there are none
+static bool trackRange(uint32_t &lo, uint32_t &hi) {
+  char dir[32];
+  snprintf(dir, sizeof(dir), "%s%s", MOUNT, DIR_NAME);
+  DIR* d = opendir(dir);
+  if (!d) return false;
+  bool any = false;
+  struct dirent* e;
+  while ((e = readdir(d)) != nullptr) {
+    unsigned idx;
+    if (sscanf(e->d_name, "%u.trk", &idx) != 1) continue;
+    if (!any || idx < lo) lo = idx;
+    if (!any || idx > hi) hi = idx;
+    any = true;
+  }
+  closedir(d);
+  return any;
+}
+
+// Random id of this filesystem, created with it: a format (which restarts the track numbering)
+// gives a new one, so whoever keeps a position in the tracks can tell it belongs to other files
+static uint32_t loadStoreId() {
+  char path[48];
+  snprintf(path, sizeof(path), "%s%s/%s", MOUNT, DIR_NAME, STORE_ID_NAME);
+  uint32_t id = 0;
+  FILE* f = fopen(path, "rb");
+  if (f) {
+    if (fread(&id, 1, sizeof(id), f) != sizeof(id)) id = 0;
+    fclose(f);
+  }
+  if (id) return id;
+  do id = esp_random(); while (!id);
+  f = fopen(path, "wb");
+  if (!f) return id;                // still unique for this boot; tried again on the next
+  fwrite(&id, 1, sizeof(id), f);
+  fclose(f);
+  return id;
+}
+
+// Remove the oldest tracks (never the current one) until there is room for more batches
+static void makeRoom() {
+  while (LittleFS.totalBytes() - LittleFS.usedBytes() < TRACK_MIN_FREE_BYTES) {
+    uint32_t lo = 0, hi = 0;
+    if (!trackRange(lo, hi) || lo >= g_stats.fileIndex) return;
+    char path[48];
+    trackPath(path, sizeof(path), lo);
+    if (remove(path) != 0) return;
+    portENTER_CRITICAL(&g_mux);
+    g_stats.filesDeleted++;
+    portEXIT_CRITICAL(&g_mux);
+    Serial.printf("[TRK] storage low, deleted %s\n", path);
+  }
+}
+
+// Continue in the next track file; retried on the next batch if it cannot be opened either
+static void rollFile() {
+  char path[48];
+  trackPath(path, sizeof(path), g_stats.fileIndex + 1);
+  if (!g_writer.open(path)) { Serial.printf("[TRK] cannot open %s\n", path); return; }
+  portENTER_CRITICAL(&g_mux);
+  g_stats.fileIndex++;
+  portEXIT_CRITICAL(&g_mux);
+  Serial.printf("[TRK] write failed, continuing in %s\n", path);
+}
+
+static void writeBatch() {
+  size_t len = g_encoder.seal();
+  if (!len) return;
+  makeRoom();
+  uint32_t t0 = micros();
+  bool ok = g_writer.append(g_batch, len);
+  uint32_t dt = micros() - t0;
+  g_encoder.reset();
+  // The writer cuts a failed batch off again; if it could not, continue in a new file rather
+  // than append behind the torn one
+  if (!ok && !g_writer.isOpen()) rollFile();
+  portENTER_CRITICAL(&g_mux);
+  if (ok) { g_stats.batches++; g_stats.bytes += len; }
+  else g_stats.writeErrors++;
+  g_stats.writeLastUs = dt;
+  if (dt > g_stats.writeMaxUs) g_stats.writeMaxUs = dt;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+static bool popFix(track::Fix &f) {
+  bool have = false;
+  portENTER_CRITICAL(&g_mux);
+  if (g_count) {
+    f = g_ring[(g_head + TRACK_RING_LEN - g_count) % TRACK_RING_LEN];
+    g_count--;
+    have = true;
+  }
+  portEXIT_CRITICAL(&g_mux);
+  return have;
+}
+
+static void trackTask(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    track::Fix f;
+    while (popFix(f)) {
+      if (g_encoder.count() == 0) g_batchStartMs = millis();
+      if (g_encoder.add(f)) continue;
+      writeBatch();                 // full: write it and start the next batch with this fix
+      g_batchStartMs = millis();
+      g_encoder.add(f);
+    }
+    bool flush = g_flushRequest;
+    g_flushRequest = false;
+    if (g_encoder.count() && (flush || millis() - g_batchStartMs >= TRACK_BATCH_MAX_MS)) writeBatch();
+    TaskHandle_t waiter = g_flushWaiter;
+    if (flush && waiter) { g_flushWaiter = nullptr; xTaskNotifyGive(waiter); }
+  }
+}
+
+bool track_log_begin(int coreId) {
+  memset(&g_stats, 0, sizeof(g_stats));
+  if (!LittleFS.begin(true)) {
+    Serial.println("[TRK] LittleFS mount failed, logging disabled");
+    return false;
+  }
+  LittleFS.mkdir(DIR_NAME);
+  g_storeId = loadStoreId();
+  uint32_t lo = 0, hi = 0;
+  g_stats.fileIndex = trackRange(lo, hi) ? hi + 1 : 1;
+  makeRoom();
+  char path[48];
+  trackPath(path, sizeof(path), g_stats.fileIndex);
+  if (!g_writer.open(path)) {
+    Serial.printf("[TRK] cannot open %s, logging disabled\n", path);
+    return false;
+  }
+  BaseType_t ok = xTaskCreatePinnedToCore(trackTask, "track_log", 4096, nullptr, TRACK_TASK_PRIORITY, &g_task, coreId);
+  if (ok != pdPASS) { g_task = nullptr; g_writer.close(); return false; }
+  g_stats.ok = true;
+  Serial.printf("[TRK] recording to %s (%u KB free)\n", path, (unsigned)((LittleFS.totalBytes() - LittleFS.usedBytes()) / 1024));
+  return true;
+}
+
+void track_log_add(const GPSData* gd) {
+  if (!g_task || !gd || !gd->validFix || gd->speedMs == g_lastSpeedMs) return;
+  g_lastSpeedMs = gd->speedMs;
+  track::Fix f;
+  f.utcMs = gps_data_utc_ms(gd);
+  if (!f.utcMs) return;             // no time yet: a track point without one is useless
+  f.latE7 = gd->latE7;
+  f.lonE7 = gd->lonE7;
+  f.speedCms = (int32_t)(gd->speedRawKmh / 0.036f + 0.5f);
+  f.altDm = (int32_t)lroundf(gd->altitude * 10.0f);
+  bool wake;
+  portENTER_CRITICAL(&g_mux);
+  if (g_count == TRACK_RING_LEN) {
+    g_stats.dropped++;
+    wake = true;
+  } else {
+    g_ring[g_head] = f;
+    g_head = (g_head + 1) % TRACK_RING_LEN;
+    g_count++;
+    g_stats.fixes++;
+    wake = g_count >= TRACK_RING_LEN / 2;   // batch the wake-ups; the task also runs every second
+  }
+  portEXIT_CRITICAL(&g_mux);
+  if (wake) xTaskNotifyGive(g_task);
+}
+
+void track_log_flush(void) {
+  if (!g_task) return;
+  g_flushRequest = true;
+  xTaskNotifyGive(g_task);
+}
+
+bool track_log_flush_wait(uint32_t timeoutMs) {
+  if (!g_task) return false;
+  ulTaskNotifyTake(pdTRUE, 0);      // drop a completion left over from a wait that timed out
+  g_flushWaiter = xTaskGetCurrentTaskHandle();
+  track_log_flush();
+  bool done = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs)) != 0;
+  g_flushWaiter = nullptr;
+  return done;
+}
+
+void track_log_get_stats(TrackLogStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+bool track_log_files(uint32_t* first, uint32_t* last) {
+  uint32_t lo = 0, hi = 0;
+  if (!trackRange(lo, hi)) return false;
+  if (first) *first = lo;
+  if (last) *last = hi;
+  return true;
+}
+
+void track_log_path(uint32_t index, char* out, size_t n) {
+  trackPath(out, n, index);
+}
+
+uint32_t track_log_store_id(void) {
+  return g_storeId;
+}
@@ -0,0 +1,50 @@
+// Track recorder: every new fix goes into a small RAM ring; a low-priority task encodes the ring
+// into compact batches (include/track_codec.hpp) and appends each full batch to a file on the
+// LittleFS partition. loop() never touches flash. A crash or power cut loses at most the batch
+// being filled (TRACK_BATCH_BYTES, or TRACK_BATCH_MAX_MS of driving, whichever comes first).
+#pragma once
+#include <Arduino.h>
+#include "gps_module.h"
+
+// Recorder counters (since track_log_begin)
+typedef struct TrackLogStats {
+  uint32_t fixes;          // fixes accepted into the ring
+  uint32_t dropped;        // fixes lost because the ring was full (writer fell behind)
+  uint32_t batches;        // batches written
+  uint32_t bytes;          // bytes written, headers included
+  uint32_t writeErrors;    // failed or short batch writes
+  uint32_t writeLastUs;    // duration of the last batch write (write + fsync)
+  uint32_t writeMaxUs;
+  uint32_t fileIndex;      // current track file, /tracks/NNNNNN.trk
+  uint32_t filesDeleted;   // oldest tracks removed to make room
+  bool     ok;             // filesystem mounted and the track file open
+} TrackLogStats;
+
+// Mount LittleFS (formatting it if it cannot be mounted), open a new track file for this boot
+// and start the writer task on 'coreId'. Returns false if logging is unavailable.
+bool track_log_begin(int coreId);
+
+// Feed every GPS snapshot; fixes are queued when the speed timestamp changes and there is a fix
+void track_log_add(const GPSData* gd);
+
+// Seal the batch being filled and write it now (e.g. before a deliberate power-off)
+void track_log_flush(void);
+
+// track_log_flush(), then block until the writer task has written it (or found nothing to
+// write). Uses the calling task's notification; one waiter at a time. False on timeout or if
+// logging is not running.
+bool track_log_flush_wait(uint32_t timeoutMs);
+
+// Copy the recorder counters into 'out'
+void track_log_get_stats(TrackLogStats* out);
+
+// Lowest and highest track index on the filesystem (the current file is the highest); false if
+// there are none or the filesystem is not mounted
+bool track_log_files(uint32_t* first, uint32_t* last);
+
+// stdio path of track 'index' (/littlefs/tracks/NNNNNN.trk), for readers such as the exporter
+void track_log_path(uint32_t index, char* out, size_t n);
+
+// Random id of the track filesystem, kept in it and new after a format (the track numbering then
+// starts again). 0 if the filesystem is not mounted. Store it with any saved track position.
+uint32_t track_log_store_id(void);
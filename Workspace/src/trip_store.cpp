@@ -0,0 +1,61 @@
+#include "trip_store.h"
+#include <Preferences.h>
+
+#ifndef TRIP_SAVE_MS
+#define TRIP_SAVE_MS (60UL * 1000UL)
+#endif
+#ifndef TRIP_SAVE_MIN_M
+#define TRIP_SAVE_MIN_M 200.0
+#endif
+#ifndef TRIP_SAVE_STOP_MS
+#define TRIP_SAVE_STOP_MS (10UL * 1000UL)
+#endif
+// Distance a stop must have left unsaved to be worth a write: stop-and-go traffic otherwise
+// costs a record every TRIP_SAVE_STOP_MS for a few metres each
+#ifndef TRIP_SAVE_STOP_MIN_M
+#define TRIP_SAVE_STOP_MIN_M (TRIP_SAVE_MIN_M / 4)
+#endif
+
+static const char* PREFS_NS = "trip";
+static const char* PREFS_STATE = "state";
+
+static double g_savedOdoM = 0.0;
+static uint32_t g_lastSaveMs = 0;
+static bool g_wasMoving = false;
+static uint32_t g_saves = 0;
+
+bool trip_store_load(nav::TripState* out) {
+  if (!out) return false;
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, true)) return false;
+  bool ok = prefs.getBytes(PREFS_STATE, out, sizeof(*out)) == sizeof(*out) && out->version == nav::TRIP_STATE_VERSION;
+  prefs.end();
+  if (ok) g_savedOdoM = out->odometerM;
+  return ok;
+}
+
+void trip_store_save(const nav::TripState* s, uint32_t nowMs) {
+  if (!s) return;
+  Preferences prefs;
+  if (!prefs.begin(PREFS_NS, false)) return;
+  prefs.putBytes(PREFS_STATE, s, sizeof(*s));
+  prefs.end();
+  g_savedOdoM = s->odometerM;
+  g_lastSaveMs = nowMs;
+  g_saves++;
+}
+
+void trip_store_update(const nav::TripState* s, uint32_t nowMs, bool moving) {
+  if (!s) return;
+  double unsaved = s->odometerM - g_savedOdoM;
+  bool stopped = g_wasMoving && !moving;
+  g_wasMoving = moving;
+  if ((unsaved >= TRIP_SAVE_MIN_M && nowMs - g_lastSaveMs >= TRIP_SAVE_MS) ||
+      (stopped && unsaved >= TRIP_SAVE_STOP_MIN_M && nowMs - g_lastSaveMs >= TRIP_SAVE_STOP_MS)) {
+    trip_store_save(s, nowMs);
+  }
+}
+
+uint32_t trip_store_saves(void) {
+  return g_saves;
+}
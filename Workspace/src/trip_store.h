@@ -0,0 +1,21 @@
+// Trip computer persistence: the odometer and trip A/B totals (include/trip_computer.hpp) kept in
+// NVS across resets and power cycles, with writes coalesced so a day of driving costs a few
+// dozen small NVS records rather than one per fix.
+#pragma once
+#include <Arduino.h>
+#include "trip_computer.hpp"
+
+// Load the saved totals into 'out'; false if there are none or they don't validate
+bool trip_store_load(nav::TripState* out);
+
+// Write the totals now (after a trip reset, or before a deliberate power-off)
+void trip_store_save(const nav::TripState* s, uint32_t nowMs);
+
+// Call after every trip update. Writes once TRIP_SAVE_MIN_M has been driven since the last
+// save and TRIP_SAVE_MS has passed, and when the vehicle comes to a stop (the likeliest moment
+// for the power to go) with at least TRIP_SAVE_STOP_MIN_M unsaved, at most once per
+// TRIP_SAVE_STOP_MS.
+void trip_store_update(const nav::TripState* s, uint32_t nowMs, bool moving);
+
+// NVS writes since boot
+uint32_t trip_store_saves(void);
@@ -62,8 +62,9 @@ void MetricsScreen::render(LGFX &g, const AppData &d) {
   char buf[64];
   snprintf(buf, sizeof(buf), "Fix:%s Q:%d", d.gps.validFix?"Y":"N", d.gps.fixQuality); g.drawString(buf, x, y); y+=dy;
   snprintf(buf, sizeof(buf), "Sats used:%d inView:%d", d.gps.satsUsed, d.gps.satsInView); g.drawString(buf, x, y); y+=dy;
-  snprintf(buf, sizeof(buf), "Lat: %.6f", d.gps.lat); g.drawString(buf, x, y); y+=dy;
-  snprintf(buf, sizeof(buf), "Lon: %.6f", d.gps.lon); g.drawString(buf, x, y); y+=dy;
+  snprintf(buf, sizeof(buf), "DOP P:%.1f H:%.1f V:%.1f", d.gps.pdop, d.gps.hdop, d.gps.vdop); g.drawString(buf, x, y); y+=dy;
+  snprintf(buf, sizeof(buf), "Lat: %.6f", d.gps.latE7 * 1e-7); g.drawString(buf, x, y); y+=dy;
+  snprintf(buf, sizeof(buf), "Lon: %.6f", d.gps.lonE7 * 1e-7); g.drawString(buf, x, y); y+=dy;
   snprintf(buf, sizeof(buf), "Alt: %.1fm", d.gps.altitude); g.drawString(buf, x, y); y+=dy;
   snprintf(buf, sizeof(buf), "Spd: %.1f kn / %.1f km/h", d.gps.speedKnots, d.gps.speedKmh); g.drawString(buf, x, y); y+=dy;
   snprintf(buf, sizeof(buf), "Course: %.1f deg", d.gps.courseDeg); g.drawString(buf, x, y); y+=dy;
@@ -0,0 +1,85 @@
+#include "wifi_link.h"
+#include <WiFi.h>
+
+#ifndef WIFI_STA_SSID
+#define WIFI_STA_SSID ""
+#endif
+#ifndef WIFI_STA_PASS
+#define WIFI_STA_PASS ""
+#endif
+#ifndef WIFI_AP_SSID
+#define WIFI_AP_SSID "ESP32-GPS"
+#endif
+#ifndef WIFI_AP_PASS
+#define WIFI_AP_PASS "gps12345" // change for security
+#endif
+
+static WifiLinkMode g_mode = WIFI_LINK_OFF;
+static bool g_temporary = false;   // station raised by wifi_link_acquire_sta, dropped on release
+
+// Join WIFI_STA_SSID; false on timeout or when no SSID is configured
+static bool connectSta(uint32_t timeoutMs) {
+  if (strlen(WIFI_STA_SSID) == 0) return false;
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_STA_SSID, WIFI_STA_PASS);
+  Serial.printf("[WiFi] Connecting to %s...\n", WIFI_STA_SSID);
+  uint32_t t0 = millis();
+  while (WiFi.status() != WL_CONNECTED && millis() - t0 < timeoutMs) {
+    delay(200);
+    Serial.print('.');
+  }
+  Serial.println();
+  if (WiFi.status() != WL_CONNECTED) return false;
+  Serial.printf("[WiFi] Connected: %s RSSI=%d dBm\n", WiFi.localIP().toString().c_str(), WiFi.RSSI());
+  return true;
+}
+
+WifiLinkMode wifi_link_begin(uint32_t staTimeoutMs) {
+  if (g_mode != WIFI_LINK_OFF) {
+    g_temporary = false;                        // someone else needs it now: keep it up
+    return g_mode;                              // already up for another user
+  }
+  if (strlen(WIFI_STA_SSID) > 0) {
+    if (connectSta(staTimeoutMs)) {
+      g_mode = WIFI_LINK_STA;
+      return g_mode;
+    }
+    Serial.println("[WiFi] STA connect failed, falling back to SoftAP");
+  }
+  WiFi.mode(WIFI_AP);
+  bool ok = WiFi.softAP(WIFI_AP_SSID, WIFI_AP_PASS);
+  Serial.printf("[WiFi] SoftAP %s %s at %s\n", WIFI_AP_SSID, ok ? "started" : "FAILED", WiFi.softAPIP().toString().c_str());
+  g_mode = ok ? WIFI_LINK_AP : WIFI_LINK_OFF;
+  return g_mode;
+}
+
+bool wifi_link_acquire_sta(uint32_t timeoutMs) {
+  if (g_mode == WIFI_LINK_AP) return false;
+  if (g_mode == WIFI_LINK_STA) return WiFi.status() == WL_CONNECTED;
+  if (!connectSta(timeoutMs)) {
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    return false;
+  }
+  g_mode = WIFI_LINK_STA;
+  g_temporary = true;
+  return true;
+}
+
+void wifi_link_release(void) {
+  if (!g_temporary) return;
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  g_mode = WIFI_LINK_OFF;
+  g_temporary = false;
+  Serial.println("[WiFi] radio off");
+}
+
+WifiLinkMode wifi_link_mode(void) {
+  if (g_mode == WIFI_LINK_STA && WiFi.status() != WL_CONNECTED) return WIFI_LINK_OFF;
+  return g_mode;
+}
+
+IPAddress wifi_link_ip(void) {
+  return g_mode == WIFI_LINK_AP ? WiFi.softAPIP() : WiFi.localIP();
+}
@@ -0,0 +1,28 @@
+// WiFi bring-up shared by the app and the GPS test sketch: join the configured network
+// (WIFI_STA_SSID / WIFI_STA_PASS build flags) and fall back to a SoftAP when that fails.
+#pragma once
+#include <Arduino.h>
+
+typedef enum WifiLinkMode {
+  WIFI_LINK_OFF = 0,   // not started, or the SoftAP failed too
+  WIFI_LINK_STA = 1,   // joined WIFI_STA_SSID
+  WIFI_LINK_AP  = 2    // running the fallback SoftAP (WIFI_AP_SSID / WIFI_AP_PASS)
+} WifiLinkMode;
+
+// Try the station network for up to 'staTimeoutMs' (skipped when no SSID is configured), then
+// start the SoftAP. Blocks while connecting. Returns the resulting mode; once a link is up, later
+// calls return it without reconnecting, so several features can each ask for the network.
+WifiLinkMode wifi_link_begin(uint32_t staTimeoutMs);
+
+// Borrow the station link for a short transfer: returns true when joined (an existing station
+// link is shared). Never starts the SoftAP, and returns false while the SoftAP is running. A link
+// raised here is only temporary: wifi_link_release() turns the radio off again unless a
+// wifi_link_begin() caller has claimed it in the meantime.
+bool wifi_link_acquire_sta(uint32_t timeoutMs);
+void wifi_link_release(void);
+
+// Current mode (a station link that dropped reports WIFI_LINK_OFF until it reconnects)
+WifiLinkMode wifi_link_mode(void);
+
+// Address others should connect to: the station IP or the SoftAP gateway
+IPAddress wifi_link_ip(void);
@@ -0,0 +1,366 @@
+#!/usr/bin/env python3
+"""Write the NMEA replay corpora and their golden parsed state (test/test_nmea_replay).
+
+Three logs shaped like u-blox M8/M10 output:
+  cold_start.nmea  logging starts mid-sentence; ~40 s of no fix with satellites appearing, then
+                   a 1 Hz fix while driving off
+  multi_gnss.nmea  10 Hz GN talker: RMC/VTG/GGA/GST every epoch, GSA per system (NMEA 4.10
+                   system id) and GP/GL/GA/GB GSV once a second
+  parked.nmea      20 min standing still at 1 Hz (the parked rate): Doppler speed noise of a
+                   stationary receiver (~0.12 m/s per axis, the odd multipath spike), a wandering
+                   position and HDOP 0.6-1.4
+  corrupted.nmea   multi_gnss with damage: flipped bytes, lines cut short, missing or non-hex
+                   checksums, lowercase checksums, binary noise, overlong lines and fields,
+                   bare LF endings and sentence types the parser does not know
+
+The golden file (<log>.golden) is what a correct parser must report, produced by an
+independent reference model of the parser's contract (reference() below): one line per
+accepted sentence and a final STATS line. Regenerate with
+    python3 test/data/nmea/make_corpus.py test/data/nmea
+"""
+import math
+import os
+import random
+import struct
+import sys
+
+MAX_SENTENCE = 96
+FIELD_MAX = 16
+# Subscribed fields per sentence type (nmea_parser.hpp policies)
+FIELDS = {
+    "GGA": {2, 3, 4, 5, 6, 7, 8, 9},
+    "RMC": {1, 2, 3, 4, 5, 6, 7, 8, 9},
+    "GSV": set(range(1, 20)),
+    "GSA": {2, 15, 16, 17},
+    "GST": {6, 7, 8},
+    "VTG": {1, 7, 9},
+}
+
+
+def cs(body):
+    c = 0
+    for ch in body.encode():
+        c ^= ch
+    return c
+
+
+def sentence(body):
+    return "$%s*%02X\r\n" % (body, cs(body))
+
+
+def ddmm(deg, lon):
+    a = abs(deg)
+    d = int(a)
+    m = (a - d) * 60.0
+    m5 = int(round(m * 1e5))
+    if m5 >= 60 * 100000:
+        d, m5 = d + 1, 0
+    return ("%03d" if lon else "%02d") % d + "%02d.%05d" % (m5 // 100000, m5 % 100000), ("EW" if lon else "NS")[deg < 0]
+
+
+SYSTEMS = [("GP", 1, [2, 5, 12, 13, 15, 18, 20, 24, 25, 29]), ("GL", 2, [65, 66, 72, 75, 81, 82, 88]),
+           ("GA", 3, [1, 3, 7, 8, 13, 26, 30]), ("GB", 4, [6, 9, 16, 19, 22, 27])]
+
+
+def gsv(talker, prns, rng, tracked, signal):
+    out = []
+    total = max(1, (len(prns) + 3) // 4)
+    for i in range(total):
+        group = prns[i * 4:i * 4 + 4]
+        f = [talker + "GSV", str(total), str(i + 1), "%02d" % len(prns)]
+        for p in group:
+            el, az = rng.randint(5, 85), rng.randint(0, 359)
+            f += ["%02d" % p, "%02d" % el, "%03d" % az, ("%02d" % rng.randint(18, 48)) if p in tracked else ""]
+        if signal:
+            f.append(signal)
+        out.append(sentence(",".join(f)))
+    return out
+
+
+def drive_state(t):
+    """Position, speed (knots), course along a gentle S-bend out of Munich."""
+    v = 0.0 if t < 3 else min(25.0, (t - 3) * 2.5) + 3.0 * math.sin(t / 17.0)
+    course = (80.0 + 40.0 * math.sin(t / 40.0)) % 360.0
+    dist = 0.0 if t < 3 else 0.5 * 2.5 * min(t - 3, 10) ** 2 + 25.0 * max(0, t - 13)
+    lat = 48.137154 + dist * math.cos(math.radians(80)) / 111320.0
+    lon = 11.576124 + dist * math.sin(math.radians(80)) / 74400.0
+    return lat, lon, max(0.0, v) / 0.514444, course
+
+
+def utc(t):
+    s = 36000 + t
+    return "%02d%02d%05.2f" % (int(s // 3600) % 24, int(s // 60) % 60, s % 60)
+
+
+def cold_start(rng):
+    out = ["2,0.0,N,V*3B\r\n"]  # tail of a sentence cut by the start of logging
+    for sec in range(150):
+        t = float(sec)
+        fix = sec >= 40
+        visible = [(tk, sid, prns[:min(len(prns), 2 + sec // 6)]) for tk, sid, prns in SYSTEMS[:2]]
+        tracked = set(p for _, _, ps in visible for p in ps[:max(0, sec // 8 - 1)])
+        if not fix:
+            out.append(sentence("GPRMC,%s,V,,,,,,,,,,N" % utc(t) if sec > 2 else "GPRMC,,V,,,,,,,,,,N"))
+            out.append(sentence("GPVTG,,,,,,,,,N"))
+            out.append(sentence("GPGGA,%s,,,,,0,%02d,99.99,,,,,," % (utc(t) if sec > 2 else "", len(tracked) // 2)))
+            out.append(sentence("GPGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99"))
+        else:
+            lat, lon, kn, crs = drive_state(t - 40)
+            la, ns = ddmm(lat, False)
+            lo, ew = ddmm(lon, True)
+            used = sorted(tracked)[:12]
+            out.append(sentence("GPRMC,%s,A,%s,%s,%s,%s,%.3f,%.2f,161026,,,A" % (utc(t), la, ns, lo, ew, kn, crs)))
+            out.append(sentence("GPVTG,%.2f,T,,M,%.3f,N,%.3f,K,A" % (crs, kn, kn * 1.852)))
+            hd = max(0.8, 3.5 - (sec - 40) * 0.05)
+            out.append(sentence("GPGGA,%s,%s,%s,%s,%s,1,%02d,%.2f,%.1f,M,47.0,M,," % (utc(t), la, ns, lo, ew, len(used), hd, 519.4 + sec * 0.1)))
+            out.append(sentence("GPGSA,A,3,%s,%.2f,%.2f,%.2f" % (",".join(["%02d" % p for p in used] + [""] * (12 - len(used))), hd * 1.6, hd, hd * 1.3)))
+        if sec % 5 == 0:
+            for tk, sid, prns in visible:
+                out += gsv(tk, prns, rng, tracked, None)
+        out.append(sentence("GPGLL,,,,,%s,V,N" % utc(t)))  # not subscribed: counted as unknown
+    return out
+
+
+def multi_gnss(rng, seconds):
+    out = []
+    for k in range(seconds * 10):
+        t = k / 10.0
+        lat, lon, kn, crs = drive_state(t)
+        la, ns = ddmm(lat, False)
+        lo, ew = ddmm(lon, True)
+        out.append(sentence("GNRMC,%s,A,%s,%s,%s,%s,%.3f,%.2f,161026,,,A,V" % (utc(t), la, ns, lo, ew, kn, crs)))
+        out.append(sentence("GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A" % (crs, kn, kn * 1.852)))
+        out.append(sentence("GNGGA,%s,%s,%s,%s,%s,1,%02d,%.2f,%.1f,M,47.0,M,," % (utc(t), la, ns, lo, ew, 24, 0.62, 521.3 + math.sin(t / 9.0))))
+        for tk, sid, prns in SYSTEMS:
+            used = prns[:12]
+            out.append(sentence("GNGSA,A,3,%s,1.10,0.62,0.91,%d" % (",".join(["%02d" % p for p in used] + [""] * (12 - len(used))), sid)))
+        out.append(sentence("GNGST,%s,11,1.2,0.9,47.1,%.1f,%.1f,%.1f" % (utc(t), 0.9 + (k % 7) * 0.1, 1.1 + (k % 5) * 0.1, 1.8)))
+        if k % 10 == 0:
+            for tk, sid, prns in SYSTEMS:
+                out += gsv(tk, prns, rng, set(prns), "1" if tk != "GB" else "B")
+    return out
+
+
+def parked(rng, seconds):
+    out = []
+    lat, lon = 48.137154, 11.576124
+    for sec in range(seconds):
+        t = float(sec)
+        ve, vn = rng.gauss(0, 0.12), rng.gauss(0, 0.12)
+        if rng.random() < 0.01:       # multipath
+            ve += rng.choice((-1, 1)) * 0.2
+        kn = math.hypot(ve, vn) / 0.514444
+        crs = math.degrees(math.atan2(ve, vn)) % 360.0
+        lat += rng.gauss(0, 0.3) / 111320.0
+        lon += rng.gauss(0, 0.3) / 74400.0
+        hd = 1.0 + 0.4 * math.sin(t / 200.0)
+        la, ns = ddmm(lat, False)
+        lo, ew = ddmm(lon, True)
+        out.append(sentence("GNRMC,%s,A,%s,%s,%s,%s,%.3f,%.2f,161026,,,A,V" % (utc(t), la, ns, lo, ew, kn, crs)))
+        out.append(sentence("GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A" % (crs, kn, kn * 1.852)))
+        out.append(sentence("GNGGA,%s,%s,%s,%s,%s,1,%02d,%.2f,%.1f,M,47.0,M,," % (utc(t), la, ns, lo, ew, 14, hd, 519.0 + rng.gauss(0, 0.5))))
+        out.append(sentence("GNGSA,A,3,02,05,12,13,15,18,20,24,,,,,%.2f,%.2f,%.2f,1" % (hd * 1.7, hd, hd * 1.4)))
+    return out
+
+
+def corrupt(lines, rng):
+    out = []
+    for i, ln in enumerate(lines):
+        r = rng.random()
+        b = bytearray(ln.encode())
+        if r < 0.02:        # flipped byte inside the body
+            j = rng.randint(1, len(b) - 6)
+            b[j] ^= 1 << rng.randint(0, 6)
+        elif r < 0.03:      # cut short: next '$' arrives first
+            b = b[:rng.randint(2, len(b) - 4)]
+        elif r < 0.035:     # checksum lost
+            b = b[:b.index(b"*")] + b"\r\n"
+        elif r < 0.04:      # non-hex checksum
+            b = b[:b.index(b"*") + 1] + b"G1\r\n"
+        elif r < 0.06:      # lowercase checksum (valid)
+            b = bytearray(ln.lower().replace(ln.lower()[:-5], ln[:-5]).encode())
+        elif r < 0.07:      # bare LF
+            b = b[:-2] + b"\n"
+        elif r < 0.075:     # binary noise between sentences (UBX from a half-configured receiver)
+            b = bytes(rng.randint(0, 255) for _ in range(rng.randint(4, 40))).replace(b"$", b"#") + b
+        elif r < 0.078:     # overlong sentence
+            b = sentence("GNTXT,01,01,02," + "X" * 120).encode()
+        elif r < 0.081:     # overlong subscribed field
+            b = sentence("GNGGA,100000.00,4808.2292" + "1" * 20 + ",N,01134.56744,E,1,12,0.70,520.0,M,47.0,M,,").encode()
+        elif r < 0.085:     # sentence types the parser does not subscribe to
+            b = sentence("GNZDA,%s,16,10,2026,00,00" % utc(i / 10.0)).encode() + b
+        out.append(bytes(b))
+    return out
+
+
+# ---------- Reference model ----------
+
+def f32(x):
+    return struct.unpack("f", struct.pack("f", x))[0]
+
+
+def to_int(s):
+    v = 0
+    for ch in s:
+        if not ch.isdigit():
+            break
+        v = v * 10 + ord(ch) - 48
+    return v
+
+
+def to_float(s):
+    i, neg = 0, False
+    if s[:1] in ("-", "+"):
+        neg, i = s[0] == "-", 1
+    mant, digits, frac = 0, 0, -1
+    while i < len(s):
+        c = s[i]
+        i += 1
+        if c == ".":
+            if frac >= 0:
+                break
+            frac = 0
+            continue
+        if not c.isdigit():
+            break
+        if digits >= 9:
+            continue
+        mant, digits = mant * 10 + ord(c) - 48, digits + 1
+        if frac >= 0:
+            frac += 1
+    v = f32(f32(mant) / f32(10.0 ** frac)) if frac > 0 else f32(mant)
+    return -v if neg else v
+
+
+def to_e7(s):
+    dot = s.find(".")
+    if dot < 0:
+        dot = len(s)
+    if dot < 3:
+        return 0
+    deg = to_int(s[:dot - 2])
+    m = (ord(s[dot - 2]) - 48) * 10 + ord(s[dot - 1]) - 48
+    m *= 10000000
+    scale = 1000000
+    for c in s[dot + 1:]:
+        if not c.isdigit() or scale == 0:
+            break
+        m += (ord(c) - 48) * scale
+        scale //= 10
+    return deg * 10000000 + (m + 30) // 60
+
+
+def describe(kind, talker, f):
+    g = lambda i: f[i] if i < len(f) else ""
+    if kind == "GGA":
+        lat, lon = to_e7(g(2)), to_e7(g(4))
+        lat = -lat if g(3)[:1] == "S" else lat
+        lon = -lon if g(5)[:1] == "W" else lon
+        return "GGA %d %d %d %d %.3f %.3f" % (lat, lon, to_int(g(6)), to_int(g(7)), to_float(g(8)), to_float(g(9)))
+    if kind == "RMC":
+        lat, lon = to_e7(g(3)), to_e7(g(5))
+        lat = -lat if g(4)[:1] == "S" else lat
+        lon = -lon if g(6)[:1] == "W" else lon
+        return "RMC %s %d %d %d %.3f %.3f %s" % (g(1)[:9] or "-", g(2)[:1] == "A", lat, lon, to_float(g(7)), to_float(g(8)), g(9)[:7] or "-")
+    if kind == "GSV":
+        sats = []
+        for k in range(4):
+            if 4 + 4 * k + 3 < len(f) and to_int(g(4 + 4 * k)):
+                sats.append("%d/%d/%d/%d" % (to_int(g(4 + 4 * k)) & 0xFF, to_int(g(5 + 4 * k)), to_int(g(6 + 4 * k)), to_int(g(7 + 4 * k)) & 0xFF))
+        return "GSV %s %d %d %d %s" % (talker, to_int(g(1)), to_int(g(2)), to_int(g(3)), ",".join(sats) or "-")
+    if kind == "GSA":
+        return "GSA %d %.3f %.3f %.3f" % (to_int(g(2)), to_float(g(15)), to_float(g(16)), to_float(g(17)))
+    if kind == "GST":
+        return "GST %.3f %.3f %.3f" % (to_float(g(6)), to_float(g(7)), to_float(g(8)))
+    if kind == "VTG":
+        valid = len(g(7)) > 0 and not (len(f) > 9 and g(9)[:1] == "N")
+        return "VTG %.3f %.3f %d" % (to_float(g(1)), to_float(g(7)), valid)
+
+
+def reference(data):
+    """What nmea::Parser<Gga, Rmc, Gsv, Gsa, Gst, Vtg> must report for these bytes."""
+    out = []
+    stats = [0, 0, 0, 0]   # sentences, checksum errors, overflows, unknown
+    i, n = 0, len(data)
+    while i < n:
+        if data[i] != 0x24:
+            i += 1
+            continue
+        # One sentence attempt from this '$'
+        i += 1
+        length, fields, cur, csum, kind, mask = 0, [], bytearray(), 0, None, {0}
+        state, ok = "field", False
+        while i < n:
+            c = data[i]
+            if c == 0x24:
+                break                       # restart, nothing counted
+            i += 1
+            if state == "field":
+                if c in (13, 10):
+                    stats[1] += 1
+                    break
+                length += 1
+                if length > MAX_SENTENCE:
+                    stats[2] += 1
+                    break
+                if c in (0x2C, 0x2A):
+                    idx = len(fields)
+                    if idx == 0:
+                        addr = cur.decode("latin1")
+                        kind = addr[2:] if len(addr) == 5 and addr[2:] in FIELDS else None
+                        if kind is None:
+                            stats[3] += 1
+                            break
+                        mask = FIELDS[kind]
+                    fields.append(cur.decode("latin1") if idx == 0 or idx in mask else "")
+                    cur = bytearray()
+                    if c == 0x2A:
+                        state, digits, expected = "cs", 0, 0
+                    else:
+                        csum ^= c
+                    continue
+                csum ^= c
+                if len(fields) in mask or not fields:
+                    if len(cur) >= FIELD_MAX:
+                        stats[2] += 1
+                        break
+                    cur.append(c)
+            else:
+                ch = chr(c)
+                if ch in "0123456789ABCDEFabcdef":
+                    expected = expected * 16 + int(ch, 16)
+                    digits += 1
+                    if digits == 2:
+                        if expected & 0xFF == csum:
+                            stats[0] += 1
+                            out.append(describe(kind, fields[0][:2], fields))
+                        else:
+                            stats[1] += 1
+                        break
+                else:
+                    stats[1] += 1
+                    break
+    out.append("STATS %d %d %d %d" % tuple(stats))
+    return out
+
+
+def main():
+    d = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    rng = random.Random(2026)
+    logs = {
+        "cold_start.nmea": "".join(cold_start(rng)).encode(),
+        "multi_gnss.nmea": "".join(multi_gnss(rng, 60)).encode(),
+    }
+    logs["parked.nmea"] = "".join(parked(random.Random(5), 1200)).encode()
+    logs["corrupted.nmea"] = b"".join(corrupt(multi_gnss(random.Random(7), 60), random.Random(11)))
+    for name, data in logs.items():
+        with open(os.path.join(d, name), "wb") as f:
+            f.write(data)
+        gold = reference(data)
+        with open(os.path.join(d, name.replace(".nmea", ".golden")), "w") as f:
+            f.write("\n".join(gold) + "\n")
+        print("%s: %d bytes, %s" % (name, len(data), gold[-1]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""Write the UBX capture and its golden decoded state (test/test_ubx_decoder).
+
+drive.ubx is shaped like a u-blox M8 at 5 Hz with UBX output: an ACK-ACK for the configuration,
+a GNTXT banner left over from NMEA mode, then 30 s of NAV-PVT (92 bytes), NAV-VELNED and
+NAV-SOL every epoch with a NAV-SAT (longer than the decoder keeps) once a second. The receiver
+has no fix for 2 s, a 2D fix for 1 s, then a 3D fix, differential from 12 s to 20 s, while the
+car pulls away, accelerates through a bend and brakes. One NAV-VELNED has a damaged checksum.
+
+The golden file (drive.golden) is what a correct decoder and gps_module's mapping must report,
+from an independent model of both: one line per checksum-valid frame (the decoded integer
+fields of the NAV messages, class/id/length of the rest), after each NAV frame the GPSData
+fields it maps to, and a final STATS line. Regenerate with
+    python3 test/data/ubx/make_capture.py test/data/ubx
+"""
+import math
+import os
+import random
+import struct
+import sys
+
+RATE_HZ = 5
+SECONDS = 30
+MAX_PAYLOAD = 100
+MAX_FRAME = 1024
+LAT0, LON0, HMSL0 = 48.137154, 11.576124, 519.0
+GPS_EPOCH_TOW_MS = 381600000          # Thursday 10:00:00 GPS time of week (18 leap seconds)
+
+
+def frame(cls, mid, payload):
+    body = struct.pack("<BBH", cls, mid, len(payload)) + payload
+    a = b = 0
+    for c in body:
+        a = (a + c) & 0xFF
+        b = (b + a) & 0xFF
+    return b"\xb5\x62" + body + bytes([a, b])
+
+
+def fix_state(t):
+    """(fixType, flags) at time t: none, 2D, 3D, 3D differential, 3D."""
+    if t < 2.0:
+        return 0, 0
+    if t < 3.0:
+        return 2, 0x01
+    if 12.0 <= t < 20.0:
+        return 3, 0x03
+    return 3, 0x01
+
+
+def motion(t):
+    """Speed (m/s) and heading (deg) of the drive: stand, pull away, bend, brake."""
+    if t < 4.0:
+        v = 0.0
+    elif t < 18.0:
+        v = min(25.0, 2.5 * (t - 4.0))
+    elif t < 24.0:
+        v = 25.0
+    else:
+        v = max(0.0, 25.0 - 6.0 * (t - 24.0))
+    heading = 80.0 + (0.0 if t < 14.0 else min(90.0, 9.0 * (t - 14.0)))
+    return v, heading % 360.0
+
+
+def epochs(rng):
+    n, e = 0.0, 0.0
+    dt = 1.0 / RATE_HZ
+    for k in range(SECONDS * RATE_HZ):
+        t = k * dt
+        v, hdg = motion(t)
+        n += v * dt * math.cos(math.radians(hdg))
+        e += v * dt * math.sin(math.radians(hdg))
+        fix_type, flags = fix_state(t)
+        lat = LAT0 + n / 111320.0
+        lon = LON0 + e / (111320.0 * math.cos(math.radians(LAT0)))
+        tow = GPS_EPOCH_TOW_MS + k * 1000 // RATE_HZ
+        utc_ms = 10 * 3600000 + k * 1000 // RATE_HZ - 18000
+        yield {
+            "t": t, "tow": tow, "fix": fix_type, "flags": flags,
+            "numSV": 0 if fix_type == 0 else 7 + min(12, int(t)),
+            "lat": int(round(lat * 1e7)), "lon": int(round(lon * 1e7)),
+            "hmsl": int(round((HMSL0 + 0.02 * e) * 1000)) + rng.randint(-80, 80),
+            "hacc": (25000 if fix_type == 0 else (3000 if t < 3.0 else 900)) + rng.randint(0, 300),
+            "vacc": (35000 if fix_type == 0 else 1500) + rng.randint(0, 400),
+            "velN": int(round(v * 1000 * math.cos(math.radians(hdg)))) + rng.randint(-30, 30),
+            "velE": int(round(v * 1000 * math.sin(math.radians(hdg)))) + rng.randint(-30, 30),
+            "velD": rng.randint(-40, 40),
+            "gspeed": max(0, int(round(v * 1000)) + rng.randint(-40, 40)),
+            "head": int(round(hdg * 1e5)),
+            "sacc": 180 + rng.randint(0, 250),
+            "headacc": 500000 + rng.randint(0, 2000000),
+            "pdop": 95 + rng.randint(0, 120),
+            "utc": utc_ms,
+            "valid": 0x03 if t >= 0.6 else 0x00,
+        }
+
+
+def nav_pvt(s):
+    ms = s["utc"]
+    h, mi, sec, frac = ms // 3600000, ms // 60000 % 60, ms // 1000 % 60, ms % 1000
+    p = struct.pack("<IHBBBBBBIiBBBBiiiiIIiiiiiIIH", s["tow"], 2026, 10, 15, h, mi, sec, s["valid"],
+                    30 + (s["fix"] and 20), frac * 1000000, s["fix"], s["flags"], 0xEA, s["numSV"],
+                    s["lon"], s["lat"], s["hmsl"] + 47000, s["hmsl"], s["hacc"], s["vacc"],
+                    s["velN"], s["velE"], s["velD"], s["gspeed"], s["head"], s["sacc"], s["headacc"], s["pdop"])
+    return p + bytes(92 - len(p))
+
+
+def nav_velned(s):
+    speed = int(round(math.sqrt(s["velN"] ** 2 + s["velE"] ** 2 + s["velD"] ** 2) / 10))
+    return struct.pack("<IiiiIIiII", s["tow"], s["velN"] // 10, s["velE"] // 10, s["velD"] // 10,
+                       speed, s["gspeed"] // 10, s["head"], s["sacc"] // 10, s["headacc"])
+
+
+def nav_sol(s):
+    p = bytearray(52)
+    struct.pack_into("<IiH", p, 0, s["tow"], 0, 2414)
+    p[10], p[11] = s["fix"], s["flags"]
+    struct.pack_into("<I", p, 24, s["hacc"] // 10 + 60)
+    struct.pack_into("<I", p, 40, s["sacc"] // 10)
+    struct.pack_into("<H", p, 44, s["pdop"])
+    p[47] = s["numSV"]
+    return bytes(p)
+
+
+def nav_sat(rng, n):
+    p = bytearray(struct.pack("<IBBH", 0, 1, n, 0))
+    for i in range(n):
+        p += struct.pack("<BBBbhhI", i % 7, i + 1, rng.randint(18, 48), rng.randint(5, 85),
+                         rng.randint(0, 359), rng.randint(-50, 50), 0x1F)
+    return bytes(p)
+
+
+def capture(rng):
+    out = [frame(0x05, 0x01, bytes([0x06, 0x01])),
+           b"$GNTXT,01,01,02,u-blox AG - www.u-blox.com*4E\r\n"]
+    for k, s in enumerate(epochs(rng)):
+        out.append(frame(0x01, 0x07, nav_pvt(s)))
+        velned = frame(0x01, 0x12, nav_velned(s))
+        if k == 77:
+            velned = velned[:-1] + bytes([velned[-1] ^ 0x5A])
+        out.append(velned)
+        out.append(frame(0x01, 0x06, nav_sol(s)))
+        if k % RATE_HZ == RATE_HZ - 1:
+            out.append(frame(0x01, 0x35, nav_sat(rng, 24 + k % 7)))
+    return b"".join(out)
+
+
+# ---------- reference model ----------
+
+def f32(x):
+    return struct.unpack("<f", struct.pack("<f", x))[0]
+
+
+class Data:
+    """The GPSData fields the UBX path writes, as gps_module maps them."""
+
+    def __init__(self):
+        self.valid, self.quality, self.mode, self.sats = 0, 0, 0, 0
+        self.lat = self.lon = 0
+        self.alt = self.kmh = self.course = self.hacc = self.vacc = self.pdop = self.sacc = 0.0
+        self.date, self.time = "-", "-"
+
+    def set_fix(self, fix_type, flags, num_sv):
+        ok = bool(flags & 1) and 2 <= fix_type <= 4
+        self.quality = (2 if flags & 2 else 1) if ok else 0
+        self.mode = (2 if fix_type == 2 else 3) if ok else 1
+        self.valid = int(ok)
+        self.sats = num_sv
+
+    def set_speed(self, gspeed_mms, heading_e5, sacc_mms):
+        self.kmh = gspeed_mms * 0.0036
+        self.course = heading_e5 * 1e-5
+        self.sacc = sacc_mms * 0.0036
+
+    def line(self):
+        return "DATA %d %d %d %d %d %d %.3f %.3f %.3f %.3f %.3f %.2f %.3f %s %s" % (
+            self.valid, self.quality, self.mode, self.sats, self.lat, self.lon, self.alt, self.kmh,
+            self.course, self.hacc, self.vacc, self.pdop, self.sacc, self.date, self.time)
+
+
+def reference(data):
+    out, d = [], Data()
+    stats = [0, 0, 0, 0]     # frames, checksum errors, oversize, bad length
+    i, n = 0, len(data)
+    while i < n:
+        if data[i] != 0xB5 or i + 1 >= n or data[i + 1] != 0x62:
+            i += 1
+            continue
+        if i + 6 > n:
+            break
+        cls, mid, length = struct.unpack_from("<BBH", data, i + 2)
+        if length > MAX_FRAME:
+            stats[3] += 1
+            i += 6
+            continue
+        end = i + 6 + length + 2
+        if end > n:
+            break
+        a = b = 0
+        for c in data[i + 2:i + 6 + length]:
+            a = (a + c) & 0xFF
+            b = (b + a) & 0xFF
+        p = data[i + 6:i + 6 + length]
+        ck = data[end - 2:end]
+        i = end
+        if length > MAX_PAYLOAD:
+            stats[2] += 1
+            continue
+        if (a, b) != (ck[0], ck[1]):
+            stats[1] += 1
+            continue
+        stats[0] += 1
+        if cls == 0x01 and mid == 0x07 and length >= 84:
+            f = struct.unpack_from("<IHBBBBBBIiBBBBiiiiIIiiiiiIIH", p)
+            (tow, year, month, day, hour, mi, sec, valid, _, nano, fix, flags, _, num_sv, lon, lat,
+             height, hmsl, hacc, vacc, vn, ve, vd, gs, head, sacc, headacc, pdop) = f
+            out.append("PVT %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d" % (
+                tow, year, month, day, hour, mi, sec, valid, nano, fix, flags, num_sv, lon, lat, height,
+                hmsl, hacc, vacc, vn, ve, vd, gs, head, sacc, headacc, pdop))
+            d.set_fix(fix, flags, num_sv)
+            d.lat, d.lon = lat, lon
+            d.alt, d.hacc, d.vacc, d.pdop = hmsl * 0.001, hacc * 0.001, vacc * 0.001, pdop * 0.01
+            d.set_speed(gs, head, sacc)
+            if valid & 1:
+                d.date = "%02d%02d%02d" % (day % 32, month % 13, year % 100)
+            if valid & 2:
+                cs = (nano // 10000000) % 100 if nano > 0 else 0
+                d.time = "%02d%02d%02d.%02d" % (hour % 24, mi % 60, sec % 61, cs)
+            out.append(d.line())
+        elif cls == 0x01 and mid == 0x12 and length >= 36:
+            f = struct.unpack_from("<IiiiIIiII", p)
+            out.append("VELNED %d %d %d %d %d %d %d %d %d" % f)
+            d.set_speed(f[5] * 10, f[6], f[7] * 10)
+            out.append(d.line())
+        elif cls == 0x01 and mid == 0x06 and length >= 52:
+            tow, = struct.unpack_from("<I", p, 0)
+            fix, flags = p[10], p[11]
+            pacc, = struct.unpack_from("<I", p, 24)
+            sacc, = struct.unpack_from("<I", p, 40)
+            pdop, = struct.unpack_from("<H", p, 44)
+            num_sv = p[47]
+            out.append("SOL %d %d %d %d %d %d %d" % (tow, fix, flags, pacc, sacc, pdop, num_sv))
+            d.set_fix(fix, flags, num_sv)
+            d.hacc, d.pdop = pacc * 0.01, pdop * 0.01
+            out.append(d.line())
+        else:
+            out.append("FRAME %02X %02X %d" % (cls, mid, length))
+    out.append("STATS %d %d %d %d" % tuple(stats))
+    return out
+
+
+def main():
+    d = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    data = capture(random.Random(2026))
+    with open(os.path.join(d, "drive.ubx"), "wb") as f:
+        f.write(data)
+    gold = reference(data)
+    with open(os.path.join(d, "drive.golden"), "w") as f:
+        f.write("\n".join(gold) + "\n")
+    print("drive.ubx: %d bytes, %s" % (len(data), gold[-1]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,243 @@
+// The basemap over a small tileset (test/data/tiles/synthetic_12km.bin, from
+//     python3 tools/build_tile_image.py --synthetic 12 -o test/data/tiles/synthetic_12km.bin
+// a 12 x 12 km street grid with a coastline at zoom 13): the image validates and every tile
+// decodes, and a drive round the grid through tiles::Basemap with the device's cache and budgets
+// reports the hit rate, prefetch use, decode and per-frame times and how full the point pool got
+// (what MAP_TILE_POOL_POINTS is sized from). Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "vector_tiles.hpp"
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "test/data"
+#endif
+// As in map_tiles.h / map_tiles.cpp / main.cpp
+static const int CACHE_SLOTS = 10;
+static const int POOL_POINTS = 6144;
+static const int POOL_FEATURES = 384;
+typedef tiles::Basemap<CACHE_SLOTS, POOL_POINTS, POOL_FEATURES> Map;
+static const int DECODES_PER_FRAME = 2;
+static const float PREFETCH_S = 10.0f;
+static const uint32_t FRAME_MS = 40;
+static const int W = 240;
+static const double LAT0 = 48.137, LON0 = 11.576;   // the tool's default --centre
+
+// Regression gates on the host: decode cost per tile and the basemap's work per frame
+#ifndef TILES_BENCH_MAX_US_PER_DECODE
+#define TILES_BENCH_MAX_US_PER_DECODE 50.0
+#endif
+#ifndef TILES_BENCH_MAX_US_PER_FRAME
+#define TILES_BENCH_MAX_US_PER_FRAME 20.0
+#endif
+
+static std::vector<uint8_t> g_image;
+
+static uint32_t clockUs() {
+    static const auto t0 = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void loadImage() {
+    if (!g_image.empty()) return;
+    FILE* f = fopen((std::string(TEST_DATA_DIR) + "/tiles/synthetic_12km.bin").c_str(), "rb");
+    if (!f) return;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) g_image.insert(g_image.end(), buf, buf + n);
+    fclose(f);
+}
+
+void setUp(void) { loadImage(); }
+void tearDown(void) {}
+
+void test_image_decodes(void) {
+    TEST_ASSERT_TRUE_MESSAGE(!g_image.empty(), "tileset missing (run from the project directory)");
+    TEST_ASSERT_TRUE(tiles::checkImage(g_image.data(), g_image.size(), true));
+    tiles::TileSet set;
+    set.attach(g_image.data());
+    TEST_ASSERT_EQUAL(13, set.zoom());
+    TEST_ASSERT_GREATER_THAN(0, (int)set.count());
+    // Every tile round the centre is either in the set and decodes cleanly, or absent
+    static tiles::TileBuffer buf;
+    tiles::DecodedTile &tile = buf.tile;
+    double fx = tiles::lonToTileX(LON0, 13), fy = tiles::latToTileY(LAT0, 13);
+    uint32_t found = 0, points = 0;
+    for (int dy = -4; dy <= 4; ++dy) {
+        for (int dx = -4; dx <= 4; ++dx) {
+            uint32_t key = tiles::tileKey((uint32_t)(fx + dx), (uint32_t)(fy + dy));
+            const uint8_t* data; size_t len;
+            if (!set.find(key, data, len)) continue;
+            TEST_ASSERT_TRUE(tiles::TileSet::decode(data, len, key, tile));
+            TEST_ASSERT_FALSE(tile.truncated);
+            TEST_ASSERT_GREATER_THAN(0, tile.features);
+            found++;
+            points += tile.points;
+        }
+    }
+    TEST_ASSERT_EQUAL(set.count(), found);
+    // A corrupted byte fails the CRC
+    std::vector<uint8_t> bad = g_image;
+    bad[bad.size() / 2] ^= 0x20;
+    TEST_ASSERT_FALSE(tiles::checkImage(bad.data(), bad.size(), true));
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%u tiles, %u points, %u bytes", found, points, (unsigned)g_image.size());
+    TEST_MESSAGE(msg);
+}
+
+void test_decode_throughput(void) {
+    tiles::TileSet set;
+    set.attach(g_image.data());
+    std::vector<uint32_t> keys;
+    double fx = tiles::lonToTileX(LON0, 13), fy = tiles::latToTileY(LAT0, 13);
+    for (int dy = -4; dy <= 4; ++dy)
+        for (int dx = -4; dx <= 4; ++dx) {
+            uint32_t key = tiles::tileKey((uint32_t)(fx + dx), (uint32_t)(fy + dy));
+            const uint8_t* data; size_t len;
+            if (set.find(key, data, len)) keys.push_back(key);
+        }
+    static tiles::TileBuffer buf;
+    tiles::DecodedTile &tile = buf.tile;
+    uint64_t decodes = 0, points = 0;
+    double s = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    do {
+        for (uint32_t key : keys) {
+            const uint8_t* data; size_t len;
+            if (!set.find(key, data, len)) continue;
+            tiles::TileSet::decode(data, len, key, tile);
+            points += tile.points;
+        }
+        decodes += keys.size();
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    double us = s * 1e6 / decodes;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "decode: %.2f us per tile (find + decode), %.1f M points/s", us, points / s / 1e6);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(TILES_BENCH_MAX_US_PER_DECODE, us);
+}
+
+// A pool with room for two or three tiles: decoding round the set evicts and compacts on nearly
+// every miss, and every tile handed out must still match a decode of its own
+void test_pool_keeps_tiles_intact(void) {
+    tiles::TileSet set;
+    set.attach(g_image.data());
+    std::vector<uint32_t> keys;
+    double fx = tiles::lonToTileX(LON0, 13), fy = tiles::latToTileY(LAT0, 13);
+    for (int dy = -4; dy <= 4; ++dy)
+        for (int dx = -4; dx <= 4; ++dx) {
+            uint32_t key = tiles::tileKey((uint32_t)(fx + dx), (uint32_t)(fy + dy));
+            const uint8_t* data; size_t len;
+            if (set.find(key, data, len)) keys.push_back(key);
+        }
+    static tiles::TileCache<4, 2048, 128> cache(clockUs);
+    static tiles::TileBuffer ref;
+    const tiles::DecodedTile* held[2];
+    for (size_t i = 0; i < 200; ++i) {
+        // Two tiles per "frame": the next along and one from earlier, both in use together
+        cache.beginFrame();
+        uint32_t k[2] = { keys[i % keys.size()], keys[i * 7 % keys.size()] };
+        for (int j = 0; j < 2; ++j) {
+            held[j] = cache.get(set, k[j], true);
+            TEST_ASSERT_NOT_NULL(held[j]);
+        }
+        for (int j = 0; j < 2; ++j) {
+            const uint8_t* data; size_t len;
+            TEST_ASSERT_TRUE(set.find(k[j], data, len));
+            tiles::TileSet::decode(data, len, k[j], ref.tile);
+            const tiles::DecodedTile &t = *held[j];
+            TEST_ASSERT_EQUAL_UINT32(k[j], t.key);
+            TEST_ASSERT_EQUAL(ref.tile.points, t.points);
+            TEST_ASSERT_EQUAL(ref.tile.features, t.features);
+            TEST_ASSERT_EQUAL_MEMORY(ref.tile.x, t.x, t.points * sizeof(int16_t));
+            TEST_ASSERT_EQUAL_MEMORY(ref.tile.y, t.y, t.points * sizeof(int16_t));
+            TEST_ASSERT_EQUAL_MEMORY(ref.tile.featStart, t.featStart, (t.features + 1) * sizeof(uint16_t));
+            TEST_ASSERT_EQUAL_MEMORY(ref.tile.kind, t.kind, t.features);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, cache.stats().dropped);
+    TEST_ASSERT_LESS_OR_EQUAL(2048, cache.stats().peakPoints);
+}
+
+// renderMap()'s basemap pass without the panel: each point through the tile's affine transform
+static uint32_t transformPoints(const tiles::DecodedTile* const* vis, int n, int &sum) {
+    uint32_t pts = 0;
+    for (int t = 0; t < n; ++t) {
+        const tiles::DecodedTile &tile = *vis[t];
+        float ox = 17.0f, oy = -9.0f, ux = 0.03f, uy = 0.01f, vx = -0.01f, vy = 0.03f;
+        for (int i = 0; i < tile.points; ++i) {
+            int x = (int)(ox + tile.x[i] * ux + tile.y[i] * vx), y = (int)(oy + tile.x[i] * uy + tile.y[i] * vy);
+            sum += x ^ y;
+        }
+        pts += tile.points;
+    }
+    return pts;
+}
+
+// A lap of a square inside the grid at 'kmh', the view at 'mpp' metres per pixel
+static void drive(double kmh, float mpp) {
+    std::unique_ptr<Map> owner(new Map(clockUs, DECODES_PER_FRAME, PREFETCH_S));
+    Map &map = *owner;
+    map.attach(g_image.data());
+    const double half = 4000.0, lap = 8 * half, mPerFrame = kmh / 3.6 * FRAME_MS / 1000.0;
+    const double dlat = 1.0 / 111320.0, dlon = dlat / cos(LAT0 * M_PI / 180.0);
+    const tiles::DecodedTile* vis[CACHE_SLOTS];
+    double frameUs = 0.0;
+    uint32_t frames = 0, drawn = 0, points = 0;
+    int sum = 0;
+    for (double s = 0.0; s < lap; s += mPerFrame) {
+        // East along the south side, north, west, south
+        int side = (int)(s / (2 * half));
+        double along = fmod(s, 2 * half) - half, e, n;
+        float course;
+        switch (side) {
+            case 0: e = along; n = -half; course = 90.0f; break;
+            case 1: e = half; n = along; course = 0.0f; break;
+            case 2: e = -along; n = half; course = 270.0f; break;
+            default: e = -half; n = -along; course = 180.0f; break;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        int got = map.frame(LAT0 + n * dlat, LON0 + e * dlon, course, (float)kmh, W / 2 * mpp, vis, CACHE_SLOTS);
+        points += transformPoints(vis, got, sum);
+        frameUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        drawn += got;
+        frames++;
+    }
+    const Map::Cache::Stats &cs = map.cacheStats();
+    const Map::FrameStats &fs = map.frameStats();
+    uint32_t lookups = cs.hits + cs.misses;
+    uint32_t decodes = cs.misses + cs.prefetched;
+    char msg[320];
+    snprintf(msg, sizeof(msg), "%3.0f km/h at %2.0f m/px: %u frames, hit rate %.2f %% (%u misses), %u prefetched (%u used), "
+             "%u deferred, %u dropped, decode avg %.0f max %u us, %.0f tiles and %.0f points/frame, pool peak %u/%d points "
+             "%u/%d features, %.2f us/frame (check %d)",
+             kmh, mpp, frames, 100.0 * cs.hits / lookups, cs.misses, cs.prefetched, cs.prefetchHits, fs.deferred, cs.dropped,
+             decodes ? (double)cs.decodeTotalUs / decodes : 0.0, cs.decodeMaxUs, (double)drawn / frames, (double)points / frames,
+             cs.peakPoints, POOL_POINTS, cs.peakFeatures, POOL_FEATURES, frameUs / frames, sum & 0xFF);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(fs.frames, frames);
+    TEST_ASSERT_EQUAL(0, cs.errors);
+    TEST_ASSERT_EQUAL(0, fs.overflow);
+    TEST_ASSERT_EQUAL(0, cs.dropped);
+    // Each tile is decoded about once per pass, so nearly every lookup is a hit
+    TEST_ASSERT_GREATER_THAN(99.0, 100.0 * cs.hits / lookups);
+    TEST_ASSERT_LESS_THAN(TILES_BENCH_MAX_US_PER_FRAME, frameUs / frames);
+}
+
+void test_drive_city_zoom(void) { drive(50.0, 5.0f); }
+void test_drive_widest_zoom(void) { drive(130.0, 20.0f); }   // MAP_BASEMAP_MAX_MPP
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_image_decodes);
+    RUN_TEST(test_decode_throughput);
+    RUN_TEST(test_pool_keeps_tiles_intact);
+    RUN_TEST(test_drive_city_zoom);
+    RUN_TEST(test_drive_widest_zoom);
+    return UNITY_END();
+}
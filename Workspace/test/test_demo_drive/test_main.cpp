@@ -0,0 +1,139 @@
+// Host run of the DEMO_MODE drive generator (include/demo_drive.hpp): the same seed gives the
+// same bytes, every epoch parses cleanly and follows the script, NmeaSource paces epochs off its
+// clock, and generation throughput is reported. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "demo_drive.hpp"
+#include "nmea_parser.hpp"
+
+static const uint32_t EPOCH_MS = 100;   // 10 Hz, the firmware's demo rate
+
+static uint32_t lapMs() {
+    uint32_t ms = 0;
+    for (size_t i = 0; i < demo::DEFAULT_DRIVE_LEN; ++i) ms += demo::DEFAULT_DRIVE[i].durationMs;
+    return ms;
+}
+
+static std::string generate(uint32_t seed, uint32_t durationMs) {
+    demo::DriveGenerator gen(demo::DEFAULT_DRIVE, demo::DEFAULT_DRIVE_LEN, seed);
+    std::string out;
+    char buf[demo::DRIVE_EPOCH_MAX];
+    for (uint32_t t = 0; t < durationMs; t += EPOCH_MS) {
+        gen.step(EPOCH_MS);
+        size_t n = gen.nmea(buf, sizeof(buf), gen.state().tMs % 1000 < EPOCH_MS);
+        out.append(buf, n);
+    }
+    return out;
+}
+
+struct DriveCheck {
+    float trueKmh = 0.0f;
+    uint32_t gga = 0, rmcActive = 0, rmcVoid = 0, gsv = 0;
+    float maxSpeedErrKmh = 0.0f;
+
+    void onSentence(const nmea::Gga &) { gga++; }
+    void onSentence(const nmea::Gsv &) { gsv++; }
+    void onSentence(const nmea::Rmc &s) {
+        if (!s.active) { rmcVoid++; return; }
+        rmcActive++;
+        float err = fabsf(s.speedKnots * 1.852f - trueKmh);
+        if (err > maxSpeedErrKmh) maxSpeedErrKmh = err;
+    }
+};
+
+static uint32_t g_nowMs = 0;
+static uint32_t fakeClock() { return g_nowMs; }
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_same_seed_same_bytes(void) {
+    std::string a = generate(1, lapMs()), b = generate(1, lapMs()), c = generate(2, lapMs());
+    TEST_ASSERT_GREATER_THAN(100000, (uint32_t)a.size());
+    TEST_ASSERT_TRUE(a == b);
+    TEST_ASSERT_FALSE(a == c);
+}
+
+void test_lap_parses_and_follows_script(void) {
+    demo::DriveGenerator gen;
+    nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsv> parser;
+    DriveCheck chk;
+    char buf[demo::DRIVE_EPOCH_MAX];
+    float maxKmh = 0.0f;
+    uint32_t epochs = lapMs() / EPOCH_MS;
+    for (uint32_t k = 0; k < epochs; ++k) {
+        gen.step(EPOCH_MS);
+        size_t n = gen.nmea(buf, sizeof(buf), gen.state().tMs % 1000 < EPOCH_MS);
+        TEST_ASSERT_GREATER_THAN(0, (uint32_t)n);
+        chk.trueKmh = gen.state().speedKmh;
+        if (chk.trueKmh > maxKmh) maxKmh = chk.trueKmh;
+        for (size_t i = 0; i < n; ++i) parser.feed(buf[i], chk);
+    }
+    const nmea::Stats &st = parser.stats();
+    TEST_ASSERT_EQUAL(0, st.checksumErrors);
+    TEST_ASSERT_EQUAL(0, st.overflows);
+    TEST_ASSERT_EQUAL(0, st.unknownSentences);
+    TEST_ASSERT_EQUAL(epochs, chk.gga);
+    TEST_ASSERT_EQUAL(epochs, chk.rmcActive + chk.rmcVoid);
+    TEST_ASSERT_EQUAL(6000 / EPOCH_MS, chk.rmcVoid);           // the tunnel
+    TEST_ASSERT_GREATER_OR_EQUAL(lapMs() / 1000 * 3, chk.gsv);  // a 3-4 message cycle per second
+    TEST_ASSERT_LESS_THAN(1.5f, chk.maxSpeedErrKmh);            // jitter only, ~0.15 km/h 1-sigma
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 180.0, maxKmh);
+    TEST_ASSERT_EQUAL(0, (uint32_t)gen.phase());                // the lap wrapped
+}
+
+void test_source_paces_epochs_off_clock(void) {
+    demo::DriveGenerator gen;
+    g_nowMs = 5000;
+    demo::NmeaSource src(gen, 10, fakeClock);
+    uint8_t buf[4096];
+    TEST_ASSERT_EQUAL(100, src.periodMs());
+    TEST_ASSERT_TRUE(src.due());
+    src.read(buf, sizeof(buf));                 // the epoch at the start time
+    TEST_ASSERT_FALSE(src.due());
+    TEST_ASSERT_EQUAL(0, src.available());
+    g_nowMs += 99;
+    TEST_ASSERT_EQUAL(0, src.available());
+    g_nowMs += 1;
+    TEST_ASSERT_GREATER_THAN(0, src.available());
+    src.read(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(200, gen.state().tMs);
+    // A stalled reader gets the backlog as a burst, a buffer at a time, not a gap
+    g_nowMs += 1000;
+    while (src.available() > 0) src.read(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(1200, gen.state().tMs);
+    src.restart();
+    TEST_ASSERT_TRUE(src.due());
+}
+
+void test_generation_throughput(void) {
+    demo::DriveGenerator gen;
+    char buf[demo::DRIVE_EPOCH_MAX];
+    uint64_t bytes = 0, epochs = 0;
+    double s = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    do {
+        for (int k = 0; k < 1000; ++k, ++epochs) {
+            gen.step(EPOCH_MS);
+            bytes += gen.nmea(buf, sizeof(buf), gen.state().tMs % 1000 < EPOCH_MS);
+        }
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%.0f epochs/s, %.1f ns/byte (%.0fx real time at 10 Hz)",
+             epochs / s, s * 1e9 / bytes, epochs / s / 10.0);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(1000, (uint32_t)(epochs / s));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_same_bytes);
+    RUN_TEST(test_lap_parses_and_follows_script);
+    RUN_TEST(test_source_paces_epochs_off_clock);
+    RUN_TEST(test_generation_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,278 @@
+// Gate file parsing and nav::LapTimer (include/lap_timer.hpp): laps of a circuit with two
+// splits, each lap at its own pace, against the exact crossing times of the simulated motion
+// (lap and split times, their deltas to the best lap, the latest delta); and the per-fix cost,
+// where with the same gates around the car a file of 10k segments must cost no more per fix than
+// one of 100. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "lap_timer.hpp"
+
+// Largest lap/split time error against the simulated truth
+#ifndef LAP_MAX_ERR_MS
+#define LAP_MAX_ERR_MS 5
+#endif
+
+static const double LAT0 = 48.137154, LON0 = 11.576124;
+static const double M_PER_DEG = 111320.0;
+static const int SEGS_PER_ROAD = 100;     // 200 m apart along each east-west road
+static const float ROAD_PITCH_M = 200.0f;
+
+static const size_t BENCH_GATES = 20000, BENCH_REFS = 40000;
+static lap::LapTimer<BENCH_GATES, BENCH_REFS> g_timer;
+
+static int32_t latE7(double n) { return (int32_t)lround((LAT0 + n / M_PER_DEG) * 1e7); }
+static int32_t lonE7(double e) { return (int32_t)lround((LON0 + e / (M_PER_DEG * cos(LAT0 * M_PI / 180.0))) * 1e7); }
+
+// A 20 m gate across an east-west road at (e, n), crossed left (north) to right going east
+static lap::Gate gateAt(double e, double n, lap::GateKind kind, uint16_t id) {
+    lap::Gate g;
+    g.lat1E7 = latE7(n + 10.0); g.lon1E7 = lonE7(e);
+    g.lat2E7 = latE7(n - 10.0); g.lon2E7 = lonE7(e);
+    g.kind = kind; g.id = id;
+    return g;
+}
+
+// 'segments' start/end pairs, 140 m long, SEGS_PER_ROAD to a road, roads stacked north
+static void buildSegments(int segments) {
+    lap::GateGrid<BENCH_GATES, BENCH_REFS> &grid = g_timer.grid();
+    grid.clear();
+    for (int i = 0; i < segments; ++i) {
+        double n = (i / SEGS_PER_ROAD) * ROAD_PITCH_M, e = (i % SEGS_PER_ROAD) * 200.0 + 10.0;
+        TEST_ASSERT_TRUE(grid.add(gateAt(e, n, lap::GATE_SEGMENT_START, (uint16_t)i)));
+        TEST_ASSERT_TRUE(grid.add(gateAt(e + 140.0, n, lap::GATE_SEGMENT_END, (uint16_t)i)));
+    }
+    TEST_ASSERT_TRUE(grid.build());
+    g_timer.reset();
+}
+
+// Drive the first road east at 72 km/h, 10 Hz; returns the segment times seen
+static uint32_t driveRoad(uint32_t &tMs, uint32_t &timed) {
+    uint32_t fixes = 0;
+    for (double e = -20.0; e < SEGS_PER_ROAD * 200.0; e += 2.0, tMs += 100, ++fixes) {
+        int n = g_timer.update(tMs, latE7(0.3), lonE7(e));
+        for (int i = 0; i < n; ++i) {
+            const lap::LapEvent &ev = g_timer.event(i);
+            if (ev.kind == lap::GATE_SEGMENT_END && ev.hasTime) {
+                timed++;
+                TEST_ASSERT_UINT32_WITHIN(20, 7000, ev.timeMs);
+            }
+        }
+    }
+    return fixes;
+}
+
+static double nsPerFix(int segments) {
+    buildSegments(segments);
+    uint32_t tMs = 1000, timed = 0;
+    uint64_t fixes = 0;
+    double s = 0.0;
+    int passes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    do {
+        fixes += driveRoad(tMs, timed);
+        tMs += 10000;                  // a gap between passes: no crossing inferred across it
+        passes++;
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    TEST_ASSERT_EQUAL((uint32_t)(passes * (segments < SEGS_PER_ROAD ? segments : SEGS_PER_ROAD)), timed);
+    char msg[120];
+    snprintf(msg, sizeof(msg), "%5d segments: %u cells, %u refs, %.0f ns/fix",
+             segments, (unsigned)g_timer.grid().cells(), (unsigned)g_timer.grid().refs(), s * 1e9 / fixes);
+    TEST_MESSAGE(msg);
+    return s * 1e9 / fixes;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_parse_gate_lines(void) {
+    lap::Gate g;
+    TEST_ASSERT_TRUE(lap::parseGateLine("L,0,48.1,11.5,48.2,11.6\n", g));
+    TEST_ASSERT_EQUAL(lap::GATE_START_FINISH, g.kind);
+    TEST_ASSERT_TRUE(lap::parseGateLine("  S,7,-33.9,151.2,-33.91,151.21", g));
+    TEST_ASSERT_EQUAL(7, g.id);
+    TEST_ASSERT_EQUAL(-339000000, g.lat1E7);
+    TEST_ASSERT_FALSE(lap::parseGateLine("# comment", g));
+    TEST_ASSERT_FALSE(lap::parseGateLine("X,1,48.1,11.5,48.2,11.6", g));
+    TEST_ASSERT_FALSE(lap::parseGateLine("S,1,48.1,11.5,48.2", g));
+    TEST_ASSERT_FALSE(lap::parseGateLine("S,1,98.1,11.5,48.2,11.6", g));
+    TEST_ASSERT_FALSE(lap::parseGateLine("E,65536,48.1,11.5,48.2,11.6", g));
+}
+
+// Segment ids the timer has no state for are rejected, not silently never timed
+void test_segment_ids_above_capacity_rejected(void) {
+    lap::Gate g;
+    TEST_ASSERT_TRUE(lap::parseGateLine("S,511,48.1,11.5,48.2,11.6", g, 512));
+    TEST_ASSERT_FALSE(lap::parseGateLine("S,512,48.1,11.5,48.2,11.6", g, 512));
+    TEST_ASSERT_FALSE(lap::parseGateLine("E,4000,48.1,11.5,48.2,11.6", g, 512));
+    // Start/finish and split ids index nothing
+    TEST_ASSERT_TRUE(lap::parseGateLine("L,4000,48.1,11.5,48.2,11.6", g, 512));
+    TEST_ASSERT_TRUE(lap::parseGateLine("P,4000,48.1,11.5,48.2,11.6", g, 512));
+}
+
+void test_wrong_way_and_gap_not_timed(void) {
+    buildSegments(1);
+    uint32_t tMs = 1000;
+    // West through the segment: both gates crossed right to left
+    for (double e = 200.0; e > -20.0; e -= 2.0, tMs += 100) TEST_ASSERT_EQUAL(0, g_timer.update(tMs, latE7(0.0), lonE7(e)));
+    // East, but the fix jumps over the start gate after a 5 s gap: the end has no start
+    g_timer.update(tMs, latE7(0.0), lonE7(0.0));
+    tMs += 5000;
+    int events = 0;
+    for (double e = 20.0; e < 200.0; e += 2.0, tMs += 100) {
+        int n = g_timer.update(tMs, latE7(0.0), lonE7(e));
+        for (int i = 0; i < n; ++i) { events++; TEST_ASSERT_FALSE(g_timer.event(i).hasTime); }
+    }
+    TEST_ASSERT_EQUAL(1, events);
+}
+
+// A circle of CIRCUIT_R_M metres driven anticlockwise: start/finish at angle 0, splits at a third
+// and two thirds. Each gate is 20 m across the track, inner end first (on the left).
+static const double CIRCUIT_R_M = 300.0;
+static const int CIRCUIT_GATES = 3;
+
+static void buildCircuit() {
+    lap::GateGrid<BENCH_GATES, BENCH_REFS> &grid = g_timer.grid();
+    grid.clear();
+    for (int i = 0; i < CIRCUIT_GATES; ++i) {
+        double a = 2.0 * M_PI * i / CIRCUIT_GATES, c = cos(a), s = sin(a);
+        lap::Gate g;
+        g.lat1E7 = latE7((CIRCUIT_R_M - 10.0) * s); g.lon1E7 = lonE7((CIRCUIT_R_M - 10.0) * c);
+        g.lat2E7 = latE7((CIRCUIT_R_M + 10.0) * s); g.lon2E7 = lonE7((CIRCUIT_R_M + 10.0) * c);
+        g.kind = i ? lap::GATE_SPLIT : lap::GATE_START_FINISH;
+        g.id = (uint16_t)i;
+        TEST_ASSERT_TRUE(grid.add(g));
+    }
+    TEST_ASSERT_TRUE(grid.build());
+    g_timer.reset();
+}
+
+// Pace of each lap in each sector (a multiplier on the base speed). Lap 2 is the slowest, lap 3
+// the best; lap 4 is quicker than lap 3 through the first split and loses it all after.
+static const double PACE[][CIRCUIT_GATES] = {
+    { 1.00, 1.00, 1.00 },
+    { 0.96, 0.97, 0.95 },
+    { 1.04, 1.03, 1.05 },
+    { 1.07, 1.00, 0.92 },
+};
+static const int LAPS = sizeof(PACE) / sizeof(PACE[0]);
+
+struct Crossing { int gate; double tMs; };
+
+// What the timer should report at each crossing, from the truth: times into the lap and the
+// deltas to the best lap so far (its lap time, and its splits as they were when it was set)
+struct Expected { lap::GateKind kind; bool hasTime, hasDelta; double tMs, timeMs, deltaMs; };
+
+static std::vector<Expected> expectedEvents(const std::vector<Crossing> &truth) {
+    std::vector<Expected> out;
+    double lapStart = -1.0, best = 0.0, splits[CIRCUIT_GATES] = {0}, bestSplits[CIRCUIT_GATES] = {0};
+    for (const Crossing &c : truth) {
+        Expected e = { c.gate ? lap::GATE_SPLIT : lap::GATE_START_FINISH, lapStart >= 0.0, false, c.tMs, 0.0, 0.0 };
+        if (e.hasTime) e.timeMs = c.tMs - lapStart;
+        if (c.gate == 0) {
+            if (e.hasTime) {
+                e.hasDelta = best > 0.0;
+                e.deltaMs = e.timeMs - best;
+                if (!e.hasDelta || e.timeMs < best) { best = e.timeMs; memcpy(bestSplits, splits, sizeof(splits)); }
+            }
+            lapStart = c.tMs;
+        } else if (e.hasTime) {
+            splits[c.gate] = e.timeMs;
+            e.hasDelta = best > 0.0;
+            e.deltaMs = e.timeMs - bestSplits[c.gate];
+        }
+        out.push_back(e);
+    }
+    return out;
+}
+
+void test_laps_and_splits_against_truth(void) {
+    buildCircuit();
+    // 1 ms integration of the angle from a flying start; the base speed (about 110 km/h) swings
+    // through the lap so the motion between fixes is not uniform. Fixes at 10 Hz.
+    const double DT_MS = 1.0, V0 = 30.0, STEP = 2.0 * M_PI / CIRCUIT_GATES;
+    double a = -0.3, tMs = 1000.0;
+    std::vector<Crossing> truth;
+    std::vector<lap::LapEvent> got;
+    std::vector<int32_t> lastDelta;
+    uint32_t nextFix = 1037;
+    while (a < 2.0 * M_PI * LAPS + 0.3) {
+        if (tMs >= nextFix) {
+            int n = g_timer.update(nextFix, latE7(CIRCUIT_R_M * sin(a)), lonE7(CIRCUIT_R_M * cos(a)));
+            for (int i = 0; i < n; ++i) {
+                got.push_back(g_timer.event(i));
+                int32_t d; uint32_t at;
+                if (g_timer.event(i).hasDelta) {
+                    // The latest delta is the last one of this fix's events
+                    TEST_ASSERT_TRUE(g_timer.lastDelta(d, at));
+                    if (i == n - 1) { TEST_ASSERT_EQUAL_INT32(g_timer.event(i).deltaMs, d); TEST_ASSERT_EQUAL_UINT32(g_timer.event(i).tMs, at); }
+                }
+            }
+            nextFix += 100;
+        }
+        int lap = a < 0.0 ? 0 : (int)(a / (2.0 * M_PI));
+        if (lap >= LAPS) lap = LAPS - 1;
+        int sector = a < 0.0 ? CIRCUIT_GATES - 1 : (int)(fmod(a, 2.0 * M_PI) / STEP);
+        double v = V0 * PACE[lap][sector] * (1.0 + 0.25 * cos(3.0 * a));
+        double a1 = a + v / CIRCUIT_R_M * DT_MS / 1000.0;
+        // Gate crossings inside this step, interpolated to the exact time
+        for (double g = floor(a / STEP + 1.0) * STEP; g <= a1; g += STEP)
+            truth.push_back({ (int)lround(g / STEP) % CIRCUIT_GATES, tMs + (g - a) / (a1 - a) * DT_MS });
+        a = a1;
+        tMs += DT_MS;
+    }
+    std::vector<Expected> want = expectedEvents(truth);
+    TEST_ASSERT_EQUAL(LAPS * CIRCUIT_GATES + 1, (int)want.size());
+    TEST_ASSERT_EQUAL(want.size(), got.size());
+    double worstTime = 0.0, worstDelta = 0.0;
+    int faster = 0, slower = 0;
+    for (size_t i = 0; i < want.size(); ++i) {
+        const Expected &w = want[i];
+        const lap::LapEvent &e = got[i];
+        TEST_ASSERT_EQUAL(w.kind, e.kind);
+        TEST_ASSERT_EQUAL(w.hasTime, e.hasTime);
+        TEST_ASSERT_EQUAL(w.hasDelta, e.hasDelta);
+        worstTime = fmax(worstTime, fabs(e.tMs - w.tMs));
+        if (e.hasTime) worstTime = fmax(worstTime, fabs(e.timeMs - w.timeMs));
+        if (!e.hasDelta) continue;
+        worstDelta = fmax(worstDelta, fabs(e.deltaMs - w.deltaMs));
+        if (w.deltaMs < -100.0) faster++;
+        if (w.deltaMs > 100.0) slower++;
+        // Clear of the error bounds, the sign is never wrong
+        if (fabs(w.deltaMs) > 2 * LAP_MAX_ERR_MS) TEST_ASSERT_EQUAL(w.deltaMs < 0.0, e.deltaMs < 0);
+    }
+    // The paces give deltas of both signs, at the line and at splits
+    TEST_ASSERT_GREATER_THAN(2, faster);
+    TEST_ASSERT_GREATER_THAN(2, slower);
+    TEST_ASSERT_EQUAL(LAPS, g_timer.laps());
+    TEST_ASSERT_UINT32_WITHIN(LAP_MAX_ERR_MS, (uint32_t)lround(want.back().timeMs), g_timer.lastLapMs());
+    double best = 0.0;
+    for (const Expected &w : want) if (w.kind == lap::GATE_START_FINISH && w.hasTime && (!best || w.timeMs < best)) best = w.timeMs;
+    TEST_ASSERT_UINT32_WITHIN(LAP_MAX_ERR_MS, (uint32_t)lround(best), g_timer.bestLapMs());
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%d laps, %d splits: worst crossing/lap/split time error %.1f ms, delta error %.1f ms",
+             LAPS, LAPS * (CIRCUIT_GATES - 1), worstTime, worstDelta);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(LAP_MAX_ERR_MS, worstTime);
+    TEST_ASSERT_LESS_THAN(2 * LAP_MAX_ERR_MS, worstDelta);
+}
+
+void test_cost_per_fix_independent_of_segment_count(void) {
+    double small = nsPerFix(100);
+    nsPerFix(1000);
+    double large = nsPerFix(10000);
+    TEST_ASSERT_LESS_THAN(2.0 * small + 50.0, large);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_gate_lines);
+    RUN_TEST(test_segment_ids_above_capacity_rejected);
+    RUN_TEST(test_wrong_way_and_gap_not_timed);
+    RUN_TEST(test_laps_and_splits_against_truth);
+    RUN_TEST(test_cost_per_fix_independent_of_segment_count);
+    return UNITY_END();
+}
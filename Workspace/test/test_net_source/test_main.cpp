@@ -0,0 +1,438 @@
+// NMEA over the network (include/net_source.hpp) fed by a UDP/TCP feeder thread on localhost,
+// drained and arbitrated the way gps_module does it (include/source_arbiter.hpp): sentences
+// split across TCP sends at arbitrary bytes parse exactly as the same bytes from memory,
+// datagrams are counted (and truncated or ignored ones too), the per-source byte, drop and
+// latency counters add up, and the arbiter moves to the network feed on a better fix only after
+// the hold time and back at once when it goes stale or loses its fix. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "byte_source.hpp"
+#include "nmea_parser.hpp"
+#include "source_arbiter.hpp"
+#ifdef __unix__
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "net_source.hpp"
+#endif
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "test/data"
+#endif
+#ifndef NET_TEST_PORT
+#define NET_TEST_PORT 47110
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static const size_t DRAIN_CHUNK = 512;     // GPS_DRAIN_CHUNK default
+static const int SRC_UART = 0, SRC_NET = 1;
+
+typedef nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsv, nmea::Gsa, nmea::Gst, nmea::Vtg> AppParser;
+
+static std::string readFile(const std::string &path, size_t max) {
+    std::string d;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return d;
+    int c;
+    while (d.size() < max && (c = fgetc(f)) != EOF) d += (char)c;
+    fclose(f);
+    size_t eol = d.rfind('\n');
+    if (d.size() == max && eol != std::string::npos) d.resize(eol + 1); // whole lines only
+    return d;
+}
+
+static std::string sentence(const char* body) {
+    uint8_t c = 0;
+    for (const char* p = body; *p; ++p) c ^= (uint8_t)*p;
+    char out[128];
+    snprintf(out, sizeof(out), "$%s*%02X\r\n", body, c);
+    return out;
+}
+
+// GGA + RMC of a parked receiver at 'tMs' with the given GGA quality (0 = no fix, RMC void)
+static std::string epoch(uint32_t tMs, int quality) {
+    char t[16], body[128];
+    snprintf(t, sizeof(t), "%02u%02u%02u.%02u", 10u, (unsigned)(tMs / 60000 % 60), (unsigned)(tMs / 1000 % 60), (unsigned)(tMs % 1000 / 10));
+    snprintf(body, sizeof(body), "GPGGA,%s,4808.22949,N,01134.56730,E,%d,12,0.8,519.1,M,47.0,M,,", t, quality);
+    std::string s = sentence(body);
+    snprintf(body, sizeof(body), "GPRMC,%s,%c,4808.22949,N,01134.56730,E,0.0,0.0,161026,,,A", t, quality ? 'A' : 'V');
+    return s + sentence(body);
+}
+
+// One source as gps_module drains it: its own parser, arbitration notes from the sink (AppSink)
+// and the byte and latency counters of drainSource()
+struct Channel {
+    int src;
+    gnss::SourceArbiter* arbiter;
+    AppParser parser;
+    uint32_t nowMs = 0, bytes = 0, reads = 0;
+    uint64_t latencySumUs = 0;
+    uint32_t latencyCount = 0, latencyMaxUs = 0;
+
+    Channel(int s, gnss::SourceArbiter* a) : src(s), arbiter(a) {}
+
+    void onSentence(const nmea::Gga &s) { arbiter->noteFix(src, (uint8_t)s.fixQuality, nowMs); take(); }
+    void onSentence(const nmea::Rmc &s) {
+        uint8_t q = arbiter->quality(src);
+        arbiter->noteFix(src, s.active ? (q ? q : 1) : 0, nowMs);
+        take();
+    }
+    void onSentence(const nmea::Gsa &s) { if (s.fixMode == 1) arbiter->noteFix(src, 0, nowMs); take(); }
+    void onSentence(const nmea::Gsv &) { take(); }
+    void onSentence(const nmea::Gst &) { take(); }
+    void onSentence(const nmea::Vtg &) { take(); }
+    void take() { arbiter->noteData(src, nowMs); }
+
+    static uint32_t micros() {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    size_t drain(io::ByteSource &in, uint32_t ms) {
+        nowMs = ms;
+        uint8_t buf[DRAIN_CHUNK];
+        size_t n, total = 0;
+        uint32_t arrivalUs = micros();
+        while ((n = in.read(buf, sizeof(buf))) > 0) {
+            reads++;
+            for (size_t i = 0; i < n; ++i) parser.feed((char)buf[i], *this);
+            total += n;
+        }
+        if (total) {
+            uint32_t latency = micros() - arrivalUs;
+            bytes += (uint32_t)total;
+            if (latency > latencyMaxUs) latencyMaxUs = latency;
+            latencySumUs += latency; latencyCount++;
+        }
+        return total;
+    }
+
+    uint32_t drops() const { return parser.stats().checksumErrors + parser.stats().overflows; }
+    uint32_t latencyAvgUs() const { return latencyCount ? (uint32_t)(latencySumUs / latencyCount) : 0; }
+};
+
+// The same bytes straight from memory, for comparison
+static nmea::Stats reference(const std::string &data) {
+    gnss::SourceArbiter arb;
+    Channel ch(SRC_UART, &arb);
+    io::MemorySource mem(data.data(), data.size());
+    ch.drain(mem, 0);
+    return ch.parser.stats();
+}
+
+static void assertSameStats(const nmea::Stats &want, const nmea::Stats &got) {
+    TEST_ASSERT_EQUAL(want.sentences, got.sentences);
+    TEST_ASSERT_EQUAL(want.checksumErrors, got.checksumErrors);
+    TEST_ASSERT_EQUAL(want.overflows, got.overflows);
+    TEST_ASSERT_EQUAL(want.unknownSentences, got.unknownSentences);
+}
+
+#ifdef __unix__
+
+// Sends on its own thread what the test queues: UDP datagrams, or a TCP stream cut into sends of
+// 1..maxChunk bytes with Nagle off, so sentences cross segment boundaries anywhere
+class Feeder {
+public:
+    void start() { _stop = false; _thread = std::thread(&Feeder::run, this); }
+
+    void stop() {
+        { std::lock_guard<std::mutex> l(_mu); _stop = true; }
+        _cv.notify_all();
+        if (_thread.joinable()) _thread.join();
+        closeTcp();
+    }
+
+    void udp(const std::string &bytes) { post(Job{ UDP, bytes, 0 }); }
+    void connect() { post(Job{ CONNECT, std::string(), 0 }); }
+    void tcp(const std::string &bytes, size_t maxChunk) { post(Job{ TCP, bytes, maxChunk }); }
+    void disconnect() { post(Job{ DISCONNECT, std::string(), 0 }); }
+
+    // Block until everything queued has been sent
+    void wait() {
+        std::unique_lock<std::mutex> l(_mu);
+        _cv.wait(l, [this] { return _jobs.empty() && !_busy; });
+    }
+
+    uint32_t sends() { std::lock_guard<std::mutex> l(_mu); return _sends; }
+
+private:
+    enum Kind { UDP, CONNECT, TCP, DISCONNECT };
+    struct Job { Kind kind; std::string bytes; size_t maxChunk; };
+
+    void post(const Job &j) {
+        { std::lock_guard<std::mutex> l(_mu); _jobs.push_back(j); }
+        _cv.notify_all();
+    }
+
+    void run() {
+        for (;;) {
+            Job j;
+            {
+                std::unique_lock<std::mutex> l(_mu);
+                _cv.wait(l, [this] { return _stop || !_jobs.empty(); });
+                if (_stop) return;
+                j = _jobs.front();
+                _jobs.pop_front();
+                _busy = true;
+            }
+            uint32_t sends = execute(j);
+            {
+                std::lock_guard<std::mutex> l(_mu);
+                _sends += sends;
+                _busy = false;
+            }
+            _cv.notify_all();
+        }
+    }
+
+    static sockaddr_in target() {
+        sockaddr_in a;
+        memset(&a, 0, sizeof(a));
+        a.sin_family = AF_INET;
+        a.sin_port = htons(NET_TEST_PORT);
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return a;
+    }
+
+    uint32_t execute(const Job &j) {
+        sockaddr_in a = target();
+        switch (j.kind) {
+            case UDP: {
+                int fd = socket(AF_INET, SOCK_DGRAM, 0);
+                sendto(fd, j.bytes.data(), j.bytes.size(), 0, (sockaddr*)&a, sizeof(a));
+                ::close(fd);
+                return 1;
+            }
+            case CONNECT: {
+                closeTcp();
+                _tcp = socket(AF_INET, SOCK_STREAM, 0);
+                int one = 1;
+                setsockopt(_tcp, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                if (::connect(_tcp, (sockaddr*)&a, sizeof(a)) != 0) closeTcp();
+                return 0;
+            }
+            case TCP: {
+                uint32_t sends = 0;
+                for (size_t at = 0; _tcp >= 0 && at < j.bytes.size(); sends++) {
+                    _rng ^= _rng << 13; _rng ^= _rng >> 17; _rng ^= _rng << 5;
+                    size_t n = 1 + _rng % j.maxChunk;
+                    if (n > j.bytes.size() - at) n = j.bytes.size() - at;
+                    ssize_t sent = send(_tcp, j.bytes.data() + at, n, MSG_NOSIGNAL);
+                    if (sent <= 0) break;
+                    at += (size_t)sent;
+                    if (sends % 8 == 7) usleep(50); // let some sends arrive on their own
+                }
+                return sends;
+            }
+            case DISCONNECT: closeTcp(); return 0;
+        }
+        return 0;
+    }
+
+    void closeTcp() { if (_tcp >= 0) ::close(_tcp); _tcp = -1; }
+
+    std::thread _thread;
+    std::mutex _mu;
+    std::condition_variable _cv;
+    std::deque<Job> _jobs;
+    bool _stop = false, _busy = false;
+    int _tcp = -1;
+    uint32_t _rng = 2463534242u;
+    uint32_t _sends = 0;
+};
+
+static io::NetSource* g_net = nullptr;
+static Feeder g_feeder;
+
+// Drain 'ch' from the network source until 'want' bytes have come in (or 2 s pass)
+static bool drainUntil(Channel &ch, uint32_t want, uint32_t nowMs) {
+    for (int i = 0; i < 2000 && ch.bytes < want; ++i) {
+        if (!ch.drain(*g_net, nowMs)) usleep(1000);
+    }
+    return ch.bytes >= want;
+}
+
+void setUp(void) {
+    g_net = new io::NetSource(NET_TEST_PORT);
+    if (!g_net->begin()) { delete g_net; g_net = nullptr; return; }
+    g_feeder.start();
+}
+
+void tearDown(void) {
+    g_feeder.stop();
+    delete g_net;
+    g_net = nullptr;
+}
+
+#define REQUIRE_NET() if (!g_net) TEST_IGNORE_MESSAGE("could not bind the NMEA-over-IP test port")
+
+// A recorded 10 Hz log over TCP in sends of 1..40 bytes parses exactly as from memory
+void test_tcp_split_sends(void) {
+    REQUIRE_NET();
+    std::string log = readFile(std::string(TEST_DATA_DIR) + "/nmea/multi_gnss.nmea", 16384);
+    TEST_ASSERT_TRUE_MESSAGE(!log.empty(), "multi_gnss.nmea missing (run from the project directory)");
+    gnss::SourceArbiter arb;
+    Channel net(SRC_NET, &arb);
+    g_feeder.connect();
+    g_feeder.tcp(log, 40);
+    TEST_ASSERT_TRUE(drainUntil(net, (uint32_t)log.size(), 0)); // read while it is being sent
+    g_feeder.wait();
+    assertSameStats(reference(log), net.parser.stats());
+    TEST_ASSERT_EQUAL(0, net.drops());
+    TEST_ASSERT_EQUAL(log.size(), g_net->stats().bytes);
+    TEST_ASSERT_EQUAL(1, g_net->stats().connections);
+    TEST_ASSERT_TRUE(g_net->connected());
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%u bytes in %u sends, %u reads, %u sentences", (unsigned)log.size(), g_feeder.sends(), net.reads, net.parser.stats().sentences);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(10, net.reads); // the stream really arrived in pieces
+    // The client going away is noticed on the next read
+    g_feeder.disconnect();
+    g_feeder.wait();
+    for (int i = 0; i < 200 && g_net->connected(); ++i) { net.drain(*g_net, 0); usleep(1000); }
+    TEST_ASSERT_FALSE(g_net->connected());
+    TEST_ASSERT_EQUAL(1, g_net->stats().disconnects);
+}
+
+// One epoch per datagram; an oversize datagram counts as truncated, and while a TCP client
+// feeds, datagrams are drained and ignored rather than interleaved
+void test_udp_datagrams(void) {
+    REQUIRE_NET();
+    gnss::SourceArbiter arb;
+    Channel net(SRC_NET, &arb);
+    std::string all;
+    for (uint32_t k = 0; k < 20; ++k) {
+        std::string e = epoch(k * 100, 1);
+        g_feeder.udp(e);
+        all += e;
+    }
+    g_feeder.wait();
+    TEST_ASSERT_TRUE(drainUntil(net, (uint32_t)all.size(), 0));
+    TEST_ASSERT_EQUAL(20, g_net->stats().datagrams);
+    TEST_ASSERT_EQUAL(40, net.parser.stats().sentences);
+    TEST_ASSERT_EQUAL(0, g_net->stats().truncated);
+
+    std::string big;
+    while (big.size() < DRAIN_CHUNK + 100) big += epoch(5000, 1);
+    g_feeder.udp(big);
+    g_feeder.wait();
+    TEST_ASSERT_TRUE(drainUntil(net, (uint32_t)(all.size() + DRAIN_CHUNK), 0));
+    TEST_ASSERT_EQUAL(1, g_net->stats().truncated);
+
+    g_feeder.connect();
+    g_feeder.tcp(epoch(6000, 1), 16);
+    g_feeder.wait();
+    uint32_t before = net.bytes;
+    TEST_ASSERT_TRUE(drainUntil(net, before + (uint32_t)epoch(6000, 1).size(), 0));
+    for (int k = 0; k < 5; ++k) g_feeder.udp(epoch(7000, 1));
+    g_feeder.wait();
+    usleep(20000);
+    net.drain(*g_net, 0);
+    TEST_ASSERT_EQUAL(5, g_net->stats().ignored);
+    TEST_ASSERT_EQUAL(before + epoch(6000, 1).size(), net.bytes);
+}
+
+// Per-source counters: the receiver log is clean, the network feed carries the damage of
+// corrupted.nmea, and each source's drops are its own parser's rejections
+void test_source_counters(void) {
+    REQUIRE_NET();
+    std::string clean = readFile(std::string(TEST_DATA_DIR) + "/nmea/multi_gnss.nmea", 24576);
+    std::string damaged = readFile(std::string(TEST_DATA_DIR) + "/nmea/corrupted.nmea", 24576);
+    TEST_ASSERT_TRUE_MESSAGE(!clean.empty() && !damaged.empty(), "NMEA corpora missing (run from the project directory)");
+    gnss::SourceArbiter arb;
+    Channel uart(SRC_UART, &arb), net(SRC_NET, &arb);
+    io::MemorySource mem(clean.data(), clean.size());
+    g_feeder.connect();
+    g_feeder.tcp(damaged, 64);
+    // Drain both while the feeder is still sending, as the parse task does
+    uint32_t ms = 0;
+    for (int i = 0; i < 4000 && (net.bytes < damaged.size() || !mem.done()); ++i, ms += 1) {
+        uart.drain(mem, ms);
+        if (!net.drain(*g_net, ms)) usleep(500);
+    }
+    g_feeder.wait();
+    TEST_ASSERT_EQUAL(clean.size(), uart.bytes);
+    TEST_ASSERT_EQUAL(damaged.size(), net.bytes);
+    nmea::Stats want = reference(damaged);
+    assertSameStats(want, net.parser.stats());
+    TEST_ASSERT_EQUAL(0, uart.drops());
+    TEST_ASSERT_EQUAL(want.checksumErrors + want.overflows, net.drops());
+    TEST_ASSERT_GREATER_THAN(0, net.drops());
+    char msg[160];
+    snprintf(msg, sizeof(msg), "uart %u B drops %u lat avg %u max %u us | net %u B drops %u lat avg %u max %u us",
+             uart.bytes, uart.drops(), uart.latencyAvgUs(), uart.latencyMaxUs, net.bytes, net.drops(), net.latencyAvgUs(), net.latencyMaxUs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(1, net.latencyCount);
+    TEST_ASSERT_TRUE(net.latencyAvgUs() <= net.latencyMaxUs);
+    TEST_ASSERT_LESS_THAN(100000, net.latencyMaxUs); // one drain call, not a stall
+}
+
+// 10 Hz from both sources in lockstep with a simulated clock. The network feed is a plain GPS fix
+// (a tie: the receiver stays), then RTK (takes over after the hold), then silent (stale: back at
+// once), RTK again, then no fix (back at once).
+void test_arbiter_switching(void) {
+    REQUIRE_NET();
+    gnss::SourceArbiter arb;
+    Channel uart(SRC_UART, &arb), net(SRC_NET, &arb);
+    g_feeder.connect();
+    std::vector<std::pair<uint32_t, int> > switches;
+    int active = arb.active();
+    for (uint32_t t = 0; t <= 36000; t += 100) {
+        std::string u = epoch(t, 1);
+        io::MemorySource mem(u.data(), u.size());
+        uart.drain(mem, t);
+        int q = t < 10000 ? 1 : t < 20000 ? 4 : t < 25000 ? -1 : t < 30000 ? 4 : 0;
+        if (q >= 0) {
+            std::string n = epoch(t, q);
+            g_feeder.tcp(n, 16);
+            g_feeder.wait();
+            TEST_ASSERT_TRUE(drainUntil(net, net.bytes + (uint32_t)n.size(), t));
+        }
+        if (arb.select(t) != active) {
+            active = arb.active();
+            switches.push_back(std::make_pair(t, active));
+        }
+    }
+    TEST_ASSERT_EQUAL(4, (int)switches.size());
+    TEST_ASSERT_EQUAL(4, arb.switches());
+    TEST_ASSERT_EQUAL(10000 + gnss::ARBITER_HOLD_MS, switches[0].first);   // RTK beats GPS, after the hold
+    TEST_ASSERT_EQUAL(SRC_NET, switches[0].second);
+    TEST_ASSERT_EQUAL(19900 + gnss::ARBITER_STALE_MS + 100, switches[1].first); // first epoch past stale
+    TEST_ASSERT_EQUAL(SRC_UART, switches[1].second);
+    TEST_ASSERT_EQUAL(25000 + gnss::ARBITER_HOLD_MS, switches[2].first);
+    TEST_ASSERT_EQUAL(SRC_NET, switches[2].second);
+    TEST_ASSERT_EQUAL(30000, switches[3].first);                            // lost fix: no hold
+    TEST_ASSERT_EQUAL(SRC_UART, switches[3].second);
+    TEST_ASSERT_EQUAL(0, uart.drops() + net.drops());
+}
+
+#else
+
+void setUp(void) {}
+void tearDown(void) {}
+void test_tcp_split_sends(void) { TEST_IGNORE_MESSAGE("needs POSIX sockets"); }
+void test_udp_datagrams(void) { TEST_IGNORE_MESSAGE("needs POSIX sockets"); }
+void test_source_counters(void) { TEST_IGNORE_MESSAGE("needs POSIX sockets"); }
+void test_arbiter_switching(void) { TEST_IGNORE_MESSAGE("needs POSIX sockets"); }
+
+#endif
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tcp_split_sends);
+    RUN_TEST(test_udp_datagrams);
+    RUN_TEST(test_source_counters);
+    RUN_TEST(test_arbiter_switching);
+    return UNITY_END();
+}
@@ -0,0 +1,349 @@
+// Replays the recorded NMEA corpora (test/data/nmea) through io::ByteSource into nmea::Parser,
+// checks every accepted sentence and the parser counters against the golden state written by
+// test/data/nmea/make_corpus.py, and reports parse throughput next to the line-buffer parser it
+// replaced, also with the shared parser cut down to that parser's GGA/RMC/GSV (the instantiation
+// GPSService and the gps_test sketch use), and bounds what gps_module's GSA/GST/VTG cost on top
+// of that. Run with: pio test -e native
+#include <unity.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "byte_source.hpp"
+#include "nmea_parser.hpp"
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "test/data"
+#endif
+// Regression gate: fail when parsing gets this much slower than it is today (host ns per byte)
+#ifndef NMEA_BENCH_MAX_NS_PER_BYTE
+#define NMEA_BENCH_MAX_NS_PER_BYTE 100.0
+#endif
+// Like for like (same three sentences) the shared parser must beat the line buffer by this much
+#ifndef NMEA_BENCH_MIN_SPEEDUP
+#define NMEA_BENCH_MIN_SPEEDUP 1.1
+#endif
+// GSA/GST/VTG on top of GGA/RMC/GSV may cost at most this factor on the 10 Hz multi-GNSS log
+#ifndef NMEA_BENCH_MAX_EXTRA_COST
+#define NMEA_BENCH_MAX_EXTRA_COST 2.0
+#endif
+
+typedef nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsv, nmea::Gsa, nmea::Gst, nmea::Vtg> FullParser;
+typedef nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsv> BasicParser;
+
+static std::vector<uint8_t> readFile(const std::string &path) {
+    std::vector<uint8_t> d;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return d;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) d.insert(d.end(), buf, buf + n);
+    fclose(f);
+    return d;
+}
+
+static std::vector<std::string> readLines(const std::string &path) {
+    std::vector<std::string> lines;
+    std::vector<uint8_t> d = readFile(path);
+    std::string cur;
+    for (uint8_t c : d) {
+        if (c == '\n') { lines.push_back(cur); cur.clear(); }
+        else cur += (char)c;
+    }
+    if (!cur.empty()) lines.push_back(cur);
+    return lines;
+}
+
+// One text line per accepted sentence, in the golden file's format
+struct StateLog {
+    std::vector<std::string> lines;
+
+    void add(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char b[256];
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(b, sizeof(b), fmt, ap);
+        va_end(ap);
+        lines.push_back(b);
+    }
+    static const char* orDash(const char* s) { return *s ? s : "-"; }
+
+    void onSentence(const nmea::Gga &s) { add("GGA %d %d %d %d %.3f %.3f", (int)s.latE7, (int)s.lonE7, s.fixQuality, s.satsUsed, s.hdop, s.altitude); }
+    void onSentence(const nmea::Rmc &s) { add("RMC %s %d %d %d %.3f %.3f %s", orDash(s.timeUTC), (int)s.active, (int)s.latE7, (int)s.lonE7, s.speedKnots, s.courseDeg, orDash(s.date)); }
+    void onSentence(const nmea::Gsa &s) { add("GSA %d %.3f %.3f %.3f", s.fixMode, s.pdop, s.hdop, s.vdop); }
+    void onSentence(const nmea::Gst &s) { add("GST %.3f %.3f %.3f", s.latErrM, s.lonErrM, s.altErrM); }
+    void onSentence(const nmea::Vtg &s) { add("VTG %.3f %.3f %d", s.courseDeg, s.speedKmh, (int)s.valid); }
+    void onSentence(const nmea::Gsv &s) {
+        gnss::SatInfo sats[4];
+        int n = s.satellites(sats);
+        std::string list;
+        for (int i = 0; i < n; ++i) {
+            char b[32];
+            snprintf(b, sizeof(b), "%s%d/%d/%d/%d", i ? "," : "", sats[i].prn, sats[i].elevation, sats[i].azimuth, sats[i].cn0);
+            list += b;
+        }
+        add("GSV %.2s %d %d %d %s", s.talker, s.total, s.index, s.inView, list.empty() ? "-" : list.c_str());
+    }
+};
+
+// Drain a source the way gps_module's parse task does: whatever is available, in UART-sized reads
+template <class Parser, class Sink>
+static void drain(io::ByteSource &src, Parser &parser, Sink &sink) {
+    uint8_t buf[256];
+    while (src.available() > 0) {
+        size_t n = src.read(buf, sizeof(buf));
+        if (!n) break;
+        for (size_t i = 0; i < n; ++i) parser.feed((char)buf[i], sink);
+    }
+}
+
+static void checkCorpus(const char* name) {
+    std::string base = std::string(TEST_DATA_DIR) + "/nmea/" + name;
+    std::vector<uint8_t> data = readFile(base + ".nmea");
+    std::vector<std::string> golden = readLines(base + ".golden");
+    TEST_ASSERT_TRUE_MESSAGE(!data.empty() && !golden.empty(), "corpus missing (run from the project directory)");
+
+    FullParser parser;
+    StateLog state;
+    io::MemorySource mem(data.data(), data.size());
+    drain(mem, parser, state);
+    const nmea::Stats &st = parser.stats();
+    char stats[96];
+    snprintf(stats, sizeof(stats), "STATS %u %u %u %u", st.sentences, st.checksumErrors, st.overflows, st.unknownSentences);
+    state.lines.push_back(stats);
+
+    TEST_ASSERT_EQUAL_MESSAGE(golden.size(), state.lines.size(), name);
+    for (size_t i = 0; i < golden.size(); ++i) {
+        char where[64];
+        snprintf(where, sizeof(where), "%s line %u", name, (unsigned)(i + 1));
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(golden[i].c_str(), state.lines[i].c_str(), where);
+    }
+
+    // The same log through a FileSource parses to the same state
+    FILE* f = fopen((base + ".nmea").c_str(), "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    io::FileSource file(f);
+    FullParser parser2;
+    StateLog state2;
+    drain(file, parser2, state2);
+    fclose(f);
+    state2.lines.push_back(stats);
+    TEST_ASSERT_TRUE_MESSAGE(state2.lines == state.lines, "FileSource and MemorySource disagree");
+}
+
+// Only what a real sink would read, so the benchmark measures the parser and not the formatting
+struct CountingSink {
+    uint32_t sentences = 0;
+    int64_t sum = 0;
+    void onSentence(const nmea::Gga &s) { sentences++; sum += s.latE7; }
+    void onSentence(const nmea::Rmc &s) { sentences++; sum += s.lonE7 + (int)s.speedKnots; }
+    void onSentence(const nmea::Gsa &s) { sentences++; sum += (int)(s.hdop * 100); }
+    void onSentence(const nmea::Gst &s) { sentences++; sum += (int)(s.latErrM * 100); }
+    void onSentence(const nmea::Vtg &s) { sentences++; sum += (int)s.speedKmh; }
+    void onSentence(const nmea::Gsv &s) { gnss::SatInfo sats[4]; sentences++; sum += s.satellites(sats); }
+};
+
+// The parser gps_module.cpp had before the streaming one, copied as it was apart from the
+// GPSData fields it does not touch: a 128-byte line buffer, tokenize() into strchr-split fields,
+// a strncmp chain on the type and atof/atoi on every field. It checks no checksum. Kept as the
+// benchmark baseline.
+namespace baseline {
+
+struct GPSData {
+  bool validFix;
+  int fixQuality, satsUsed, satsInView;
+  float lat, lon, altitude, speedKnots, courseDeg;
+  char timeUTC[12], date[8];
+};
+
+static GPSData g_data = {0};
+static char lineBuf[128];
+static int linePos = 0;
+
+static int tokenize(char* s, const char* tokens[], int maxTok) {
+  int count = 0; char* p = s;
+  while (p && *p && count < maxTok) {
+    tokens[count++] = p;
+    char* comma = strchr(p, ',');
+    if (!comma) break;
+    *comma = '\0';
+    p = comma + 1;
+  }
+  return count;
+}
+
+static float nmeaCoordToDeg(const char* fld) {
+  if (!fld || !*fld) return 0.0f;
+  float v = atof(fld);
+  int deg = (int)(v / 100.0f);
+  float minutes = v - deg * 100.0f;
+  return deg + minutes / 60.0f;
+}
+
+static void parseGGA(char* sentence) {
+  const char* t[20] = {0};
+  int n = tokenize(sentence, t, 20);
+  if (n < 10) return;
+  g_data.fixQuality = atoi(t[6]);
+  g_data.satsUsed = atoi(t[7]);
+  g_data.altitude = atof(t[9]);
+  g_data.lat = nmeaCoordToDeg(t[2]);
+  if (t[3] && t[3][0] == 'S') g_data.lat = -g_data.lat;
+  g_data.lon = nmeaCoordToDeg(t[4]);
+  if (t[5] && t[5][0] == 'W') g_data.lon = -g_data.lon;
+  g_data.validFix = (g_data.fixQuality > 0);
+}
+
+static void parseRMC(char* sentence) {
+  const char* t[20] = {0};
+  int n = tokenize(sentence, t, 20);
+  if (n < 10) return;
+  if (t[1]) strncpy(g_data.timeUTC, t[1], sizeof(g_data.timeUTC)-1);
+  g_data.timeUTC[sizeof(g_data.timeUTC)-1] = '\0';
+  bool active = (t[2] && t[2][0] == 'A');
+  g_data.speedKnots = t[7] ? atof(t[7]) : 0.0f;
+  g_data.courseDeg = t[8] ? atof(t[8]) : 0.0f;
+  if (t[9]) strncpy(g_data.date, t[9], sizeof(g_data.date)-1);
+  g_data.date[sizeof(g_data.date)-1] = '\0';
+  if (!g_data.validFix && active) {
+    g_data.lat = nmeaCoordToDeg(t[3]);
+    if (t[4] && t[4][0] == 'S') g_data.lat = -g_data.lat;
+    g_data.lon = nmeaCoordToDeg(t[5]);
+    if (t[6] && t[6][0] == 'W') g_data.lon = -g_data.lon;
+  }
+  if (active) g_data.validFix = true;
+}
+
+static void parseGSV(char* sentence) {
+  const char* t[30] = {0};
+  int n = tokenize(sentence, t, 30);
+  if (n < 4) return;
+  g_data.satsInView = atoi(t[3]);
+}
+
+// gps_poll()'s loop body for one byte
+static void feed(char c) {
+  if (c == '\r') return;
+  if (c == '\n') {
+    lineBuf[linePos] = '\0';
+    if (linePos > 6 && lineBuf[0] == '$') {
+      char* s = lineBuf + 1;
+      if (strncmp(s+2, "GGA", 3) == 0) {
+        parseGGA(s);
+      } else if (strncmp(s+2, "RMC", 3) == 0) {
+        parseRMC(s);
+      } else if (strncmp(s+2, "GSV", 3) == 0) {
+        parseGSV(s);
+      }
+    }
+    linePos = 0;
+  } else if (linePos < (int)sizeof(lineBuf)-1) {
+    lineBuf[linePos++] = c;
+  } else {
+    linePos = 0;
+  }
+}
+
+} // namespace baseline
+
+// Host ns per byte of 'run' over 'data', repeated for at least 0.2 s
+template <class Run>
+static double nsPerByte(const std::vector<uint8_t> &data, Run run) {
+    uint64_t bytes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double s = 0.0;
+    do {
+        run();
+        bytes += data.size();
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    return s * 1e9 / bytes;
+}
+
+static void benchCorpus(const char* name) {
+    std::vector<uint8_t> data = readFile(std::string(TEST_DATA_DIR) + "/nmea/" + name + ".nmea");
+    TEST_ASSERT_TRUE(!data.empty());
+    CountingSink sink;
+    FullParser parser;
+    double streaming = nsPerByte(data, [&] {
+        io::MemorySource mem(data.data(), data.size());
+        drain(mem, parser, sink);
+    });
+    BasicParser basic;
+    double shared3 = nsPerByte(data, [&] {
+        io::MemorySource mem(data.data(), data.size());
+        drain(mem, basic, sink);
+    });
+    // The baseline drained the same way, UART-sized reads then byte by byte
+    int64_t baseSum = 0;
+    double lineBuffer = nsPerByte(data, [&] {
+        io::MemorySource mem(data.data(), data.size());
+        uint8_t buf[256];
+        size_t n;
+        while ((n = mem.read(buf, sizeof(buf))) > 0)
+            for (size_t i = 0; i < n; ++i) baseline::feed((char)buf[i]);
+        baseSum += baseline::g_data.satsInView + (int64_t)(baseline::g_data.lat * 1e7f);
+    });
+    char msg[240];
+    snprintf(msg, sizeof(msg), "%s: streaming %.2f ns/byte (%.1f MB/s), GGA/RMC/GSV only %.2f, line buffer %.2f (%.1fx / %.1fx) (checksum %lld/%lld)",
+             name, streaming, 1e3 / streaming, shared3, lineBuffer, lineBuffer / streaming, lineBuffer / shared3, (long long)sink.sum, (long long)baseSum);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN_MESSAGE(NMEA_BENCH_MAX_NS_PER_BYTE, streaming, msg);
+    TEST_ASSERT_TRUE_MESSAGE(lineBuffer / shared3 >= NMEA_BENCH_MIN_SPEEDUP, msg);
+}
+
+// What gps_module pays for GSA/GST/VTG: the full parser against the GGA/RMC/GSV one on the log
+// that carries them all (per epoch: 4 GSA, GST, VTG besides GGA and RMC, GSV once a second)
+static void benchExtraSentences() {
+    std::vector<uint8_t> data = readFile(std::string(TEST_DATA_DIR) + "/nmea/multi_gnss.nmea");
+    TEST_ASSERT_TRUE(!data.empty());
+    CountingSink fullSink, basicSink;
+    FullParser full;
+    BasicParser basic;
+    // Interleaved and best of three, so a busy host skews both alike
+    double fullNs = 1e9, basicNs = 1e9;
+    for (int round = 0; round < 3; ++round) {
+        double f = nsPerByte(data, [&] { io::MemorySource mem(data.data(), data.size()); drain(mem, full, fullSink); });
+        double b = nsPerByte(data, [&] { io::MemorySource mem(data.data(), data.size()); drain(mem, basic, basicSink); });
+        if (f < fullNs) fullNs = f;
+        if (b < basicNs) basicNs = b;
+    }
+    double epochs = 600.0, bytesPerEpoch = data.size() / epochs;
+    char msg[200];
+    snprintf(msg, sizeof(msg), "multi_gnss: full %.2f ns/byte, GGA/RMC/GSV %.2f ns/byte: x%.2f, +%.2f us per 10 Hz epoch (checksum %lld/%lld)",
+             fullNs, basicNs, fullNs / basicNs, (fullNs - basicNs) * bytesPerEpoch / 1e3, (long long)fullSink.sum, (long long)basicSink.sum);
+    TEST_MESSAGE(msg);
+    // Each pass accepts every sentence of the log, or only the three
+    TEST_ASSERT_EQUAL(0, full.stats().sentences % (600 + 600 + 540 + 2400 + 600 + 600));
+    TEST_ASSERT_EQUAL(0, basic.stats().sentences % (600 + 600 + 540));
+    TEST_ASSERT_EQUAL(0, basic.stats().checksumErrors);
+    TEST_ASSERT_TRUE_MESSAGE(fullNs / basicNs <= NMEA_BENCH_MAX_EXTRA_COST, msg);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_cold_start_matches_golden(void) { checkCorpus("cold_start"); }
+void test_multi_gnss_matches_golden(void) { checkCorpus("multi_gnss"); }
+void test_corrupted_matches_golden(void) { checkCorpus("corrupted"); }
+void test_parked_matches_golden(void) { checkCorpus("parked"); }
+void test_throughput_cold_start(void) { benchCorpus("cold_start"); }
+void test_throughput_multi_gnss(void) { benchCorpus("multi_gnss"); }
+void test_throughput_corrupted(void) { benchCorpus("corrupted"); }
+void test_extra_sentence_cost(void) { benchExtraSentences(); }
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cold_start_matches_golden);
+    RUN_TEST(test_multi_gnss_matches_golden);
+    RUN_TEST(test_corrupted_matches_golden);
+    RUN_TEST(test_parked_matches_golden);
+    RUN_TEST(test_throughput_cold_start);
+    RUN_TEST(test_throughput_multi_gnss);
+    RUN_TEST(test_throughput_corrupted);
+    RUN_TEST(test_extra_sentence_cost);
+    return UNITY_END();
+}
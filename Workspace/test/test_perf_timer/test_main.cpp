@@ -0,0 +1,191 @@
+// Synthetic 10 Hz drives through perf::PerfTimer (include/perf_timer.hpp) against the exact
+// times of the simulated motion: launches of different character, each at many phases against
+// the epoch grid and with Doppler-like speed noise, then a 100-0 stop. Every reported time must
+// be within PERF_MAX_ERR_MS of the truth with clean samples and with typical Doppler speed noise
+// at 10 Hz (0.08 km/h, 0.02 m/s). With the receiver duty-cycled to 1 Hz while parked
+// (include/gps_power.hpp), the perf screen's hold must bring 10 Hz back in time to arm and time
+// a launch. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "perf_timer.hpp"
+#include "gps_power.hpp"
+
+#ifndef PERF_MAX_ERR_MS
+#define PERF_MAX_ERR_MS 50.0
+#endif
+
+static const double SIM_DT = 1e-4;        // 0.1 ms integration step
+static const int EPOCH_STEPS = 1000;      // 10 Hz
+static const double G = 9.80665;
+
+struct Profile {
+    const char* name;
+    double peakG;        // launch acceleration
+    double rampS;        // time for it to build up (clutch, traction control)
+    double topKmh;       // drag: acceleration falls to zero here
+    double brakeG;
+};
+
+static const Profile PROFILES[] = {
+    { "hot hatch",  0.55, 0.15, 230.0, 1.00 },
+    { "family car", 0.35, 0.30, 190.0, 0.85 },
+    { "EV",         0.80, 0.05, 200.0, 1.05 },
+};
+
+// Roughly unit normal (sum of four uniforms), repeatable across hosts
+static uint32_t g_rng = 1;
+static double gauss() {
+    double sum = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+        sum += (g_rng & 0xFFFF) / 65535.0;
+    }
+    return (sum - 2.0) * 1.732;
+}
+
+struct Truth { double mph60, kmh100, quarter, trapKmh, brakeS, brakeM; };
+
+struct Errors {
+    double worstMs = 0.0, worstTrapKmh = 0.0, worstBrakeM = 0.0;
+    void time(double wantS, uint32_t gotMs) { double e = fabs(gotMs - wantS * 1000.0); if (e > worstMs) worstMs = e; }
+};
+
+// One drive: stand, launch at 'launchS' (off the epoch grid), accelerate past 130 km/h and the
+// quarter mile, cruise,
+// brake to a stop, stand. Samples are the speed at each epoch plus noise.
+static void drive(const Profile &p, double launchS, double noiseKmh, Errors &err) {
+    perf::PerfTimer<1024> timer;
+    Truth t = {0, 0, 0, 0, 0, 0};
+    double v = 0.0, s = 0.0, brakeFromS = -1.0, brakeFromM = 0.0;
+    enum { STAND, ACCEL, CRUISE, BRAKE, STOPPED } phase = STAND;
+    double phaseS = 0.0;
+    bool sawBrake = false;
+    for (long k = 0; k < (long)(60.0 / SIM_DT); ++k) {
+        double tS = k * SIM_DT;
+        if (k % EPOCH_STEPS == 0) {
+            double kmh = v * 3.6 + noiseKmh * gauss();
+            uint32_t ev = timer.update((uint32_t)lround(tS * 1000.0), (float)fabs(kmh));
+            if (ev & perf::PERF_EV_BRAKE) sawBrake = true;
+        }
+        double a = 0.0;
+        switch (phase) {
+            case STAND: if (tS >= launchS) { phase = ACCEL; phaseS = tS; } break;
+            case ACCEL: {
+                double tl = tS - phaseS, ramp = tl < p.rampS ? tl / p.rampS : 1.0;
+                double drag = 1.0 - (v * 3.6 / p.topKmh) * (v * 3.6 / p.topKmh);
+                a = p.peakG * G * ramp * drag;
+                if (v * 3.6 >= 130.0 && s > 450.0) { phase = CRUISE; phaseS = tS; }
+                break;
+            }
+            case CRUISE: if (tS - phaseS >= 3.0) { phase = BRAKE; phaseS = tS; } break;
+            case BRAKE: a = -p.brakeG * G; break;
+            case STOPPED: break;
+        }
+        double v1 = v + a * SIM_DT;
+        if (phase == BRAKE && v1 <= 0.0) {
+            double frac = v / (v - v1);
+            s += 0.5 * v * SIM_DT * frac;
+            t.brakeS = tS + frac * SIM_DT - brakeFromS;
+            t.brakeM = s - brakeFromM;
+            v1 = 0.0;
+            phase = STOPPED;
+        } else {
+            double s1 = s + 0.5 * (v + v1) * SIM_DT;
+            double fromLaunch = tS - launchS;
+            if (!t.mph60 && v * 3.6 < perf::PERF_MPH60_KMH && v1 * 3.6 >= perf::PERF_MPH60_KMH)
+                t.mph60 = fromLaunch + (perf::PERF_MPH60_KMH / 3.6 - v) / (v1 - v) * SIM_DT;
+            if (!t.kmh100 && v * 3.6 < 100.0 && v1 * 3.6 >= 100.0)
+                t.kmh100 = fromLaunch + (100.0 / 3.6 - v) / (v1 - v) * SIM_DT;
+            if (!t.quarter && s < perf::PERF_QUARTER_M && s1 >= perf::PERF_QUARTER_M) {
+                double f = (perf::PERF_QUARTER_M - s) / (s1 - s);
+                t.quarter = fromLaunch + f * SIM_DT;
+                t.trapKmh = (v + f * (v1 - v)) * 3.6;
+            }
+            if (phase == BRAKE && brakeFromS < 0.0 && v * 3.6 >= 100.0 && v1 * 3.6 < 100.0) {
+                double f = (v - 100.0 / 3.6) / (v - v1);
+                brakeFromS = tS + f * SIM_DT;
+                brakeFromM = s + f * (s1 - s);
+            }
+            s = s1;
+        }
+        v = v1;
+    }
+    const perf::RunResult &r = timer.run();
+    TEST_ASSERT_EQUAL(1, timer.runs());
+    TEST_ASSERT_TRUE(sawBrake);
+    TEST_ASSERT_TRUE(r.mph60Ms && r.kmh100Ms && r.quarterMs && !r.gap);
+    err.time(t.mph60, r.mph60Ms);
+    err.time(t.kmh100, r.kmh100Ms);
+    err.time(t.quarter, r.quarterMs);
+    err.time(t.brakeS, timer.brake().timeMs);
+    double trap = fabs(r.quarterTrapKmh - t.trapKmh), bm = fabs(timer.brake().distanceM - t.brakeM);
+    if (trap > err.worstTrapKmh) err.worstTrapKmh = trap;
+    if (bm > err.worstBrakeM) err.worstBrakeM = bm;
+}
+
+static void profile(const Profile &p, double noiseKmh, double maxErrMs) {
+    Errors err;
+    // 20 launch phases across one epoch, none on the grid
+    for (int i = 0; i < 20; ++i) drive(p, 3.0 + 0.0051 * i + 0.00037, noiseKmh, err);
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%-10s noise %.2f km/h: worst time error %.1f ms, trap %.2f km/h, 100-0 distance %.2f m",
+             p.name, noiseKmh, err.worstMs, err.worstTrapKmh, err.worstBrakeM);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(maxErrMs, err.worstMs);
+    TEST_ASSERT_LESS_THAN(1.0, err.worstTrapKmh);
+    TEST_ASSERT_LESS_THAN(1.0, err.worstBrakeM);
+}
+
+// Park for a minute (the governor drops the receiver to 1 Hz after 30 s), open the perf screen
+// at 40 s ('hold' from then on if 'holdOnPerf') and launch at 45 s with a 0.15 s build-up to
+// 0.5 g. The receiver runs at 10 Hz in POWER_FULL and 1 Hz otherwise; the governor sees the
+// noiseless speed through the 1.8 km/h gate. Returns the timer's 0-100 km/h error in ms, -1 if it did not time it.
+static double parkedLaunch(bool holdOnPerf) {
+    const double PERF_OPEN_S = 40.0, LAUNCH_S = 45.00037, A = 0.5 * G * 3.6, RAMP_S = 0.15;
+    gnss::PowerGovernor gov;
+    perf::PerfTimer<1024> timer;
+    bool sawReduced = false;
+    uint32_t nextMs = 0;
+    for (uint32_t tMs = 0; tMs <= 60000; tMs += 100) {
+        if (tMs < nextMs) continue;
+        double tl = tMs / 1000.0 - LAUNCH_S;
+        double kmh = tl <= 0.0 ? 0.0 : tl < RAMP_S ? A * tl * tl / (2.0 * RAMP_S) : A * (tl - 0.5 * RAMP_S);
+        bool perfOpen = tMs >= PERF_OPEN_S * 1000.0;
+        gov.update(tMs, true, kmh > 1.8 ? (float)kmh : 0.0f, 90.0f, holdOnPerf && perfOpen);
+        if (gov.mode() != gnss::POWER_FULL) sawReduced = true;
+        if (perfOpen) timer.update(tMs, (float)kmh);
+        nextMs = tMs + (gov.mode() == gnss::POWER_FULL ? 100 : 1000);
+    }
+    TEST_ASSERT_TRUE(sawReduced);
+    if (!timer.runs() || !timer.run().kmh100Ms) return -1.0;
+    double truthS = 100.0 / A + 0.5 * RAMP_S;
+    return fabs(timer.run().kmh100Ms - truthS * 1000.0);
+}
+
+void test_launch_after_reduced_rate(void) {
+    // Without the hold every standing sample is a gap: the timer never arms and the run is lost
+    TEST_ASSERT_EQUAL_FLOAT(-1.0, parkedLaunch(false));
+    double err = parkedLaunch(true);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "1 Hz parked, perf screen held at 10 Hz: 0-100 km/h error %.1f ms", err);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(err >= 0.0);
+    TEST_ASSERT_LESS_THAN(PERF_MAX_ERR_MS, err);
+}
+
+void setUp(void) { g_rng = 1; }
+void tearDown(void) {}
+
+void test_clean_samples(void) { for (const Profile &p : PROFILES) profile(p, 0.0, PERF_MAX_ERR_MS); }
+void test_quiet_doppler(void) { for (const Profile &p : PROFILES) profile(p, 0.05, PERF_MAX_ERR_MS); }
+void test_typical_doppler(void) { for (const Profile &p : PROFILES) profile(p, 0.08, PERF_MAX_ERR_MS); }
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_clean_samples);
+    RUN_TEST(test_quiet_doppler);
+    RUN_TEST(test_typical_doppler);
+    RUN_TEST(test_launch_after_reduced_rate);
+    return UNITY_END();
+}
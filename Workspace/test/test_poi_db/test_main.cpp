@@ -0,0 +1,160 @@
+// Proximity queries on the POI table (include/poi_db.hpp) against a brute-force scan, including a
+// city centre far denser than POI_MAX_SCAN per cell, and query cost for 10k and 100k records.
+// 100k is past what the 512 KB partition holds (32766); it shows the cost does not follow the
+// table size. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "poi_db.hpp"
+
+static const double LAT0 = 48.137154, LON0 = 11.576124;
+static const int MAX_HITS = 8;
+
+static uint32_t g_rng = 1;
+static double uniform(double lo, double hi) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return lo + (hi - lo) * (g_rng / 4294967296.0);
+}
+
+static poi::Record makeRecord(double lat, double lon) {
+    poi::Record r;
+    r.latE7 = (int32_t)lround(lat * 1e7);
+    r.lonE7 = (int32_t)lround(lon * 1e7);
+    r.key = poi::geohashKey(r.latE7, r.lonE7);
+    r.type = uniform(0, 1) < 0.7 ? poi::POI_CAMERA : poi::POI_ZONE;
+    r.limitKmh = 50;
+    r.radius10m = 0;
+    r.heading2 = 0xFF;
+    return r;
+}
+
+// The image build_poi_image.py writes: header, then records sorted by key
+static std::vector<uint8_t> buildImage(std::vector<poi::Record> rows) {
+    std::stable_sort(rows.begin(), rows.end(), [](const poi::Record &a, const poi::Record &b) { return a.key < b.key; });
+    std::vector<uint8_t> img(sizeof(poi::Header) + rows.size() * sizeof(poi::Record));
+    memcpy(&img[sizeof(poi::Header)], rows.data(), rows.size() * sizeof(poi::Record));
+    poi::Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "POI1", 4);
+    h.version = poi::POI_VERSION;
+    h.count = (uint32_t)rows.size();
+    h.recordSize = sizeof(poi::Record);
+    h.crc = track::crc32(&img[sizeof(poi::Header)], rows.size() * sizeof(poi::Record));
+    memcpy(&img[0], &h, sizeof(h));
+    return img;
+}
+
+// 'spread' records over +-2 degrees plus 'city' within 1.5 km of the centre
+static std::vector<poi::Record> region(size_t spread, size_t city) {
+    std::vector<poi::Record> rows;
+    for (size_t i = 0; i < spread; ++i) rows.push_back(makeRecord(LAT0 + uniform(-2, 2), LON0 + uniform(-2, 2)));
+    for (size_t i = 0; i < city; ++i) {
+        double r = 1500.0 * sqrt(uniform(0, 1)), a = uniform(0, 2 * M_PI);
+        rows.push_back(makeRecord(LAT0 + r * cos(a) / 111320.0, LON0 + r * sin(a) / 74400.0));
+    }
+    return rows;
+}
+
+// The MAX_HITS nearest within radiusM, by looking at every record
+static int bruteForce(const poi::PoiDb &db, int32_t latE7, int32_t lonE7, float radiusM, float* dist) {
+    geo::LocalFrame f;
+    f.setOrigin(latE7, lonE7);
+    std::vector<float> all;
+    for (uint32_t i = 0; i < db.count(); ++i) {
+        float e, n;
+        f.toEnu(db.record(i).latE7, db.record(i).lonE7, e, n);
+        float d = sqrtf(e * e + n * n);
+        if (d <= radiusM) all.push_back(d);
+    }
+    std::sort(all.begin(), all.end());
+    int n = (int)std::min<size_t>(all.size(), MAX_HITS);
+    for (int i = 0; i < n; ++i) dist[i] = all[i];
+    return n;
+}
+
+static void checkAgainstBruteForce(const poi::PoiDb &db, double lat, double lon, uint32_t &truncated) {
+    int32_t la = (int32_t)lround(lat * 1e7), lo = (int32_t)lround(lon * 1e7);
+    poi::Hit hits[MAX_HITS];
+    float want[MAX_HITS];
+    bool cut;
+    int n = db.query(la, lo, poi::POI_QUERY_RADIUS_M, hits, MAX_HITS, &cut);
+    int m = bruteForce(db, la, lo, poi::POI_QUERY_RADIUS_M, want);
+    if (cut) { truncated++; return; }
+    TEST_ASSERT_EQUAL(m, n);
+    for (int i = 0; i < n; ++i) TEST_ASSERT_FLOAT_WITHIN(0.01, want[i], hits[i].distM);
+}
+
+void setUp(void) { g_rng = 1; }
+void tearDown(void) {}
+
+void test_queries_match_brute_force(void) {
+    std::vector<uint8_t> img = buildImage(region(20000, 1500));
+    TEST_ASSERT_TRUE(poi::checkImage(img.data(), img.size(), true));
+    poi::PoiDb db;
+    db.attach(img.data());
+    uint32_t truncated = 0;
+    for (int q = 0; q < 400; ++q) checkAgainstBruteForce(db, LAT0 + uniform(-2, 2), LON0 + uniform(-2, 2), truncated);
+    // The city centre holds ~200 records per square km: the old per-cell cap missed most of them
+    for (int q = 0; q < 400; ++q) checkAgainstBruteForce(db, LAT0 + uniform(-0.02, 0.02), LON0 + uniform(-0.03, 0.03), truncated);
+    TEST_ASSERT_EQUAL(0, truncated);
+}
+
+// More records in one finest-level cell than a query may read: still answers, and says so
+void test_overfull_cell_reports_truncation(void) {
+    std::vector<poi::Record> rows = region(1000, 0);
+    for (int i = 0; i < 200; ++i) rows.push_back(makeRecord(LAT0 + uniform(-0.0003, 0.0003), LON0 + uniform(-0.0003, 0.0003)));
+    std::vector<uint8_t> img = buildImage(rows);
+    poi::PoiDb db;
+    db.attach(img.data());
+    poi::Hit hits[MAX_HITS];
+    bool cut = false;
+    int n = db.query((int32_t)lround(LAT0 * 1e7), (int32_t)lround(LON0 * 1e7), poi::POI_QUERY_RADIUS_M, hits, MAX_HITS, &cut);
+    TEST_ASSERT_TRUE(cut);
+    TEST_ASSERT_EQUAL(MAX_HITS, n);
+    TEST_ASSERT_LESS_THAN(50.0f, hits[MAX_HITS - 1].distM);
+    // Away from it, nothing is cut short
+    db.query((int32_t)lround((LAT0 + 1.0) * 1e7), (int32_t)lround(LON0 * 1e7), poi::POI_QUERY_RADIUS_M, hits, MAX_HITS, &cut);
+    TEST_ASSERT_FALSE(cut);
+}
+
+static double nsPerQuery(size_t spread, size_t city) {
+    std::vector<uint8_t> img = buildImage(region(spread, city));
+    poi::PoiDb db;
+    db.attach(img.data());
+    std::vector<int32_t> qs;
+    for (int q = 0; q < 4096; ++q) {
+        bool inCity = q % 4 == 0;
+        qs.push_back((int32_t)lround((LAT0 + (inCity ? uniform(-0.02, 0.02) : uniform(-2, 2))) * 1e7));
+        qs.push_back((int32_t)lround((LON0 + (inCity ? uniform(-0.03, 0.03) : uniform(-2, 2))) * 1e7));
+    }
+    poi::Hit hits[MAX_HITS];
+    uint64_t queries = 0, found = 0;
+    double s = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    do {
+        for (size_t i = 0; i < qs.size(); i += 2, ++queries) found += db.query(qs[i], qs[i + 1], poi::POI_QUERY_RADIUS_M, hits, MAX_HITS);
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    char msg[120];
+    snprintf(msg, sizeof(msg), "%6u records: %.0f ns/query, %.2f hits/query", (unsigned)db.count(), s * 1e9 / queries, (double)found / queries);
+    TEST_MESSAGE(msg);
+    return s * 1e9 / queries;
+}
+
+void test_query_cost_10k_vs_100k(void) {
+    double small = nsPerQuery(9000, 1000);
+    double large = nsPerQuery(99000, 1000);
+    // Ten times the records around the query cost more reads, but only through the density
+    TEST_ASSERT_LESS_THAN(6.0 * small, large);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_queries_match_brute_force);
+    RUN_TEST(test_overfull_cell_reports_truncation);
+    RUN_TEST(test_query_cost_10k_vs_100k);
+    return UNITY_END();
+}
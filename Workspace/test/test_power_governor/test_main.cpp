@@ -0,0 +1,217 @@
+// Receiver duty cycling (include/gps_power.hpp) against recorded and synthetic drives, fed the
+// way main.cpp does it: the speed filter's gated speed and the course of every snapshot, with the
+// receiver at 10 Hz in POWER_FULL and 1 Hz otherwise. A parked receiver (test/data/nmea/parked.nmea, random
+// courses and the odd speed spike included) must drop to 1 Hz after 30 s and to power-save
+// after 300 s; a lap of the demo drive never leaves full rate; a launch and a steady course
+// swing wake it, course noise does not. estimatedSavingPct() is reported for each run.
+// Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "demo_drive.hpp"
+#include "gps_power.hpp"
+#include "nmea_parser.hpp"
+#include "speed_filter.hpp"
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "test/data"
+#endif
+
+static const float GATE_SIGMA_BUILD = 2.0f;   // GPS_SPEED_GATE_SIGMA default
+static const uint32_t FRAME_MS = 100;         // snapshot period of these runs
+
+static std::vector<uint8_t> readFile(const std::string &path) {
+    std::vector<uint8_t> d;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return d;
+    int c;
+    while ((c = fgetc(f)) != EOF) d.push_back((uint8_t)c);
+    fclose(f);
+    return d;
+}
+
+// What powerOnSnapshot() sees: the fix, the speed filter's gated speed at the fix (the raw gate
+// while the filter has no estimate) and the course. 'tMs' is the decode time of the next fix.
+struct Snapshot {
+    nav::SpeedFilter filter;
+    bool fix = false;
+    float hdop = 0.0f, speedKmh = 0.0f, courseDeg = 0.0f;
+    uint32_t tMs = 0, fixes = 0;
+
+    void onSentence(const nmea::Gga &s) { if (s.hdop > 0.0f) hdop = s.hdop; }
+    void onSentence(const nmea::Rmc &s) {
+        fix = s.active;
+        courseDeg = s.courseDeg;
+        fixes++;
+        if (!fix) { filter.reset(); speedKmh = 0.0f; return; }
+        float kmh = s.speedKnots * 1.852f, sAcc = hdop * nav::SACC_KMH_PER_HDOP;
+        filter.update(tMs, kmh, s.courseDeg, sAcc, false, fixes);
+        speedKmh = filter.speedKmhAt(tMs);
+    }
+};
+
+struct Transition { uint32_t tMs; gnss::PowerMode mode; };
+
+struct Run {
+    gnss::PowerGovernor gov;
+    std::vector<Transition> log;
+
+    Run() { gov.reset(0); }
+    void update(uint32_t tMs, const Snapshot &s, bool hold = false) {
+        if (gov.update(tMs, s.fix, s.speedKmh, s.courseDeg, hold)) log.push_back(Transition{ tMs, gov.mode() });
+    }
+    // Time of the n-th change into 'mode' (0 if there is none)
+    uint32_t at(gnss::PowerMode mode, int n = 0) const {
+        for (const Transition &t : log) if (t.mode == mode && n-- == 0) return t.tMs;
+        return 0;
+    }
+    void report(const char* name) const {
+        const gnss::PowerGovernor::Stats &st = gov.stats();
+        char msg[160];
+        snprintf(msg, sizeof(msg), "%-14s full %us, 1 Hz %us, psm %us, %u transitions: saving ~%.1f%%",
+                 name, st.timeMs[gnss::POWER_FULL] / 1000, st.timeMs[gnss::POWER_REDUCED] / 1000,
+                 st.timeMs[gnss::POWER_SAVE] / 1000, st.transitions, gov.estimatedSavingPct());
+        TEST_MESSAGE(msg);
+    }
+};
+
+// Saving for a timeline of full/1 Hz/psm seconds, from the nominal currents
+static float savingPct(float fullS, float reducedS, float saveS) {
+    float charge = fullS * gnss::POWER_MODE_MA[gnss::POWER_FULL] + reducedS * gnss::POWER_MODE_MA[gnss::POWER_REDUCED] +
+                   saveS * gnss::POWER_MODE_MA[gnss::POWER_SAVE];
+    return 100.0f * (1.0f - charge / ((fullS + reducedS + saveS) * gnss::POWER_MODE_MA[gnss::POWER_FULL]));
+}
+
+// Drive a script through the generator; NMEA is emitted at the rate the governor asks for
+static void drive(const demo::Phase* script, size_t count, Run &run, uint32_t* launchMs = nullptr) {
+    uint32_t totalMs = 0;
+    for (size_t i = 0; i < count; ++i) totalMs += script[i].durationMs;
+    demo::DriveGenerator gen(script, count);
+    nmea::Parser<nmea::Gga, nmea::Rmc> parser;
+    Snapshot snap;
+    char buf[demo::DRIVE_EPOCH_MAX];
+    uint32_t nextFixMs = 0;
+    size_t lastPhase = 0;
+    while (gen.state().tMs < totalMs) {
+        gen.step(FRAME_MS);
+        uint32_t t = gen.state().tMs;
+        if (launchMs && gen.phase() != lastPhase && script[gen.phase()].targetKmh > 0.0f && gen.state().speedKmh == 0.0f)
+            *launchMs++ = t;
+        lastPhase = gen.phase();
+        if (t >= nextFixMs) {
+            snap.tMs = t;
+            size_t n = gen.nmea(buf, sizeof(buf), false);
+            for (size_t i = 0; i < n; ++i) parser.feed(buf[i], snap);
+            nextFixMs = t + (run.gov.mode() == gnss::POWER_FULL ? 100 : 1000);
+        }
+        run.update(t, snap);
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// 20 minutes parked at 1 Hz: 30 s at full rate, 270 s at 1 Hz, the rest in power-save
+void test_parked_corpus(void) {
+    std::vector<uint8_t> data = readFile(std::string(TEST_DATA_DIR) + "/nmea/parked.nmea");
+    TEST_ASSERT_TRUE_MESSAGE(!data.empty(), "parked.nmea missing (run from the project directory)");
+    nmea::Parser<nmea::Gga, nmea::Rmc> parser;
+    Snapshot snap;
+    Run run;
+    uint32_t fixes = 0;
+    for (uint8_t c : data) {
+        snap.tMs = snap.fixes * 1000;
+        parser.feed((char)c, snap);
+        if (snap.fixes != fixes) { fixes = snap.fixes; run.update((fixes - 1) * 1000, snap); }
+    }
+    run.report("parked.nmea");
+    TEST_ASSERT_EQUAL(1200, fixes);
+    TEST_ASSERT_EQUAL(2, (int)run.log.size());
+    TEST_ASSERT_EQUAL(30000, run.at(gnss::POWER_REDUCED));
+    TEST_ASSERT_EQUAL(300000, run.at(gnss::POWER_SAVE));
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, savingPct(30, 270, 899), run.gov.estimatedSavingPct());
+}
+
+// Everything the demo lap throws at it (walking pace, a tunnel, stop-and-go) is full rate
+void test_demo_lap_stays_full(void) {
+    Run run;
+    drive(demo::DEFAULT_DRIVE, demo::DEFAULT_DRIVE_LEN, run);
+    run.report("demo lap");
+    TEST_ASSERT_EQUAL(0, (int)run.log.size());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, run.gov.estimatedSavingPct());
+}
+
+// Park for 6 minutes, drive, park for 45 s, drive: the rate follows each stop, and a launch
+// brings full rate back at the first 1 Hz fix after it
+void test_stops_and_launches(void) {
+    static const demo::Phase SCRIPT[] = {
+        { 360000,  0.0f, 1.0f, 0.0f, 10, true },
+        {  20000, 50.0f, 3.5f, 0.0f, 10, true },
+        {  10000,  0.0f, 6.0f, 0.0f, 10, true },
+        {  45000,  0.0f, 1.0f, 0.0f, 10, true },
+        {  20000, 50.0f, 3.5f, 0.0f, 10, true },
+    };
+    Run run;
+    uint32_t launch[2] = { 0, 0 };
+    drive(SCRIPT, sizeof(SCRIPT) / sizeof(SCRIPT[0]), run, launch);
+    run.report("stops");
+    TEST_ASSERT_EQUAL(5, (int)run.log.size());
+    // First stop: parked from the start
+    TEST_ASSERT_UINT32_WITHIN(FRAME_MS, 30000, run.at(gnss::POWER_REDUCED, 0));
+    TEST_ASSERT_UINT32_WITHIN(FRAME_MS, 300000, run.at(gnss::POWER_SAVE, 0));
+    // Launch: at 3.5 m/s^2 the speed clears the gate within 0.2 s, seen at the next 1 Hz fix
+    TEST_ASSERT_EQUAL(360000, launch[0]);
+    TEST_ASSERT_UINT32_WITHIN(600, launch[0] + 600, run.at(gnss::POWER_FULL, 0));
+    // Second stop: the car stands still from ~2.3 s into the braking phase (50 km/h at 6 m/s^2)
+    uint32_t stoppedMs = 380000 + 2300;
+    TEST_ASSERT_UINT32_WITHIN(500, stoppedMs + 30000, run.at(gnss::POWER_REDUCED, 1));
+    TEST_ASSERT_EQUAL(435000, launch[1]);
+    TEST_ASSERT_UINT32_WITHIN(600, launch[1] + 600, run.at(gnss::POWER_FULL, 1));
+    TEST_ASSERT_EQUAL(gnss::POWER_FULL, run.gov.mode());
+    TEST_ASSERT_TRUE(run.gov.estimatedSavingPct() > 10.0f);
+}
+
+// Course changes with the gated speed at zero: noise and a glance away do not wake it, a new
+// heading held for courseWakeMs does
+void test_course_swing_wakes(void) {
+    gnss::PowerGovernorConfig cfg;
+    Run run;
+    Snapshot snap;
+    snap.fix = true;
+    uint32_t t = 0;
+    uint32_t rng = 7;
+    for (; t < 60000; t += 1000) { // parked, a random course every fix
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        snap.courseDeg = (float)(rng % 360);
+        run.update(t, snap);
+    }
+    TEST_ASSERT_EQUAL(gnss::POWER_REDUCED, run.gov.mode());
+    TEST_ASSERT_EQUAL(1, (int)run.log.size());
+    // Settle on a heading, then swing 45 degrees for less than courseWakeMs and back
+    snap.courseDeg = 100.0f;
+    for (uint32_t end = t + cfg.courseWakeMs + 2000; t < end; t += 1000) run.update(t, snap);
+    run.log.clear();
+    run.gov.reset(t);
+    for (uint32_t end = t + 40000; t < end; t += 1000) run.update(t, snap);
+    TEST_ASSERT_EQUAL(gnss::POWER_REDUCED, run.gov.mode());
+    snap.courseDeg = 145.0f;
+    for (uint32_t end = t + cfg.courseWakeMs - 1000; t < end; t += 1000) run.update(t, snap);
+    snap.courseDeg = 100.0f;
+    run.update(t, snap); t += 1000;
+    TEST_ASSERT_EQUAL(gnss::POWER_REDUCED, run.gov.mode());
+    // The same swing held: full rate once it has lasted courseWakeMs
+    uint32_t swingMs = t;
+    snap.courseDeg = 145.0f;
+    for (uint32_t end = t + cfg.courseWakeMs + 2000; t < end; t += 1000) run.update(t, snap);
+    TEST_ASSERT_EQUAL(swingMs + cfg.courseWakeMs, run.at(gnss::POWER_FULL));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parked_corpus);
+    RUN_TEST(test_demo_lap_stays_full);
+    RUN_TEST(test_stops_and_launches);
+    RUN_TEST(test_course_swing_wakes);
+    return UNITY_END();
+}
@@ -0,0 +1,254 @@
+// gnss::SatTable (include/sat_table.hpp) fed GSV sentences through the parser and mapped the way
+// gps_module does it: cycles of GP/GL/GA/BD (and a combined GN) messages assemble into one
+// snapshot that only flips when a constellation's cycle completes, out-of-order and missing
+// messages drop the cycle, each constellation keeps at most SATS_PER_CYCLE satellites, and the
+// C/N0 average and top-4 follow the tracked satellites. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include "nmea_parser.hpp"
+#include "sat_table.hpp"
+
+struct Sat { int prn, elevation, azimuth, cn0; };   // cn0 < 0: tracked field left empty
+
+struct GsvSink {
+    gnss::SatTable table;
+    int published = 0;
+
+    // gps_module's onSentence(Gsv)
+    void onSentence(const nmea::Gsv &s) {
+        gnss::SatInfo sats[4];
+        int n = s.satellites(sats);
+        gnss::System sys = gnss::systemFromTalker(s.talker[0], s.talker[1]);
+        if (table.addMessage(sys, s.total, s.index, (uint8_t)s.inView, sats, n)) published++;
+    }
+};
+
+static GsvSink* g_sink;
+static nmea::Parser<nmea::Gsv>* g_parser;
+
+static void feed(const std::string &body) {
+    uint8_t cs = 0;
+    for (char c : body) cs ^= (uint8_t)c;
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", cs);
+    std::string line = "$" + body + tail;
+    for (char c : line) g_parser->feed(c, *g_sink);
+}
+
+// One GSV message: talker ("GP"), message 'index' of 'total', 'inView', then up to 4 satellites
+static void gsv(const char* talker, int total, int index, int inView, const Sat* sats, int n) {
+    char buf[160];
+    int len = snprintf(buf, sizeof(buf), "%sGSV,%d,%d,%02d", talker, total, index, inView);
+    for (int i = 0; i < n; ++i) {
+        if (sats[i].cn0 < 0) len += snprintf(buf + len, sizeof(buf) - len, ",%02d,%02d,%03d,", sats[i].prn, sats[i].elevation, sats[i].azimuth);
+        else len += snprintf(buf + len, sizeof(buf) - len, ",%02d,%02d,%03d,%02d", sats[i].prn, sats[i].elevation, sats[i].azimuth, sats[i].cn0);
+    }
+    feed(buf);
+}
+
+// A whole cycle of 'n' satellites, four to a message
+static void cycle(const char* talker, const Sat* sats, int n, int inView = -1) {
+    int total = (n + 3) / 4;
+    for (int m = 0; m < total; ++m) gsv(talker, total, m + 1, inView < 0 ? n : inView, sats + 4 * m, n - 4 * m < 4 ? n - 4 * m : 4);
+}
+
+static int countSystem(const gnss::SatSnapshot &s, gnss::System sys) {
+    int n = 0;
+    for (int i = 0; i < s.count; ++i) if (s.sats[i].system == sys) n++;
+    return n;
+}
+
+static const Sat GP[] = {
+    { 2, 45, 120, 42 }, { 5, 12, 300, 31 }, { 7, 67, 45, 47 }, { 9, 30, 210, 38 },
+    { 13, 8, 15, -1 }, { 15, 52, 95, 44 }, { 18, 22, 160, 35 }, { 20, 5, 270, -1 },
+    { 24, 71, 330, 46 }, { 29, 35, 185, 40 },
+};
+static const Sat GL[] = {
+    { 65, 40, 60, 39 }, { 66, 25, 110, 33 }, { 72, 60, 200, 43 }, { 73, 15, 250, 28 },
+    { 80, 50, 340, 41 }, { 81, 10, 20, -1 }, { 88, 33, 150, 36 },
+};
+static const Sat GA[] = { { 3, 55, 80, 45 }, { 8, 28, 140, 37 }, { 13, 42, 230, 40 }, { 26, 18, 310, 30 } };
+static const Sat BD[] = {
+    { 6, 62, 100, 44 }, { 14, 37, 190, 39 }, { 19, 20, 280, 32 }, { 22, 48, 20, 41 },
+    { 27, 11, 160, -1 }, { 33, 30, 240, 35 },
+};
+
+void setUp(void) {
+    static GsvSink sink;
+    static nmea::Parser<nmea::Gsv> parser;
+    sink.table = gnss::SatTable();
+    sink.published = 0;
+    parser.reset();
+    g_sink = &sink;
+    g_parser = &parser;
+}
+void tearDown(void) {}
+
+void test_talkers(void) {
+    TEST_ASSERT_EQUAL(gnss::SYS_GPS, gnss::systemFromTalker('G', 'P'));
+    TEST_ASSERT_EQUAL(gnss::SYS_GLONASS, gnss::systemFromTalker('G', 'L'));
+    TEST_ASSERT_EQUAL(gnss::SYS_GALILEO, gnss::systemFromTalker('G', 'A'));
+    TEST_ASSERT_EQUAL(gnss::SYS_BEIDOU, gnss::systemFromTalker('G', 'B'));
+    TEST_ASSERT_EQUAL(gnss::SYS_BEIDOU, gnss::systemFromTalker('B', 'D'));
+    TEST_ASSERT_EQUAL(gnss::SYS_QZSS, gnss::systemFromTalker('G', 'Q'));
+    TEST_ASSERT_EQUAL(gnss::SYS_QZSS, gnss::systemFromTalker('Q', 'Z'));
+    TEST_ASSERT_EQUAL(gnss::SYS_COMBINED, gnss::systemFromTalker('G', 'N'));
+    TEST_ASSERT_EQUAL(gnss::SYS_OTHER, gnss::systemFromTalker('G', 'I'));
+    TEST_ASSERT_EQUAL_STRING("GNS", gnss::systemName(gnss::SYS_COMBINED));
+}
+
+// Messages of a cycle in progress never show; the snapshot flips whole on the last one, and the
+// buffer a reader held keeps the previous complete set
+void test_cycles_assemble_and_flip(void) {
+    const gnss::SatSnapshot* before = &g_sink->table.snapshot();
+    gsv("GP", 3, 1, 10, GP, 4);
+    gsv("GP", 3, 2, 10, GP + 4, 4);
+    TEST_ASSERT_EQUAL(0, g_sink->published);
+    TEST_ASSERT_EQUAL(0, g_sink->table.snapshot().count);
+    gsv("GP", 3, 3, 10, GP + 8, 2);
+    TEST_ASSERT_EQUAL(1, g_sink->published);
+    const gnss::SatSnapshot &gp = g_sink->table.snapshot();
+    TEST_ASSERT_TRUE(&gp != before);
+    TEST_ASSERT_EQUAL(0, before->count);
+    TEST_ASSERT_EQUAL(10, gp.count);
+    TEST_ASSERT_EQUAL(10, gp.inView[gnss::SYS_GPS]);
+    TEST_ASSERT_EQUAL(1, gp.cycles);
+    TEST_ASSERT_EQUAL(7, gp.sats[2].prn);
+    TEST_ASSERT_EQUAL(67, gp.sats[2].elevation);
+    TEST_ASSERT_EQUAL(45, gp.sats[2].azimuth);
+    TEST_ASSERT_EQUAL(47, gp.sats[2].cn0);
+    TEST_ASSERT_EQUAL(0, gp.sats[4].cn0);   // in view, not tracked
+
+    // GLONASS half-way: the published set is still GPS only
+    gsv("GL", 2, 1, 7, GL, 4);
+    TEST_ASSERT_EQUAL(10, g_sink->table.snapshot().count);
+    gsv("GL", 2, 2, 7, GL + 4, 3);
+    cycle("GA", GA, 4);
+    cycle("BD", BD, 6);
+    const gnss::SatSnapshot &all = g_sink->table.snapshot();
+    TEST_ASSERT_EQUAL(4, g_sink->published);
+    TEST_ASSERT_EQUAL(27, all.count);
+    TEST_ASSERT_EQUAL(27, all.totalInView());
+    TEST_ASSERT_EQUAL(10, countSystem(all, gnss::SYS_GPS));
+    TEST_ASSERT_EQUAL(7, countSystem(all, gnss::SYS_GLONASS));
+    TEST_ASSERT_EQUAL(4, countSystem(all, gnss::SYS_GALILEO));
+    TEST_ASSERT_EQUAL(6, countSystem(all, gnss::SYS_BEIDOU));
+
+    // A new GPS cycle replaces only the GPS satellites
+    cycle("GP", GP, 6, 9);
+    const gnss::SatSnapshot &next = g_sink->table.snapshot();
+    TEST_ASSERT_EQUAL(23, next.count);
+    TEST_ASSERT_EQUAL(6, countSystem(next, gnss::SYS_GPS));
+    TEST_ASSERT_EQUAL(7, countSystem(next, gnss::SYS_GLONASS));
+    TEST_ASSERT_EQUAL(9, next.inView[gnss::SYS_GPS]);
+    TEST_ASSERT_EQUAL(5, next.cycles);
+}
+
+void test_out_of_order_and_missing_messages(void) {
+    cycle("GL", GL, 7);
+    TEST_ASSERT_EQUAL(1, g_sink->published);
+    // GPS 1, 3: the skipped message drops the cycle, and its last message publishes nothing
+    gsv("GP", 3, 1, 10, GP, 4);
+    gsv("GP", 3, 3, 10, GP + 8, 2);
+    gsv("GP", 3, 2, 10, GP + 4, 4);
+    TEST_ASSERT_EQUAL(1, g_sink->published);
+    // 1, 2 and no 3: the next cycle starts over, without the stale satellites
+    gsv("GP", 3, 1, 10, GP, 4);
+    gsv("GP", 3, 2, 10, GP + 4, 4);
+    gsv("GP", 2, 1, 6, GP, 4);
+    gsv("GP", 2, 2, 6, GP + 4, 2);
+    TEST_ASSERT_EQUAL(2, g_sink->published);
+    TEST_ASSERT_EQUAL(6, countSystem(g_sink->table.snapshot(), gnss::SYS_GPS));
+    // A repeated message, and a message count that changes mid-cycle
+    gsv("GP", 3, 1, 10, GP, 4);
+    gsv("GP", 3, 1, 10, GP, 4);
+    gsv("GP", 3, 2, 10, GP + 4, 4);
+    gsv("GP", 3, 3, 10, GP + 8, 2);
+    TEST_ASSERT_EQUAL(3, g_sink->published);   // the repeat restarted the cycle, which then completed
+    gsv("GP", 3, 1, 10, GP, 4);
+    gsv("GP", 4, 2, 10, GP + 4, 4);
+    gsv("GP", 3, 3, 10, GP + 8, 2);
+    TEST_ASSERT_EQUAL(3, g_sink->published);
+    // A cycle starting mid-way waits for its first message
+    gsv("GA", 2, 2, 6, GA, 2);
+    TEST_ASSERT_EQUAL(3, g_sink->published);
+    const gnss::SatSnapshot &s = g_sink->table.snapshot();
+    TEST_ASSERT_EQUAL(10, countSystem(s, gnss::SYS_GPS));
+    TEST_ASSERT_EQUAL(7, countSystem(s, gnss::SYS_GLONASS));
+    TEST_ASSERT_EQUAL(0, countSystem(s, gnss::SYS_GALILEO));
+}
+
+// A constellation reporting more than SATS_PER_CYCLE keeps the first ones; its in-view count
+// is the receiver's
+void test_per_constellation_cap(void) {
+    Sat many[20];
+    for (int i = 0; i < 20; ++i) many[i] = Sat{ i + 1, 10 + i, 18 * i, 20 + i };
+    cycle("GP", many, 20);
+    cycle("GA", GA, 4);
+    const gnss::SatSnapshot &s = g_sink->table.snapshot();
+    TEST_ASSERT_EQUAL(gnss::SATS_PER_CYCLE, countSystem(s, gnss::SYS_GPS));
+    TEST_ASSERT_EQUAL(20, s.inView[gnss::SYS_GPS]);
+    TEST_ASSERT_EQUAL(24, s.totalInView());
+    TEST_ASSERT_EQUAL(gnss::SATS_PER_CYCLE + 4, s.count);
+    for (int i = 0; i < s.count; ++i) if (s.sats[i].system == gnss::SYS_GPS) TEST_ASSERT_LESS_OR_EQUAL(gnss::SATS_PER_CYCLE, s.sats[i].prn);
+    // Four full constellations overflow the table: it holds SAT_TABLE_CAPACITY
+    cycle("GL", many, 20);
+    cycle("BD", many, 20);
+    TEST_ASSERT_EQUAL(gnss::SAT_TABLE_CAPACITY, g_sink->table.snapshot().count);
+}
+
+// Average over tracked satellites only (empty C/N0 fields are not zeros), rounded; top-4 is the
+// mean of the four strongest across constellations
+void test_cn0_average_and_top4(void) {
+    cycle("GP", GP, 10);
+    const gnss::SatSnapshot &gp = g_sink->table.snapshot();
+    // Tracked: 42 31 47 38 44 35 46 40 = 323 / 8 = 40.4
+    TEST_ASSERT_EQUAL(40, gp.averageCn0());
+    uint8_t top[4];
+    TEST_ASSERT_EQUAL(4, gp.topCn0(top, 4));
+    TEST_ASSERT_EQUAL(47, top[0]);
+    TEST_ASSERT_EQUAL(46, top[1]);
+    TEST_ASSERT_EQUAL(44, top[2]);
+    TEST_ASSERT_EQUAL(42, top[3]);
+    TEST_ASSERT_EQUAL(45, gp.topCn0Average(4));   // 179 / 4 = 44.75
+    cycle("GA", GA, 4);
+    cycle("BD", BD, 6);
+    const gnss::SatSnapshot &s = g_sink->table.snapshot();
+    // + 45 37 40 30 + 44 39 32 41 35 = 323 + 152 + 191 = 666 / 17 = 39.2
+    TEST_ASSERT_EQUAL(39, s.averageCn0());
+    TEST_ASSERT_EQUAL(46, s.topCn0Average(4));    // 47 46 45 44 = 45.5, rounded up
+    // Nothing tracked, or fewer than four
+    gnss::SatSnapshot empty;
+    TEST_ASSERT_EQUAL(0, empty.averageCn0());
+    TEST_ASSERT_EQUAL(0, empty.topCn0Average(4));
+    setUp();
+    cycle("GA", GA, 2);
+    TEST_ASSERT_EQUAL(41, g_sink->table.snapshot().topCn0Average(4));   // 45 37
+}
+
+// A receiver sending one combined GN cycle: its satellites are kept under SYS_COMBINED, not
+// lost in SYS_OTHER, and a GN cycle replaces the previous GN set like any constellation's
+void test_combined_gn_cycle(void) {
+    Sat mixed[8] = { GP[0], GP[2], GP[3], GL[0], GL[2], GA[0], GA[1], BD[0] };
+    cycle("GN", mixed, 8);
+    const gnss::SatSnapshot &s = g_sink->table.snapshot();
+    TEST_ASSERT_EQUAL(8, countSystem(s, gnss::SYS_COMBINED));
+    TEST_ASSERT_EQUAL(0, countSystem(s, gnss::SYS_OTHER));
+    TEST_ASSERT_EQUAL(8, s.inView[gnss::SYS_COMBINED]);
+    TEST_ASSERT_EQUAL(8, s.totalInView());
+    cycle("GN", mixed, 5);
+    TEST_ASSERT_EQUAL(5, g_sink->table.snapshot().count);
+    TEST_ASSERT_EQUAL(2, g_sink->published);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_talkers);
+    RUN_TEST(test_cycles_assemble_and_flip);
+    RUN_TEST(test_out_of_order_and_missing_messages);
+    RUN_TEST(test_per_constellation_cap);
+    RUN_TEST(test_cn0_average_and_top4);
+    RUN_TEST(test_combined_gn_cycle);
+    return UNITY_END();
+}
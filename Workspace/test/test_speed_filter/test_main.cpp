@@ -0,0 +1,143 @@
+// Known-truth replay of the speed needle: one lap of the demo drive (include/demo_drive.hpp)
+// goes through the NMEA parser and nav::SpeedFilter (include/speed_filter.hpp) the way
+// gps_module and main.cpp wire them, at 10 Hz and at the 1 Hz of a duty-cycled receiver. The
+// needle is sampled at the UI frame rate and compared with the generator's true speed: RMS error
+// and lag (the delay that best lines the needle up with the truth) are reported next to the
+// needle main.cpp used to draw, the gated speed of the last fix held until the next, and both
+// must stay within bounds. The lag includes the DECODE_MS between an epoch and its decoded RMC,
+// which the filter (keyed on decode time) cannot see. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "demo_drive.hpp"
+#include "nmea_parser.hpp"
+#include "speed_filter.hpp"
+
+#ifndef SPEED_MAX_RMS_10HZ_KMH
+#define SPEED_MAX_RMS_10HZ_KMH 0.6
+#endif
+#ifndef SPEED_MAX_LAG_10HZ_MS
+#define SPEED_MAX_LAG_10HZ_MS 120
+#endif
+#ifndef SPEED_MAX_RMS_1HZ_KMH
+#define SPEED_MAX_RMS_1HZ_KMH 2.5
+#endif
+#ifndef SPEED_MAX_LAG_1HZ_MS
+#define SPEED_MAX_LAG_1HZ_MS 250
+#endif
+
+static const uint32_t TICK_MS = 20;        // truth resolution
+static const uint32_t FRAME_MS = 40;       // UI_FRAME_MS default
+static const uint32_t DECODE_MS = 60;      // epoch to decoded RMC (UART burst + parse)
+static const uint32_t MAX_LAG_MS = 1500;   // lag search range
+static const float GATE_SIGMA_BUILD = 2.0f; // GPS_SPEED_GATE_SIGMA default
+
+struct NeedleSample { uint32_t tMs; float filtered, held; };
+
+// gps_module's gate on the raw report, main.cpp's filter feed and reset on a void fix
+struct NeedleSink {
+    nav::SpeedFilter filter;
+    uint32_t nowMs = 0, epoch = 0;
+    float hdop = 0.0f, heldKmh = 0.0f;
+    bool fix = false;
+
+    void onSentence(const nmea::Gga &s) { if (s.hdop > 0.0f) hdop = s.hdop; }
+    void onSentence(const nmea::Rmc &s) {
+        fix = s.active;
+        if (!fix) { filter.reset(); return; }
+        float kmh = s.speedKnots * 1.852f, sAcc = hdop * nav::SACC_KMH_PER_HDOP;
+        heldKmh = kmh < nav::speedGateKmh(GATE_SIGMA_BUILD, sAcc, false) ? 0.0f : kmh;
+        filter.update(nowMs, kmh, s.courseDeg, sAcc, false, ++epoch);
+    }
+};
+
+struct Score { double rmsKmh, lagMs; };
+
+// RMS of needle(t) against truth(t - lagMs)
+static double rmsAt(const std::vector<NeedleSample> &n, const std::vector<float> &truth, uint32_t lagMs, bool filtered) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (const NeedleSample &s : n) {
+        if (s.tMs < MAX_LAG_MS) continue; // same samples for every lag
+        double e = (filtered ? s.filtered : s.held) - truth[(s.tMs - lagMs) / TICK_MS];
+        sum += e * e;
+        count++;
+    }
+    return count ? sqrt(sum / count) : 0.0;
+}
+
+static Score score(const std::vector<NeedleSample> &n, const std::vector<float> &truth, bool filtered) {
+    Score s = { rmsAt(n, truth, 0, filtered), 0.0 };
+    double best = s.rmsKmh;
+    for (uint32_t lag = TICK_MS; lag <= MAX_LAG_MS; lag += TICK_MS) {
+        double r = rmsAt(n, truth, lag, filtered);
+        if (r < best) { best = r; s.lagMs = lag; }
+    }
+    return s;
+}
+
+// One lap at 'epochMs' between fixes; the needle is only scored while there is a fix
+static void replay(uint32_t epochMs, Score &filtered, Score &held) {
+    uint32_t lapMs = 0;
+    for (size_t i = 0; i < demo::DEFAULT_DRIVE_LEN; ++i) lapMs += demo::DEFAULT_DRIVE[i].durationMs;
+    demo::DriveGenerator gen;
+    nmea::Parser<nmea::Gga, nmea::Rmc> parser;
+    NeedleSink sink;
+    std::vector<float> truth(1, gen.state().speedKmh);
+    std::vector<NeedleSample> needle;
+    char buf[demo::DRIVE_EPOCH_MAX];
+    size_t pending = 0;
+    uint32_t dueMs = 0;
+    while (gen.state().tMs < lapMs) {
+        gen.step(TICK_MS);
+        uint32_t t = gen.state().tMs;
+        truth.push_back(gen.state().speedKmh);
+        if (pending && t >= dueMs) {
+            sink.nowMs = dueMs;
+            for (size_t i = 0; i < pending; ++i) parser.feed(buf[i], sink);
+            pending = 0;
+        }
+        if (t % epochMs == 0) {
+            pending = gen.nmea(buf, sizeof(buf), false);
+            dueMs = t + DECODE_MS;
+        }
+        if (t % FRAME_MS == 0 && sink.fix && sink.filter.valid()) {
+            NeedleSample s = { t, sink.filter.speedKmhAt(t), sink.heldKmh };
+            needle.push_back(s);
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(lapMs / FRAME_MS * 9 / 10, (uint32_t)needle.size());
+    filtered = score(needle, truth, true);
+    held = score(needle, truth, false);
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%4u ms fixes: filtered RMS %.2f km/h, lag %.0f ms | last fix held RMS %.2f km/h, lag %.0f ms",
+             epochMs, filtered.rmsKmh, filtered.lagMs, held.rmsKmh, held.lagMs);
+    TEST_MESSAGE(msg);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_needle_10hz(void) {
+    Score f, h;
+    replay(100, f, h);
+    TEST_ASSERT_LESS_THAN(SPEED_MAX_RMS_10HZ_KMH, f.rmsKmh);
+    TEST_ASSERT_LESS_OR_EQUAL(SPEED_MAX_LAG_10HZ_MS, f.lagMs);
+    TEST_ASSERT_TRUE(f.rmsKmh < h.rmsKmh && f.lagMs < h.lagMs);
+}
+
+void test_needle_1hz(void) {
+    Score f, h;
+    replay(1000, f, h);
+    TEST_ASSERT_LESS_THAN(SPEED_MAX_RMS_1HZ_KMH, f.rmsKmh);
+    TEST_ASSERT_LESS_OR_EQUAL(SPEED_MAX_LAG_1HZ_MS, f.lagMs);
+    TEST_ASSERT_TRUE(f.rmsKmh < h.rmsKmh && f.lagMs < h.lagMs);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_needle_10hz);
+    RUN_TEST(test_needle_1hz);
+    return UNITY_END();
+}
@@ -0,0 +1,144 @@
+// Parked replay: 20 minutes of a stationary NMEA receiver (test/data/nmea/parked.nmea) through
+// the parser, the raw speed gate, the speed filter and the trip computer, mapped the way
+// gps_module and main.cpp do it. Standing still must read zero on the needle and add no
+// distance or moving time. Also checks that two reports of one fix update the filter once.
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "nmea_parser.hpp"
+#include "speed_filter.hpp"
+#include "trip_computer.hpp"
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "test/data"
+#endif
+
+static const float GATE_SIGMA_BUILD = 2.0f;   // GPS_SPEED_GATE_SIGMA default
+
+static std::vector<uint8_t> readFile(const std::string &path) {
+    std::vector<uint8_t> d;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return d;
+    int c;
+    while ((c = fgetc(f)) != EOF) d.push_back((uint8_t)c);
+    fclose(f);
+    return d;
+}
+
+struct ParkedSink {
+    nav::SpeedFilter filter;
+    nav::TripComputer trip;
+    float hdop = 0.0f;
+    uint32_t epoch = 0;
+    uint32_t reports = 0, rawPassed = 0, hdopGatePassed = 0;
+    uint32_t needleSamples = 0, needleNonZero = 0;
+    float needleMax = 0.0f, rawMax = 0.0f;
+
+    // gps_module: every speed report is gated, then main.cpp feeds the filter
+    void speed(uint32_t tMs, float kmh, float course) {
+        reports++;
+        if (kmh > rawMax) rawMax = kmh;
+        float sAcc = hdop * nav::SACC_KMH_PER_HDOP;
+        if (kmh >= nav::speedGateKmh(GATE_SIGMA_BUILD, sAcc, false)) rawPassed++;
+        // The gate as it was: 2 x the HDOP estimate, 0.3 km/h floor
+        float old = GATE_SIGMA_BUILD * sAcc;
+        if (kmh >= (old < nav::MIN_GATE_KMH ? nav::MIN_GATE_KMH : old)) hdopGatePassed++;
+        filter.update(tMs, kmh, course, sAcc, false, epoch);
+    }
+    void onSentence(const nmea::Rmc &s) {
+        if (!s.active) return;
+        epoch++;
+        uint32_t t = epoch * 1000 + 40;
+        speed(t, s.speedKnots * 1.852f, s.courseDeg);
+        trip.update(t, s.latE7, s.lonE7, filter.speedKmhAt(t), 0.0f);
+        // The needle between this fix and the next, at the UI frame rate
+        for (uint32_t dt = 0; dt < 1000; dt += 40) {
+            float v = filter.speedKmhAt(t + dt);
+            needleSamples++;
+            if (v > 0.0f) needleNonZero++;
+            if (v > needleMax) needleMax = v;
+        }
+    }
+    void onSentence(const nmea::Vtg &s) { if (s.valid) speed(epoch * 1000 + 43, s.speedKmh, s.courseDeg); }
+    void onSentence(const nmea::Gsa &s) { if (s.hdop > 0.0f) hdop = s.hdop; }
+    void onSentence(const nmea::Gga &s) { if (s.hdop > 0.0f) hdop = s.hdop; }
+};
+
+static ParkedSink g_sink;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void replay() {
+    static bool done = false;
+    if (done) return;
+    std::vector<uint8_t> data = readFile(std::string(TEST_DATA_DIR) + "/nmea/parked.nmea");
+    TEST_ASSERT_TRUE_MESSAGE(!data.empty(), "parked.nmea missing (run from the project directory)");
+    nmea::Parser<nmea::Gga, nmea::Rmc, nmea::Gsa, nmea::Vtg> parser;
+    for (uint8_t c : data) parser.feed((char)c, g_sink);
+    done = true;
+    char msg[200];
+    snprintf(msg, sizeof(msg), "%u reports, raw max %.2f km/h: gate passes %u (HDOP-only gate would pass %u), needle max %.2f km/h",
+             g_sink.reports, g_sink.rawMax, g_sink.rawPassed, g_sink.hdopGatePassed, g_sink.needleMax);
+    TEST_MESSAGE(msg);
+}
+
+void test_parked_needle_stays_zero(void) {
+    replay();
+    TEST_ASSERT_EQUAL(1200, g_sink.epoch);
+    TEST_ASSERT_EQUAL(0, g_sink.needleNonZero);
+}
+
+void test_parked_adds_no_distance_or_moving_time(void) {
+    replay();
+    const nav::TripTotals &a = g_sink.trip.trip(nav::TRIP_A);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, g_sink.trip.odometerM());
+    TEST_ASSERT_EQUAL(0, (uint32_t)a.movingMs);
+    TEST_ASSERT_GREATER_THAN(1000000, (uint32_t)a.stoppedMs);
+}
+
+// The raw gate may let the odd multipath spike through, but not ordinary Doppler noise
+void test_parked_raw_gate_rejects_noise(void) {
+    replay();
+    TEST_ASSERT_LESS_OR_EQUAL(g_sink.reports / 500, g_sink.rawPassed);
+}
+
+// The floor must not swallow real low-speed motion, and a reported sAcc still tightens the gate
+void test_gate_keeps_walking_pace(void) {
+    TEST_ASSERT_TRUE(3.0f >= nav::speedGateKmh(GATE_SIGMA_BUILD, 0.8f * nav::SACC_KMH_PER_HDOP, false));
+    TEST_ASSERT_TRUE(3.0f >= nav::speedGateKmh(GATE_SIGMA_BUILD, 0.0f, false));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.6, nav::speedGateKmh(GATE_SIGMA_BUILD, 0.3f, true));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, nav::MAX_GATE_KMH, nav::speedGateKmh(GATE_SIGMA_BUILD, 9.0f, true));
+    nav::SpeedFilter f;
+    for (uint32_t t = 0; t < 20000; t += 1000) f.update(t, 3.0f, 90.0f, 0.8f * nav::SACC_KMH_PER_HDOP, false);
+    TEST_ASSERT_FLOAT_WITHIN(0.2, 3.0, f.speedKmhAt(19000));
+}
+
+// RMC and VTG of one fix arrive a few ms apart: the second must not be taken as a new measurement
+void test_same_epoch_counts_once(void) {
+    nav::SpeedFilter once, twice, unkeyed;
+    for (uint32_t k = 1; k <= 30; ++k) {
+        uint32_t t = k * 1000 + 40;
+        float v = 50.0f + 0.5f * k;
+        once.update(t, v, 10.0f, 0.0f, false, k);
+        twice.update(t, v, 10.0f, 0.0f, false, k);
+        twice.update(t + 3, v, 10.0f, 0.0f, false, k);
+        unkeyed.update(t, v, 10.0f, 0.0f, false);
+        unkeyed.update(t + 3, v, 10.0f, 0.0f, false);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, once.speedKmhAt(30500), twice.speedKmhAt(30500));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, once.gateKmh(), twice.gateKmh());
+    // Without the key a 3 ms "interval" drags the fix interval down and the extrapolation with it
+    TEST_ASSERT_TRUE(unkeyed.speedKmhAt(30900) < once.speedKmhAt(30900));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parked_needle_stays_zero);
+    RUN_TEST(test_parked_adds_no_distance_or_moving_time);
+    RUN_TEST(test_parked_raw_gate_rejects_noise);
+    RUN_TEST(test_gate_keeps_walking_pace);
+    RUN_TEST(test_same_epoch_counts_once);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// Drives of hours at 10 Hz through nav::SpeedHistory (include/speed_history.hpp) with the
+// device's shape (200 buckets x 3 levels x 10): graph columns match a brute-force scan of the raw
+// samples, an update costs the same however long the history has been running (amortised O(1)),
+// and a query costs the same however many samples went in. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "speed_history.hpp"
+
+typedef nav::SpeedHistory<200, 3, 10> History;
+static const int COLS = 180;                 // graph width on the round display
+
+// Regression gates, host ns: fail when an update or a whole graph gets this slow
+#ifndef HIST_BENCH_MAX_NS_PER_ADD
+#define HIST_BENCH_MAX_NS_PER_ADD 200.0
+#endif
+#ifndef HIST_BENCH_MAX_NS_PER_QUERY
+#define HIST_BENCH_MAX_NS_PER_QUERY 50000.0
+#endif
+
+struct Sample { uint32_t sec; float kmh, alt; };
+
+// Deterministic noise, roughly N(0,1)
+static uint32_t g_rng = 1;
+static float gauss() {
+    float sum = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+        sum += (g_rng & 0xFFFF) / 65535.0f;
+    }
+    return (sum - 2.0f) * 1.732f;
+}
+
+// Speed and altitude for tenth-of-a-second 'k': town, motorway and stops, with a fix gap
+static bool drive(uint32_t k, Sample &s) {
+    double t = k * 0.1;
+    if (fmod(t, 5400.0) > 3000.0 && fmod(t, 5400.0) < 3090.0) return false;   // tunnel
+    double v = 70.0 + 50.0 * sin(t / 400.0) + 15.0 * sin(t / 23.0) + 0.5 * gauss();
+    s.sec = 1000 + (uint32_t)(k / 10);
+    s.kmh = v < 0.0 ? 0.0f : (float)v;
+    s.alt = (float)(300.0 + 80.0 * sin(t / 1700.0));
+    return true;
+}
+
+static std::vector<Sample> makeDrive(uint32_t seconds) {
+    std::vector<Sample> d;
+    Sample s;
+    for (uint32_t k = 0; k < seconds * 10; ++k) if (drive(k, s)) d.push_back(s);
+    return d;
+}
+
+// Columns from the raw samples: every bucket of the level the query reads that meets the column
+static void checkSpan(const History &h, const std::vector<Sample> &d, uint32_t spanSec) {
+    nav::HistColumn cols[COLS];
+    uint32_t now = d.back().sec;
+    int level = h.query(now, spanSec, cols, COLS);
+    uint32_t p = History::period(level);
+    uint32_t span = spanSec > History::levelSpan(level) ? History::levelSpan(level) : spanSec;
+    uint32_t t0 = now + 1 >= span ? now + 1 - span : 0;
+    int valid = 0;
+    for (int c = 0; c < COLS; ++c) {
+        uint32_t cs = t0 + (uint32_t)((uint64_t)span * c / COLS), ce = t0 + (uint32_t)((uint64_t)span * (c + 1) / COLS);
+        if (ce <= cs) ce = cs + 1;
+        uint32_t from = cs / p * p, to = ((ce - 1) / p + 1) * p;
+        float vMin = 1e9f, vMax = -1e9f, aMin = 1e9f, aMax = -1e9f;
+        bool any = false;
+        for (const Sample &s : d) {
+            if (s.sec < from || s.sec >= to) continue;
+            any = true;
+            vMin = fminf(vMin, s.kmh); vMax = fmaxf(vMax, s.kmh);
+            aMin = fminf(aMin, s.alt); aMax = fmaxf(aMax, s.alt);
+        }
+        char where[64];
+        snprintf(where, sizeof(where), "span %u s column %d", (unsigned)spanSec, c);
+        TEST_ASSERT_EQUAL_MESSAGE(any, cols[c].valid, where);
+        if (!any) continue;
+        valid++;
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01f, vMin, cols[c].vMin, where);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01f, vMax, cols[c].vMax, where);
+        TEST_ASSERT_TRUE_MESSAGE(cols[c].vAvg >= cols[c].vMin - 0.01f && cols[c].vAvg <= cols[c].vMax + 0.01f, where);
+        TEST_ASSERT_TRUE_MESSAGE(cols[c].altValid, where);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5f, aMin, cols[c].aMin, where);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5f, aMax, cols[c].aMax, where);
+    }
+    TEST_ASSERT_GREATER_THAN(COLS / 2, valid);
+}
+
+void setUp(void) { g_rng = 1; }
+void tearDown(void) {}
+
+void test_columns_match_raw_samples(void) {
+    std::vector<Sample> d = makeDrive(6 * 3600);
+    static History h;
+    h.clear();
+    for (const Sample &s : d) h.add(s.sec, s.kmh, s.alt, true);
+    TEST_ASSERT_EQUAL(d.size(), h.samples());
+    // The spans main.cpp offers, one per level plus the whole reach
+    checkSpan(h, d, 180);
+    checkSpan(h, d, 1800);
+    checkSpan(h, d, 7200);
+    checkSpan(h, d, 19800);
+}
+
+// ns per add() over 'seconds' of 10 Hz samples, repeated until at least 0.2 s has been timed.
+// Speeds come from a short table so the loop measures the history, not memory bandwidth.
+static double nsPerAdd(uint32_t seconds) {
+    static History h;
+    static float kmh[4096];
+    for (int i = 0; i < 4096; ++i) kmh[i] = 70.0f + 50.0f * sinf(i / 400.0f) + gauss();
+    uint64_t n = 0;
+    double s = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    do {
+        h.clear();
+        for (uint32_t k = 0; k < seconds * 10; ++k) h.add(1000 + k / 10, kmh[k & 4095], 300.0f, true);
+        n += seconds * 10;
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    TEST_ASSERT_EQUAL(seconds * 10, h.samples());
+    return s * 1e9 / n;
+}
+
+void test_update_cost_does_not_grow(void) {
+    double a = nsPerAdd(600), b = nsPerAdd(24 * 3600);
+    char msg[160];
+    snprintf(msg, sizeof(msg), "add(): %.1f ns over 10 min, %.1f ns over 24 h", a, b);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(HIST_BENCH_MAX_NS_PER_ADD, b);
+    // Amortised O(1): a day of history costs no more per sample than ten minutes (with slack for timing noise)
+    TEST_ASSERT_LESS_THAN(1.5 * a + 5.0, b);
+}
+
+void test_query_cost_does_not_grow(void) {
+    nav::HistColumn cols[COLS];
+    static History h;
+    const uint32_t spans[] = { 180, 1800, 7200, 19800 };
+    for (uint32_t hours : { 1u, 24u }) {
+        std::vector<Sample> d = makeDrive(hours * 3600);
+        h.clear();
+        for (const Sample &s : d) h.add(s.sec, s.kmh, s.alt, true);
+        for (uint32_t span : spans) {
+            uint64_t n = 0;
+            float sink = 0.0f;
+            double s = 0.0;
+            auto t0 = std::chrono::steady_clock::now();
+            do {
+                for (int i = 0; i < 100; ++i) { h.query(d.back().sec, span, cols, COLS); sink += cols[COLS - 1].vMax; }
+                n += 100;
+                s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            } while (s < 0.05);
+            double ns = s * 1e9 / n;
+            char msg[160];
+            snprintf(msg, sizeof(msg), "query(): %5u s span, %2u h in: %.0f ns for %d columns (check %.0f)", (unsigned)span, (unsigned)hours, ns, COLS, sink / n);
+            TEST_MESSAGE(msg);
+            TEST_ASSERT_LESS_THAN(HIST_BENCH_MAX_NS_PER_QUERY, ns);
+        }
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_columns_match_raw_samples);
+    RUN_TEST(test_update_cost_does_not_grow);
+    RUN_TEST(test_query_cost_does_not_grow);
+    return UNITY_END();
+}
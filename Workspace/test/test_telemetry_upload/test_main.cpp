@@ -0,0 +1,543 @@
+// Telemetry upload (include/telemetry_upload.hpp) against a stub HTTP server on localhost: a
+// session must send every track byte once over one keep-alive connection, a 5xx or a dropped
+// connection must leave the cursor where the server last acknowledged and back off, a 409 with
+// X-Next-Offset is followed, torn or corrupt batches are stepped over, and a cursor saved for
+// other files starts over at the oldest. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "track_codec.hpp"
+#include "telemetry_upload.hpp"
+#ifdef __unix__
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static const size_t BATCH_BYTES = 1024;    // TRACK_BATCH_BYTES in track_log.cpp
+static const size_t BODY_BYTES = 8192;     // TELEMETRY_BODY_BYTES, smaller so a file takes several requests
+
+// 10 Hz drive with turns, speed changes and receiver noise, 'seed' apart per file
+static std::vector<track::Fix> drive(size_t n, uint32_t seed) {
+    std::vector<track::Fix> v;
+    uint32_t rng = 12345 + seed;
+    double lat = 48.137154, lon = 11.576124, course = 30.0, speed = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        double target = (i / 600) % 4 == 3 ? 0.0 : 15.0 + 10.0 * ((i / 600) % 3);
+        speed += (target - speed) * 0.02;
+        course += ((i / 300) % 2 ? 0.4 : -0.1);
+        double d = speed * 0.1;
+        lat += d * cos(course * M_PI / 180.0) / 111320.0;
+        lon += d * sin(course * M_PI / 180.0) / 74400.0;
+        track::Fix f;
+        f.utcMs = 1718000000000ULL + seed * 3600000ULL + i * 100;
+        f.latE7 = (int32_t)lround(lat * 1e7) + (int32_t)(rng % 5) - 2;
+        f.lonE7 = (int32_t)lround(lon * 1e7) + (int32_t)((rng >> 8) % 5) - 2;
+        f.speedCms = (int32_t)lround(speed * 100.0);
+        f.altDm = 5200 + (int32_t)(150.0 * sin(i * 1e-3));
+        v.push_back(f);
+    }
+    return v;
+}
+
+// Sealed batches, each its own byte string, as track_log writes them
+static std::vector<std::string> encode(const std::vector<track::Fix> &fixes) {
+    std::vector<std::string> batches;
+    uint8_t buf[BATCH_BYTES];
+    track::BatchEncoder enc(buf, sizeof(buf));
+    for (const track::Fix &f : fixes) {
+        if (enc.add(f)) continue;
+        batches.push_back(std::string((const char*)buf, enc.seal()));
+        enc.reset();
+        enc.add(f);
+    }
+    size_t n = enc.seal();
+    if (n) batches.push_back(std::string((const char*)buf, n));
+    return batches;
+}
+
+static std::string join(const std::vector<std::string> &batches) {
+    std::string s;
+    for (const std::string &b : batches) s += b;
+    return s;
+}
+
+// Track files in memory, numbered like /tracks/NNNNNN.trk
+class MemStore : public telemetry::Store {
+public:
+    std::map<uint32_t, std::string> files;
+
+    bool range(uint32_t &first, uint32_t &last) override {
+        if (files.empty()) return false;
+        first = files.begin()->first;
+        last = files.rbegin()->first;
+        return true;
+    }
+    int64_t size(uint32_t file) override {
+        std::map<uint32_t, std::string>::const_iterator it = files.find(file);
+        return it == files.end() ? -1 : (int64_t)it->second.size();
+    }
+    size_t read(uint32_t file, uint32_t offset, uint8_t* buf, size_t n) override {
+        std::map<uint32_t, std::string>::const_iterator it = files.find(file);
+        if (it == files.end() || offset >= it->second.size()) return 0;
+        size_t got = it->second.size() - offset < n ? it->second.size() - offset : n;
+        memcpy(buf, it->second.data() + offset, got);
+        return got;
+    }
+    uint64_t total() const {
+        uint64_t t = 0;
+        for (std::map<uint32_t, std::string>::const_iterator it = files.begin(); it != files.end(); ++it) t += it->second.size();
+        return t;
+    }
+};
+
+// Three finished-looking track files of 6-8 minutes each (~65 KB together)
+static void fillStore(MemStore &store) {
+    for (uint32_t f = 1; f <= 3; ++f) store.files[f] = join(encode(drive(3000 + 600 * f, f)));
+}
+
+static uint32_t g_nowMs = 1000;
+static uint32_t clockMs() { return g_nowMs; }
+
+static telemetry::Policy policy() {
+    telemetry::Policy p;
+    p.minBytes = 32UL * 1024UL;
+    p.maxDelayMs = 900000;
+    p.maxRequests = 64;
+    p.backoffBaseMs = 30000;
+    p.backoffMaxMs = 1800000;
+    return p;
+}
+
+#ifdef __unix__
+
+// What the stub server does with the next request instead of its usual bookkeeping
+enum Script { REPLY_500, STORE_AND_DROP };
+
+// One-connection-at-a-time HTTP/1.1 server on 127.0.0.1. Like the real endpoint it appends each
+// body to the file it names, acknowledges with 200, and answers a range it already has with 409
+// and X-Next-Offset; an offset beyond what it has (the device skipped bad data) is accepted.
+class StubServer {
+public:
+    struct Request { uint32_t file, offset, length; unsigned conn; std::string trip; };
+
+    bool start() {
+        _listen = socket(AF_INET, SOCK_STREAM, 0);
+        if (_listen < 0) return false;
+        int one = 1;
+        setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in a;
+        memset(&a, 0, sizeof(a));
+        a.sin_family = AF_INET;
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t al = sizeof(a);
+        if (bind(_listen, (sockaddr*)&a, sizeof(a)) != 0 || listen(_listen, 4) != 0 ||
+            getsockname(_listen, (sockaddr*)&a, &al) != 0) { ::close(_listen); _listen = -1; return false; }
+        port = ntohs(a.sin_port);
+        _thread = std::thread(&StubServer::run, this);
+        return true;
+    }
+
+    void stop() {
+        if (_listen < 0) return;
+        shutdown(_listen, SHUT_RDWR);      // wakes accept()
+        _thread.join();
+        ::close(_listen);
+        _listen = -1;
+    }
+
+    void script(Script s) { std::lock_guard<std::mutex> l(_mu); _script.push_back(s); }
+    void preload(uint32_t file, const std::string &bytes) { std::lock_guard<std::mutex> l(_mu); _files[file] = bytes; _next[file] = (uint32_t)bytes.size(); }
+    std::map<uint32_t, std::string> files() { std::lock_guard<std::mutex> l(_mu); return _files; }
+    std::vector<Request> requests() { std::lock_guard<std::mutex> l(_mu); return _requests; }
+    unsigned connections() { std::lock_guard<std::mutex> l(_mu); return _conns; }
+
+    uint16_t port = 0;
+
+private:
+    void run() {
+        for (;;) {
+            int c = accept(_listen, nullptr, nullptr);
+            if (c < 0) return;
+            unsigned conn;
+            { std::lock_guard<std::mutex> l(_mu); conn = ++_conns; }
+            timeval tv = {2, 0};
+            setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            std::string in;
+            while (serve(c, in, conn)) {}
+            ::close(c);
+        }
+    }
+
+    // Read and answer one request; false once the connection is finished
+    bool serve(int c, std::string &in, unsigned conn) {
+        size_t end;
+        while ((end = in.find("\r\n\r\n")) == std::string::npos) if (!fill(c, in)) return false;
+        std::string head = in.substr(0, end + 2);
+        in.erase(0, end + 4);
+        Request r = {0, 0, 0, conn, std::string()};
+        char trip[128] = "";
+        for (size_t at = head.find("\r\n") + 2; at < head.size(); ) {
+            size_t eol = head.find("\r\n", at);
+            std::string line = head.substr(at, eol - at);
+            sscanf(line.c_str(), "Content-Length: %u", &r.length);
+            sscanf(line.c_str(), "X-Track-File: %u", &r.file);
+            sscanf(line.c_str(), "X-Track-Offset: %u", &r.offset);
+            sscanf(line.c_str(), "X-Trip: %127s", trip);
+            at = eol + 2;
+        }
+        r.trip = trip;
+        while (in.size() < r.length) if (!fill(c, in)) return false;
+        std::string body = in.substr(0, r.length);
+        in.erase(0, r.length);
+
+        std::lock_guard<std::mutex> l(_mu);
+        _requests.push_back(r);
+        bool drop = false;
+        if (!_script.empty()) {
+            Script s = _script.front();
+            _script.erase(_script.begin());
+            if (s == REPLY_500) return reply(c, "500 Internal Server Error", -1);
+            drop = true;                   // STORE_AND_DROP: keep the body, lose the reply
+        }
+        uint32_t &next = _next[r.file];
+        if (r.offset < next) return reply(c, "409 Conflict", next);
+        _files[r.file] += body;
+        next = r.offset + r.length;
+        return drop ? false : reply(c, "200 OK", -1);
+    }
+
+    bool fill(int c, std::string &in) {
+        char buf[4096];
+        ssize_t n = recv(c, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        in.append(buf, (size_t)n);
+        return true;
+    }
+
+    bool reply(int c, const char* status, int64_t nextOffset) {
+        char head[160];
+        int n = nextOffset >= 0
+            ? snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nX-Next-Offset: %lld\r\nContent-Length: 2\r\n\r\nok", status, (long long)nextOffset)
+            : snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Length: 2\r\n\r\nok", status);
+        return send(c, head, (size_t)n, MSG_NOSIGNAL) == n;
+    }
+
+    int _listen = -1;
+    std::thread _thread;
+    std::mutex _mu;
+    std::vector<Script> _script;
+    std::map<uint32_t, std::string> _files;
+    std::map<uint32_t, uint32_t> _next;        // per file, where the server wants the next body
+    std::vector<Request> _requests;
+    unsigned _conns = 0;
+};
+
+// WifiTransport without the WiFi: one keep-alive socket to the stub server
+class PosixTransport : public telemetry::Transport {
+public:
+    explicit PosixTransport(uint16_t port) : _port(port), _fd(-1), opens(0) {}
+    ~PosixTransport() { close(); }
+
+    bool open() override { opens++; return connect(); }
+
+    bool exchange(const char* head, size_t headLen, const uint8_t* body, size_t bodyLen, telemetry::ResponseParser &resp, uint32_t &bytesOut, uint32_t &bytesIn) override {
+        if (_fd < 0 && !connect()) return false;
+        if (!sendAll((const uint8_t*)head, headLen, bytesOut) || !sendAll(body, bodyLen, bytesOut)) { close(); return false; }
+        uint8_t buf[256];
+        while (!resp.done() && !resp.error()) {
+            ssize_t n = recv(_fd, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            bytesIn += (uint32_t)n;
+            resp.feed(buf, (size_t)n);
+        }
+        if (!resp.done() || resp.closes()) close();
+        return resp.done();
+    }
+
+    void close() override {
+        if (_fd >= 0) ::close(_fd);
+        _fd = -1;
+    }
+
+private:
+    bool connect() {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (_fd < 0) return false;
+        timeval tv = {2, 0};
+        setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sockaddr_in a;
+        memset(&a, 0, sizeof(a));
+        a.sin_family = AF_INET;
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        a.sin_port = htons(_port);
+        if (::connect(_fd, (sockaddr*)&a, sizeof(a)) == 0) return true;
+        close();
+        return false;
+    }
+
+    bool sendAll(const uint8_t* p, size_t n, uint32_t &bytesOut) {
+        for (size_t sent = 0; sent < n; ) {
+            ssize_t w = send(_fd, p + sent, n - sent, MSG_NOSIGNAL);
+            if (w <= 0) return false;
+            sent += (size_t)w;
+            bytesOut += (uint32_t)w;
+        }
+        return true;
+    }
+
+    uint16_t _port;
+    int _fd;
+
+public:
+    unsigned opens;
+};
+
+static StubServer* g_server = nullptr;
+static uint8_t g_body[BODY_BYTES];
+
+// The uploader as telemetry_uploader.cpp sets it up, pointed at the stub server
+struct Rig {
+    MemStore store;
+    telemetry::Url url;
+    PosixTransport transport;
+    telemetry::Uploader uploader;
+
+    Rig() : url(makeUrl()), transport(g_server->port), uploader(store, transport, g_body, sizeof(g_body), url, "speedo-test", policy(), clockMs) {}
+
+    static telemetry::Url makeUrl() {
+        char s[64];
+        snprintf(s, sizeof(s), "http://127.0.0.1:%u/upload", (unsigned)g_server->port);
+        telemetry::Url u;
+        TEST_ASSERT_TRUE(u.parse(s));
+        return u;
+    }
+};
+
+static void assertServerHas(const std::map<uint32_t, std::string> &expected) {
+    std::map<uint32_t, std::string> got = g_server->files();
+    TEST_ASSERT_EQUAL_MESSAGE(expected.size(), got.size(), "files on the server");
+    for (std::map<uint32_t, std::string>::const_iterator it = expected.begin(); it != expected.end(); ++it) {
+        char where[48];
+        snprintf(where, sizeof(where), "file %u", (unsigned)it->first);
+        TEST_ASSERT_EQUAL_MESSAGE(it->second.size(), got[it->first].size(), where);
+        TEST_ASSERT_TRUE_MESSAGE(got[it->first] == it->second, where);
+    }
+}
+
+#endif // __unix__
+
+void setUp(void) {
+#ifdef __unix__
+    g_server = new StubServer();
+    if (!g_server->start()) { delete g_server; g_server = nullptr; }
+#endif
+}
+
+void tearDown(void) {
+#ifdef __unix__
+    if (g_server) g_server->stop();
+    delete g_server;
+    g_server = nullptr;
+#endif
+}
+
+// Everything pending goes in one session, over one connection, and arrives byte for byte
+void test_session_uploads_everything_once(void) {
+#ifdef __unix__
+    TEST_ASSERT_NOT_NULL_MESSAGE(g_server, "cannot listen on 127.0.0.1");
+    Rig rig;
+    fillStore(rig.store);
+    rig.uploader.setTrip("odo_m=1234;a_m=56");
+    uint64_t total = rig.store.total();
+    TEST_ASSERT_EQUAL(total, rig.uploader.pendingBytes());
+    TEST_ASSERT_TRUE(rig.uploader.due(g_nowMs, false));
+
+    TEST_ASSERT_TRUE(rig.uploader.session(1));
+    assertServerHas(rig.store.files);
+    const telemetry::Stats &s = rig.uploader.stats();
+    TEST_ASSERT_EQUAL(1u, g_server->connections());
+    TEST_ASSERT_EQUAL(1u, rig.transport.opens);
+    TEST_ASSERT_EQUAL(g_server->requests().size(), s.requests);
+    TEST_ASSERT_TRUE(s.requests >= total / BODY_BYTES);
+    TEST_ASSERT_EQUAL(0u, s.failures);
+    TEST_ASSERT_EQUAL(total, s.bodyBytes);
+    TEST_ASSERT_EQUAL(0u, s.skippedBytes);
+    TEST_ASSERT_TRUE(s.bytesOut > total);
+    TEST_ASSERT_EQUAL_STRING("odo_m=1234;a_m=56", g_server->requests()[0].trip.c_str());
+    TEST_ASSERT_EQUAL(0u, rig.uploader.pendingBytes());
+    TEST_ASSERT_EQUAL(3u, rig.uploader.cursor().file);
+    TEST_ASSERT_EQUAL(rig.store.files[3].size(), rig.uploader.cursor().offset);
+
+    // The newest file grows: only the new batches go next time
+    std::string more = join(encode(drive(300, 9)));
+    rig.store.files[3] += more;
+    TEST_ASSERT_EQUAL(more.size(), rig.uploader.pendingBytes());
+    TEST_ASSERT_TRUE(rig.uploader.session(2));
+    std::vector<StubServer::Request> req = g_server->requests();
+    TEST_ASSERT_EQUAL(rig.store.files[3].size() - more.size(), req.back().offset);
+    assertServerHas(rig.store.files);
+#else
+    TEST_IGNORE_MESSAGE("needs POSIX sockets");
+#endif
+}
+
+// A 500 or a connection dropped before the reply moves nothing; the session backs off, and the
+// retry carries on where the server is (a body it stored but could not acknowledge is not repeated)
+void test_failures_keep_the_cursor_and_back_off(void) {
+#ifdef __unix__
+    TEST_ASSERT_NOT_NULL_MESSAGE(g_server, "cannot listen on 127.0.0.1");
+    Rig rig;
+    fillStore(rig.store);
+    uint64_t total = rig.store.total();
+
+    g_server->script(REPLY_500);
+    TEST_ASSERT_FALSE(rig.uploader.session(1));
+    TEST_ASSERT_EQUAL(1u, rig.uploader.stats().failures);
+    TEST_ASSERT_EQUAL(1u, rig.uploader.backoff().failures());
+    TEST_ASSERT_EQUAL(1u, rig.uploader.cursor().file);
+    TEST_ASSERT_EQUAL(0u, rig.uploader.cursor().offset);
+    TEST_ASSERT_EQUAL(total, rig.uploader.pendingBytes());
+    TEST_ASSERT_FALSE(rig.uploader.due(g_nowMs, true));
+    TEST_ASSERT_TRUE(rig.uploader.due(g_nowMs + 60000, true));    // 30 s +-25%
+    g_nowMs += 60000;
+
+    // The first body is stored but the reply never comes
+    g_server->script(STORE_AND_DROP);
+    TEST_ASSERT_FALSE(rig.uploader.session(2));
+    TEST_ASSERT_EQUAL(2u, rig.uploader.stats().failures);
+    TEST_ASSERT_EQUAL(2u, rig.uploader.backoff().failures());
+    TEST_ASSERT_EQUAL(0u, rig.uploader.cursor().offset);
+    TEST_ASSERT_FALSE(rig.uploader.due(g_nowMs + 40000, true));   // 60 s +-25%
+    g_nowMs += 80000;
+    TEST_ASSERT_TRUE(rig.uploader.due(g_nowMs, true));
+
+    // The repeat is answered with 409 and the server's offset, and the rest follows
+    TEST_ASSERT_TRUE(rig.uploader.session(3));
+    TEST_ASSERT_EQUAL(0u, rig.uploader.backoff().failures());
+    TEST_ASSERT_EQUAL(2u, rig.uploader.stats().failures);
+    assertServerHas(rig.store.files);
+    TEST_ASSERT_EQUAL(0u, rig.uploader.pendingBytes());
+    TEST_ASSERT_EQUAL(3u, g_server->connections());    // one per session
+#else
+    TEST_IGNORE_MESSAGE("needs POSIX sockets");
+#endif
+}
+
+// The server already has the start of a file (an upload from before a reboot whose cursor was
+// never saved): its X-Next-Offset is followed rather than sending the range again
+void test_conflict_follows_the_server_offset(void) {
+#ifdef __unix__
+    TEST_ASSERT_NOT_NULL_MESSAGE(g_server, "cannot listen on 127.0.0.1");
+    Rig rig;
+    std::vector<std::string> batches = encode(drive(3000, 1));
+    rig.store.files[1] = join(batches);
+    std::string sent = join(std::vector<std::string>(batches.begin(), batches.begin() + batches.size() / 2));
+    g_server->preload(1, sent);
+
+    TEST_ASSERT_TRUE(rig.uploader.session(1));
+    assertServerHas(rig.store.files);
+    const telemetry::Stats &s = rig.uploader.stats();
+    TEST_ASSERT_EQUAL(0u, s.failures);
+    TEST_ASSERT_EQUAL(rig.store.files[1].size() - sent.size(), s.bodyBytes);
+    std::vector<StubServer::Request> req = g_server->requests();
+    TEST_ASSERT_EQUAL(0u, req[0].offset);
+    TEST_ASSERT_EQUAL(sent.size(), req[1].offset);
+#else
+    TEST_IGNORE_MESSAGE("needs POSIX sockets");
+#endif
+}
+
+// A batch torn by a power cut at the end of an old file and a corrupt one in the middle of the
+// next are stepped over; everything around them arrives
+void test_torn_and_corrupt_batches_are_skipped(void) {
+#ifdef __unix__
+    TEST_ASSERT_NOT_NULL_MESSAGE(g_server, "cannot listen on 127.0.0.1");
+    Rig rig;
+    std::vector<std::string> a = encode(drive(2000, 1)), b = encode(drive(2000, 2));
+    std::string torn = a.back().substr(0, a.back().size() / 2);
+    a.pop_back();
+    rig.store.files[1] = join(a) + torn;
+    std::string bad = b[b.size() / 2];
+    bad[bad.size() / 2] ^= 0x40;
+    std::vector<std::string> b2 = b;
+    b2[b.size() / 2] = bad;
+    rig.store.files[2] = join(b2);
+    b.erase(b.begin() + b.size() / 2);
+
+    TEST_ASSERT_TRUE(rig.uploader.session(1));
+    std::map<uint32_t, std::string> expected;
+    expected[1] = join(a);
+    expected[2] = join(b);
+    assertServerHas(expected);
+    TEST_ASSERT_EQUAL(torn.size() + bad.size(), rig.uploader.stats().skippedBytes);
+    TEST_ASSERT_EQUAL(0u, rig.uploader.stats().failures);
+    TEST_ASSERT_EQUAL(0u, rig.uploader.pendingBytes());
+#else
+    TEST_IGNORE_MESSAGE("needs POSIX sockets");
+#endif
+}
+
+// A cursor saved before the filesystem was formatted points past the files there are now:
+// everything counts as pending again and the next session starts at the oldest file
+void test_stale_cursor_starts_over(void) {
+#ifdef __unix__
+    TEST_ASSERT_NOT_NULL_MESSAGE(g_server, "cannot listen on 127.0.0.1");
+    Rig rig;
+    fillStore(rig.store);
+    uint64_t total = rig.store.total();
+
+    telemetry::Cursor c = {57, 1000};
+    rig.uploader.setCursor(c);
+    TEST_ASSERT_EQUAL(total, rig.uploader.pendingBytes());
+    TEST_ASSERT_EQUAL(1u, rig.uploader.stats().cursorResets);
+    TEST_ASSERT_EQUAL(1u, rig.uploader.cursor().file);
+    TEST_ASSERT_EQUAL(0u, rig.uploader.cursor().offset);
+
+    rig.uploader.setCursor(c);
+    TEST_ASSERT_TRUE(rig.uploader.session(1));
+    TEST_ASSERT_EQUAL(2u, rig.uploader.stats().cursorResets);
+    TEST_ASSERT_EQUAL(0u, rig.uploader.stats().lostFiles);
+    assertServerHas(rig.store.files);
+
+    // Past the end of a file that is there: also another filesystem's position
+    c.file = 2;
+    c.offset = (uint32_t)rig.store.files[2].size() + 500;
+    rig.uploader.setCursor(c);
+    TEST_ASSERT_EQUAL(total, rig.uploader.pendingBytes());
+    TEST_ASSERT_EQUAL(3u, rig.uploader.stats().cursorResets);
+    TEST_ASSERT_EQUAL(1u, rig.uploader.cursor().file);
+
+    // A cursor inside the files is left alone
+    c.offset = 100;
+    rig.uploader.setCursor(c);
+    rig.uploader.pendingBytes();
+    TEST_ASSERT_EQUAL(3u, rig.uploader.stats().cursorResets);
+    TEST_ASSERT_EQUAL(2u, rig.uploader.cursor().file);
+#else
+    TEST_IGNORE_MESSAGE("needs POSIX sockets");
+#endif
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_session_uploads_everything_once);
+    RUN_TEST(test_failures_keep_the_cursor_and_back_off);
+    RUN_TEST(test_conflict_follows_the_server_offset);
+    RUN_TEST(test_torn_and_corrupt_batches_are_skipped);
+    RUN_TEST(test_stale_cursor_starts_over);
+    return UNITY_END();
+}
@@ -0,0 +1,258 @@
+// Track export (include/track_export.hpp) over files written with TrackWriter: the streamed
+// document is exactly length(fixes) bytes in GPX and CSV, seek(k) for every byte offset k gives
+// exactly the rest of the full document, both parse back to the recorded fixes, and the heap
+// used while streaming does not grow with the track. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "track_codec.hpp"
+#include "track_file.hpp"
+#include "track_export.hpp"
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2 1
+#endif
+
+#ifndef P_tmpdir
+#define P_tmpdir "."
+#endif
+
+static const size_t BATCH_BYTES = 1024;   // TRACK_BATCH_BYTES in track_log.cpp
+static const size_t CHUNK = 1436;         // TRACK_EXPORT_CHUNK
+static const char* NAME = "000042";       // the 6-digit track index, as track_export.cpp names it
+
+static std::string g_path;
+static uint8_t g_buf[track::BATCH_MAX];
+
+// 10 Hz drive with turns, speed changes, a stop, receiver noise and a southern/western start
+// for some of it, so signs and zero padding are exercised
+static std::vector<track::Fix> drive(size_t n) {
+    std::vector<track::Fix> v;
+    uint32_t rng = 12345;
+    double lat = -0.0004, lon = -0.0011, course = 30.0, speed = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        double target = (i / 600) % 4 == 3 ? 0.0 : 15.0 + 10.0 * ((i / 600) % 3);
+        speed += (target - speed) * 0.02;
+        course += ((i / 300) % 2 ? 0.4 : -0.1);
+        double d = speed * 0.1;
+        lat += d * cos(course * M_PI / 180.0) / 111320.0;
+        lon += d * sin(course * M_PI / 180.0) / 111320.0;
+        track::Fix f;
+        f.utcMs = 1718000000000ULL + i * 100 + (rng % 3 == 0 ? 1 : 0);
+        f.latE7 = (int32_t)lround(lat * 1e7) + (int32_t)(rng % 5) - 2;
+        f.lonE7 = (int32_t)lround(lon * 1e7) + (int32_t)((rng >> 8) % 5) - 2;
+        f.speedCms = (int32_t)lround(speed * 100.0);
+        f.altDm = (int32_t)(150.0 * sin(i * 1e-2)) - 20;
+        v.push_back(f);
+    }
+    return v;
+}
+
+// Write 'fixes' as TrackWriter appends them: sealed batches of 'batchBytes'
+static void writeTrack(const std::vector<track::Fix> &fixes, size_t batchBytes) {
+    track::TrackWriter w;
+    TEST_ASSERT_TRUE(w.open(g_path.c_str()));
+    uint8_t buf[BATCH_BYTES];
+    track::BatchEncoder enc(buf, batchBytes);
+    for (const track::Fix &f : fixes) {
+        if (enc.add(f)) continue;
+        TEST_ASSERT_TRUE(w.append(buf, enc.seal()));
+        enc.reset();
+        enc.add(f);
+    }
+    size_t n = enc.seal();
+    if (n) TEST_ASSERT_TRUE(w.append(buf, n));
+    w.close();
+}
+
+// What handleExport() sends: count the fixes, limit the stream to them, optionally seek, read in
+// chunks. 'ok' is false if the seek was refused.
+static std::string exportTrack(track::ExportFormat fmt, uint64_t from = 0, uint64_t* length = nullptr, bool* ok = nullptr) {
+    FILE* f = fopen(g_path.c_str(), "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    fseek(f, 0, SEEK_END);
+    long bytes = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint32_t fixes = track::countFixes(f, g_buf, bytes);
+    fseek(f, 0, SEEK_SET);
+    track::ExportStream ex(f, g_buf, fmt, NAME);
+    ex.setLimit(fixes);
+    if (length) *length = ex.length(fixes);
+    std::string doc;
+    bool seeked = !from || ex.seek(from);
+    if (ok) *ok = seeked;
+    char chunk[CHUNK];
+    size_t n;
+    while (seeked && (n = ex.read(chunk, sizeof(chunk))) > 0) doc.append(chunk, n);
+    fclose(f);
+    return doc;
+}
+
+static std::vector<std::string> lines(const std::string &doc) {
+    std::vector<std::string> v;
+    size_t at = 0, eol;
+    while ((eol = doc.find('\n', at)) != std::string::npos) { v.push_back(doc.substr(at, eol - at)); at = eol + 1; }
+    TEST_ASSERT_EQUAL_MESSAGE(doc.size(), at, "document does not end in a newline");
+    return v;
+}
+
+// "2024-06-10T06:13:20.001Z" -> ms since 1970
+static uint64_t parseTime(const char* s) {
+    int y, mo, d, h, mi, sec, ms;
+    if (sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d.%3dZ", &y, &mo, &d, &h, &mi, &sec, &ms) != 7) return 0;
+    y -= mo <= 2;
+    int era = y / 400, yoe = y - era * 400;
+    int doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint64_t days = (uint64_t)(era * 146097 + doe - 719468);
+    return ((days * 24 + h) * 60 + mi) * 60000ULL + sec * 1000ULL + ms;
+}
+
+// The decimal text must give back the stored integer exactly
+static void assertFix(const track::Fix &want, uint64_t utcMs, double lat, double lon, double alt, double speed, size_t row) {
+    char where[48];
+    snprintf(where, sizeof(where), "row %u", (unsigned)row);
+    TEST_ASSERT_TRUE_MESSAGE(want.utcMs == utcMs, where);
+    TEST_ASSERT_EQUAL_MESSAGE(want.latE7, (int32_t)llround(lat * 1e7), where);
+    TEST_ASSERT_EQUAL_MESSAGE(want.lonE7, (int32_t)llround(lon * 1e7), where);
+    TEST_ASSERT_EQUAL_MESSAGE(want.altDm, (int32_t)llround(alt * 10.0), where);
+    TEST_ASSERT_EQUAL_MESSAGE(want.speedCms, (int32_t)llround(speed * 100.0), where);
+}
+
+static void parseCsv(const std::string &doc, const std::vector<track::Fix> &fixes) {
+    std::vector<std::string> rows = lines(doc);
+    TEST_ASSERT_EQUAL(fixes.size() + 1, rows.size());
+    TEST_ASSERT_EQUAL_STRING("time,lat,lon,alt_m,speed_ms", rows[0].c_str());
+    for (size_t i = 0; i < fixes.size(); ++i) {
+        char time[32];
+        double lat, lon, alt, speed;
+        char tail;
+        TEST_ASSERT_EQUAL(5, sscanf(rows[i + 1].c_str(), "%31[^,],%lf,%lf,%lf,%lf%c", time, &lat, &lon, &alt, &speed, &tail));
+        assertFix(fixes[i], parseTime(time), lat, lon, alt, speed, i);
+    }
+}
+
+// The structure handleExport() promises: XML declaration, one gpx/trk/trkseg, one trkpt per
+// line with the five values, then the closing tags
+static void parseGpx(const std::string &doc, const std::vector<track::Fix> &fixes) {
+    std::vector<std::string> rows = lines(doc);
+    TEST_ASSERT_EQUAL(fixes.size() + 5, rows.size());
+    TEST_ASSERT_EQUAL_STRING("<?xml version=\"1.0\" encoding=\"UTF-8\"?>", rows[0].c_str());
+    TEST_ASSERT_TRUE(rows[1].compare(0, 5, "<gpx ") == 0 && rows[1].find("xmlns=\"http://www.topografix.com/GPX/1/0\"") != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING((std::string("<trk><name>") + NAME + "</name><trkseg>").c_str(), rows[2].c_str());
+    for (size_t i = 0; i < fixes.size(); ++i) {
+        double lat, lon, alt, speed;
+        char time[32];
+        int end = 0;
+        int got = sscanf(rows[i + 3].c_str(), "<trkpt lat=\"%lf\" lon=\"%lf\"><ele>%lf</ele><time>%31[^<]</time><speed>%lf</speed></trkpt>%n",
+                         &lat, &lon, &alt, time, &speed, &end);
+        TEST_ASSERT_EQUAL(5, got);
+        TEST_ASSERT_EQUAL(rows[i + 3].size(), (size_t)end);
+        assertFix(fixes[i], parseTime(time), lat, lon, alt, speed, i);
+    }
+    TEST_ASSERT_EQUAL_STRING("</trkseg></trk>", rows[fixes.size() + 3].c_str());
+    TEST_ASSERT_EQUAL_STRING("</gpx>", rows[fixes.size() + 4].c_str());
+}
+
+void setUp(void) { g_path = std::string(P_tmpdir) + "/test_track_export.trk"; remove(g_path.c_str()); }
+void tearDown(void) { remove(g_path.c_str()); }
+
+// Ten minutes at 10 Hz: the byte count matches length() and the text reads back as the fixes
+void test_length_and_parse(void) {
+    std::vector<track::Fix> fixes = drive(6000);
+    writeTrack(fixes, BATCH_BYTES);
+    for (int k = 0; k < 2; ++k) {
+        track::ExportFormat fmt = k ? track::EXPORT_CSV : track::EXPORT_GPX;
+        uint64_t length = 0;
+        std::string doc = exportTrack(fmt, 0, &length);
+        TEST_ASSERT_EQUAL((uint32_t)length, doc.size());
+        if (fmt == track::EXPORT_CSV) parseCsv(doc, fixes);
+        else parseGpx(doc, fixes);
+        char msg[96];
+        snprintf(msg, sizeof(msg), "%s: %u fixes, %u bytes (%.1f per fix)", track::exportExt(fmt), (unsigned)fixes.size(),
+                 (unsigned)doc.size(), (double)doc.size() / fixes.size());
+        TEST_MESSAGE(msg);
+    }
+}
+
+// Every byte offset of a track spread over several batches resumes with exactly the rest of the
+// document; the end of the document is refused
+void test_seek_every_offset(void) {
+    std::vector<track::Fix> fixes = drive(150);
+    writeTrack(fixes, 256);                         // small batches: many batch boundaries
+    for (int k = 0; k < 2; ++k) {
+        track::ExportFormat fmt = k ? track::EXPORT_CSV : track::EXPORT_GPX;
+        uint64_t length = 0;
+        std::string full = exportTrack(fmt, 0, &length);
+        TEST_ASSERT_EQUAL((uint32_t)length, full.size());
+        for (uint64_t at = 1; at < length; ++at) {
+            bool ok = false;
+            std::string rest = exportTrack(fmt, at, nullptr, &ok);
+            if (!ok || rest.size() != length - at || memcmp(rest.data(), full.data() + at, rest.size()) != 0) {
+                char msg[64];
+                snprintf(msg, sizeof(msg), "%s: seek(%u) differs", track::exportExt(fmt), (unsigned)at);
+                TEST_FAIL_MESSAGE(msg);
+            }
+        }
+        bool ok = true;
+        exportTrack(fmt, length, nullptr, &ok);
+        TEST_ASSERT_FALSE(ok);
+    }
+}
+
+// Heap in use while streaming a one-minute and a two-hour track: no growth in either
+void test_heap_flat(void) {
+#ifdef HAVE_MALLINFO2
+    size_t growth[2];
+    uint32_t sizes[2] = { 600, 72000 };
+    for (int t = 0; t < 2; ++t) {
+        remove(g_path.c_str());                     // TrackWriter appends
+        writeTrack(drive(sizes[t]), BATCH_BYTES);
+        FILE* f = fopen(g_path.c_str(), "rb");
+        TEST_ASSERT_NOT_NULL(f);
+        fseek(f, 0, SEEK_END);
+        long bytes = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        uint32_t fixes = track::countFixes(f, g_buf, bytes);
+        fseek(f, 0, SEEK_SET);
+        size_t base = mallinfo2().uordblks, peak = base;
+        {
+            track::ExportStream ex(f, g_buf, track::EXPORT_GPX, NAME);
+            ex.setLimit(fixes);
+            char chunk[CHUNK];
+            uint64_t total = 0;
+            size_t n;
+            while ((n = ex.read(chunk, sizeof(chunk))) > 0) {
+                total += n;
+                size_t used = mallinfo2().uordblks;
+                if (used > peak) peak = used;
+            }
+            TEST_ASSERT_EQUAL((uint32_t)ex.length(fixes), (uint32_t)total);
+            TEST_ASSERT_EQUAL(sizes[t], ex.fixes());
+        }
+        fclose(f);
+        growth[t] = peak - base;
+    }
+    char msg[128];
+    snprintf(msg, sizeof(msg), "heap growth while streaming: %u B (1 min), %u B (2 h); stream object %u B + batch buffer %u B",
+             (unsigned)growth[0], (unsigned)growth[1], (unsigned)sizeof(track::ExportStream), (unsigned)track::BATCH_MAX);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(0, growth[0]);
+    TEST_ASSERT_EQUAL(0, growth[1]);
+#else
+    TEST_IGNORE_MESSAGE("needs glibc mallinfo2()");
+#endif
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_length_and_parse);
+    RUN_TEST(test_seek_every_offset);
+    RUN_TEST(test_heap_flat);
+    return UNITY_END();
+}
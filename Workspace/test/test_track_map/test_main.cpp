@@ -0,0 +1,195 @@
+// A two-hour synthetic drive at 10 Hz through track::TrackSimplifier and track::TrackView
+// (include/track_simplifier.hpp) with the map screen's sizes: the track stays within
+// MAP_VERTICES and close to the driven line, and the per-frame work of renderMap() (view update
+// plus the walk over the cached points) is timed against a fixed host budget, on average and for
+// a frame that re-projects the whole track. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "track_simplifier.hpp"
+
+static const int MAP_VERTICES = 400;          // as in main.cpp
+static const int W = 240, H = 240;
+static const uint32_t FRAME_MS = 40;          // UI_FRAME_MS
+
+// Host budget for the map's own work in a frame (the drawing itself is the panel's), on average
+// and for a frame that re-projects everything. The device is roughly 20x slower than a desktop,
+// so even the worst frame's 100 us here is about 2 ms of a 40 ms frame.
+#ifndef MAP_BENCH_MAX_US_PER_FRAME
+#define MAP_BENCH_MAX_US_PER_FRAME 20.0
+#endif
+#ifndef MAP_BENCH_MAX_US_WORST_FRAME
+#define MAP_BENCH_MAX_US_WORST_FRAME 100.0
+#endif
+
+typedef track::TrackSimplifier<MAP_VERTICES> Track;
+typedef track::TrackView<MAP_VERTICES> View;
+
+struct Fix { uint32_t ms; float e, n, course; };
+
+// Deterministic uniform [0,1)
+static uint32_t g_rng = 1;
+static float uniform() {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (g_rng & 0xFFFFFF) / 16777216.0f;
+}
+
+// Town blocks, country bends and motorway, with a 60 s tunnel every 40 minutes
+static std::vector<Fix> makeDrive(uint32_t seconds) {
+    std::vector<Fix> d;
+    double e = 0.0, n = 0.0, course = 30.0, turn = 0.0, kmh = 50.0;
+    double legLeft = 0.0;
+    for (uint32_t k = 0; k < seconds * 10; ++k) {
+        if (legLeft <= 0.0) {
+            float r = uniform();
+            if (r < 0.3) { kmh = 40.0; turn = uniform() < 0.5 ? 30.0 : -30.0; legLeft = 3.0; }      // junction: 90 deg
+            else if (r < 0.7) { kmh = 80.0; turn = (uniform() - 0.5) * 10.0; legLeft = 20.0 + 60.0 * uniform(); }
+            else { kmh = 120.0; turn = (uniform() - 0.5) * 1.0; legLeft = 60.0 + 240.0 * uniform(); }
+        }
+        legLeft -= 0.1;
+        course = fmod(course + turn * 0.1 + 360.0, 360.0);
+        double step = kmh / 3.6 * 0.1;
+        e += step * sin(course * M_PI / 180.0);
+        n += step * cos(course * M_PI / 180.0);
+        uint32_t t = k * 100;
+        if (t % 2400000 >= 1200000 && t % 2400000 < 1260000) continue;
+        Fix f = { t, (float)e, (float)n, (float)course };
+        d.push_back(f);
+    }
+    return d;
+}
+
+static float segDist(float px, float py, float ax, float ay, float bx, float by) {
+    float dx = bx - ax, dy = by - ay, l2 = dx * dx + dy * dy;
+    float u = l2 > 0.0f ? ((px - ax) * dx + (py - ay) * dy) / l2 : 0.0f;
+    u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+    float ex = ax + u * dx - px, ey = ay + u * dy - py;
+    return sqrtf(ex * ex + ey * ey);
+}
+
+static void feed(Track &t, const Fix &f, uint32_t &lastMs, bool &have) {
+    t.add(f.e, f.n, have && f.ms - lastMs > 5000);     // a gap starts a new run, as in mapOnFix()
+    lastMs = f.ms;
+    have = true;
+}
+
+// renderMap()'s walk without the panel: the segments it would hand to drawLine()
+static int walk(const Track &t, const View &v, int &sum) {
+    int lines = 0;
+    int16_t p = Track::NONE;
+    for (int16_t i = t.head(); i != Track::NONE; i = t.next(i)) {
+        if (p != Track::NONE && !t.runStart(i)) {
+            int x0 = v.x(p), y0 = v.y(p), x1 = v.x(i), y1 = v.y(i);
+            if (!((x0 < 0 && x1 < 0) || (y0 < 0 && y1 < 0) || (x0 >= W && x1 >= W) || (y0 >= H && y1 >= H))) { lines++; sum += x0 + y1; }
+        }
+        p = i;
+    }
+    return lines;
+}
+
+void setUp(void) { g_rng = 1; }
+void tearDown(void) {}
+
+void test_track_stays_bounded_and_close(void) {
+    std::vector<Fix> d = makeDrive(2 * 3600);
+    static Track t;
+    t.clear();
+    uint32_t lastMs = 0; bool have = false;
+    for (const Fix &f : d) feed(t, f, lastMs, have);
+    TEST_ASSERT_LESS_OR_EQUAL(MAP_VERTICES, t.count());
+    // Every tenth fix against the simplified line of its own run
+    float worst = 0.0f; double sum = 0.0; int n = 0;
+    for (size_t k = 0; k < d.size(); k += 10) {
+        float best = 1e30f;
+        int16_t p = Track::NONE;
+        for (int16_t i = t.head(); i != Track::NONE; i = t.next(i)) {
+            if (p != Track::NONE && !t.runStart(i)) best = fminf(best, segDist(d[k].e, d[k].n, t.east(p), t.north(p), t.east(i), t.north(i)));
+            p = i;
+        }
+        if (best > worst) worst = best;
+        sum += best; n++;
+    }
+    // What that is on the auto-fitted map of the whole drive
+    View v(W / 2, H / 2, 100, 12, 15.0f);
+    v.update(t, d.back().e, d.back().n, d.back().course);
+    char msg[200];
+    snprintf(msg, sizeof(msg), "%u fixes -> %d vertices (%u removed, area threshold %.0f m^2): fix to line mean %.1f m, worst %.1f m = %.2f px at %.0f m/px",
+             (unsigned)d.size(), t.count(), t.removed(), t.threshold(), sum / n, worst, worst / v.metersPerPx(), v.metersPerPx());
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(2.0f, worst / v.metersPerPx());
+}
+
+void test_frame_budget(void) {
+    std::vector<Fix> d = makeDrive(2 * 3600);
+    static Track t;
+    for (int mode = 0; mode < 2; ++mode) {
+        int zoom = mode == 0 ? -1 : 3;                 // auto fit, and 5 m/px as when following
+        View v(W / 2, H / 2, 100, 12, 15.0f);
+        v.setZoom(zoom);
+        t.clear();
+        uint32_t lastMs = 0; bool have = false;
+        size_t k = 0;
+        std::vector<double> us;
+        uint32_t lines = 0;
+        int sum = 0;
+        // A frame every FRAME_MS of drive time, taking in the fixes that arrived since
+        for (uint32_t now = 0; k < d.size(); now += FRAME_MS) {
+            while (k < d.size() && d[k].ms <= now) feed(t, d[k++], lastMs, have);
+            if (!have) continue;
+            const Fix &car = d[k - 1];
+            auto t0 = std::chrono::steady_clock::now();
+            v.update(t, car.e, car.n, car.course);
+            lines += walk(t, v, sum);
+            us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        }
+        double total = 0.0;
+        for (double x : us) total += x;
+        double mean = total / us.size();
+        // The most a frame can cost: a full re-projection of the whole (full) track, repeated so
+        // a scheduler hiccup on the host does not count
+        const Fix &car = d.back();
+        const int REPS = 2000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < REPS; ++i) {
+            v.setZoom(zoom);
+            v.update(t, car.e, car.n, car.course + (i & 1) * 30.0f);
+            walk(t, v, sum);
+        }
+        double full = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / REPS;
+        char msg[200];
+        snprintf(msg, sizeof(msg), "%s: %u frames, %.2f us mean, %.1f us for a full re-projection, %u re-projections, %.0f lines/frame (check %d)",
+                 mode == 0 ? "auto zoom" : "5 m/px   ", (unsigned)us.size(), mean, full, v.reprojections() - REPS, (double)lines / us.size(), sum & 0xFF);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_LESS_THAN(MAP_BENCH_MAX_US_PER_FRAME, mean);
+        TEST_ASSERT_LESS_THAN(MAP_BENCH_MAX_US_WORST_FRAME, full);
+    }
+}
+
+void test_simplifier_throughput(void) {
+    std::vector<Fix> d = makeDrive(2 * 3600);
+    static Track t;
+    uint64_t n = 0;
+    double s = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    do {
+        t.clear();
+        uint32_t lastMs = 0; bool have = false;
+        for (const Fix &f : d) feed(t, f, lastMs, have);
+        n += d.size();
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    char msg[120];
+    snprintf(msg, sizeof(msg), "add(): %.1f ns per fix", s * 1e9 / n);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(1000.0, s * 1e9 / n);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_track_stays_bounded_and_close);
+    RUN_TEST(test_frame_budget);
+    RUN_TEST(test_simplifier_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,299 @@
+// Track codec and storage on real files (include/track_codec.hpp, include/track_file.hpp): a
+// recorded drive must read back exactly, and a truncated tail, a flipped byte, a torn batch
+// or a failed write must cost only the batch it hits. Reports encode/decode throughput and
+// bytes per fix. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "track_codec.hpp"
+#include "track_file.hpp"
+#ifdef __unix__
+#include <signal.h>
+#include <sys/resource.h>
+#endif
+
+#ifndef P_tmpdir
+#define P_tmpdir "."
+#endif
+
+static const size_t BATCH_BYTES = 1024;   // TRACK_BATCH_BYTES in track_log.cpp
+
+static std::string g_path;
+static uint8_t g_buf[track::BATCH_MAX];
+
+// 10 Hz drive: accelerations, a stop, turns and a little position noise, like a receiver
+static std::vector<track::Fix> drive(size_t n) {
+    std::vector<track::Fix> v;
+    uint32_t rng = 12345;
+    double lat = 48.137154, lon = 11.576124, course = 30.0, speed = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        double target = (i / 600) % 4 == 3 ? 0.0 : 15.0 + 10.0 * ((i / 600) % 3);
+        speed += (target - speed) * 0.02;
+        course += ((i / 300) % 2 ? 0.4 : -0.1);
+        double d = speed * 0.1;
+        lat += d * cos(course * M_PI / 180.0) / 111320.0;
+        lon += d * sin(course * M_PI / 180.0) / 74400.0;
+        track::Fix f;
+        f.utcMs = 1718000000000ULL + i * 100 + (rng % 3 == 0 ? 1 : 0);
+        f.latE7 = (int32_t)lround(lat * 1e7) + (int32_t)(rng % 5) - 2;
+        f.lonE7 = (int32_t)lround(lon * 1e7) + (int32_t)((rng >> 8) % 5) - 2;
+        f.speedCms = (int32_t)lround(speed * 100.0) + (int32_t)((rng >> 16) % 7) - 3;
+        if (f.speedCms < 0) f.speedCms = 0;
+        f.altDm = 5200 + (int32_t)(150.0 * sin(i * 1e-3));
+        v.push_back(f);
+    }
+    return v;
+}
+
+// Encode 'fixes' into sealed batches, each returned as its own byte string
+static std::vector<std::string> encode(const std::vector<track::Fix> &fixes) {
+    std::vector<std::string> batches;
+    uint8_t buf[BATCH_BYTES];
+    track::BatchEncoder enc(buf, sizeof(buf));
+    for (const track::Fix &f : fixes) {
+        if (enc.add(f)) continue;
+        size_t n = enc.seal();
+        batches.push_back(std::string((const char*)buf, n));
+        enc.reset();
+        enc.add(f);
+    }
+    size_t n = enc.seal();
+    if (n) batches.push_back(std::string((const char*)buf, n));
+    return batches;
+}
+
+static void writeFile(const std::string &bytes) {
+    FILE* f = fopen(g_path.c_str(), "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    fwrite(bytes.data(), 1, bytes.size(), f);
+    fclose(f);
+}
+
+static std::string join(const std::vector<std::string> &batches) {
+    std::string s;
+    for (const std::string &b : batches) s += b;
+    return s;
+}
+
+struct ReadBack {
+    std::vector<track::Fix> fixes;
+    uint32_t batches, corrupt;
+};
+
+static ReadBack readAll() {
+    ReadBack r;
+    FILE* f = fopen(g_path.c_str(), "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    track::TrackReader rd(f, g_buf);
+    track::BatchHeader h;
+    while (rd.next(h)) {
+        track::BatchDecoder dec(rd.payload(), h.payload, h.count);
+        track::Fix x;
+        while (dec.next(x)) r.fixes.push_back(x);
+    }
+    r.batches = rd.batches();
+    r.corrupt = rd.corrupt();
+    fclose(f);
+    return r;
+}
+
+static bool sameFix(const track::Fix &a, const track::Fix &b) {
+    return a.utcMs == b.utcMs && a.latE7 == b.latE7 && a.lonE7 == b.lonE7 && a.speedCms == b.speedCms && a.altDm == b.altDm;
+}
+
+// The fixes of batches [from, to) of 'batches', in order
+static std::vector<track::Fix> fixesOf(const std::vector<std::string> &batches, size_t from, size_t to) {
+    std::vector<track::Fix> v;
+    for (size_t i = from; i < to; ++i) {
+        track::BatchHeader h;
+        const uint8_t* p = (const uint8_t*)batches[i].data();
+        TEST_ASSERT_TRUE(h.parse(p));
+        track::BatchDecoder dec(p + track::BATCH_HEADER, h.payload, h.count);
+        track::Fix x;
+        while (dec.next(x)) v.push_back(x);
+    }
+    return v;
+}
+
+static void assertFixes(const std::vector<track::Fix> &want, const std::vector<track::Fix> &got) {
+    TEST_ASSERT_EQUAL(want.size(), got.size());
+    for (size_t i = 0; i < want.size(); ++i) TEST_ASSERT_TRUE_MESSAGE(sameFix(want[i], got[i]), "fix differs");
+}
+
+void setUp(void) { g_path = std::string(P_tmpdir) + "/test_track_storage.trk"; remove(g_path.c_str()); }
+void tearDown(void) { remove(g_path.c_str()); }
+
+void test_round_trip_through_writer(void) {
+    std::vector<track::Fix> fixes = drive(36000);   // one hour at 10 Hz
+    std::vector<std::string> batches = encode(fixes);
+    track::TrackWriter w;
+    TEST_ASSERT_TRUE(w.open(g_path.c_str()));
+    for (const std::string &b : batches) TEST_ASSERT_TRUE(w.append((const uint8_t*)b.data(), b.size()));
+    w.close();
+    ReadBack r = readAll();
+    TEST_ASSERT_EQUAL(batches.size(), r.batches);
+    TEST_ASSERT_EQUAL(0, r.corrupt);
+    assertFixes(fixes, r.fixes);
+    // The writer picks up where the file ends
+    TEST_ASSERT_TRUE(w.open(g_path.c_str()));
+    TEST_ASSERT_EQUAL(join(batches).size(), w.size());
+
+    char msg[120];
+    size_t bytes = join(batches).size();
+    snprintf(msg, sizeof(msg), "%u fixes in %u batches: %.2f B/fix, %.0f KB/h at 10 Hz",
+             (unsigned)fixes.size(), (unsigned)batches.size(), (double)bytes / fixes.size(), bytes / 1024.0);
+    TEST_MESSAGE(msg);
+}
+
+void test_truncated_tail_loses_only_last_batch(void) {
+    std::vector<std::string> batches = encode(drive(3000));
+    std::string all = join(batches);
+    size_t lastLen = batches.back().size();
+    size_t cuts[] = { 1, 5, track::BATCH_HEADER, track::BATCH_HEADER + 1, lastLen / 2, lastLen - 1 };
+    for (size_t cut : cuts) {
+        writeFile(all.substr(0, all.size() - lastLen + cut));
+        ReadBack r = readAll();
+        TEST_ASSERT_EQUAL(batches.size() - 1, r.batches);
+        TEST_ASSERT_LESS_OR_EQUAL(1, r.corrupt);
+        assertFixes(fixesOf(batches, 0, batches.size() - 1), r.fixes);
+    }
+}
+
+void test_flipped_byte_loses_only_its_batch(void) {
+    std::vector<std::string> batches = encode(drive(3000));
+    TEST_ASSERT_GREATER_OR_EQUAL(4, batches.size());
+    const size_t hit = 2;
+    size_t start = 0;
+    for (size_t i = 0; i < hit; ++i) start += batches[i].size();
+    // Magic, version, length (both bytes), count, CRC and several payload bytes
+    size_t offsets[] = { 0, 1, 2, 4, 5, 6, 8, 12, 13, 100, batches[hit].size() - 1 };
+    std::vector<track::Fix> want = fixesOf(batches, 0, hit), tail = fixesOf(batches, hit + 1, batches.size());
+    want.insert(want.end(), tail.begin(), tail.end());
+    for (size_t off : offsets) {
+        for (int bit = 0; bit < 8; bit += 3) {
+            std::string bytes = join(batches);
+            bytes[start + off] ^= (char)(1 << bit);
+            writeFile(bytes);
+            ReadBack r = readAll();
+            char msg[48];
+            snprintf(msg, sizeof(msg), "byte %u bit %d", (unsigned)off, bit);
+            TEST_ASSERT_EQUAL_MESSAGE(batches.size() - 1, r.batches, msg);
+            TEST_ASSERT_GREATER_OR_EQUAL(1, r.corrupt);
+            assertFixes(want, r.fixes);
+        }
+    }
+}
+
+// A power cut mid-write leaves half a batch; after reboot the writer appends behind it
+void test_torn_batch_then_good_batches(void) {
+    std::vector<std::string> batches = encode(drive(6000));
+    TEST_ASSERT_GREATER_OR_EQUAL(6, batches.size());
+    const size_t torn = 2;
+    for (size_t keep : { (size_t)3, track::BATCH_HEADER, batches[torn].size() / 2, batches[torn].size() - 1 }) {
+        std::string bytes;
+        for (size_t i = 0; i < batches.size(); ++i) bytes += i == torn ? batches[i].substr(0, keep) : batches[i];
+        writeFile(bytes);
+        ReadBack r = readAll();
+        TEST_ASSERT_EQUAL(batches.size() - 1, r.batches);
+        TEST_ASSERT_GREATER_OR_EQUAL(1, r.corrupt);
+        std::vector<track::Fix> want = fixesOf(batches, 0, torn), tail = fixesOf(batches, torn + 1, batches.size());
+        want.insert(want.end(), tail.begin(), tail.end());
+        assertFixes(want, r.fixes);
+    }
+}
+
+// A write that fails part-way (here: the file size limit) is cut off again, so the batches
+// written after it follow the last good one directly
+void test_failed_write_is_rolled_back(void) {
+#ifdef __unix__
+    std::vector<std::string> batches = encode(drive(6000));
+    track::TrackWriter w;
+    TEST_ASSERT_TRUE(w.open(g_path.c_str()));
+    TEST_ASSERT_TRUE(w.append((const uint8_t*)batches[0].data(), batches[0].size()));
+    TEST_ASSERT_TRUE(w.append((const uint8_t*)batches[1].data(), batches[1].size()));
+    uint32_t good = w.size();
+
+    struct rlimit old, lim;
+    getrlimit(RLIMIT_FSIZE, &old);
+    void (*prev)(int) = signal(SIGXFSZ, SIG_IGN);
+    lim = old;
+    lim.rlim_cur = good + 100;
+    setrlimit(RLIMIT_FSIZE, &lim);
+    bool ok = w.append((const uint8_t*)batches[2].data(), batches[2].size());
+    setrlimit(RLIMIT_FSIZE, &old);
+    signal(SIGXFSZ, prev);
+
+    TEST_ASSERT_FALSE(ok);
+    TEST_ASSERT_TRUE(w.isOpen());
+    TEST_ASSERT_EQUAL(good, w.size());
+    for (size_t i = 3; i < batches.size(); ++i) TEST_ASSERT_TRUE(w.append((const uint8_t*)batches[i].data(), batches[i].size()));
+    w.close();
+    ReadBack r = readAll();
+    TEST_ASSERT_EQUAL(0, r.corrupt);
+    TEST_ASSERT_EQUAL(batches.size() - 1, r.batches);
+    std::vector<track::Fix> want = fixesOf(batches, 0, 2), tail = fixesOf(batches, 3, batches.size());
+    want.insert(want.end(), tail.begin(), tail.end());
+    assertFixes(want, r.fixes);
+#else
+    TEST_IGNORE_MESSAGE("needs RLIMIT_FSIZE");
+#endif
+}
+
+void test_codec_throughput(void) {
+    std::vector<track::Fix> fixes = drive(36000);
+    uint8_t buf[BATCH_BYTES];
+    uint64_t encoded = 0, bytes = 0;
+    double s = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    do {
+        track::BatchEncoder enc(buf, sizeof(buf));
+        for (const track::Fix &f : fixes) {
+            if (enc.add(f)) continue;
+            bytes += enc.seal();
+            enc.reset();
+            enc.add(f);
+        }
+        bytes += enc.seal();
+        encoded += fixes.size();
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+    double encS = s;
+
+    std::vector<std::string> batches = encode(fixes);
+    uint64_t decoded = 0;
+    t0 = std::chrono::steady_clock::now();
+    do {
+        for (const std::string &b : batches) {
+            track::BatchHeader h;
+            const uint8_t* p = (const uint8_t*)b.data();
+            if (!h.parse(p) || !h.check(p + track::BATCH_HEADER)) continue;
+            track::BatchDecoder dec(p + track::BATCH_HEADER, h.payload, h.count);
+            track::Fix x;
+            while (dec.next(x)) decoded++;
+        }
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (s < 0.2);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "encode %.1f M fixes/s (%.1f MB/s out), decode + CRC %.1f M fixes/s",
+             encoded / encS * 1e-6, bytes / encS * 1e-6, decoded / s * 1e-6);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(fixes.size() * (decoded / fixes.size()), decoded);
+    TEST_ASSERT_GREATER_THAN(100000, (uint32_t)(encoded / encS));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_through_writer);
+    RUN_TEST(test_truncated_tail_loses_only_last_batch);
+    RUN_TEST(test_flipped_byte_loses_only_its_batch);
+    RUN_TEST(test_torn_batch_then_good_batches);
+    RUN_TEST(test_failed_write_is_rolled_back);
+    RUN_TEST(test_codec_throughput);
+    return UNITY_END();
+}
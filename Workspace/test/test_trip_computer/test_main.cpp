@@ -0,0 +1,194 @@
+// Synthetic drives through nav::TripComputer (include/trip_computer.hpp): a receiver whose speed
+// reads 3 % high is trimmed by the position cross-check, a fix gap is bridged with the chord,
+// and a parked receiver whose position wanders adds no distance. Also reports the cost of one
+// update over a long drive. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "trip_computer.hpp"
+
+// Regression gate: fail when one update gets this slow (host ns per fix)
+#ifndef TRIP_BENCH_MAX_NS_PER_FIX
+#define TRIP_BENCH_MAX_NS_PER_FIX 1000.0
+#endif
+
+static const double LAT0 = 48.137154, LON0 = 11.576124;
+static const double M_PER_DEG = 111320.0;
+
+// Deterministic noise, roughly N(0,1)
+static uint32_t g_rng = 1;
+static float gauss() {
+    float sum = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+        sum += (g_rng & 0xFFFF) / 65535.0f;
+    }
+    return (sum - 2.0f) * 1.732f;
+}
+
+struct Car {
+    double e = 0.0, n = 0.0;     // true position, metres east/north of LAT0/LON0
+    double courseDeg = 0.0;
+    double pathM = 0.0;          // true distance driven
+    uint32_t tMs = 1000;
+
+    void drive(double kmh, double turnDegS, uint32_t dtMs) {
+        double d = kmh / 3.6 * dtMs * 0.001;
+        courseDeg += turnDegS * dtMs * 0.001;
+        e += d * sin(courseDeg * M_PI / 180.0);
+        n += d * cos(courseDeg * M_PI / 180.0);
+        pathM += d;
+        tMs += dtMs;
+    }
+    // Reported position with 'noiseM' 1-sigma per axis
+    void fix(int32_t &latE7, int32_t &lonE7, float noiseM) const {
+        double ee = e + noiseM * gauss(), nn = n + noiseM * gauss();
+        latE7 = (int32_t)lround((LAT0 + nn / M_PER_DEG) * 1e7);
+        lonE7 = (int32_t)lround((LON0 + ee / (M_PER_DEG * cos(LAT0 * M_PI / 180.0))) * 1e7);
+    }
+};
+
+// One 10 Hz fix: reported speed = true x 'bias' + noise
+static void feed(nav::TripComputer &trip, Car &car, double kmh, double turnDegS, float bias, float posNoiseM) {
+    car.drive(kmh, turnDegS, 100);
+    int32_t lat, lon;
+    car.fix(lat, lon, posNoiseM);
+    float v = kmh > 0.0 ? (float)kmh * bias + 0.2f * gauss() : 0.0f;
+    trip.update(car.tMs, lat, lon, v, 2.0f);
+}
+
+void setUp(void) { g_rng = 1; }
+void tearDown(void) {}
+
+void test_speed_bias_is_trimmed(void) {
+    nav::TripComputer trip;
+    Car car;
+    // 30 km of country road: 90 km/h with gentle bends, a slower town section in the middle
+    while (car.pathM < 30000.0) {
+        double kmh = car.pathM > 12000.0 && car.pathM < 15000.0 ? 45.0 : 90.0;
+        double turn = fmod(car.pathM, 4000.0) < 1000.0 ? 1.5 : 0.0;
+        feed(trip, car, kmh, turn, 1.03f, 1.0f);
+    }
+    double err = trip.odometerM() / car.pathM - 1.0;
+    char msg[160];
+    snprintf(msg, sizeof(msg), "scale %.4f after %u windows, odometer %.0f m vs %.0f m driven (%+.2f %%, uncorrected +3.00 %%)",
+             trip.scale(), trip.state().calibrations, trip.odometerM(), car.pathM, err * 100.0);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 1.0 / 1.03, trip.scale());
+    TEST_ASSERT_GREATER_THAN(30, trip.state().calibrations);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 0.0, err);
+    // The last 10 km, once trimmed, reads true to a few tenths of a percent
+    double odo0 = trip.odometerM(), path0 = car.pathM;
+    while (car.pathM - path0 < 10000.0) feed(trip, car, 90.0, 0.0, 1.03f, 1.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.004, 1.0, (trip.odometerM() - odo0) / (car.pathM - path0));
+}
+
+void test_fix_gap_is_bridged(void) {
+    nav::TripComputer trip;
+    Car car;
+    for (int i = 0; i < 600; ++i) feed(trip, car, 50.0, 0.0, 1.0f, 1.0f);
+    // 30 s tunnel at 50 km/h in a straight line: no fixes, then one where the car came out
+    car.drive(50.0, 0.0, 30000);
+    int32_t lat, lon;
+    car.fix(lat, lon, 1.0f);
+    float added = trip.update(car.tMs, lat, lon, 50.0f, 2.0f);
+    TEST_ASSERT_FLOAT_WITHIN(5.0, 50.0 / 3.6 * 30.0, added);
+    for (int i = 0; i < 600; ++i) feed(trip, car, 50.0, 0.0, 1.0f, 1.0f);
+    const nav::TripTotals &a = trip.trip(nav::TRIP_A);
+    TEST_ASSERT_FLOAT_WITHIN(0.01 * car.pathM, car.pathM, a.distanceM);
+    TEST_ASSERT_EQUAL(0, (uint32_t)a.stoppedMs);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 50.0, a.avgKmh());
+
+    // A jump no car could have made (a bad first fix after the gap) is not counted
+    double before = trip.odometerM();
+    Car far = car;
+    far.e += 20000.0;
+    far.tMs += 10000;
+    far.fix(lat, lon, 0.0f);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, trip.update(far.tMs, lat, lon, 0.0f, 2.0f));
+    TEST_ASSERT_EQUAL_FLOAT(before, trip.odometerM());
+}
+
+void test_parked_wander_adds_nothing(void) {
+    nav::TripComputer trip;
+    Car car;
+    for (int i = 0; i < 300; ++i) feed(trip, car, 30.0, 0.0, 1.0f, 1.0f);
+    feed(trip, car, 0.0, 0.0, 1.0f, 1.0f);   // the stop itself still integrates 30 -> 0
+    double odo = trip.odometerM();
+    uint64_t moving = trip.trip(nav::TRIP_A).movingMs;
+    // 10 minutes parked under trees: 4 m of position wander, gated speed reads zero
+    for (int i = 0; i < 6000; ++i) feed(trip, car, 0.0, 0.0, 1.0f, 4.0f);
+    // ...and a 20 s gap while parked, coming back a few metres off
+    car.tMs += 20000;
+    int32_t lat, lon;
+    car.fix(lat, lon, 8.0f);
+    trip.update(car.tMs, lat, lon, 0.0f, 10.0f);
+    const nav::TripTotals &a = trip.trip(nav::TRIP_A);
+    TEST_ASSERT_EQUAL_FLOAT(odo, trip.odometerM());
+    TEST_ASSERT_EQUAL((uint32_t)moving, (uint32_t)a.movingMs);
+    TEST_ASSERT_UINT32_WITHIN(200, 619900, (uint32_t)a.stoppedMs);
+    TEST_ASSERT_FALSE(trip.moving());
+}
+
+void test_restore_rejects_bad_state(void) {
+    nav::TripComputer trip;
+    Car car;
+    for (int i = 0; i < 100; ++i) feed(trip, car, 40.0, 0.0, 1.0f, 1.0f);
+    nav::TripState s = trip.state();
+    nav::TripComputer back;
+    TEST_ASSERT_TRUE(back.restore(s));
+    TEST_ASSERT_EQUAL_FLOAT(trip.odometerM(), back.odometerM());
+    s.scale = 2.0f;
+    TEST_ASSERT_FALSE(nav::TripComputer().restore(s));
+    s = trip.state();
+    s.version++;
+    TEST_ASSERT_FALSE(nav::TripComputer().restore(s));
+}
+
+// Two hours at 10 Hz (country road, town, stops, a tunnel) recorded first, then replayed through
+// fresh trip computers until 0.2 s have passed, so only update() is timed
+void test_update_cost(void) {
+    struct Sample { uint32_t tMs; int32_t lat, lon; float kmh; };
+    std::vector<Sample> drive;
+    Car car;
+    for (int i = 0; i < 72000; ++i) {
+        int phase = i / 3000 % 8;
+        double kmh = phase == 3 ? 0.0 : phase == 5 ? 45.0 : 90.0;
+        if (i % 24000 == 12000) car.drive(kmh, 0.0, 20000); // fix gap
+        car.drive(kmh, fmod(car.pathM, 4000.0) < 1000.0 ? 1.5 : 0.0, 100);
+        Sample s;
+        s.tMs = car.tMs;
+        car.fix(s.lat, s.lon, 1.5f);
+        s.kmh = kmh > 0.0 ? (float)kmh + 0.2f * gauss() : 0.0f;
+        drive.push_back(s);
+    }
+    double odo = 0.0;
+    uint64_t fixes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double sec = 0.0;
+    do {
+        nav::TripComputer trip;
+        for (const Sample &s : drive) trip.update(s.tMs, s.lat, s.lon, s.kmh, 2.0f);
+        odo += trip.odometerM();
+        fixes += drive.size();
+        sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (sec < 0.2);
+    double ns = sec * 1e9 / fixes;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "update(): %.0f ns per fix over %u fixes of a 2 h drive (%.1f km)",
+             ns, (unsigned)drive.size(), odo / (fixes / drive.size()) / 1000.0);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN_MESSAGE(TRIP_BENCH_MAX_NS_PER_FIX, ns, msg);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_speed_bias_is_trimmed);
+    RUN_TEST(test_fix_gap_is_bridged);
+    RUN_TEST(test_parked_wander_adds_nothing);
+    RUN_TEST(test_restore_rejects_bad_state);
+    RUN_TEST(test_update_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,207 @@
+// ubx::Decoder framing: valid frames, skipped long frames, and recovery from a corrupt length.
+// Also a 5 Hz M8 capture (test/data/ubx/drive.ubx, from
+//     python3 test/data/ubx/make_capture.py test/data/ubx
+// NAV-PVT/VELNED/SOL with NAV-SAT, an ACK, NMEA text and a damaged checksum) decoded and mapped
+// onto GPSData with ubx::applyNav* as gps_module does, against the golden decoded fields and
+// GPSData state. Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ubx_protocol.hpp"
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "test/data"
+#endif
+
+static uint8_t g_frame[1200];
+
+static size_t navPvtFrame(uint8_t* out, int32_t latE7) {
+    uint8_t p[92];
+    memset(p, 0, sizeof(p));
+    ubx::put4(p + 28, (uint32_t)latE7);
+    return ubx::encode(ubx::CLS_NAV, ubx::NAV_PVT, p, sizeof(p), out, 100);
+}
+
+static int feedAll(ubx::Decoder &d, const uint8_t* p, size_t n, int32_t* lastLat) {
+    int frames = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!d.feed(p[i])) continue;
+        frames++;
+        ubx::NavPvt pvt;
+        if (lastLat && d.msgId() == ubx::NAV_PVT && ubx::parseNavPvt(d.payload(), d.length(), pvt)) *lastLat = pvt.latE7;
+    }
+    return frames;
+}
+
+static std::vector<uint8_t> readFile(const std::string &path) {
+    std::vector<uint8_t> d;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return d;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) d.insert(d.end(), buf, buf + n);
+    fclose(f);
+    return d;
+}
+
+static std::vector<std::string> split(const std::string &s, char sep) {
+    std::vector<std::string> out;
+    std::string cur;
+    for (char c : s) {
+        if (c == sep) { out.push_back(cur); cur.clear(); }
+        else cur += c;
+    }
+    if (!cur.empty()) out.push_back(cur);
+    return out;
+}
+
+// The GPSData members the UBX path writes (src/gps_module.h), for ubx::applyNav*
+struct Data {
+    bool validFix;
+    int fixQuality, fixMode, satsUsed;
+    int32_t latE7, lonE7;
+    float altitude, speedKnots, speedKmh, courseDeg;
+    char date[8];
+    char timeUTC[10];
+    float hAccM, vAccM, sAccKmh;
+    bool sAccMeasured;
+    float pdop;
+};
+
+static std::string dataLine(const Data &d) {
+    char buf[200];
+    snprintf(buf, sizeof(buf), "DATA %d %d %d %d %d %d %.3f %.3f %.3f %.3f %.3f %.2f %.3f %s %s",
+             d.validFix, d.fixQuality, d.fixMode, d.satsUsed, (int)d.latE7, (int)d.lonE7, d.altitude, d.speedKmh,
+             d.courseDeg, d.hAccM, d.vAccM, d.pdop, d.sAccKmh, d.date[0] ? d.date : "-", d.timeUTC[0] ? d.timeUTC : "-");
+    return buf;
+}
+
+// Fields equal, or numbers within a rounding step of the golden's (its model maps in double,
+// gps_module in float)
+static bool sameLine(const std::string &want, const std::string &got) {
+    std::vector<std::string> a = split(want, ' '), b = split(got, ' ');
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] == b[i]) continue;
+        char* end;
+        double x = strtod(a[i].c_str(), &end), y = strtod(b[i].c_str(), nullptr);
+        if (*end || a[i].find('.') == std::string::npos || fabs(x - y) > 0.0015) return false;
+    }
+    return true;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_nav_pvt_round_trip(void) {
+    ubx::Decoder d;
+    int32_t lat = 0;
+    size_t n = navPvtFrame(g_frame, 481371540);
+    TEST_ASSERT_EQUAL(1, feedAll(d, g_frame, n, &lat));
+    TEST_ASSERT_EQUAL_INT32(481371540, lat);
+}
+
+// NAV-SAT sized frame: longer than MAX_PAYLOAD, skipped whole, the next frame still decodes
+void test_long_frame_is_skipped(void) {
+    ubx::Decoder d;
+    static uint8_t sat[8 + 12 * 40];
+    memset(sat, 0x24, sizeof(sat));
+    size_t n = ubx::encode(ubx::CLS_NAV, 0x35, sat, sizeof(sat), g_frame, sizeof(g_frame));
+    n += navPvtFrame(g_frame + n, 1);
+    int32_t lat = 0;
+    TEST_ASSERT_EQUAL(1, feedAll(d, g_frame, n, &lat));
+    TEST_ASSERT_EQUAL(1, d.stats().oversize);
+    TEST_ASSERT_EQUAL_INT32(1, lat);
+}
+
+// A corrupted length byte must cost the frame, not the next seconds of data
+void test_corrupt_length_resyncs_at_once(void) {
+    ubx::Decoder d;
+    size_t n = navPvtFrame(g_frame, 7);
+    g_frame[5] = 0xF0;                              // length high byte: 92 -> 61532
+    size_t m = n;
+    m += navPvtFrame(g_frame + m, 8);
+    m += navPvtFrame(g_frame + m, 9);
+    int32_t lat = 0;
+    TEST_ASSERT_EQUAL(2, feedAll(d, g_frame, m, &lat));
+    TEST_ASSERT_EQUAL(1, d.stats().badLength);
+    TEST_ASSERT_EQUAL_INT32(9, lat);
+}
+
+void test_capture_matches_golden(void) {
+    std::string base = std::string(TEST_DATA_DIR) + "/ubx/drive";
+    std::vector<uint8_t> data = readFile(base + ".ubx");
+    std::vector<uint8_t> g = readFile(base + ".golden");
+    std::vector<std::string> golden = split(std::string(g.begin(), g.end()), '\n');
+    TEST_ASSERT_TRUE_MESSAGE(!data.empty() && !golden.empty(), "capture missing (run from the project directory)");
+
+    ubx::Decoder d;
+    Data gd;
+    memset(&gd, 0, sizeof(gd));
+    std::vector<std::string> lines;
+    uint32_t pvts = 0, fixes3d = 0, dgps = 0;
+    char buf[256];
+    for (uint8_t b : data) {
+        if (!d.feed(b)) continue;
+        const uint8_t* p = d.payload();
+        uint16_t len = d.length();
+        ubx::NavPvt pvt; ubx::NavVelned vel; ubx::NavSol sol;
+        if (d.msgClass() == ubx::CLS_NAV && d.msgId() == ubx::NAV_PVT && ubx::parseNavPvt(p, len, pvt)) {
+            snprintf(buf, sizeof(buf), "PVT %u %u %u %u %u %u %u %u %d %u %u %u %d %d %d %d %u %u %d %d %d %d %d %u %u %u",
+                     pvt.iTOW, pvt.year, pvt.month, pvt.day, pvt.hour, pvt.min, pvt.sec, pvt.valid, (int)pvt.nano,
+                     pvt.fixType, pvt.flags, pvt.numSV, (int)pvt.lonE7, (int)pvt.latE7, (int)pvt.heightMm, (int)pvt.hMSLmm,
+                     pvt.hAccMm, pvt.vAccMm, (int)pvt.velNmms, (int)pvt.velEmms, (int)pvt.velDmms, (int)pvt.gSpeedMms,
+                     (int)pvt.headMotE5, pvt.sAccMms, pvt.headAccE5, pvt.pDOPx100);
+            ubx::applyNavPvt(gd, pvt);
+            pvts++;
+            if (gd.fixMode == 3) fixes3d++;
+            if (gd.fixQuality == 2) dgps++;
+        } else if (d.msgClass() == ubx::CLS_NAV && d.msgId() == ubx::NAV_VELNED && ubx::parseNavVelned(p, len, vel)) {
+            snprintf(buf, sizeof(buf), "VELNED %u %d %d %d %u %u %d %u %u", vel.iTOW, (int)vel.velNcms, (int)vel.velEcms,
+                     (int)vel.velDcms, vel.speedCms, vel.gSpeedCms, (int)vel.headingE5, vel.sAccCms, vel.cAccE5);
+            ubx::applyNavVelned(gd, vel);
+        } else if (d.msgClass() == ubx::CLS_NAV && d.msgId() == ubx::NAV_SOL && ubx::parseNavSol(p, len, sol)) {
+            snprintf(buf, sizeof(buf), "SOL %u %u %u %u %u %u %u", sol.iTOW, sol.gpsFix, sol.flags, sol.pAccCm, sol.sAccCms,
+                     sol.pDOPx100, sol.numSV);
+            ubx::applyNavSol(gd, sol);
+        } else {
+            snprintf(buf, sizeof(buf), "FRAME %02X %02X %u", d.msgClass(), d.msgId(), len);
+            lines.push_back(buf);
+            continue;
+        }
+        lines.push_back(buf);
+        lines.push_back(dataLine(gd));
+    }
+    const ubx::Decoder::Stats &st = d.stats();
+    snprintf(buf, sizeof(buf), "STATS %u %u %u %u", st.frames, st.checksumErrors, st.oversize, st.badLength);
+    lines.push_back(buf);
+
+    TEST_ASSERT_EQUAL(golden.size(), lines.size());
+    for (size_t i = 0; i < golden.size(); ++i) {
+        char where[300];
+        snprintf(where, sizeof(where), "line %u: want '%s' got '%s'", (unsigned)(i + 1), golden[i].c_str(), lines[i].c_str());
+        TEST_ASSERT_TRUE_MESSAGE(sameLine(golden[i], lines[i]), where);
+    }
+    // The capture covers what the mapping has to tell apart
+    TEST_ASSERT_EQUAL(150, pvts);
+    TEST_ASSERT_GREATER_THAN(100, fixes3d);
+    TEST_ASSERT_GREATER_THAN(30, dgps);
+    TEST_ASSERT_EQUAL(1, st.checksumErrors);
+    TEST_ASSERT_TRUE(gd.sAccMeasured);
+    snprintf(buf, sizeof(buf), "%u bytes: %u frames, %u PVT (%u 3D, %u differential), %u skipped, %u bad checksum",
+             (unsigned)data.size(), st.frames, pvts, fixes3d, dgps, st.oversize, st.checksumErrors);
+    TEST_MESSAGE(buf);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nav_pvt_round_trip);
+    RUN_TEST(test_long_frame_is_skipped);
+    RUN_TEST(test_corrupt_length_resyncs_at_once);
+    RUN_TEST(test_capture_matches_golden);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Build the POI image read by include/poi_db.hpp.
+
+Input CSV (header line optional, '#' comments allowed):
+    type,lat,lon,limit_kmh,radius_m,heading_deg
+type is "camera" or "zone"; limit_kmh 0 = none; radius_m 0 = default (400 m), at most 1000 m
+(split larger zones into several circles); heading_deg empty or -1 = any direction.
+
+Flash the result into the "poi" partition, e.g.
+    parttool.py --port COM3 write_partition --partition-name poi --input poi.bin
+or esptool.py write_flash 0x670000 poi.bin (offset from partitions.csv). The stock 512 KB
+partition holds 32766 records.
+
+--synthetic N writes N random records around --centre instead of reading a CSV (for benchmarks).
+"""
+import argparse
+import csv
+import random
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = b"POI1"
+VERSION = 1
+RECORD = struct.Struct("<iiIBBBB")
+HEADER = struct.Struct("<4sIIIII8x")
+TYPES = {"camera": 1, "zone": 2}
+MAX_RADIUS_M = 1000
+
+
+def quant(e7, offset, span):
+    v = (e7 + offset) * 65536 // span
+    return max(0, min(65535, v))
+
+
+def geohash_key(lat_e7, lon_e7):
+    qlat = quant(lat_e7, 900000000, 1800000000)
+    qlon = quant(lon_e7, 1800000000, 3600000000)
+    key = 0
+    for b in range(15, -1, -1):
+        key = (key << 2) | (((qlon >> b) & 1) << 1) | ((qlat >> b) & 1)
+    return key
+
+
+def record(kind, lat, lon, limit, radius, heading):
+    lat_e7, lon_e7 = round(lat * 1e7), round(lon * 1e7)
+    if not (-900000000 <= lat_e7 <= 900000000 and -1800000000 <= lon_e7 <= 1800000000):
+        raise ValueError("position out of range")
+    if radius > MAX_RADIUS_M:
+        raise ValueError("radius above %d m" % MAX_RADIUS_M)
+    heading2 = 0xFF if heading is None or heading < 0 else int(round(heading % 360 / 2)) % 180
+    return (geohash_key(lat_e7, lon_e7), lat_e7, lon_e7, TYPES[kind], min(255, int(limit)),
+            int(round(radius / 10)), heading2)
+
+
+def read_csv(path):
+    rows = []
+    with open(path, newline="") as f:
+        for n, row in enumerate(csv.reader(f), 1):
+            if not row or row[0].startswith("#") or row[0] == "type":
+                continue
+            try:
+                heading = float(row[5]) if len(row) > 5 and row[5].strip() else None
+                rows.append(record(row[0].strip(), float(row[1]), float(row[2]), float(row[3] or 0),
+                                   float(row[4] or 0), heading))
+            except (ValueError, KeyError, IndexError) as e:
+                sys.exit("%s:%d: %s" % (path, n, e))
+    return rows
+
+
+def synthetic(n, lat, lon, span_deg, seed):
+    rng = random.Random(seed)
+    rows = []
+    for _ in range(n):
+        kind = "camera" if rng.random() < 0.7 else "zone"
+        rows.append(record(kind, lat + rng.uniform(-span_deg, span_deg), lon + rng.uniform(-span_deg, span_deg),
+                           rng.choice((30, 50, 70, 80, 100, 120)), rng.choice((0, 200, 300, 500)),
+                           rng.choice((None, rng.uniform(0, 360)))))
+    return rows
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("input", nargs="?", help="POI CSV")
+    ap.add_argument("-o", "--output", default="poi.bin")
+    ap.add_argument("--partition-size", type=lambda s: int(s, 0), default=0x80000)
+    ap.add_argument("--synthetic", type=int, metavar="N")
+    ap.add_argument("--centre", type=float, nargs=2, default=(48.137, 11.576), metavar=("LAT", "LON"))
+    ap.add_argument("--span", type=float, default=2.0, help="synthetic: +- degrees around the centre")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    if args.synthetic:
+        rows = synthetic(args.synthetic, args.centre[0], args.centre[1], args.span, args.seed)
+    elif args.input:
+        rows = read_csv(args.input)
+    else:
+        ap.error("give a CSV or --synthetic N")
+
+    rows.sort()
+    body = b"".join(RECORD.pack(lat, lon, key, t, limit, r, h) for key, lat, lon, t, limit, r, h in rows)
+    image = HEADER.pack(MAGIC, VERSION, len(rows), RECORD.size, zlib.crc32(body), int(time.time())) + body
+    if args.partition_size and len(image) > args.partition_size:
+        sys.exit("%d records (%d bytes) do not fit the %d-byte partition" % (len(rows), len(image), args.partition_size))
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("%s: %d records, %d bytes" % (args.output, len(rows), len(image)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""Build the vector basemap image read by include/vector_tiles.hpp.
+
+Input is GeoJSON (a FeatureCollection of LineString, MultiLineString, Polygon or MultiPolygon;
+polygon rings become lines). The kind of each feature comes from its "kind" property (major,
+minor or water) or, failing that, from OSM tags: highway=motorway/trunk/primary/secondary is
+major, any other highway is minor, natural=coastline/water and waterway are water. Anything else
+is skipped. An OSM extract converts with e.g.
+    osmium export -f geojson region.osm.pbf -o region.geojson
+
+Lines are clipped to Web Mercator tiles of one zoom level (with a small margin so they join
+across edges), simplified with Douglas-Peucker and quantised to 4096 units per tile. A tile
+that still has more than MAX_POINTS points is simplified harder, then loses its minor roads.
+
+Flash the result into the "tiles" partition, e.g.
+    parttool.py --port COM3 write_partition --partition-name tiles --input tiles.bin
+or esptool.py write_flash 0x6F0000 tiles.bin (offset from partitions.csv).
+
+--synthetic KM writes a street grid and a coastline over KM x KM around --centre instead of
+reading GeoJSON (for benchmarks).
+"""
+import argparse
+import json
+import math
+import random
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = b"VTL1"
+VERSION = 1
+HEADER = struct.Struct("<4sIIIIII4x")
+INDEX = struct.Struct("<II")
+EXTENT = 4096
+MARGIN = 64
+MAX_POINTS = 1024
+MAX_FEATURES = 160
+KINDS = {"major": 1, "minor": 2, "water": 3}
+MAJOR_HIGHWAYS = {"motorway", "motorway_link", "trunk", "trunk_link", "primary", "primary_link", "secondary"}
+
+
+def kind_of(props):
+    k = props.get("kind")
+    if k in KINDS:
+        return KINDS[k]
+    hw = props.get("highway")
+    if hw:
+        return KINDS["major"] if hw in MAJOR_HIGHWAYS else KINDS["minor"]
+    if props.get("natural") in ("coastline", "water") or props.get("waterway"):
+        return KINDS["water"]
+    return None
+
+
+def project(lon, lat, zoom):
+    """Global tile-unit coordinates (tile x * EXTENT + unit)."""
+    n = (1 << zoom) * EXTENT
+    lat = max(-85.0511, min(85.0511, lat))
+    r = math.radians(lat)
+    return ((lon + 180.0) / 360.0 * n, (1.0 - math.log(math.tan(r) + 1.0 / math.cos(r)) / math.pi) * 0.5 * n)
+
+
+def read_geojson(path):
+    with open(path) as f:
+        doc = json.load(f)
+    feats = doc["features"] if doc.get("type") == "FeatureCollection" else [doc]
+    lines = []
+    for ft in feats:
+        k = kind_of(ft.get("properties") or {})
+        g = ft.get("geometry") or {}
+        if k is None:
+            continue
+        t, c = g.get("type"), g.get("coordinates")
+        if t == "LineString":
+            parts = [c]
+        elif t in ("MultiLineString", "Polygon"):
+            parts = c
+        elif t == "MultiPolygon":
+            parts = [ring for poly in c for ring in poly]
+        else:
+            continue
+        lines.extend((k, [(p[0], p[1]) for p in part]) for part in parts if len(part) >= 2)
+    return lines
+
+
+def synthetic(km, lat, lon, seed):
+    """Street grid (a major road every 2 km, streets every 200 m, wobbling) and a coastline."""
+    rng = random.Random(seed)
+    dlat = 1.0 / 111320.0
+    dlon = dlat / math.cos(math.radians(lat))
+    half = km * 500.0
+    lines = []
+    for i in range(int(km * 5) + 1):
+        off = -half + i * 200.0
+        k = KINDS["major"] if i % 10 == 0 else KINDS["minor"]
+        for vertical in (False, True):
+            pts, s = [], -half
+            while s <= half:
+                w = off + rng.uniform(-8, 8)
+                e, n = (w, s) if vertical else (s, w)
+                pts.append((lon + e * dlon, lat + n * dlat))
+                s += 50.0
+            lines.append((k, pts))
+    pts, s, wob = [], -half, 0.0
+    while s <= half:
+        wob += rng.uniform(-30, 30)
+        pts.append((lon + (half * 0.6 + wob) * dlon, lat + s * dlat))
+        s += 25.0
+    lines.append((KINDS["water"], pts))
+    return lines
+
+
+def clip(x0, y0, x1, y1, xmin, ymin, xmax, ymax):
+    """Liang-Barsky: the part of the segment inside the box, or None."""
+    t0, t1, dx, dy = 0.0, 1.0, x1 - x0, y1 - y0
+    for p, q in ((-dx, x0 - xmin), (dx, xmax - x0), (-dy, y0 - ymin), (dy, ymax - y0)):
+        if p == 0:
+            if q < 0:
+                return None
+        else:
+            r = q / p
+            if p < 0:
+                if r > t1:
+                    return None
+                t0 = max(t0, r)
+            else:
+                if r < t0:
+                    return None
+                t1 = min(t1, r)
+    return (x0 + t0 * dx, y0 + t0 * dy, x0 + t1 * dx, y0 + t1 * dy)
+
+
+def cut(lines, zoom):
+    """{(tx, ty): [(kind, [(x, y) tile-local float])]}"""
+    tiles = {}
+    for k, pts in lines:
+        xy = [project(lon, lat, zoom) for lon, lat in pts]
+        runs = {}  # tile -> run being extended for this line
+        for (x0, y0), (x1, y1) in zip(xy, xy[1:]):
+            txa = int((min(x0, x1) - MARGIN) // EXTENT)
+            txb = int((max(x0, x1) + MARGIN) // EXTENT)
+            tya = int((min(y0, y1) - MARGIN) // EXTENT)
+            tyb = int((max(y0, y1) + MARGIN) // EXTENT)
+            for tx in range(txa, txb + 1):
+                for ty in range(tya, tyb + 1):
+                    bx, by = tx * EXTENT, ty * EXTENT
+                    c = clip(x0 - bx, y0 - by, x1 - bx, y1 - by, -MARGIN, -MARGIN, EXTENT + MARGIN, EXTENT + MARGIN)
+                    if c is None:
+                        continue
+                    run = runs.get((tx, ty))
+                    if run and run[-1] == (c[0], c[1]):
+                        run.append((c[2], c[3]))
+                    else:
+                        run = [(c[0], c[1]), (c[2], c[3])]
+                        runs[(tx, ty)] = run
+                        tiles.setdefault((tx, ty), []).append((k, run))
+    return tiles
+
+
+def douglas_peucker(pts, tol):
+    if len(pts) < 3:
+        return list(pts)
+    keep = [False] * len(pts)
+    keep[0] = keep[-1] = True
+    stack = [(0, len(pts) - 1)]
+    while stack:
+        a, b = stack.pop()
+        ax, ay = pts[a]
+        bx, by = pts[b]
+        dx, dy = bx - ax, by - ay
+        norm = math.hypot(dx, dy) or 1e-9
+        best, bi = -1.0, -1
+        for i in range(a + 1, b):
+            d = abs(dy * (pts[i][0] - ax) - dx * (pts[i][1] - ay)) / norm
+            if d > best:
+                best, bi = d, i
+        if best > tol:
+            keep[bi] = True
+            stack.append((a, bi))
+            stack.append((bi, b))
+    return [p for p, kp in zip(pts, keep) if kp]
+
+
+def quantise(run, tol):
+    out = []
+    for x, y in douglas_peucker(run, tol):
+        q = (int(round(x)), int(round(y)))
+        if not out or q != out[-1]:
+            out.append(q)
+    return out if len(out) >= 2 else []
+
+
+def encode_tile(feats, tol, max_tol):
+    """Payload bytes, points, and whether anything had to be dropped."""
+    dropped = False
+    while True:
+        runs = [(k, quantise(r, tol)) for k, r in feats]
+        runs = [(k, r) for k, r in runs if r]
+        if sum(len(r) for _, r in runs) <= MAX_POINTS and len(runs) <= MAX_FEATURES:
+            break
+        if tol < max_tol:
+            tol *= 2
+            continue
+        # Still too dense: minor roads go first, then whatever is past the budget
+        minor = [f for f in feats if f[0] == KINDS["minor"]]
+        if minor:
+            feats = [f for f in feats if f[0] != KINDS["minor"]]
+            dropped = True
+            continue
+        kept, total = [], 0
+        for k, r in runs:
+            if total + len(r) > MAX_POINTS or len(kept) >= MAX_FEATURES:
+                break
+            kept.append((k, r))
+            total += len(r)
+        runs, dropped = kept, True
+        break
+    out = bytearray()
+    for k, r in runs:
+        out.append(k)
+        out += varint(len(r))
+        px = py = 0
+        for x, y in r:
+            out += varint(zigzag(x - px))
+            out += varint(zigzag(y - py))
+            px, py = x, y
+    return bytes(out), sum(len(r) for _, r in runs), dropped
+
+
+def zigzag(v):
+    return (v << 1) ^ (v >> 63)
+
+
+def varint(v):
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("input", nargs="?", help="GeoJSON")
+    ap.add_argument("-o", "--output", default="tiles.bin")
+    ap.add_argument("--zoom", type=int, default=13, help="tile zoom (13: ~3 km tiles at 48 deg)")
+    ap.add_argument("--tolerance", type=float, default=2.0, help="simplification, tile units")
+    ap.add_argument("--max-tolerance", type=float, default=32.0)
+    ap.add_argument("--partition-size", type=lambda s: int(s, 0), default=0x100000)
+    ap.add_argument("--synthetic", type=float, metavar="KM")
+    ap.add_argument("--centre", type=float, nargs=2, default=(48.137, 11.576), metavar=("LAT", "LON"))
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+    if not 0 <= args.zoom <= 16:
+        ap.error("zoom must be 0..16")
+
+    if args.synthetic:
+        lines = synthetic(args.synthetic, args.centre[0], args.centre[1], args.seed)
+    elif args.input:
+        lines = read_geojson(args.input)
+    else:
+        ap.error("give a GeoJSON file or --synthetic KM")
+
+    tiles = cut(lines, args.zoom)
+    payloads, points, worst, thinned = [], 0, 0, 0
+    for (tx, ty) in sorted(tiles, key=lambda t: (t[0] << 16) | t[1]):
+        data, n, dropped = encode_tile(tiles[(tx, ty)], args.tolerance, args.max_tolerance)
+        if not data:
+            continue
+        payloads.append(((tx << 16) | ty, data))
+        points += n
+        worst = max(worst, n)
+        thinned += dropped
+
+    index_size = (len(payloads) + 1) * INDEX.size
+    offset = HEADER.size + index_size
+    index, body = bytearray(), bytearray()
+    for key, data in payloads:
+        index += INDEX.pack(key, offset + len(body))
+        body += data
+    index += INDEX.pack(0xFFFFFFFF, offset + len(body))
+    blob = bytes(index + body)
+    image = HEADER.pack(MAGIC, VERSION, args.zoom, len(payloads), len(blob), zlib.crc32(blob), int(time.time())) + blob
+    if args.partition_size and len(image) > args.partition_size:
+        sys.exit("%d tiles (%d bytes) do not fit the %d-byte partition: use a smaller region or a larger --tolerance"
+                 % (len(payloads), len(image), args.partition_size))
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("%s: zoom %d, %d tiles, %d points (max %d per tile, %d thinned), %d bytes"
+          % (args.output, args.zoom, len(payloads), points, worst, thinned, len(image)))
+
+
+if __name__ == "__main__":
+    main()